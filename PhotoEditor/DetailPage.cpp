@@ -228,10 +228,8 @@ namespace winrt::PhotoEditor::implementation
         ButtonPreviewImage().Source(m_imageSource);
         ButtonPreviewImage().InvalidateArrange();
 
-        CreateEffectsGraph();
-
         auto destinationBrush = m_compositor.CreateBackdropBrush();
-        auto graphicsEffectFactory = m_compositor.CreateEffectFactory(m_graphicsEffect);
+        auto graphicsEffectFactory = GetEffectFactory(false);
 
         auto previewBrush = graphicsEffectFactory.CreateBrush();
         previewBrush.SetSourceParameter(L"Backdrop", destinationBrush);
@@ -378,42 +376,45 @@ namespace winrt::PhotoEditor::implementation
     }
 
     // Creates all the thumbnail previews for effect selection UI.
-    void DetailPage::InitializeEffectPreviews()
+    IAsyncAction DetailPage::InitializeEffectPreviews()
     {
+        // Every preview shows the same thumbnail, so it is fetched once and shared.
+        Photo* implType = get_self<Photo>(Item());
+        auto thumbnail = co_await implType->GetImageThumbnailAsync();
+
         SepiaEffect sepiaEffect{};
         sepiaEffect.Intensity(0.5f);
         sepiaEffect.Source(CompositionEffectSourceParameter{ L"source" });
-        InitializeEffectPreview(sepiaEffect, sepiaImage());
+        InitializeEffectPreview(sepiaEffect, sepiaImage(), thumbnail);
 
         GrayscaleEffect grayscaleEffect{};
         grayscaleEffect.Source(CompositionEffectSourceParameter{ L"source" });
-        InitializeEffectPreview(grayscaleEffect, grayscaleImage());
+        InitializeEffectPreview(grayscaleEffect, grayscaleImage(), thumbnail);
 
         GaussianBlurEffect blurEffect{};
         blurEffect.BlurAmount(3.0f);
         blurEffect.Source(CompositionEffectSourceParameter{ L"source" });
-        InitializeEffectPreview(blurEffect, blurImage());
+        InitializeEffectPreview(blurEffect, blurImage(), thumbnail);
 
         InvertEffect invertEffect{};
         invertEffect.Source(CompositionEffectSourceParameter{ L"source" });
-        InitializeEffectPreview(invertEffect, invertImage());
+        InitializeEffectPreview(invertEffect, invertImage(), thumbnail);
 
         ExposureEffect lightEffect{};
         lightEffect.Exposure(1.0f);
         lightEffect.Source(CompositionEffectSourceParameter{ L"source" });
-        InitializeEffectPreview(lightEffect, lightImage());
+        InitializeEffectPreview(lightEffect, lightImage(), thumbnail);
 
         SaturationEffect colorEffect{};
         colorEffect.Saturation(0.5f);
         colorEffect.Source(CompositionEffectSourceParameter{ L"source" });
-        InitializeEffectPreview(colorEffect, colorImage());
+        InitializeEffectPreview(colorEffect, colorImage(), thumbnail);
     }
 
     // Creates a specified effect thumbnail for the effect preview UI.
-    IAsyncAction DetailPage::InitializeEffectPreview(IInspectable compEffect, Image image)
+    void DetailPage::InitializeEffectPreview(IInspectable compEffect, Image image, BitmapImage thumbnail)
     {
-        Photo* implType = get_self<Photo>(Item());
-        image.Source(co_await implType->GetImageThumbnailAsync());
+        image.Source(thumbnail);
         image.InvalidateArrange();
 
         auto destinationBrush = m_compositor.CreateBackdropBrush();
@@ -478,15 +479,45 @@ namespace winrt::PhotoEditor::implementation
         }
     }
 
+    // Returns a cached effect factory for the selected effects. The factory captures the graph
+    // when it is created, so the key only has to identify what the graph contains: the effects
+    // in order, and for the main image brush the properties that are animated afterward.
+    CompositionEffectFactory DetailPage::GetEffectFactory(bool withAnimatableProperties)
+    {
+        std::wstring key;
+        for (auto&& effect : m_effectsList)
+        {
+            key += std::to_wstring(effect.index()) + L',';
+        }
+
+        if (withAnimatableProperties)
+        {
+            for (auto&& property : m_animatablePropertiesList)
+            {
+                key += L'|';
+                key += property.c_str();
+            }
+        }
+
+        if (auto factory = m_effectFactories.Find(key))
+        {
+            return *factory;
+        }
+
+        CreateEffectsGraph();
+        auto factory = withAnimatableProperties ?
+            m_compositor.CreateEffectFactory(m_graphicsEffect, m_animatablePropertiesList) :
+            m_compositor.CreateEffectFactory(m_graphicsEffect);
+        return m_effectFactories.Insert(key, factory);
+    }
+
     void DetailPage::UpdateMainImageBrush()
     {
         MainImage().Source(m_imageSource);
         MainImage().InvalidateArrange();
 
-        CreateEffectsGraph();
-
         auto destinationBrush = m_compositor.CreateBackdropBrush();
-        auto graphicsEffectFactory = m_compositor.CreateEffectFactory(m_graphicsEffect, m_animatablePropertiesList);
+        auto graphicsEffectFactory = GetEffectFactory(true);
 
         m_combinedBrush = graphicsEffectFactory.CreateBrush();
         m_combinedBrush.SetSourceParameter(L"Backdrop", destinationBrush);
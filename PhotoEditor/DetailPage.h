@@ -24,6 +24,7 @@
 
 #pragma once
 #include "DetailPage.g.h"
+#include "LruCache.h"
 #include <variant>
 
 namespace winrt::PhotoEditor::implementation
@@ -111,12 +112,16 @@ namespace winrt::PhotoEditor::implementation
         void InitializeEffects();
 
         // Generate preview of effects for effect selection UI.
-        void InitializeEffectPreviews();
-        Windows::Foundation::IAsyncAction InitializeEffectPreview(Windows::Foundation::IInspectable, Windows::UI::Xaml::Controls::Image);
+        Windows::Foundation::IAsyncAction InitializeEffectPreviews();
+        void InitializeEffectPreview(Windows::Foundation::IInspectable, Windows::UI::Xaml::Controls::Image, Windows::UI::Xaml::Media::Imaging::BitmapImage);
 
         // Creates the effects graph based on the selected effects.
         void CreateEffectsGraph();
 
+        // Returns the effect factory for the selected effects, creating the effects graph and
+        // the factory only if this combination has not been used recently.
+        Windows::UI::Composition::CompositionEffectFactory GetEffectFactory(bool withAnimatableProperties);
+
         // Configure and generate resources for rendering.
         void UpdateMainImageBrush();
         void UpdatePanelState();
@@ -165,6 +170,9 @@ namespace winrt::PhotoEditor::implementation
         // Photo image
         Windows::UI::Xaml::Media::Imaging::BitmapImage m_imageSource{ nullptr };
 
+        // Effect factories keyed by the ordered effects and their animatable properties.
+        PhotoEngine::LruCache<std::wstring, Windows::UI::Composition::CompositionEffectFactory> m_effectFactories{ 16 };
+
      };
 }
 
@@ -25,6 +25,9 @@
 #include "pch.h"
 #include "MainPage.h"
 #include "Photo.h"
+#include <deque>
+#include <unordered_set>
+#include <vector>
 
 using namespace winrt;
 using namespace Windows::Foundation;
@@ -33,6 +36,7 @@ using namespace Windows::Storage;
 using namespace Windows::Storage::Search;
 using namespace Windows::Storage::Streams;
 using namespace Windows::UI::Composition;
+using namespace Windows::UI::Core;
 using namespace Windows::UI::Xaml::Navigation;
 using namespace Windows::UI::Xaml;
 using namespace Windows::UI::Xaml::Controls;
@@ -41,6 +45,20 @@ using namespace Windows::UI::Xaml::Hosting;
 using namespace Windows::UI::Xaml::Media::Animation;
 using namespace Windows::UI::Xaml::Media::Imaging;
 
+namespace
+{
+    // The first page of the file query holds about a screenful of photos so the grid
+    // fills quickly; each later page is twice as large, up to MaxQueryPageSize.
+    constexpr uint32_t FirstQueryPageSize = 64;
+    constexpr uint32_t MaxQueryPageSize = 2048;
+
+    // Image property reads in flight at once.
+    constexpr size_t MaxPropertyReads = 16;
+
+    // How long the library must be quiet after a change before the photos are refreshed.
+    constexpr std::chrono::milliseconds LibraryRefreshDelay{ 500 };
+}
+
 namespace winrt::PhotoEditor::implementation
 {
     // Page constructor.
@@ -77,6 +95,13 @@ namespace winrt::PhotoEditor::implementation
             elementVisual.ImplicitAnimations(nullptr);
 
             image.Source(nullptr);
+
+            // The container now shows nothing, so its thumbnail is no longer needed.
+            if (auto load = m_thumbnailLoads.find(args.ItemContainer()); load != m_thumbnailLoads.end())
+            {
+                load->second.Cancel();
+                m_thumbnailLoads.erase(load);
+            }
         }
 
         if (args.Phase() == 0)
@@ -100,20 +125,48 @@ namespace winrt::PhotoEditor::implementation
             auto item = unbox_value<PhotoEditor::Photo>(args.Item());
             Photo* impleType = get_self<Photo>(item);
 
+            // The map is read again after the thumbnail arrives, so the page must outlive the load.
+            auto strong = get_strong();
+            auto container = args.ItemContainer();
+            auto load = impleType->GetImageThumbnailAsync();
+            if (auto existing = m_thumbnailLoads.find(container); existing != m_thumbnailLoads.end())
+            {
+                // The container was bound again without being recycled.
+                existing->second.Cancel();
+                existing->second = load;
+            }
+            else
+            {
+                m_thumbnailLoads.emplace(container, load);
+            }
+
+            BitmapImage thumbnail{ nullptr };
             try
             {
-                auto thumbnail = co_await impleType->GetImageThumbnailAsync();
-                image.Source(thumbnail);
+                thumbnail = co_await load;
+            }
+            catch (winrt::hresult_canceled const&)
+            {
+                // The container was recycled before the thumbnail arrived.
+                co_return;
             }
             catch (winrt::hresult_error)
             {
                 // File could be corrupt, or it might have an image file
                 // extension, but not really be an image file.
-                BitmapImage bitmapImage{};
+                thumbnail = BitmapImage{};
                 Uri uri{ image.BaseUri().AbsoluteUri(), L"Assets/StoreLogo.png" };
-                bitmapImage.UriSource(uri);
-                image.Source(bitmapImage);
+                thumbnail.UriSource(uri);
             }
+
+            // Only the container's latest load may set its image.
+            auto entry = m_thumbnailLoads.find(container);
+            if (entry == m_thumbnailLoads.end() || entry->second != load)
+            {
+                co_return;
+            }
+            m_thumbnailLoads.erase(entry);
+            image.Source(thumbnail);
         }
     }
 
@@ -160,26 +213,42 @@ namespace winrt::PhotoEditor::implementation
 
         // Get the Pictures library.
         StorageFolder picturesFolder = KnownFolders::PicturesLibrary();
-        auto result = picturesFolder.CreateFileQueryWithOptions(options);
-        auto imageFiles = co_await result.GetFilesAsync();
+        m_query = picturesFolder.CreateFileQueryWithOptions(options);
         auto unsupportedFilesFound = false;
 
-        // Populate Photos collection.
-        for (auto&& file : imageFiles)
+        // Populate Photos collection a page of the query at a time, so the first photos
+        // show while the rest of the library is still being read.
+        uint32_t pageStart = 0;
+        uint32_t pageSize = FirstQueryPageSize;
+        for (;;)
         {
-            // Only files on the local computer are supported. 
-            // Files on OneDrive or a network location are excluded.
-            if (file.Provider().Id() == L"computer")
+            auto imageFiles = co_await m_query.GetFilesAsync(pageStart, pageSize);
+            if (imageFiles.Size() == 0)
             {
-                auto image = co_await LoadImageInfoAsync(file);
-                Photos().Append(image);
+                break;
             }
-            else
+            pageStart += imageFiles.Size();
+            pageSize = std::min(pageSize * 2, MaxQueryPageSize);
+
+            std::vector<StorageFile> page;
+            page.reserve(imageFiles.Size());
+            for (auto&& file : imageFiles)
             {
-                unsupportedFilesFound = true;
+                // Only files on the local computer are supported. 
+                // Files on OneDrive or a network location are excluded.
+                if (file.Provider().Id() != L"computer")
+                {
+                    unsupportedFilesFound = true;
+                    continue;
+                }
+                page.push_back(file);
             }
+
+            co_await AppendPhotosAsync(std::move(page));
         }
 
+        WatchLibrary();
+
         if (Photos().Size() == 0)
         {
             // No pictures were found in the library, so show message.
@@ -200,6 +269,167 @@ namespace winrt::PhotoEditor::implementation
         }
     }
 
+    // Reads the properties of files and appends them to the Photos collection in order.
+    // A file whose properties cannot be read, such as one deleted since the query found
+    // it, is left out.
+    IAsyncAction MainPage::AppendPhotosAsync(std::vector<StorageFile> files)
+    {
+        // LoadImageInfoAsync starts reading as soon as it is called, so keep up to
+        // MaxPropertyReads reads running and collect them in order.
+        std::deque<IAsyncOperation<PhotoEditor::Photo>> reads;
+        std::vector<PhotoEditor::Photo> photos;
+        photos.reserve(files.size());
+        for (size_t next = 0; next < files.size() || !reads.empty();)
+        {
+            if (next < files.size() && reads.size() < MaxPropertyReads)
+            {
+                try
+                {
+                    reads.push_back(LoadImageInfoAsync(files[next]));
+                }
+                catch (winrt::hresult_error const&)
+                {
+                }
+                next++;
+                continue;
+            }
+
+            auto read = std::move(reads.front());
+            reads.pop_front();
+            try
+            {
+                photos.push_back(co_await read);
+            }
+            catch (winrt::hresult_error const&)
+            {
+            }
+        }
+
+        // Append in one pass, so the grid updates its layout once.
+        for (auto&& photo : photos)
+        {
+            Photos().Append(photo);
+        }
+    }
+
+    // Refreshes the photos when files are added to or removed from the library.
+    void MainPage::WatchLibrary()
+    {
+        m_refreshTimer = DispatcherTimer();
+        m_refreshTimer.Interval(LibraryRefreshDelay);
+        m_refreshTimer.Tick([weak{ get_weak() }](auto&&, auto&&)
+        {
+            if (auto strong = weak.get())
+            {
+                strong->m_refreshTimer.Stop();
+                strong->RefreshItemsAsync();
+            }
+        });
+
+        // ContentsChanged is raised on a background thread, once per change.
+        m_contentsChangedToken = m_query.ContentsChanged(auto_revoke, [weak{ get_weak() }](auto&&, auto&&)
+        {
+            if (auto strong = weak.get())
+            {
+                strong->Dispatcher().RunAsync(CoreDispatcherPriority::Normal, [strong]
+                {
+                    strong->m_refreshTimer.Stop();
+                    strong->m_refreshTimer.Start();
+                });
+            }
+        });
+    }
+
+    // Queries the library again, removes the photos whose files are gone, and appends
+    // the files that are new, leaving every other photo and its container in place.
+    // Each refresh enumerates the whole query, so it costs time proportional to the
+    // library size, once per burst of changes; only the grid update is incremental.
+    IAsyncAction MainPage::RefreshItemsAsync()
+    {
+        // A refresh already running goes around again for changes that arrive meanwhile.
+        if (m_refreshing)
+        {
+            m_refreshPending = true;
+            co_return;
+        }
+
+        auto strong = get_strong();
+        m_refreshing = true;
+        try
+        {
+            do
+            {
+                m_refreshPending = false;
+
+                std::unordered_set<hstring> shown;
+                for (auto&& item : Photos())
+                {
+                    shown.insert(get_self<Photo>(item.as<PhotoEditor::Photo>())->ImageFile().Path());
+                }
+
+                std::unordered_set<hstring> found;
+                std::vector<StorageFile> added;
+                uint32_t pageStart = 0;
+                for (;;)
+                {
+                    auto imageFiles = co_await m_query.GetFilesAsync(pageStart, MaxQueryPageSize);
+                    if (imageFiles.Size() == 0)
+                    {
+                        break;
+                    }
+                    pageStart += imageFiles.Size();
+
+                    for (auto&& file : imageFiles)
+                    {
+                        if (file.Provider().Id() != L"computer")
+                        {
+                            continue;
+                        }
+
+                        auto path = file.Path();
+                        if (shown.count(path) == 0)
+                        {
+                            added.push_back(file);
+                        }
+                        found.insert(std::move(path));
+                    }
+                }
+
+                // Remove from the end, so the indexes still to visit stay valid.
+                for (uint32_t i = Photos().Size(); i-- > 0;)
+                {
+                    auto photo = Photos().GetAt(i).as<PhotoEditor::Photo>();
+                    if (found.count(get_self<Photo>(photo)->ImageFile().Path()) == 0)
+                    {
+                        if (photo == m_persistedItem)
+                        {
+                            m_persistedItem = nullptr;
+                        }
+                        Photos().RemoveAt(i);
+                    }
+                }
+
+                co_await AppendPhotosAsync(std::move(added));
+            } while (m_refreshPending);
+        }
+        catch (winrt::hresult_error const&)
+        {
+            // The query failed while the library was changing, as it can during an
+            // import. The Tick handler does not observe this action, so try again once
+            // the library has been quiet for another LibraryRefreshDelay.
+            m_refreshTimer.Stop();
+            m_refreshTimer.Start();
+        }
+        catch (...)
+        {
+            m_refreshing = false;
+            throw;
+        }
+        m_refreshing = false;
+
+        NoPicsText().Visibility(Photos().Size() == 0 ? Windows::UI::Xaml::Visibility::Visible : Windows::UI::Xaml::Visibility::Collapsed);
+    }
+
     // Creates a Photo from Storage file for adding to Photo collection.
     IAsyncOperation<PhotoEditor::Photo> MainPage::LoadImageInfoAsync(StorageFile file)
     {
@@ -24,6 +24,8 @@
 
 #pragma once
 #include "MainPage.g.h"
+#include <unordered_map>
+#include <vector>
 
 namespace winrt::PhotoEditor::implementation
 {
@@ -54,18 +56,34 @@ namespace winrt::PhotoEditor::implementation
     private:
         // Functions for image loading and animation.
         Windows::Foundation::IAsyncAction GetItemsAsync();
+        Windows::Foundation::IAsyncAction AppendPhotosAsync(std::vector<Windows::Storage::StorageFile>);
+        Windows::Foundation::IAsyncAction RefreshItemsAsync();
+        void WatchLibrary();
         Windows::UI::Composition::CompositionAnimationGroup CreateOffsetAnimation();
         Windows::Foundation::IAsyncOperation<PhotoEditor::Photo> LoadImageInfoAsync(Windows::Storage::StorageFile);
 
         // Backing field for Photo collection.
         Windows::Foundation::Collections::IVector<IInspectable> m_photos{ nullptr };
 
+        // The library query, watched for files added or removed while the app runs. Its
+        // change notifications restart the timer, so a burst of changes, such as an
+        // import, is applied in one refresh once the library has been quiet for a moment.
+        Windows::Storage::Search::StorageFileQueryResult m_query{ nullptr };
+        event_revoker<Windows::Storage::Search::IStorageQueryResultBase> m_contentsChangedToken;
+        Windows::UI::Xaml::DispatcherTimer m_refreshTimer{ nullptr };
+        bool m_refreshing{ false };
+        bool m_refreshPending{ false };
+
         // Field to store selected Photo for later back navigation.
         PhotoEditor::Photo m_persistedItem{ nullptr };
 
         // Collection of animations for element visuals for reorder animation.
         Windows::UI::Composition::ImplicitAnimationCollection m_elementImplicitAnimation{ nullptr };
 
+        // Thumbnail loads in flight, by the container that shows them, so a recycled
+        // container can cancel its load.
+        std::unordered_map<Windows::UI::Xaml::Controls::Primitives::SelectorItem, Windows::Foundation::IAsyncOperation<Windows::UI::Xaml::Media::Imaging::BitmapImage>> m_thumbnailLoads;
+
         // Field to store page Compositor for creation of types in the Windows.UI.Composition namespace.
         Windows::UI::Composition::Compositor m_compositor{ nullptr };
 
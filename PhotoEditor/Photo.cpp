@@ -38,7 +38,12 @@ namespace winrt::PhotoEditor::implementation
 {
     IAsyncOperation<BitmapImage> Photo::GetImageThumbnailAsync() const
     {
-        auto thumbnail = co_await m_imageFile.GetThumbnailAsync(FileProperties::ThumbnailMode::PicturesView);
+        // Cancelling this operation cancels the thumbnail request it is waiting on.
+        auto request = m_imageFile.GetThumbnailAsync(FileProperties::ThumbnailMode::PicturesView);
+        auto cancellation = co_await get_cancellation_token();
+        cancellation.callback([request] { request.Cancel(); });
+
+        auto thumbnail = co_await request;
         BitmapImage bitmapImage{};
         bitmapImage.SetSource(thumbnail);
         thumbnail.Close();
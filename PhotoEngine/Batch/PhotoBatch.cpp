@@ -0,0 +1,269 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+// Applies one look to every JPEG under a folder, without the app: each photo is decoded,
+// run through the recipe's effects, and encoded to the same relative path under the
+// output folder, on all cores. Progress and failures go to stderr; a summary with the
+// throughput and the per-photo latency percentiles is written to stdout as one JSON
+// object. Exits with 1 if any photo failed, and with 2 if the arguments, the recipe, or
+// the input folder cannot be used. The output folder must be outside the input folder,
+// so a photo is never written over itself or read back as a source by the next run.
+//
+//     PhotoEngineBatch --recipe look.txt --input folder --output folder [--threads 8]
+//                      [--memory-mb 1024] [--quality 90] [--format Bgra8|Float32|Float16]
+//                      [--linear 0|1] [--huge-pages 0|1]
+//
+// The --memory-mb budget covers both the photos in flight and the free buffers kept for
+// reuse between them.
+//
+// The recipe holds the effect values of a Photo and the selected effects, for example:
+//
+//     effects = light, color, sepia
+//     Exposure = 0.5
+//     Contrast = 0.2
+//     Temperature = 0.3
+//     Intensity = 0.6
+
+#include "BatchProcessor.h"
+#include "BufferPool.h"
+#include "LibraryScanner.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace PhotoEngine;
+
+namespace
+{
+    struct Settings
+    {
+        std::filesystem::path Recipe;
+        std::filesystem::path Input;
+        std::filesystem::path Output;
+        BatchOptions Options;
+        BufferPoolOptions Pool;
+    };
+
+    WorkingFormat ParseFormat(std::string const& name)
+    {
+        for (auto format : { WorkingFormat::Bgra8, WorkingFormat::Float32, WorkingFormat::Float16 })
+        {
+            if (name == WorkingFormatName(format))
+            {
+                return format;
+            }
+        }
+        throw std::invalid_argument("unknown format " + name);
+    }
+
+    Settings ParseArguments(int argc, char** argv)
+    {
+        Settings settings;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string argument = argv[i];
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("missing value for " + argument);
+            }
+
+            const char* value = argv[++i];
+            if (argument == "--recipe")
+            {
+                settings.Recipe = value;
+            }
+            else if (argument == "--input")
+            {
+                settings.Input = value;
+            }
+            else if (argument == "--output")
+            {
+                settings.Output = value;
+            }
+            else if (argument == "--threads")
+            {
+                settings.Options.ThreadCount = static_cast<unsigned>(std::stoul(value));
+            }
+            else if (argument == "--memory-mb")
+            {
+                settings.Options.MaxInFlightBytes = static_cast<size_t>(std::stoull(value)) << 20;
+            }
+            else if (argument == "--quality")
+            {
+                settings.Options.Quality = std::clamp(std::stoi(value), 1, 100);
+            }
+            else if (argument == "--format")
+            {
+                settings.Options.Pipeline.Format = ParseFormat(value);
+            }
+            else if (argument == "--linear")
+            {
+                settings.Options.Pipeline.LinearLight = std::stoul(value) != 0;
+            }
+            else if (argument == "--huge-pages")
+            {
+                settings.Pool.HugePages = std::stoul(value) != 0;
+            }
+            else
+            {
+                throw std::invalid_argument("unknown argument " + argument);
+            }
+        }
+
+        if (settings.Recipe.empty() || settings.Input.empty() || settings.Output.empty())
+        {
+            throw std::invalid_argument("--recipe, --input, and --output are required");
+        }
+        if (!std::filesystem::is_directory(settings.Input))
+        {
+            throw std::invalid_argument(settings.Input.string() + " is not a folder");
+        }
+
+        // A quarter of the budget is left to the buffer pool's cache.
+        settings.Pool.MaxCachedBytes = settings.Options.MaxInFlightBytes / 4;
+        settings.Options.MaxInFlightBytes -= settings.Pool.MaxCachedBytes;
+        return settings;
+    }
+
+    BatchRecipe ReadRecipe(std::filesystem::path const& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("cannot read " + path.string());
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+        return BatchRecipe::Parse(text.str());
+    }
+
+    // Returns the absolute form of a folder without symbolic links or a trailing separator.
+    std::filesystem::path FolderPath(std::filesystem::path const& folder)
+    {
+        auto path = std::filesystem::weakly_canonical(std::filesystem::absolute(folder));
+        return path.has_filename() ? path : path.parent_path();
+    }
+
+    // Finds the JPEGs under the input folder and maps each to the same relative path
+    // under the output folder, in path order so runs deal the photos out the same way.
+    // Throws if the output folder is the input folder or inside it, since the next run
+    // would take the results for photos, or if a photo would be written over itself.
+    std::vector<BatchItem> FindItems(Settings const& settings)
+    {
+        const auto input = FolderPath(settings.Input);
+        const auto output = FolderPath(settings.Output);
+        if (std::mismatch(input.begin(), input.end(), output.begin(), output.end()).first == input.end())
+        {
+            throw std::invalid_argument("--output " + settings.Output.string() + " is inside --input; choose a folder outside it");
+        }
+
+        LibraryScanOptions options;
+        options.Extensions = { ".jpg", ".jpeg" };
+
+        std::vector<ScannedFile> files;
+        LibraryScanner(options).Scan(settings.Input, [&](std::vector<ScannedFile>&& batch)
+        {
+            files.insert(files.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+        });
+        std::sort(files.begin(), files.end(), [](auto&& a, auto&& b) { return a.Path < b.Path; });
+
+        std::vector<BatchItem> items;
+        items.reserve(files.size());
+        for (auto&& file : files)
+        {
+            auto destination = settings.Output / std::filesystem::relative(file.Path, settings.Input);
+            std::error_code error;
+            if (std::filesystem::equivalent(file.Path, destination, error))
+            {
+                throw std::invalid_argument("the result for " + file.Path.string() + " would replace it; choose another --output folder");
+            }
+            items.push_back({ file.Path, std::move(destination) });
+        }
+        return items;
+    }
+
+    double Milliseconds(std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Settings settings;
+    BatchRecipe recipe;
+    std::vector<BatchItem> items;
+    try
+    {
+        settings = ParseArguments(argc, argv);
+        ConfigureBufferPool(settings.Pool);
+        recipe = ReadRecipe(settings.Recipe);
+        items = FindItems(settings);
+    }
+    catch (std::exception const& e)
+    {
+        std::fprintf(stderr, "PhotoEngineBatch: %s\n", e.what());
+        return 2;
+    }
+
+    std::fprintf(stderr, "%zu photos, %s\n", items.size(), Pipeline(recipe.Chain(), settings.Options.Pipeline).Describe().c_str());
+
+    // The status line is redrawn at most a few times a second.
+    auto lastReport = std::chrono::steady_clock::now();
+    const auto start = lastReport;
+
+    BatchProcessor processor(recipe, settings.Options);
+    processor.Run(items, [&](BatchItemResult const& result, size_t completed, size_t total)
+    {
+        if (!result.Succeeded)
+        {
+            std::fprintf(stderr, "\nfailed: %s: %s\n", result.Item->Source.string().c_str(), result.Error.c_str());
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - lastReport >= std::chrono::milliseconds(250) || completed == total)
+        {
+            lastReport = now;
+            const double seconds = std::chrono::duration<double>(now - start).count();
+            std::fprintf(stderr, "\r%zu/%zu photos, %.1f photos/s", completed, total, seconds > 0 ? completed / seconds : 0.0);
+        }
+    });
+    std::fprintf(stderr, "\n");
+
+    auto const& statistics = processor.Statistics();
+    std::printf("{\"photos\":%zu,\"succeeded\":%zu,\"failed\":%zu,\"threads\":%u,\"format\":\"%s\",\"linear_light\":%s,"
+        "\"elapsed_ms\":%.1f,\"images_per_second\":%.2f,\"median_latency_ms\":%.2f,\"p99_latency_ms\":%.2f,"
+        "\"max_latency_ms\":%.2f,\"peak_in_flight_mb\":%.1f,\"steals\":%zu}\n",
+        items.size(), statistics.Succeeded, statistics.Failed, processor.Options().ThreadCount,
+        WorkingFormatName(settings.Options.Pipeline.Format), settings.Options.Pipeline.LinearLight ? "true" : "false",
+        Milliseconds(statistics.Elapsed), statistics.ImagesPerSecond(), Milliseconds(statistics.MedianLatency),
+        Milliseconds(statistics.P99Latency), Milliseconds(statistics.MaxLatency),
+        statistics.PeakInFlightBytes / 1048576.0, statistics.Steals);
+
+    return statistics.Failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,333 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "BatchProcessor.h"
+#include "BufferPool.h"
+#include "ImageProbe.h"
+#include "JpegFile.h"
+#include "Renderer.h"
+#include "WorkStealingScheduler.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        std::string Trim(std::string const& text)
+        {
+            const auto first = text.find_first_not_of(" \t\r");
+            if (first == std::string::npos)
+            {
+                return {};
+            }
+            return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+        }
+
+        std::string ToLower(std::string text)
+        {
+            std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return text;
+        }
+
+        float ParseFloat(std::string const& text)
+        {
+            size_t used = 0;
+            const float value = std::stof(text, &used);
+            if (used != text.size())
+            {
+                throw std::invalid_argument(text);
+            }
+            return value;
+        }
+
+        // Returns the value at fraction p of the sorted durations, by nearest rank.
+        std::chrono::steady_clock::duration Percentile(std::vector<std::chrono::steady_clock::duration> const& sorted, double p)
+        {
+            if (sorted.empty())
+            {
+                return {};
+            }
+            const auto rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+            return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+        }
+    }
+
+    BatchRecipe BatchRecipe::Parse(std::string const& text)
+    {
+        BatchRecipe recipe;
+        std::stringstream stream(text);
+        std::string line;
+        for (size_t number = 1; std::getline(stream, line); number++)
+        {
+            line = Trim(line.substr(0, line.find('#')));
+            if (line.empty())
+            {
+                continue;
+            }
+
+            const auto equals = line.find('=');
+            const auto name = ToLower(Trim(line.substr(0, equals)));
+            const auto value = equals == std::string::npos ? std::string() : Trim(line.substr(equals + 1));
+            try
+            {
+                if (equals == std::string::npos)
+                {
+                    throw std::invalid_argument("expected name = value");
+                }
+
+                if (name == "effects")
+                {
+                    recipe.Effects.clear();
+                    std::stringstream tags(value);
+                    std::string tag;
+                    while (std::getline(tags, tag, ','))
+                    {
+                        if (!(tag = ToLower(Trim(tag))).empty())
+                        {
+                            recipe.Effects.push_back(tag);
+                        }
+                    }
+
+                    // Rejects unknown tags now rather than at the first photo.
+                    EffectChain::FromSelection(recipe.Effects);
+                }
+                else if (name == "exposure")
+                {
+                    recipe.Parameters.Exposure = ParseFloat(value);
+                }
+                else if (name == "temperature")
+                {
+                    recipe.Parameters.Temperature = ParseFloat(value);
+                }
+                else if (name == "tint")
+                {
+                    recipe.Parameters.Tint = ParseFloat(value);
+                }
+                else if (name == "contrast")
+                {
+                    recipe.Parameters.Contrast = ParseFloat(value);
+                }
+                else if (name == "saturation")
+                {
+                    recipe.Parameters.Saturation = ParseFloat(value);
+                }
+                else if (name == "bluramount")
+                {
+                    recipe.Parameters.BlurAmount = ParseFloat(value);
+                }
+                else if (name == "intensity")
+                {
+                    recipe.Parameters.Intensity = ParseFloat(value);
+                }
+                else
+                {
+                    throw std::invalid_argument("unknown name " + name);
+                }
+            }
+            catch (std::exception const& e)
+            {
+                throw std::invalid_argument("recipe line " + std::to_string(number) + ": " + e.what());
+            }
+        }
+        return recipe;
+    }
+
+    BatchProcessor::BatchProcessor(BatchRecipe const& recipe, BatchOptions const& options, PixelKernels const& kernels) :
+        m_chain(recipe.Chain()),
+        m_parameters(recipe.Parameters),
+        m_options(options),
+        m_kernels(kernels)
+    {
+        m_options.ThreadCount = std::max(m_options.ThreadCount, 1u);
+
+        // A planar render converts the image into a working image and blurs it there; an
+        // 8-bit render blurs through a scratch copy.
+        auto const& effects = m_chain.Effects();
+        const bool blurs = std::find(effects.begin(), effects.end(), EffectKind::GaussianBlur) != effects.end();
+        switch (m_options.Pipeline.Format)
+        {
+        case WorkingFormat::Float32:
+            m_bytesPerPixel = BytesPerPixel + 4 * SampleBytes(PlanarFormat::Float32);
+            break;
+        case WorkingFormat::Float16:
+            m_bytesPerPixel = BytesPerPixel + 4 * SampleBytes(PlanarFormat::Float16);
+            break;
+        default:
+            m_bytesPerPixel = BytesPerPixel * (blurs ? 2 : 1);
+            break;
+        }
+    }
+
+    size_t BatchProcessor::EstimateBytes(uint32_t width, uint32_t height) const
+    {
+        return static_cast<size_t>(width) * height * m_bytesPerPixel;
+    }
+
+    void BatchProcessor::AcquireBytes(size_t bytes)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_bytesReleased.wait(lock, [&] { return m_inFlightBytes == 0 || m_inFlightBytes + bytes <= m_options.MaxInFlightBytes; });
+        m_inFlightBytes += bytes;
+        m_statistics.PeakInFlightBytes = std::max(m_statistics.PeakInFlightBytes, m_inFlightBytes);
+    }
+
+    void BatchProcessor::ReleaseBytes(size_t bytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_inFlightBytes -= bytes;
+        }
+        m_bytesReleased.notify_all();
+    }
+
+    BatchItemResult BatchProcessor::Process(BatchItem const& item, Pipeline& pipeline)
+    {
+        BatchItemResult result;
+        result.Item = &item;
+
+        size_t bytes = 0;
+        try
+        {
+            // The result would replace the photo it is made from.
+            std::error_code sameError;
+            if (std::filesystem::equivalent(item.Source, item.Destination, sameError))
+            {
+                throw std::runtime_error("the destination is the source photo");
+            }
+
+            const auto probe = ProbeImageFile(item.Source);
+            if (!probe || probe->Format != ImageFormat::Jpeg)
+            {
+                throw std::runtime_error("not a JPEG file");
+            }
+            bytes = EstimateBytes(probe->Width, probe->Height);
+            AcquireBytes(bytes);
+
+            const auto start = std::chrono::steady_clock::now();
+            JpegRowReader reader(item.Source.string());
+            auto image = Image::Uninitialized(reader.Width(), reader.Height());
+            reader.ReadRows(image.View());
+            if (const auto warning = reader.Warning(); !warning.empty())
+            {
+                // A damaged file still decodes, with gray rows where data is missing.
+                throw std::runtime_error("damaged JPEG: " + warning);
+            }
+
+            // The photos already keep every thread busy, so each renders on its own thread.
+            ThreadPool serial(1);
+            Renderer(serial, m_kernels).Render(pipeline, m_parameters, image.View(), image.View());
+
+            if (item.Destination.has_parent_path())
+            {
+                std::filesystem::create_directories(item.Destination.parent_path());
+            }
+            // The result is written next to the destination and renamed over it once it is
+            // complete, so a failed or interrupted encode never leaves a truncated file or
+            // destroys one that was there.
+            auto partial = item.Destination;
+            partial += ".partial";
+            try
+            {
+                {
+                    JpegRowWriter writer(partial.string(), image.Width(), image.Height(), m_options.Quality);
+                    writer.WriteRows(image.View());
+                }
+                std::filesystem::rename(partial, item.Destination);
+            }
+            catch (...)
+            {
+                std::error_code ignored;
+                std::filesystem::remove(partial, ignored);
+                throw;
+            }
+
+            result.Latency = std::chrono::steady_clock::now() - start;
+            result.Succeeded = true;
+        }
+        catch (std::exception const& e)
+        {
+            result.Error = e.what();
+        }
+
+        if (bytes > 0)
+        {
+            ReleaseBytes(bytes);
+        }
+        return result;
+    }
+
+    void BatchProcessor::Run(std::vector<BatchItem> const& items, ProgressHandler const& onProgress)
+    {
+        m_statistics = {};
+        const auto start = std::chrono::steady_clock::now();
+
+        std::mutex resultsMutex;
+        std::vector<std::chrono::steady_clock::duration> latencies;
+        latencies.reserve(items.size());
+
+        WorkStealingScheduler scheduler(m_options.ThreadCount);
+
+        // A pipeline per thread, since a pipeline caches the programs of its last render.
+        std::vector<Pipeline> pipelines(scheduler.ThreadCount(), Pipeline(m_chain, m_options.Pipeline));
+
+        for (auto&& item : items)
+        {
+            scheduler.Submit([&, item = &item]
+            {
+                const auto result = Process(*item, pipelines[scheduler.CurrentWorker()]);
+
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                if (result.Succeeded)
+                {
+                    m_statistics.Succeeded++;
+                    latencies.push_back(result.Latency);
+                }
+                else
+                {
+                    m_statistics.Failed++;
+                }
+
+                if (onProgress)
+                {
+                    onProgress(result, m_statistics.Succeeded + m_statistics.Failed, items.size());
+                }
+            });
+        }
+        scheduler.Wait();
+
+        // Nothing reuses the photos' buffers once the batch is done.
+        GetBufferPool().Trim();
+
+        std::sort(latencies.begin(), latencies.end());
+        m_statistics.Elapsed = std::chrono::steady_clock::now() - start;
+        m_statistics.MedianLatency = Percentile(latencies, 0.5);
+        m_statistics.P99Latency = Percentile(latencies, 0.99);
+        m_statistics.MaxLatency = latencies.empty() ? std::chrono::steady_clock::duration{} : latencies.back();
+        m_statistics.Steals = scheduler.Steals();
+    }
+}
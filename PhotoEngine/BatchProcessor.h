@@ -0,0 +1,187 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "EffectChain.h"
+#include "EffectParameters.h"
+#include "Pipeline.h"
+#include "PixelKernels.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PhotoEngine
+{
+    // A look to apply to many photos: the effect values of a Photo and the effects
+    // selected on DetailPage.
+    struct BatchRecipe
+    {
+        // Tags of the selected effects, as passed to EffectChain::FromSelection.
+        std::vector<std::string> Effects;
+        EffectParameters Parameters;
+
+        // Parses a recipe of "name = value" lines. "effects" takes a comma-separated list
+        // of tags; the other names are the Photo properties, e.g. "Exposure = 0.5" or
+        // "BlurAmount = 3". Names ignore case, and text after '#' is a comment. Throws
+        // std::invalid_argument, naming the line, for an unknown name or a bad value.
+        static BatchRecipe Parse(std::string const& text);
+
+        EffectChain Chain() const
+        {
+            return EffectChain::FromSelection(Effects);
+        }
+    };
+
+    struct BatchOptions
+    {
+        // Photos processed at once, one per thread.
+        unsigned ThreadCount{ std::thread::hardware_concurrency() };
+
+        // Upper bound on the estimated memory of the photos being processed. A photo
+        // waits to start until its estimate fits; a photo larger than the whole budget
+        // runs once nothing else is in flight. The buffers GetBufferPool() keeps for
+        // reuse, up to its MaxCachedBytes, come on top of this while the batch runs.
+        size_t MaxInFlightBytes{ size_t{ 1 } << 30 };
+
+        // JPEG quality of the results.
+        int Quality{ 90 };
+
+        // How the effect chain is compiled.
+        PipelineOptions Pipeline;
+    };
+
+    // A photo to process, and where to write the result.
+    struct BatchItem
+    {
+        std::filesystem::path Source;
+        std::filesystem::path Destination;
+    };
+
+    struct BatchItemResult
+    {
+        BatchItem const* Item{ nullptr };
+        bool Succeeded{ false };
+
+        // What went wrong when the photo failed.
+        std::string Error;
+
+        // Time from decoding the photo to finishing its result, not counting time spent
+        // waiting for a thread or for memory.
+        std::chrono::steady_clock::duration Latency{};
+    };
+
+    struct BatchStatistics
+    {
+        size_t Succeeded{ 0 };
+        size_t Failed{ 0 };
+
+        std::chrono::steady_clock::duration Elapsed{};
+
+        // Percentiles of the latency of the photos that succeeded.
+        std::chrono::steady_clock::duration MedianLatency{};
+        std::chrono::steady_clock::duration P99Latency{};
+        std::chrono::steady_clock::duration MaxLatency{};
+
+        // Largest total estimate of the photos in flight at the same time.
+        size_t PeakInFlightBytes{ 0 };
+
+        // Photos a thread took from another thread's queue.
+        size_t Steals{ 0 };
+
+        // Photos finished per second, counting the ones that failed.
+        double ImagesPerSecond() const
+        {
+            const double seconds = std::chrono::duration<double>(Elapsed).count();
+            return seconds > 0 ? (Succeeded + Failed) / seconds : 0;
+        }
+    };
+
+    // Applies one recipe to a list of JPEG photos on all cores: each photo is decoded,
+    // rendered in place at full resolution, and encoded to its destination, which is
+    // replaced if it exists. The result is encoded to a temporary file beside the
+    // destination and renamed over it only when complete. A photo whose destination is
+    // the photo itself, or that libjpeg reports as damaged, fails.
+    //
+    // Photos are tasks of a WorkStealingScheduler. They are dealt to the threads' queues
+    // in order, and a thread that finishes its share early takes photos from the others,
+    // so a few large photos do not hold up the end of the batch. Before a photo is
+    // decoded, its header is read to estimate the memory it needs, and the photo waits
+    // until the estimate fits in MaxInFlightBytes.
+    class BatchProcessor
+    {
+    public:
+        // Receives each finished photo, along with the number finished so far. Calls are
+        // made one at a time from the processing threads.
+        using ProgressHandler = std::function<void(BatchItemResult const& result, size_t completed, size_t total)>;
+
+        BatchProcessor(BatchRecipe const& recipe, BatchOptions const& options = {}, PixelKernels const& kernels = GetPixelKernels());
+
+        BatchOptions const& Options() const
+        {
+            return m_options;
+        }
+
+        // Processes every item and blocks until all have finished. A photo that fails is
+        // reported and counted; it does not stop the others. Destination folders are
+        // created as needed. The buffers the photos left in GetBufferPool() are freed at
+        // the end.
+        void Run(std::vector<BatchItem> const& items, ProgressHandler const& onProgress = {});
+
+        BatchStatistics const& Statistics() const
+        {
+            return m_statistics;
+        }
+
+        // Returns the memory a width x height photo is estimated to need: the decoded
+        // image, which is rendered in place, plus the renderer's intermediates.
+        size_t EstimateBytes(uint32_t width, uint32_t height) const;
+
+    private:
+        BatchItemResult Process(BatchItem const& item, Pipeline& pipeline);
+
+        // Waits until bytes fit in the memory budget and takes them.
+        void AcquireBytes(size_t bytes);
+        void ReleaseBytes(size_t bytes);
+
+        EffectChain m_chain;
+        EffectParameters m_parameters;
+        BatchOptions m_options;
+        PixelKernels const& m_kernels;
+        BatchStatistics m_statistics;
+
+        // Estimated bytes per pixel of a photo in flight.
+        size_t m_bytesPerPixel;
+
+        std::mutex m_mutex;
+        std::condition_variable m_bytesReleased;
+        size_t m_inFlightBytes{ 0 };
+    };
+}
@@ -0,0 +1,393 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+// Measures the engine's throughput for each effect, the DetailPage preset chains, and
+// a chain with every effect selected, across image sizes and thread counts. Results
+// are written to stdout as JSON Lines, one object per measurement, so runs can be
+// stored and compared between releases; progress goes to stderr. The scaling efficiency
+// is the throughput divided by threads times the single-thread throughput, or -1 when
+// the run did not include one thread.
+//
+// Each case runs in every working format given. Renders in a format other than float32
+// also report their error against a Float32 render with the same linear-light setting,
+// as the largest and mean absolute difference in 8-bit levels.
+//
+//     PhotoEngineBenchmarks [--sizes 2,12,24,48] [--threads 1,2,4] [--iterations 5]
+//                           [--filter text] [--lut 33] [--formats Bgra8,Float32,Float16]
+//                           [--linear 0|1]
+
+#include "Renderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace PhotoEngine;
+
+namespace
+{
+    struct BenchmarkCase
+    {
+        std::string Name;
+        EffectChain Chain;
+    };
+
+    struct Settings
+    {
+        std::vector<double> Megapixels{ 2, 12, 24, 48 };
+        std::vector<unsigned> Threads;
+        unsigned Iterations{ 5 };
+        std::string Filter;
+        uint32_t ColorLutSize{ 0 };
+        std::vector<WorkingFormat> Formats{ WorkingFormat::Bgra8, WorkingFormat::Float32, WorkingFormat::Float16 };
+        bool LinearLight{ false };
+    };
+
+    // The values InitializeEffectPreviews gives the preset previews, plus edits for the
+    // effects that have no preview.
+    EffectParameters PresetParameters()
+    {
+        EffectParameters params;
+        params.Intensity = 0.5f;
+        params.BlurAmount = 3.0f;
+        params.Exposure = 1.0f;
+        params.Saturation = 0.5f;
+        params.Contrast = 0.5f;
+        params.Temperature = 0.3f;
+        params.Tint = -0.2f;
+        return params;
+    }
+
+    std::vector<BenchmarkCase> BenchmarkCases()
+    {
+        std::vector<BenchmarkCase> cases;
+        const EffectKind kinds[] = {
+            EffectKind::Contrast, EffectKind::Exposure, EffectKind::TemperatureAndTint, EffectKind::GaussianBlur,
+            EffectKind::Saturation, EffectKind::Sepia, EffectKind::Grayscale, EffectKind::Invert };
+        for (auto kind : kinds)
+        {
+            cases.push_back({ std::string("effect/") + EffectName(kind), EffectChain{ kind } });
+        }
+
+        const char* presets[] = { "sepia", "grayscale", "blur", "invert", "light", "color" };
+        for (auto preset : presets)
+        {
+            cases.push_back({ std::string("preset/") + preset, EffectChain::FromSelection({ preset }) });
+        }
+
+        cases.push_back({ "preset/everything", EffectChain::FromSelection({ "sepia", "grayscale", "blur", "invert", "light", "color" }) });
+        return cases;
+    }
+
+    // Bytes read and written per pixel by the passes of a render, counting the image
+    // buffers the renderer touches but not cache effects. A point stage reads and writes
+    // each pixel once; a blur runs a horizontal and a vertical pass through an
+    // intermediate image, and when it is not the first stage its input is copied first.
+    // In a planar format the point stages between blurs share one pass, which reads the
+    // source or the planar image and writes the planar image or the destination, and a
+    // blur reads and writes the planar image twice.
+    double BytesMovedPerPixel(Pipeline const& pipeline)
+    {
+        double bytes = 0;
+        auto const& stages = pipeline.Stages();
+        const auto format = pipeline.Options().Format;
+        if (format != WorkingFormat::Bgra8)
+        {
+            const double sample = 4.0 * SampleBytes(format == WorkingFormat::Float16 ? PlanarFormat::Float16 : PlanarFormat::Float32);
+            bytes = BytesPerPixel;
+            for (auto&& stage : stages)
+            {
+                if (stage.Type == StageType::GaussianBlur)
+                {
+                    bytes += sample + 4 * sample + sample;
+                }
+            }
+            return bytes + BytesPerPixel;
+        }
+
+        for (size_t i = 0; i < stages.size(); i++)
+        {
+            if (stages[i].Type == StageType::GaussianBlur)
+            {
+                bytes += 4 * BytesPerPixel + (i > 0 ? 2 * BytesPerPixel : 0);
+            }
+            else
+            {
+                bytes += 2 * BytesPerPixel;
+            }
+        }
+        return bytes;
+    }
+
+    // A smooth gradient with some texture, so blurs and curves see realistic values.
+    Image MakeSourceImage(uint32_t width, uint32_t height)
+    {
+        Image image(width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t* row = image.View().Row(y);
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const uint32_t texture = (x * 7 + y * 13) % 23;
+                row[x * BytesPerPixel + 0] = static_cast<uint8_t>(x * 255 / width);
+                row[x * BytesPerPixel + 1] = static_cast<uint8_t>(y * 255 / height);
+                row[x * BytesPerPixel + 2] = static_cast<uint8_t>(std::min(255u, (x + y) * 255 / (width + height) + texture));
+                row[x * BytesPerPixel + 3] = 255;
+            }
+        }
+        return image;
+    }
+
+    // The largest and mean absolute difference between two images, in 8-bit levels.
+    std::pair<int, double> ImageError(ConstImageView a, ConstImageView b)
+    {
+        int largest = 0;
+        uint64_t sum = 0;
+        for (uint32_t y = 0; y < a.Height; y++)
+        {
+            const uint8_t* rowA = a.Row(y);
+            const uint8_t* rowB = b.Row(y);
+            for (size_t i = 0; i < static_cast<size_t>(a.Width) * BytesPerPixel; i++)
+            {
+                const int difference = std::abs(rowA[i] - rowB[i]);
+                largest = std::max(largest, difference);
+                sum += difference;
+            }
+        }
+        return { largest, static_cast<double>(sum) / (static_cast<double>(a.Width) * a.Height * BytesPerPixel) };
+    }
+
+    WorkingFormat ParseFormat(std::string const& name)
+    {
+        for (auto format : { WorkingFormat::Bgra8, WorkingFormat::Float32, WorkingFormat::Float16 })
+        {
+            if (name == WorkingFormatName(format))
+            {
+                return format;
+            }
+        }
+        throw std::invalid_argument("unknown format " + name);
+    }
+
+    template <typename T>
+    std::vector<T> ParseList(const char* text)
+    {
+        std::vector<T> values;
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            values.push_back(static_cast<T>(std::stod(item)));
+        }
+        return values;
+    }
+
+    std::vector<unsigned> DefaultThreadCounts()
+    {
+        const unsigned hardware = std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<unsigned> counts;
+        for (unsigned count = 1; count < hardware; count *= 2)
+        {
+            counts.push_back(count);
+        }
+        counts.push_back(hardware);
+        return counts;
+    }
+
+    Settings ParseArguments(int argc, char** argv)
+    {
+        Settings settings;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string argument = argv[i];
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("missing value for " + argument);
+            }
+
+            const char* value = argv[++i];
+            if (argument == "--sizes")
+            {
+                settings.Megapixels = ParseList<double>(value);
+            }
+            else if (argument == "--threads")
+            {
+                settings.Threads = ParseList<unsigned>(value);
+            }
+            else if (argument == "--iterations")
+            {
+                settings.Iterations = std::max(1u, static_cast<unsigned>(std::stoul(value)));
+            }
+            else if (argument == "--filter")
+            {
+                settings.Filter = value;
+            }
+            else if (argument == "--lut")
+            {
+                settings.ColorLutSize = static_cast<uint32_t>(std::stoul(value));
+            }
+            else if (argument == "--formats")
+            {
+                settings.Formats.clear();
+                std::stringstream stream(value);
+                std::string item;
+                while (std::getline(stream, item, ','))
+                {
+                    settings.Formats.push_back(ParseFormat(item));
+                }
+            }
+            else if (argument == "--linear")
+            {
+                settings.LinearLight = std::stoul(value) != 0;
+            }
+            else
+            {
+                throw std::invalid_argument("unknown argument " + argument);
+            }
+        }
+
+        if (settings.Threads.empty())
+        {
+            settings.Threads = DefaultThreadCounts();
+        }
+        return settings;
+    }
+
+    // Returns the median of the render times in milliseconds, and their minimum.
+    std::pair<double, double> TimeRenders(Renderer& renderer, Pipeline& pipeline, EffectParameters const& params,
+        ConstImageView src, ImageView dst, unsigned iterations)
+    {
+        // The first render builds the point programs and any LUTs.
+        renderer.Render(pipeline, params, src, dst);
+
+        std::vector<double> times;
+        for (unsigned i = 0; i < iterations; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            renderer.Render(pipeline, params, src, dst);
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        return { times[times.size() / 2], times.front() };
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Settings settings;
+    try
+    {
+        settings = ParseArguments(argc, argv);
+    }
+    catch (std::exception const& e)
+    {
+        std::fprintf(stderr, "PhotoEngineBenchmarks: %s\n", e.what());
+        return 2;
+    }
+
+    const auto params = PresetParameters();
+    const auto cases = BenchmarkCases();
+    const char* simd = SimdLevelName(BestSimdLevel());
+    const unsigned hardwareThreads = std::thread::hardware_concurrency();
+
+    PipelineOptions options;
+    options.ColorLutSize = settings.ColorLutSize;
+    options.LinearLight = settings.LinearLight;
+
+    for (auto megapixels : settings.Megapixels)
+    {
+        // 4:3 images, the aspect ratio of most camera sensors.
+        const auto width = static_cast<uint32_t>(std::lround(std::sqrt(megapixels * 1e6 * 4 / 3)));
+        const auto height = std::max(1u, width * 3 / 4);
+        const double pixels = static_cast<double>(width) * height;
+        const auto source = MakeSourceImage(width, height);
+        Image destination(width, height);
+        Image reference(width, height);
+
+        // Single-thread throughput per case and format, for the scaling efficiency.
+        std::map<std::string, double> baseline;
+
+        for (auto threads : settings.Threads)
+        {
+            ThreadPool pool(threads);
+            Renderer renderer(pool);
+
+            for (auto&& benchmark : cases)
+            {
+                if (benchmark.Name.find(settings.Filter) == std::string::npos)
+                {
+                    continue;
+                }
+
+                // The float32 reference for the error of the other formats.
+                auto referenceOptions = options;
+                referenceOptions.Format = WorkingFormat::Float32;
+                Pipeline referencePipeline(benchmark.Chain, referenceOptions);
+                renderer.Render(referencePipeline, params, source.View(), reference.View());
+
+                for (auto format : settings.Formats)
+                {
+                    const std::string key = benchmark.Name + "/" + WorkingFormatName(format);
+                    std::fprintf(stderr, "%s %s %ux%u %u threads\n", benchmark.Name.c_str(), WorkingFormatName(format), width, height, threads);
+
+                    auto formatOptions = options;
+                    formatOptions.Format = format;
+                    Pipeline pipeline(benchmark.Chain, formatOptions);
+                    const auto [medianMs, minMs] = TimeRenders(renderer, pipeline, params, source.View(), destination.View(), settings.Iterations);
+                    const double megapixelsPerSecond = pixels / 1e6 / (medianMs / 1e3);
+                    const double bytesPerPixel = BytesMovedPerPixel(pipeline);
+                    const auto [maxError, meanError] = ImageError(destination.View(), reference.View());
+
+                    if (threads == 1)
+                    {
+                        baseline[key] = megapixelsPerSecond;
+                    }
+                    const auto single = baseline.find(key);
+                    const double efficiency = single == baseline.end() ? -1 : megapixelsPerSecond / (single->second * threads);
+
+                    std::printf("{\"case\":\"%s\",\"stages\":\"%s\",\"format\":\"%s\",\"linear_light\":%s,"
+                        "\"megapixels\":%.2f,\"width\":%u,\"height\":%u,"
+                        "\"threads\":%u,\"hardware_threads\":%u,\"simd\":\"%s\",\"color_lut\":%u,\"iterations\":%u,"
+                        "\"median_ms\":%.3f,\"min_ms\":%.3f,\"megapixels_per_second\":%.2f,\"bytes_per_pixel\":%.1f,"
+                        "\"gigabytes_per_second\":%.3f,\"scaling_efficiency\":%.3f,\"max_error\":%d,\"mean_error\":%.4f}\n",
+                        benchmark.Name.c_str(), pipeline.Describe().c_str(), WorkingFormatName(format), settings.LinearLight ? "true" : "false",
+                        pixels / 1e6, width, height,
+                        threads, hardwareThreads, simd, settings.ColorLutSize, settings.Iterations,
+                        medianMs, minMs, megapixelsPerSecond, bytesPerPixel,
+                        megapixelsPerSecond * bytesPerPixel / 1e3, efficiency, maxError, meanError);
+                    std::fflush(stdout);
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,372 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "BufferPool.h"
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Buffers at least this large are mapped from the system rather than taken from
+        // the heap.
+        constexpr size_t MappedBytes = size_t{ 256 } << 10;
+
+        constexpr size_t HugePageBytes = size_t{ 2 } << 20;
+
+        // The smallest size class.
+        constexpr size_t MinClassBytes = 4096;
+
+        size_t RoundUp(size_t value, size_t multiple)
+        {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+        int HighestBit(size_t value)
+        {
+            int bit = -1;
+            while (value != 0)
+            {
+                value >>= 1;
+                bit++;
+            }
+            return bit;
+        }
+
+        // The process-wide pool, created on first use with the options given so far.
+        struct ProcessPool
+        {
+            std::mutex Mutex;
+            BufferPoolOptions Options;
+            std::atomic<BufferPool*> Pool{ nullptr };
+        };
+
+        ProcessPool& GetProcessPool()
+        {
+            static ProcessPool* process = new ProcessPool();
+            return *process;
+        }
+    }
+
+    BufferPool::BufferPool(BufferPoolOptions const& options) :
+        m_options(options)
+    {
+    }
+
+    BufferPool::~BufferPool()
+    {
+        Trim();
+    }
+
+    BufferPool::Buffer BufferPool::Acquire(size_t bytes)
+    {
+        if (bytes == 0)
+        {
+            return {};
+        }
+
+        const uint32_t sizeClass = SizeClass(bytes);
+        auto& ownCache = CacheOfThisThread();
+        uint8_t* data = TakeFromCache(ownCache, sizeClass);
+
+        if (!data)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (sizeClass < m_freeLists.size() && !m_freeLists[sizeClass].empty())
+            {
+                data = m_freeLists[sizeClass].back();
+                m_freeLists[sizeClass].pop_back();
+            }
+        }
+
+        // Before going to the system, take one from another thread's cache.
+        for (size_t i = 0; !data && i < m_threadCaches.size(); i++)
+        {
+            if (&m_threadCaches[i] != &ownCache)
+            {
+                data = TakeFromCache(m_threadCaches[i], sizeClass);
+            }
+        }
+
+        if (data)
+        {
+            m_reuses++;
+            m_bytesCached -= SizeOfClass(sizeClass);
+        }
+        else
+        {
+            data = Allocate(sizeClass);
+            m_allocations++;
+        }
+
+        AddInUse(bytes);
+        return Buffer(this, data, bytes, sizeClass);
+    }
+
+    uint8_t* BufferPool::TakeFromCache(ThreadCache& cache, uint32_t sizeClass)
+    {
+        std::lock_guard<std::mutex> lock(cache.Mutex);
+        auto found = std::find_if(cache.Buffers.rbegin(), cache.Buffers.rend(), [&](auto&& buffer) { return buffer.first == sizeClass; });
+        if (found == cache.Buffers.rend())
+        {
+            return nullptr;
+        }
+
+        uint8_t* data = found->second;
+        cache.Buffers.erase(std::next(found).base());
+        return data;
+    }
+
+    void BufferPool::Release(uint8_t* data, size_t size, uint32_t sizeClass)
+    {
+        m_bytesInUse -= size;
+
+        const size_t classBytes = SizeOfClass(sizeClass);
+        if (m_bytesCached + classBytes > m_options.MaxCachedBytes)
+        {
+            Free(data, sizeClass);
+            return;
+        }
+        m_bytesCached += classBytes;
+
+        // The thread's cache keeps its most recent buffers; the oldest moves on to the
+        // shared free lists.
+        std::pair<uint32_t, uint8_t*> evicted{ 0, nullptr };
+        {
+            auto& cache = CacheOfThisThread();
+            std::lock_guard<std::mutex> lock(cache.Mutex);
+            if (cache.Buffers.size() == ThreadCacheCapacity)
+            {
+                evicted = cache.Buffers.front();
+                cache.Buffers.erase(cache.Buffers.begin());
+            }
+            cache.Buffers.emplace_back(sizeClass, data);
+        }
+
+        if (evicted.second)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (evicted.first >= m_freeLists.size())
+            {
+                m_freeLists.resize(evicted.first + 1);
+            }
+            m_freeLists[evicted.first].push_back(evicted.second);
+        }
+    }
+
+    void BufferPool::Trim()
+    {
+        for (auto& cache : m_threadCaches)
+        {
+            std::lock_guard<std::mutex> lock(cache.Mutex);
+            for (auto&& [sizeClass, data] : cache.Buffers)
+            {
+                m_bytesCached -= SizeOfClass(sizeClass);
+                Free(data, sizeClass);
+            }
+            cache.Buffers.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (uint32_t sizeClass = 0; sizeClass < m_freeLists.size(); sizeClass++)
+        {
+            for (auto data : m_freeLists[sizeClass])
+            {
+                m_bytesCached -= SizeOfClass(sizeClass);
+                Free(data, sizeClass);
+            }
+            m_freeLists[sizeClass].clear();
+        }
+    }
+
+    BufferPoolStatistics BufferPool::Statistics() const
+    {
+        BufferPoolStatistics statistics;
+        statistics.Allocations = m_allocations;
+        statistics.Reuses = m_reuses;
+        statistics.BytesInUse = m_bytesInUse;
+        statistics.PeakBytesInUse = m_peakBytesInUse;
+        statistics.BytesCached = m_bytesCached;
+        return statistics;
+    }
+
+    size_t BufferPool::ClassBytes(size_t bytes)
+    {
+        return bytes == 0 ? 0 : SizeOfClass(SizeClass(bytes));
+    }
+
+    // Class c holds (4 + c % 4) << (c / 4 + 10) bytes: 4 KB, 5 KB, 6 KB, 7 KB, 8 KB,
+    // 10 KB, and so on, so at most a quarter of a buffer is rounding.
+    uint32_t BufferPool::SizeClass(size_t bytes)
+    {
+        if (bytes <= MinClassBytes)
+        {
+            return 0;
+        }
+
+        const int shift = HighestBit(bytes - 1) - 2;
+        const size_t mantissa = (bytes - 1) >> shift;
+        auto sizeClass = static_cast<uint32_t>((shift - 10) * 4 + static_cast<int>(mantissa) - 4);
+        return SizeOfClass(sizeClass) < bytes ? sizeClass + 1 : sizeClass;
+    }
+
+    size_t BufferPool::SizeOfClass(uint32_t sizeClass)
+    {
+        return (4 + size_t{ sizeClass % 4 }) << (sizeClass / 4 + 10);
+    }
+
+    BufferPool::ThreadCache& BufferPool::CacheOfThisThread()
+    {
+        static thread_local const size_t slot = std::hash<std::thread::id>()(std::this_thread::get_id()) % ThreadCacheCount;
+        return m_threadCaches[slot];
+    }
+
+    uint8_t* BufferPool::Allocate(uint32_t sizeClass)
+    {
+        const size_t bytes = SizeOfClass(sizeClass);
+        if (bytes < MappedBytes)
+        {
+            return static_cast<uint8_t*>(::operator new(bytes, std::align_val_t(Alignment)));
+        }
+
+        const bool huge = m_options.HugePages && bytes >= HugePageBytes;
+#if defined(_WIN32)
+        if (huge)
+        {
+            // Large pages need the lock pages privilege, which most accounts lack.
+            const size_t largePage = GetLargePageMinimum();
+            if (largePage != 0)
+            {
+                if (void* data = VirtualAlloc(nullptr, RoundUp(bytes, largePage), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE))
+                {
+                    return static_cast<uint8_t*>(data);
+                }
+            }
+        }
+
+        void* data = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!data)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<uint8_t*>(data);
+#else
+        if (huge)
+        {
+            // Map a huge page more than needed and cut the ends off, so the buffer starts
+            // on a huge page boundary.
+            const size_t length = RoundUp(bytes, HugePageBytes);
+            void* mapping = mmap(nullptr, length + HugePageBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED)
+            {
+                throw std::bad_alloc();
+            }
+
+            auto start = reinterpret_cast<uintptr_t>(mapping);
+            const uintptr_t aligned = RoundUp(start, HugePageBytes);
+            if (aligned != start)
+            {
+                munmap(mapping, aligned - start);
+            }
+            munmap(reinterpret_cast<void*>(aligned + length), start + HugePageBytes - aligned);
+#ifdef MADV_HUGEPAGE
+            madvise(reinterpret_cast<void*>(aligned), length, MADV_HUGEPAGE);
+#endif
+            return reinterpret_cast<uint8_t*>(aligned);
+        }
+
+        void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<uint8_t*>(data);
+#endif
+    }
+
+    void BufferPool::Free(uint8_t* data, uint32_t sizeClass)
+    {
+        const size_t bytes = SizeOfClass(sizeClass);
+        if (bytes < MappedBytes)
+        {
+            ::operator delete(data, std::align_val_t(Alignment));
+            return;
+        }
+
+#if defined(_WIN32)
+        VirtualFree(data, 0, MEM_RELEASE);
+#else
+        const bool huge = m_options.HugePages && bytes >= HugePageBytes;
+        munmap(data, huge ? RoundUp(bytes, HugePageBytes) : bytes);
+#endif
+    }
+
+    void BufferPool::AddInUse(size_t bytes)
+    {
+        const size_t inUse = m_bytesInUse += bytes;
+        size_t peak = m_peakBytesInUse;
+        while (inUse > peak && !m_peakBytesInUse.compare_exchange_weak(peak, inUse))
+        {
+        }
+    }
+
+    BufferPool& GetBufferPool()
+    {
+        auto& process = GetProcessPool();
+        if (auto pool = process.Pool.load(std::memory_order_acquire))
+        {
+            return *pool;
+        }
+
+        std::lock_guard<std::mutex> lock(process.Mutex);
+        if (!process.Pool.load(std::memory_order_relaxed))
+        {
+            process.Pool.store(new BufferPool(process.Options), std::memory_order_release);
+        }
+        return *process.Pool.load(std::memory_order_relaxed);
+    }
+
+    void ConfigureBufferPool(BufferPoolOptions const& options)
+    {
+        auto& process = GetProcessPool();
+        std::lock_guard<std::mutex> lock(process.Mutex);
+        if (process.Pool.load(std::memory_order_relaxed))
+        {
+            throw std::logic_error("the buffer pool is already in use");
+        }
+        process.Options = options;
+    }
+}
@@ -0,0 +1,224 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace PhotoEngine
+{
+    struct BufferPoolOptions
+    {
+        // Back buffers of 2 MB and more with huge pages where the system allows it, which
+        // saves TLB misses when a pass walks a full-frame image. Falls back to normal
+        // pages silently.
+        bool HugePages{ false };
+
+        // Most bytes kept in free buffers; a buffer released beyond this is freed.
+        size_t MaxCachedBytes{ size_t{ 512 } << 20 };
+    };
+
+    struct BufferPoolStatistics
+    {
+        // Acquire calls that took new memory from the system.
+        size_t Allocations{ 0 };
+
+        // Acquire calls served with a released buffer.
+        size_t Reuses{ 0 };
+
+        // Bytes of the buffers handed out and not yet released, and the most there were
+        // at once.
+        size_t BytesInUse{ 0 };
+        size_t PeakBytesInUse{ 0 };
+
+        // Bytes of released buffers kept for reuse.
+        size_t BytesCached{ 0 };
+
+        double ReuseRate() const
+        {
+            const size_t acquired = Allocations + Reuses;
+            return acquired == 0 ? 0.0 : static_cast<double>(Reuses) / acquired;
+        }
+    };
+
+    // Recycles large, 64-byte aligned pixel buffers, so rendering the same chain again,
+    // as every slider move does, takes its intermediates from the pool instead of the
+    // system.
+    //
+    // Sizes are rounded up to size classes, four per power of two. Buffers of 256 KB
+    // and more are mapped straight from the system, so the rounding costs address space
+    // but not memory: pages past the size asked for are never touched. A released
+    // buffer goes to a small cache owned by the releasing thread's slot, where the same
+    // thread finds it again without contention, and from there to a shared free list.
+    //
+    // All methods may be called from any thread. Buffers must be released before their
+    // pool is destroyed.
+    class BufferPool
+    {
+    public:
+        static constexpr size_t Alignment = 64;
+
+        // A buffer from a BufferPool, returned to it when destroyed.
+        class Buffer
+        {
+        public:
+            Buffer() = default;
+
+            ~Buffer()
+            {
+                Reset();
+            }
+
+            Buffer(Buffer&& other) noexcept :
+                m_pool(std::exchange(other.m_pool, nullptr)),
+                m_data(std::exchange(other.m_data, nullptr)),
+                m_size(std::exchange(other.m_size, 0)),
+                m_sizeClass(other.m_sizeClass)
+            {
+            }
+
+            Buffer& operator=(Buffer&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    Reset();
+                    m_pool = std::exchange(other.m_pool, nullptr);
+                    m_data = std::exchange(other.m_data, nullptr);
+                    m_size = std::exchange(other.m_size, 0);
+                    m_sizeClass = other.m_sizeClass;
+                }
+                return *this;
+            }
+
+            Buffer(Buffer const&) = delete;
+            Buffer& operator=(Buffer const&) = delete;
+
+            uint8_t* Data() const
+            {
+                return m_data;
+            }
+
+            // The size asked for; the buffer may be larger.
+            size_t Size() const
+            {
+                return m_size;
+            }
+
+            // Returns the buffer to its pool.
+            void Reset()
+            {
+                if (m_data)
+                {
+                    m_pool->Release(m_data, m_size, m_sizeClass);
+                }
+                m_pool = nullptr;
+                m_data = nullptr;
+                m_size = 0;
+            }
+
+        private:
+            friend class BufferPool;
+
+            Buffer(BufferPool* pool, uint8_t* data, size_t size, uint32_t sizeClass) :
+                m_pool(pool),
+                m_data(data),
+                m_size(size),
+                m_sizeClass(sizeClass)
+            {
+            }
+
+            BufferPool* m_pool{ nullptr };
+            uint8_t* m_data{ nullptr };
+            size_t m_size{ 0 };
+            uint32_t m_sizeClass{ 0 };
+        };
+
+        explicit BufferPool(BufferPoolOptions const& options = {});
+        ~BufferPool();
+
+        BufferPool(BufferPool const&) = delete;
+        BufferPool& operator=(BufferPool const&) = delete;
+
+        // Returns a buffer of at least bytes bytes, aligned to Alignment. Its contents
+        // are undefined. Throws std::bad_alloc if the system is out of memory. Zero bytes
+        // returns an empty buffer.
+        Buffer Acquire(size_t bytes);
+
+        // Frees every cached buffer.
+        void Trim();
+
+        BufferPoolStatistics Statistics() const;
+
+        // Returns the number of bytes reserved for a buffer of bytes bytes.
+        static size_t ClassBytes(size_t bytes);
+
+    private:
+        // Slots of the per-thread caches; threads are spread over them by id.
+        static constexpr size_t ThreadCacheCount = 16;
+        static constexpr size_t ThreadCacheCapacity = 4;
+
+        struct ThreadCache
+        {
+            std::mutex Mutex;
+            std::vector<std::pair<uint32_t, uint8_t*>> Buffers;
+        };
+
+        static uint32_t SizeClass(size_t bytes);
+        static size_t SizeOfClass(uint32_t sizeClass);
+
+        ThreadCache& CacheOfThisThread();
+        static uint8_t* TakeFromCache(ThreadCache& cache, uint32_t sizeClass);
+        uint8_t* Allocate(uint32_t sizeClass);
+        void Free(uint8_t* data, uint32_t sizeClass);
+        void Release(uint8_t* data, size_t size, uint32_t sizeClass);
+        void AddInUse(size_t bytes);
+
+        BufferPoolOptions m_options;
+        std::array<ThreadCache, ThreadCacheCount> m_threadCaches;
+
+        std::mutex m_mutex;
+        std::vector<std::vector<uint8_t*>> m_freeLists;
+
+        std::atomic<size_t> m_allocations{ 0 };
+        std::atomic<size_t> m_reuses{ 0 };
+        std::atomic<size_t> m_bytesInUse{ 0 };
+        std::atomic<size_t> m_peakBytesInUse{ 0 };
+        std::atomic<size_t> m_bytesCached{ 0 };
+    };
+
+    // The process-wide pool that Image, PlanarImage, and the blurs allocate from, with
+    // the options given to ConfigureBufferPool or the defaults. It is never destroyed, so
+    // images in static objects can outlive everything else.
+    BufferPool& GetBufferPool();
+
+    // Sets the options of the process-wide pool. Call it at startup, before anything
+    // allocates an image; throws std::logic_error once the pool exists.
+    void ConfigureBufferPool(BufferPoolOptions const& options);
+}
@@ -0,0 +1,143 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ColorLut.h"
+#include "Image.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // MaxError samples every fifth 8-bit level, 0 through 255.
+        constexpr uint32_t ErrorSampleStep = 5;
+        constexpr uint32_t ErrorSampleCount = 255 / ErrorSampleStep + 1;
+
+        bool IsAlphaIndependent(ColorMatrix const& matrix)
+        {
+            return matrix.M[0][3] == 0 && matrix.M[1][3] == 0 && matrix.M[2][3] == 0 &&
+                matrix.M[3][0] == 0 && matrix.M[3][1] == 0 && matrix.M[3][2] == 0 &&
+                matrix.M[3][3] == 1 && matrix.M[3][4] == 0;
+        }
+    }
+
+    ColorLut::ColorLut(uint32_t size, PointOp const* ops, size_t opCount, PixelKernels const& kernels) :
+        m_size(size),
+        m_ops(ops, ops + opCount)
+    {
+        if (size < 2 || size > 256)
+        {
+            throw std::invalid_argument("ColorLut: size must be between 2 and 256");
+        }
+        if (opCount > MaxPointOps || !CanBake(ops, opCount))
+        {
+            throw std::invalid_argument("ColorLut: the point program cannot be baked");
+        }
+
+        // Run the program over one R slice of the lattice at a time.
+        const size_t sliceNodes = static_cast<size_t>(size) * size;
+        const float step = 1.0f / (size - 1);
+        std::vector<float> slice(sliceNodes * 4);
+        m_table.resize(NodeCount() * 3);
+
+        for (uint32_t r = 0; r < size; r++)
+        {
+            float* node = slice.data();
+            for (uint32_t g = 0; g < size; g++)
+            {
+                for (uint32_t b = 0; b < size; b++, node += 4)
+                {
+                    node[0] = b * step;
+                    node[1] = g * step;
+                    node[2] = r * step;
+                    node[3] = 1.0f;
+                }
+            }
+
+            kernels.PointProgramFloat(m_ops.data(), m_ops.size(), slice.data(), slice.data(), sliceNodes);
+
+            float* out = m_table.data() + r * sliceNodes * 3;
+            for (size_t i = 0; i < sliceNodes; i++)
+            {
+                out[i * 3 + 0] = slice[i * 4 + 0];
+                out[i * 3 + 1] = slice[i * 4 + 1];
+                out[i * 3 + 2] = slice[i * 4 + 2];
+            }
+        }
+    }
+
+    bool ColorLut::CanBake(PointOp const* ops, size_t opCount)
+    {
+        return std::all_of(ops, ops + opCount, [](PointOp const& op)
+        {
+            return op.Type == PointOpType::Contrast || IsAlphaIndependent(op.Matrix);
+        });
+    }
+
+    void ColorLut::Apply(PixelKernels const& kernels, const uint8_t* src, uint8_t* dst, size_t count) const
+    {
+        kernels.ColorLutBgra8(m_table.data(), m_size, src, dst, count);
+    }
+
+    int ColorLut::MaxError(PixelKernels const& kernels) const
+    {
+        if (m_table.empty())
+        {
+            return 0;
+        }
+
+        // One B x G plane of samples per R value.
+        constexpr size_t planePixels = ErrorSampleCount * ErrorSampleCount;
+        std::vector<uint8_t> input(planePixels * BytesPerPixel);
+        std::vector<uint8_t> direct(input.size());
+        std::vector<uint8_t> lookedUp(input.size());
+
+        int error = 0;
+        for (uint32_t r = 0; r < ErrorSampleCount; r++)
+        {
+            uint8_t* pixel = input.data();
+            for (uint32_t g = 0; g < ErrorSampleCount; g++)
+            {
+                for (uint32_t b = 0; b < ErrorSampleCount; b++, pixel += BytesPerPixel)
+                {
+                    pixel[0] = static_cast<uint8_t>(b * ErrorSampleStep);
+                    pixel[1] = static_cast<uint8_t>(g * ErrorSampleStep);
+                    pixel[2] = static_cast<uint8_t>(r * ErrorSampleStep);
+                    pixel[3] = 255;
+                }
+            }
+
+            kernels.PointProgramBgra8(m_ops.data(), m_ops.size(), input.data(), direct.data(), planePixels);
+            Apply(kernels, input.data(), lookedUp.data(), planePixels);
+
+            for (size_t i = 0; i < input.size(); i++)
+            {
+                error = std::max(error, std::abs(direct[i] - lookedUp[i]));
+            }
+        }
+        return error;
+    }
+}
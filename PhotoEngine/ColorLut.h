@@ -0,0 +1,90 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "PixelKernels.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PhotoEngine
+{
+    // A point program baked into a 3D lookup table. The table has size^3 lattice nodes
+    // spanning the BGR cube and holds the program's B, G, R output at each node, with B
+    // varying fastest. Pixels are looked up with tetrahedral interpolation between the
+    // four nodes around them, so a program of any length costs the same per pixel.
+    //
+    // Alpha passes through the lookup, so only programs that neither read nor write
+    // alpha can be baked. Every point effect in EffectChain qualifies.
+    class ColorLut
+    {
+    public:
+        // 33 nodes per axis keep the table in L2 (431 KB); 65 halve the node spacing
+        // for programs with strong curves (3.3 MB).
+        static constexpr uint32_t SmallSize = 33;
+        static constexpr uint32_t LargeSize = 65;
+
+        ColorLut() = default;
+
+        // Bakes a point program by running it on every node with the given kernels.
+        // Throws std::invalid_argument if size is not in [2, 256] or CanBake is false.
+        ColorLut(uint32_t size, PointOp const* ops, size_t opCount, PixelKernels const& kernels = GetPixelKernels());
+
+        // Returns true if the program leaves alpha alone and does not read it.
+        static bool CanBake(PointOp const* ops, size_t opCount);
+
+        uint32_t Size() const
+        {
+            return m_size;
+        }
+
+        size_t NodeCount() const
+        {
+            return static_cast<size_t>(m_size) * m_size * m_size;
+        }
+
+        const float* Table() const
+        {
+            return m_table.data();
+        }
+
+        size_t Bytes() const
+        {
+            return m_table.size() * sizeof(float);
+        }
+
+        // Looks up count BGRA8 pixels with the given kernels. src and dst may be the same.
+        void Apply(PixelKernels const& kernels, const uint8_t* src, uint8_t* dst, size_t count) const;
+
+        // Returns the largest channel difference, in 8-bit levels, between the lookup and
+        // direct evaluation of the baked program over a 52^3 grid of BGRA8 colors.
+        int MaxError(PixelKernels const& kernels = GetPixelKernels()) const;
+
+    private:
+        uint32_t m_size{ 0 };
+        std::vector<float> m_table;
+        std::vector<PointOp> m_ops;
+    };
+}
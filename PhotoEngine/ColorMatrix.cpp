@@ -0,0 +1,199 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ColorMatrix.h"
+#include "PointEffects.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Indices of the BGRA channels in a matrix row or column.
+        constexpr int B = 0;
+        constexpr int G = 1;
+        constexpr int R = 2;
+        constexpr int A = 3;
+        constexpr int Offset = 4;
+
+        ColorMatrix Diagonal(float b, float g, float r)
+        {
+            auto matrix = ColorMatrix::Identity();
+            matrix.M[B][B] = b;
+            matrix.M[G][G] = g;
+            matrix.M[R][R] = r;
+            return matrix;
+        }
+
+        // Matrix whose B, G and R outputs all equal the weighted sum of the inputs.
+        ColorMatrix Luminance(float weightR, float weightG, float weightB)
+        {
+            auto matrix = ColorMatrix::Identity();
+            for (int row : { B, G, R })
+            {
+                matrix.M[row][B] = weightB;
+                matrix.M[row][G] = weightG;
+                matrix.M[row][R] = weightR;
+            }
+            return matrix;
+        }
+
+        // Returns (1 - amount) * from + amount * to.
+        ColorMatrix Lerp(ColorMatrix const& from, ColorMatrix const& to, float amount)
+        {
+            ColorMatrix result;
+            for (int row = 0; row < 4; row++)
+            {
+                for (int column = 0; column < 5; column++)
+                {
+                    result.M[row][column] = from.M[row][column] + amount * (to.M[row][column] - from.M[row][column]);
+                }
+            }
+            return result;
+        }
+    }
+
+    ColorMatrix ColorMatrix::Identity()
+    {
+        return { {
+            { 1, 0, 0, 0, 0 },
+            { 0, 1, 0, 0, 0 },
+            { 0, 0, 1, 0, 0 },
+            { 0, 0, 0, 1, 0 } } };
+    }
+
+    bool ColorMatrix::operator==(ColorMatrix const& other) const
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 5; column++)
+            {
+                if (M[row][column] != other.M[row][column])
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    ColorMatrix Concatenate(ColorMatrix const& first, ColorMatrix const& second)
+    {
+        ColorMatrix result;
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 5; column++)
+            {
+                // The offset column of first is carried through second's linear part.
+                float value = column == Offset ? second.M[row][Offset] : 0.0f;
+                for (int k = 0; k < 4; k++)
+                {
+                    value += second.M[row][k] * first.M[k][column];
+                }
+                result.M[row][column] = value;
+            }
+        }
+        return result;
+    }
+
+    bool IsLinearEffect(EffectKind kind)
+    {
+        return IsPointEffect(kind) && kind != EffectKind::Contrast;
+    }
+
+    ColorMatrix EffectMatrix(EffectKind kind, EffectParameters const& params)
+    {
+        switch (kind)
+        {
+        case EffectKind::Exposure:
+            return ExposureMatrix(params.Exposure);
+        case EffectKind::TemperatureAndTint:
+            return TemperatureAndTintMatrix(params.Temperature, params.Tint);
+        case EffectKind::Saturation:
+            return SaturationMatrix(params.Saturation);
+        case EffectKind::Sepia:
+            return SepiaMatrix(params.Intensity);
+        case EffectKind::Grayscale:
+            return GrayscaleMatrix();
+        case EffectKind::Invert:
+            return InvertMatrix();
+        case EffectKind::Contrast:
+        case EffectKind::GaussianBlur:
+            break;
+        }
+        throw std::invalid_argument("EffectMatrix: not a linear effect");
+    }
+
+    ColorMatrix ExposureMatrix(float exposure)
+    {
+        const float gain = std::exp2(exposure);
+        return Diagonal(gain, gain, gain);
+    }
+
+    ColorMatrix TemperatureAndTintMatrix(float temperature, float tint)
+    {
+        return Diagonal(
+            1.0f - TemperatureTintStrength * temperature,
+            1.0f + TemperatureTintStrength * tint,
+            1.0f + TemperatureTintStrength * temperature);
+    }
+
+    ColorMatrix SaturationMatrix(float saturation)
+    {
+        return Lerp(Luminance(SaturationLumaR, SaturationLumaG, SaturationLumaB), ColorMatrix::Identity(), saturation);
+    }
+
+    ColorMatrix SepiaMatrix(float intensity)
+    {
+        auto sepia = ColorMatrix::Identity();
+        const float weights[3][3] = {
+            { 0.131f, 0.534f, 0.272f },
+            { 0.168f, 0.686f, 0.349f },
+            { 0.189f, 0.769f, 0.393f } };
+
+        for (int row : { B, G, R })
+        {
+            for (int column : { B, G, R })
+            {
+                sepia.M[row][column] = weights[row][column];
+            }
+        }
+        return Lerp(ColorMatrix::Identity(), sepia, intensity);
+    }
+
+    ColorMatrix GrayscaleMatrix()
+    {
+        return Luminance(GrayscaleLumaR, GrayscaleLumaG, GrayscaleLumaB);
+    }
+
+    ColorMatrix InvertMatrix()
+    {
+        auto matrix = Diagonal(-1, -1, -1);
+        matrix.M[B][Offset] = 1;
+        matrix.M[G][Offset] = 1;
+        matrix.M[R][Offset] = 1;
+        return matrix;
+    }
+}
@@ -0,0 +1,59 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "EffectChain.h"
+#include "EffectParameters.h"
+
+namespace PhotoEngine
+{
+    // Affine color transform in BGRA order, like the 5x4 matrix of Win2D's
+    // ColorMatrixEffect: out[i] = M[i][0] * B + M[i][1] * G + M[i][2] * R + M[i][3] * A + M[i][4].
+    struct ColorMatrix
+    {
+        float M[4][5];
+
+        static ColorMatrix Identity();
+
+        bool operator==(ColorMatrix const& other) const;
+    };
+
+    // Returns the matrix that applies first and then second.
+    ColorMatrix Concatenate(ColorMatrix const& first, ColorMatrix const& second);
+
+    // Returns true if the point effect is an affine color transform. Every point
+    // effect except contrast is.
+    bool IsLinearEffect(EffectKind kind);
+
+    // Returns the matrix of a linear effect for the given parameter values.
+    ColorMatrix EffectMatrix(EffectKind kind, EffectParameters const& params);
+
+    ColorMatrix ExposureMatrix(float exposure);
+    ColorMatrix TemperatureAndTintMatrix(float temperature, float tint);
+    ColorMatrix SaturationMatrix(float saturation);
+    ColorMatrix SepiaMatrix(float intensity);
+    ColorMatrix GrayscaleMatrix();
+    ColorMatrix InvertMatrix();
+}
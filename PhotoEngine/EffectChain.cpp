@@ -0,0 +1,122 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "EffectChain.h"
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    bool IsPointEffect(EffectKind kind)
+    {
+        return kind != EffectKind::GaussianBlur;
+    }
+
+    const char* EffectName(EffectKind kind)
+    {
+        switch (kind)
+        {
+        case EffectKind::Contrast:
+            return "ContrastEffect";
+        case EffectKind::Exposure:
+            return "ExposureEffect";
+        case EffectKind::TemperatureAndTint:
+            return "TemperatureAndTintEffect";
+        case EffectKind::GaussianBlur:
+            return "BlurEffect";
+        case EffectKind::Saturation:
+            return "SaturationEffect";
+        case EffectKind::Sepia:
+            return "SepiaEffect";
+        case EffectKind::Grayscale:
+            return "GrayscaleEffect";
+        case EffectKind::Invert:
+            return "InvertEffect";
+        }
+        return "";
+    }
+
+    bool EffectParametersChanged(EffectKind kind, EffectParameters const& before, EffectParameters const& after)
+    {
+        switch (kind)
+        {
+        case EffectKind::Contrast:
+            return before.Contrast != after.Contrast;
+        case EffectKind::Exposure:
+            return before.Exposure != after.Exposure;
+        case EffectKind::TemperatureAndTint:
+            return before.Temperature != after.Temperature || before.Tint != after.Tint;
+        case EffectKind::GaussianBlur:
+            return before.BlurAmount != after.BlurAmount;
+        case EffectKind::Saturation:
+            return before.Saturation != after.Saturation;
+        case EffectKind::Sepia:
+            return before.Intensity != after.Intensity;
+        case EffectKind::Grayscale:
+        case EffectKind::Invert:
+            return false;
+        }
+        return true;
+    }
+
+    EffectChain EffectChain::FromSelection(std::vector<std::string> const& tags)
+    {
+        EffectChain chain;
+
+        for (auto&& tag : tags)
+        {
+            if (tag == "sepia")
+            {
+                chain.Append(EffectKind::Sepia);
+            }
+            else if (tag == "invert")
+            {
+                chain.Append(EffectKind::Invert);
+            }
+            else if (tag == "grayscale")
+            {
+                chain.Append(EffectKind::Grayscale);
+            }
+            else if (tag == "blur")
+            {
+                chain.Append(EffectKind::GaussianBlur);
+            }
+            else if (tag == "color")
+            {
+                chain.Append(EffectKind::TemperatureAndTint);
+                chain.Append(EffectKind::Saturation);
+            }
+            else if (tag == "light")
+            {
+                chain.Append(EffectKind::Contrast);
+                chain.Append(EffectKind::Exposure);
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown effect tag: " + tag);
+            }
+        }
+
+        return chain;
+    }
+}
@@ -0,0 +1,106 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "EffectParameters.h"
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace PhotoEngine
+{
+    // The effects DetailPage can place in its effects graph.
+    enum class EffectKind : uint8_t
+    {
+        Contrast,
+        Exposure,
+        TemperatureAndTint,
+        GaussianBlur,
+        Saturation,
+        Sepia,
+        Grayscale,
+        Invert
+    };
+
+    // Returns true if the effect maps each pixel independently of its neighbors.
+    bool IsPointEffect(EffectKind kind);
+
+    // Returns the effect name used for animatable properties, e.g. "SepiaEffect".
+    const char* EffectName(EffectKind kind);
+
+    // Returns true if any parameter the effect reads differs between before and after.
+    bool EffectParametersChanged(EffectKind kind, EffectParameters const& before, EffectParameters const& after);
+
+    // Ordered list of effects, equivalent to DetailPage's m_effectsList without
+    // the trailing CompositeEffect.
+    class EffectChain
+    {
+    public:
+        EffectChain() = default;
+
+        EffectChain(std::initializer_list<EffectKind> effects) :
+            m_effects(effects)
+        {
+        }
+
+        // Builds the chain for the effect preview tags ("sepia", "invert", "grayscale",
+        // "blur", "color", "light") in the same order as DetailPage::PrepareSelectedEffects.
+        static EffectChain FromSelection(std::vector<std::string> const& tags);
+
+        void Append(EffectKind kind)
+        {
+            m_effects.push_back(kind);
+        }
+
+        std::vector<EffectKind> const& Effects() const
+        {
+            return m_effects;
+        }
+
+        size_t Size() const
+        {
+            return m_effects.size();
+        }
+
+        bool Empty() const
+        {
+            return m_effects.empty();
+        }
+
+        bool operator==(EffectChain const& other) const
+        {
+            return m_effects == other.m_effects;
+        }
+
+        bool operator!=(EffectChain const& other) const
+        {
+            return m_effects != other.m_effects;
+        }
+
+    private:
+        std::vector<EffectKind> m_effects;
+    };
+}
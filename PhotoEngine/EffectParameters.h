@@ -0,0 +1,68 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+namespace PhotoEngine
+{
+    // The effect values edited on DetailPage. Field names and defaults match the
+    // Photo runtime class so a Photo can be copied across one property at a time.
+    struct EffectParameters
+    {
+        // Exposure for light effect, in stops (-2 to 2).
+        float Exposure{ 0 };
+
+        // Temperature and tint for color effect (-1 to 1).
+        float Temperature{ 0 };
+        float Tint{ 0 };
+
+        // Contrast for light effect (-1 to 1).
+        float Contrast{ 0 };
+
+        // Saturation for color effect (0 to 1).
+        float Saturation{ 1 };
+
+        // Standard deviation of the Gaussian blur, in pixels.
+        float BlurAmount{ 0 };
+
+        // Intensity for sepia effect (0 to 1).
+        float Intensity{ .5f };
+
+        bool operator==(EffectParameters const& other) const
+        {
+            return Exposure == other.Exposure &&
+                Temperature == other.Temperature &&
+                Tint == other.Tint &&
+                Contrast == other.Contrast &&
+                Saturation == other.Saturation &&
+                BlurAmount == other.BlurAmount &&
+                Intensity == other.Intensity;
+        }
+
+        bool operator!=(EffectParameters const& other) const
+        {
+            return !(*this == other);
+        }
+    };
+}
@@ -0,0 +1,154 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "Exporter.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <memory>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        struct Tile
+        {
+            // Output rows [Top, Top + Rows) are rendered from input rows starting at InputTop.
+            uint32_t Top{ 0 };
+            uint32_t Rows{ 0 };
+            uint32_t InputTop{ 0 };
+
+            Image Input;
+            Image Output;
+            std::future<void> Rendered;
+
+            size_t Bytes() const
+            {
+                return Input.Stride() * Input.Height() + Output.Stride() * Output.Height();
+            }
+        };
+    }
+
+    void Exporter::Export(EffectChain const& chain, EffectParameters const& params, RowReader& source, RowWriter& destination)
+    {
+        const uint32_t width = source.Width();
+        const uint32_t height = source.Height();
+        Pipeline pipeline(chain, m_options);
+        const uint32_t halo = pipeline.Halo(params);
+        const uint32_t tileHeight = std::max({ m_tileHeight, 2 * halo, 1u });
+        const size_t maxTilesInFlight = std::max(m_maxTilesInFlight, 1u);
+        m_statistics = { 0, tileHeight, halo, 0 };
+
+        // Bake the color LUTs for the whole image up front; the tiles' pipeline copies share them.
+        for (size_t i = 0; i < pipeline.Stages().size(); i++)
+        {
+            pipeline.StageLut(i, params, static_cast<size_t>(width) * height);
+        }
+
+        // Neighboring tiles share 2 * halo input rows; the source is read once, so the
+        // shared rows are kept here for the next tile.
+        Image carry(width, std::min(2 * halo, height));
+        uint32_t carryTop = 0;
+        uint32_t decodedRows = 0;
+
+        std::deque<std::shared_ptr<Tile>> inFlight;
+        size_t tileBytes = 0;
+
+        auto writeOldest = [&]
+        {
+            auto tile = std::move(inFlight.front());
+            inFlight.pop_front();
+            tile->Rendered.get();
+            destination.WriteRows(tile->Output.View().Rows(tile->Top - tile->InputTop, tile->Rows));
+            tileBytes -= tile->Bytes();
+        };
+
+        try
+        {
+            for (uint32_t top = 0; top < height; top += tileHeight)
+            {
+                while (inFlight.size() >= maxTilesInFlight)
+                {
+                    writeOldest();
+                }
+
+                auto tile = std::make_shared<Tile>();
+                tile->Top = top;
+                tile->Rows = std::min(tileHeight, height - top);
+                tile->InputTop = top - std::min(top, halo);
+                const uint32_t inputEnd = top + tile->Rows + std::min(halo, height - top - tile->Rows);
+                tile->Input = Image::Uninitialized(width, inputEnd - tile->InputTop);
+                tile->Output = Image::Uninitialized(width, inputEnd - tile->InputTop);
+
+                const uint32_t carried = decodedRows - tile->InputTop;
+                if (carried > 0)
+                {
+                    CopyPixels(carry.View().Rows(tile->InputTop - carryTop, carried), tile->Input.View().Rows(0, carried));
+                }
+                if (inputEnd > decodedRows)
+                {
+                    source.ReadRows(tile->Input.View().Rows(carried, inputEnd - decodedRows));
+                    decodedRows = inputEnd;
+                }
+
+                // The next tile starts halo rows above its first output row.
+                if (top + tileHeight < height && halo > 0)
+                {
+                    carryTop = top + tileHeight - halo;
+                    CopyPixels(tile->Input.View().Rows(carryTop - tile->InputTop, inputEnd - carryTop), carry.View().Rows(0, inputEnd - carryTop));
+                }
+
+                tileBytes += tile->Bytes();
+                m_statistics.PeakBufferBytes = std::max(m_statistics.PeakBufferBytes, tileBytes + carry.Stride() * carry.Height());
+                m_statistics.Tiles++;
+
+                // Each tile renders on one thread; the pool provides parallelism across tiles.
+                auto render = std::make_shared<std::packaged_task<void()>>([this, tile, pipeline, params]() mutable
+                {
+                    ThreadPool serial(1);
+                    Renderer renderer(serial, m_kernels);
+                    renderer.Render(pipeline, params, tile->Input.View(), tile->Output.View());
+                });
+                tile->Rendered = render->get_future();
+                inFlight.push_back(tile);
+                m_pool.Submit([render] { (*render)(); });
+            }
+
+            while (!inFlight.empty())
+            {
+                writeOldest();
+            }
+        }
+        catch (...)
+        {
+            // Let the tiles still rendering finish before the caller's sink goes away.
+            for (auto&& tile : inFlight)
+            {
+                tile->Rendered.wait();
+            }
+            throw;
+        }
+    }
+}
@@ -0,0 +1,124 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "EffectChain.h"
+#include "EffectParameters.h"
+#include "Pipeline.h"
+#include "PixelKernels.h"
+#include "RowStream.h"
+#include "ThreadPool.h"
+
+namespace PhotoEngine
+{
+    // Counters from the last Exporter::Export call.
+    struct ExportStatistics
+    {
+        uint32_t Tiles{ 0 };
+        uint32_t TileHeight{ 0 };
+
+        // Rows above and below each tile that were decoded and rendered so blurs near
+        // the tile edges see the same neighbors as in a full-frame render.
+        uint32_t HaloRows{ 0 };
+
+        // Largest total size of the tile buffers that were alive at the same time.
+        size_t PeakBufferBytes{ 0 };
+    };
+
+    // Renders an effect chain at full resolution from a row source to a row sink without
+    // holding the whole image, so the memory used depends on the image width and the
+    // tile height but not on the image height.
+    //
+    // The image is cut into tiles of whole rows, since decoders and encoders both work
+    // from top to bottom. The calling thread reads each tile plus the halo its blurs
+    // need, hands it to the thread pool, and writes finished tiles to the sink in
+    // order; decoding, rendering, and encoding of different tiles overlap.
+    class Exporter
+    {
+    public:
+        explicit Exporter(ThreadPool& pool, PixelKernels const& kernels = GetPixelKernels()) :
+            m_pool(pool),
+            m_kernels(kernels),
+            m_maxTilesInFlight(pool.ThreadCount() + 1)
+        {
+        }
+
+        // Gets or sets the number of output rows in a tile. A tile is made at least twice
+        // as tall as the halo the chain needs, so no more than half the rows rendered are
+        // overlap.
+        uint32_t TileHeight() const
+        {
+            return m_tileHeight;
+        }
+
+        void TileHeight(uint32_t value)
+        {
+            m_tileHeight = value;
+        }
+
+        // Gets or sets how many tiles can be in memory at once, counting the ones being
+        // rendered and the ones waiting to be written. Defaults to one per pool thread
+        // plus one.
+        unsigned MaxTilesInFlight() const
+        {
+            return m_maxTilesInFlight;
+        }
+
+        void MaxTilesInFlight(unsigned value)
+        {
+            m_maxTilesInFlight = value;
+        }
+
+        // Gets or sets how the effect chain is compiled.
+        PipelineOptions const& Options() const
+        {
+            return m_options;
+        }
+
+        void Options(PipelineOptions const& value)
+        {
+            m_options = value;
+        }
+
+        // Reads every row of source, renders it through chain, and writes it to destination.
+        // The result matches Renderer::Render on the whole image exactly for point effects
+        // and the direct blur. The recursive blur, which Automatic picks for larger sigma,
+        // is within 1 level of it, since the halo cuts off the filter's infinite response.
+        void Export(EffectChain const& chain, EffectParameters const& params, RowReader& source, RowWriter& destination);
+
+        ExportStatistics const& Statistics() const
+        {
+            return m_statistics;
+        }
+
+    private:
+        ThreadPool& m_pool;
+        PixelKernels const& m_kernels;
+        PipelineOptions m_options;
+        uint32_t m_tileHeight{ 128 };
+        unsigned m_maxTilesInFlight;
+        ExportStatistics m_statistics;
+    };
+}
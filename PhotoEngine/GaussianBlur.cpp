@@ -0,0 +1,719 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "GaussianBlur.h"
+#include "PixelKernels.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Number of rows handed to a thread at a time.
+        constexpr size_t RowsPerBand = 16;
+
+        // Width in pixels of the column strips the vertical pass of the constant-cost
+        // methods works on: 256 samples per strip row.
+        constexpr uint32_t StripWidth = 64;
+
+        // Largest sigma Automatic blurs with the direct kernel. Up to here its 2 * ceil(3 * sigma) + 1
+        // taps per sample are no slower than the forward and backward recursive passes.
+        constexpr float DirectMaxSigma = 2.0f;
+
+        // The recursive filter coefficients are fitted for sigma >= 0.5.
+        constexpr float RecursiveMinSigma = 0.5f;
+
+        template <typename Sample>
+        uint8_t QuantizeSample(Sample value)
+        {
+            return static_cast<uint8_t>(std::clamp(value, Sample(0), Sample(255)) + Sample(0.5));
+        }
+
+        void BlurRow(const uint8_t* in, uint8_t* out, uint32_t width, std::vector<float> const& kernel, std::vector<float>& padded)
+        {
+            const int radius = static_cast<int>(kernel.size()) - 1;
+            const int paddedWidth = static_cast<int>(width) + 2 * radius;
+            padded.resize(static_cast<size_t>(paddedWidth) * BytesPerPixel);
+
+            // Extend the row with copies of its edge pixels.
+            for (int x = 0; x < paddedWidth; x++)
+            {
+                const int source = std::clamp(x - radius, 0, static_cast<int>(width) - 1);
+                for (int c = 0; c < 4; c++)
+                {
+                    padded[x * BytesPerPixel + c] = in[source * BytesPerPixel + c];
+                }
+            }
+
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const float* center = &padded[(x + radius) * BytesPerPixel];
+                float sum[4];
+                for (int c = 0; c < 4; c++)
+                {
+                    sum[c] = center[c] * kernel[0];
+                }
+
+                for (int k = 1; k <= radius; k++)
+                {
+                    const float* left = center - k * BytesPerPixel;
+                    const float* right = center + k * BytesPerPixel;
+                    for (int c = 0; c < 4; c++)
+                    {
+                        sum[c] += (left[c] + right[c]) * kernel[k];
+                    }
+                }
+
+                for (int c = 0; c < 4; c++)
+                {
+                    out[x * BytesPerPixel + c] = QuantizeSample(sum[c]);
+                }
+            }
+        }
+
+        void DirectBlur(ConstImageView src, ImageView dst, float sigma, ThreadPool& pool)
+        {
+            const auto kernel = GaussianKernel(sigma);
+            const int radius = static_cast<int>(kernel.size()) - 1;
+            const int height = static_cast<int>(src.Height);
+            const size_t rowFloats = static_cast<size_t>(src.Width) * BytesPerPixel;
+
+            // Horizontal pass into an intermediate image.
+            auto horizontal = Image::Uninitialized(src.Width, src.Height);
+            pool.ParallelFor(0, src.Height, RowsPerBand, [&](size_t begin, size_t end)
+            {
+                // Row buffers are kept per thread, so a render allocates none after the first.
+                thread_local std::vector<float> padded;
+                for (size_t y = begin; y < end; y++)
+                {
+                    BlurRow(src.Row(static_cast<uint32_t>(y)), horizontal.View().Row(static_cast<uint32_t>(y)), src.Width, kernel, padded);
+                }
+            });
+
+            // Vertical pass, accumulating whole rows so memory is read sequentially.
+            const ConstImageView rows = horizontal.View();
+            pool.ParallelFor(0, src.Height, RowsPerBand, [&](size_t begin, size_t end)
+            {
+                thread_local std::vector<float> sum;
+                sum.resize(rowFloats);
+                for (size_t y = begin; y < end; y++)
+                {
+                    const int row = static_cast<int>(y);
+                    std::fill(sum.begin(), sum.end(), 0.0f);
+
+                    for (int k = -radius; k <= radius; k++)
+                    {
+                        const uint8_t* in = rows.Row(static_cast<uint32_t>(std::clamp(row + k, 0, height - 1)));
+                        const float weight = kernel[std::abs(k)];
+                        for (size_t i = 0; i < rowFloats; i++)
+                        {
+                            sum[i] += in[i] * weight;
+                        }
+                    }
+
+                    uint8_t* out = dst.Row(static_cast<uint32_t>(y));
+                    for (size_t i = 0; i < rowFloats; i++)
+                    {
+                        out[i] = QuantizeSample(sum[i]);
+                    }
+                }
+            });
+        }
+
+        // Runs a one-dimensional filter over the rows and then the columns of src. The
+        // filter is called as filter(samples, length, lanes, scratch) and filters length
+        // samples of lanes interleaved channels in place: sample n of lane l is at
+        // samples[n * lanes + l]. Rows are filtered as 4 lanes; columns in strips of
+        // StripWidth pixels, so the inner loops run over contiguous memory.
+        template <typename Sample, typename Filter>
+        void SeparableBlur(ConstImageView src, ImageView dst, ThreadPool& pool, Filter const& filter)
+        {
+            const uint32_t width = src.Width;
+            const uint32_t height = src.Height;
+
+            auto horizontal = Image::Uninitialized(width, height);
+            const ImageView rows = horizontal.View();
+            pool.ParallelFor(0, height, RowsPerBand, [&](size_t begin, size_t end)
+            {
+                // Line buffers come from the pool, whose per-thread caches hand the same
+                // memory back on the next render, and scratch is kept per thread.
+                const size_t count = static_cast<size_t>(width) * BytesPerPixel;
+                auto buffer = GetBufferPool().Acquire(count * sizeof(Sample));
+                auto samples = reinterpret_cast<Sample*>(buffer.Data());
+                thread_local std::vector<Sample> scratch;
+                for (auto y = static_cast<uint32_t>(begin); y < end; y++)
+                {
+                    std::copy(src.Row(y), src.Row(y) + count, samples);
+                    filter(samples, width, BytesPerPixel, scratch);
+                    std::transform(samples, samples + count, rows.Row(y), QuantizeSample<Sample>);
+                }
+            });
+
+            const size_t strips = (width + StripWidth - 1) / StripWidth;
+            pool.ParallelFor(0, strips, 1, [&](size_t begin, size_t end)
+            {
+                auto buffer = GetBufferPool().Acquire(size_t{ StripWidth } * BytesPerPixel * height * sizeof(Sample));
+                auto samples = reinterpret_cast<Sample*>(buffer.Data());
+                thread_local std::vector<Sample> scratch;
+                for (size_t strip = begin; strip < end; strip++)
+                {
+                    const size_t left = strip * StripWidth * BytesPerPixel;
+                    const size_t lanes = std::min<size_t>(StripWidth, width - strip * StripWidth) * BytesPerPixel;
+
+                    for (uint32_t y = 0; y < height; y++)
+                    {
+                        const uint8_t* in = rows.Row(y) + left;
+                        std::copy(in, in + lanes, samples + y * lanes);
+                    }
+
+                    filter(samples, height, lanes, scratch);
+
+                    for (uint32_t y = 0; y < height; y++)
+                    {
+                        const auto line = samples + y * lanes;
+                        std::transform(line, line + lanes, dst.Row(y) + left, QuantizeSample<Sample>);
+                    }
+                }
+            });
+        }
+
+        // Coefficients of a third-order recursive Gaussian, normalized so each pass has unit
+        // gain: w[n] = B * x[n] + A[0] * w[n - 1] + A[1] * w[n - 2] + A[2] * w[n - 3].
+        // The poles are those of Vliet, Young and Verbeek ("Recursive Gaussian derivative
+        // filters", 1998), which track the Gaussian more closely than the 1995 Young-van
+        // Vliet fit. The filter runs in double precision: for large sigma the poles are
+        // close to one and single precision visibly shifts the result.
+        struct RecursiveCoefficients
+        {
+            double B;
+            double A[3];
+
+            // Maps the last three forward outputs, relative to the last input, to the three
+            // backward outputs past the end of the line, relative to the last input. This
+            // is the Triggs-Sdika boundary condition for a line that continues with copies
+            // of its last sample, so the right edge is exact and not just steady-state.
+            double Tail[3][3];
+        };
+
+        RecursiveCoefficients MakeRecursiveCoefficients(float sigma)
+        {
+            using Complex = std::complex<double>;
+            const Complex unitPoles[3] = { { 1.41650, 1.00829 }, { 1.41650, -1.00829 }, { 1.86543, 0.0 } };
+
+            // The poles scale as d^(1/q). Newton's method finds the q for which the variance
+            // of the forward-backward filter, 2 * sum(z / (z - 1)^2), is sigma squared.
+            double q = sigma / 2.0;
+            for (int iteration = 0; iteration < 20; iteration++)
+            {
+                Complex variance;
+                Complex derivative;
+                for (auto&& pole : unitPoles)
+                {
+                    const Complex z = std::pow(pole, 1.0 / q);
+                    variance += z / ((z - 1.0) * (z - 1.0));
+                    derivative += z * std::log(z) * (z + 1.0) / ((z - 1.0) * (z - 1.0) * (z - 1.0));
+                }
+                q -= (2.0 * variance.real() - double(sigma) * sigma) / (2.0 / q * derivative.real());
+            }
+
+            // Expand the product of (1 - 1 / (z * pole)) into the feedback polynomial.
+            Complex polynomial[4] = { 1.0, 0.0, 0.0, 0.0 };
+            for (int k = 0; k < 3; k++)
+            {
+                const Complex pole = std::pow(unitPoles[k], 1.0 / q);
+                for (int j = k; j >= 0; j--)
+                {
+                    polynomial[j + 1] -= polynomial[j] / pole;
+                }
+            }
+
+            RecursiveCoefficients coefficients{};
+            coefficients.B = 1.0;
+            for (int i = 0; i < 3; i++)
+            {
+                coefficients.A[i] = -polynomial[i + 1].real();
+                coefficients.B -= coefficients.A[i];
+            }
+
+            // Past the end, the deviation of the forward output from the last input decays
+            // on its own. Run it out for each unit start state, filter it backward, and read
+            // off the backward outputs at the end of the line.
+            auto const& a = coefficients.A;
+            const double b = coefficients.B;
+            const size_t length = static_cast<size_t>(std::ceil(20.0 * sigma)) + 64;
+            std::vector<double> forward(length + 3);
+            std::vector<double> backward(length + 3);
+            for (int k = 0; k < 3; k++)
+            {
+                std::fill(forward.begin(), forward.end(), 0.0);
+                std::fill(backward.begin(), backward.end(), 0.0);
+                forward[2 - k] = 1.0;
+
+                for (size_t n = 3; n < length; n++)
+                {
+                    forward[n] = a[0] * forward[n - 1] + a[1] * forward[n - 2] + a[2] * forward[n - 3];
+                }
+                for (size_t n = length; n-- > 3;)
+                {
+                    backward[n] = b * forward[n] + a[0] * backward[n + 1] + a[1] * backward[n + 2] + a[2] * backward[n + 3];
+                }
+                for (int j = 0; j < 3; j++)
+                {
+                    coefficients.Tail[j][k] = backward[3 + j];
+                }
+            }
+
+            return coefficients;
+        }
+
+        void RecursiveFilter(double* samples, size_t length, size_t lanes, RecursiveCoefficients const& c, std::vector<double>& scratch)
+        {
+            scratch.resize(lanes * 4);
+            double* last = scratch.data();
+            double* w1 = last + lanes;
+            double* w2 = w1 + lanes;
+            double* w3 = w2 + lanes;
+
+            // The line starts as if preceded by copies of its first sample; the filter's
+            // unit gain makes that the forward state.
+            for (size_t l = 0; l < lanes; l++)
+            {
+                last[l] = samples[(length - 1) * lanes + l];
+                w1[l] = w2[l] = w3[l] = samples[l];
+            }
+
+            for (size_t n = 0; n < length; n++)
+            {
+                double* x = samples + n * lanes;
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    const double w = c.B * x[l] + c.A[0] * w1[l] + c.A[1] * w2[l] + c.A[2] * w3[l];
+                    w3[l] = w;
+                    x[l] = w;
+                }
+                std::swap(w2, w3);
+                std::swap(w1, w2);
+            }
+
+            for (size_t l = 0; l < lanes; l++)
+            {
+                const double d[3] = { w1[l] - last[l], w2[l] - last[l], w3[l] - last[l] };
+                double tail[3];
+                for (int j = 0; j < 3; j++)
+                {
+                    tail[j] = last[l] + c.Tail[j][0] * d[0] + c.Tail[j][1] * d[1] + c.Tail[j][2] * d[2];
+                }
+                w1[l] = tail[0];
+                w2[l] = tail[1];
+                w3[l] = tail[2];
+            }
+
+            for (size_t n = length; n-- > 0;)
+            {
+                double* x = samples + n * lanes;
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    const double y = c.B * x[l] + c.A[0] * w1[l] + c.A[1] * w2[l] + c.A[2] * w3[l];
+                    w3[l] = y;
+                    x[l] = y;
+                }
+                std::swap(w2, w3);
+                std::swap(w1, w2);
+            }
+        }
+
+        // Returns the radii of three box filters whose combined variance is closest to
+        // sigma squared (Kovesi, "Fast almost-Gaussian filtering", 2010).
+        std::array<int, 3> BoxRadii(float sigma)
+        {
+            constexpr int boxes = 3;
+            const double variance = 12.0 * sigma * sigma;
+            int lower = static_cast<int>(std::floor(std::sqrt(variance / boxes + 1)));
+            if (lower % 2 == 0)
+            {
+                lower--;
+            }
+
+            const double lowerBoxes = (variance - boxes * lower * lower - 4.0 * boxes * lower - 3.0 * boxes) / (-4.0 * lower - 4.0);
+            const int lowerCount = static_cast<int>(std::lround(lowerBoxes));
+
+            std::array<int, 3> radii{};
+            for (int i = 0; i < boxes; i++)
+            {
+                radii[i] = (i < lowerCount ? lower - 1 : lower + 1) / 2;
+            }
+            return radii;
+        }
+
+        // Writes the mean of in[n - radius, n + radius] to out[n] for n in [begin, end),
+        // keeping a running sum so the cost does not depend on the radius.
+        void BoxPass(const float* in, float* out, size_t begin, size_t end, size_t lanes, int radius, float* sum)
+        {
+            std::fill(sum, sum + lanes, 0.0f);
+            for (size_t n = begin - radius; n <= begin + radius; n++)
+            {
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    sum[l] += in[n * lanes + l];
+                }
+            }
+
+            const float scale = 1.0f / (2 * radius + 1);
+            for (size_t n = begin; n < end; n++)
+            {
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    out[n * lanes + l] = sum[l] * scale;
+                }
+
+                if (n + 1 < end)
+                {
+                    const float* entering = in + (n + radius + 1) * lanes;
+                    const float* leaving = in + (n - radius) * lanes;
+                    for (size_t l = 0; l < lanes; l++)
+                    {
+                        sum[l] += entering[l] - leaving[l];
+                    }
+                }
+            }
+        }
+
+        // Filters a line with three successive boxes. Replicating the edge before every box
+        // would repeat already blurred samples, so the line is extended once by the sum of
+        // the radii and each box shrinks the valid range by its own radius.
+        void TripleBoxFilter(float* samples, size_t length, size_t lanes, std::array<int, 3> const& radii, std::vector<float>& scratch)
+        {
+            const size_t margin = static_cast<size_t>(radii[0]) + radii[1] + radii[2];
+            const size_t extended = length + 2 * margin;
+            scratch.resize(lanes * (2 * extended + 1));
+            float* sum = scratch.data();
+            float* front = sum + lanes;
+            float* back = front + extended * lanes;
+
+            for (size_t n = 0; n < extended; n++)
+            {
+                const size_t source = std::min(n > margin ? n - margin : 0, length - 1);
+                std::copy(samples + source * lanes, samples + (source + 1) * lanes, front + n * lanes);
+            }
+
+            size_t valid = 0;
+            for (auto radius : radii)
+            {
+                valid += radius;
+                BoxPass(front, back, valid, extended - valid, lanes, radius, sum);
+                std::swap(front, back);
+            }
+
+            std::copy(front + margin * lanes, front + (margin + length) * lanes, samples);
+        }
+
+        // Convolves a line with the sampled kernel, extended with copies of its edge samples.
+        // This is the direct method in the form of the other filters, for planar images.
+        void DirectFilter(float* samples, size_t length, size_t lanes, std::vector<float> const& kernel, std::vector<float>& scratch)
+        {
+            const size_t radius = kernel.size() - 1;
+            scratch.resize((length + 2 * radius) * lanes);
+            for (size_t n = 0; n < length + 2 * radius; n++)
+            {
+                const size_t source = std::min(n > radius ? n - radius : 0, length - 1);
+                std::copy(samples + source * lanes, samples + (source + 1) * lanes, scratch.begin() + n * lanes);
+            }
+
+            for (size_t n = 0; n < length; n++)
+            {
+                const float* center = scratch.data() + (n + radius) * lanes;
+                float* out = samples + n * lanes;
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    out[l] = center[l] * kernel[0];
+                }
+
+                for (size_t k = 1; k <= radius; k++)
+                {
+                    const float* left = center - k * lanes;
+                    const float* right = center + k * lanes;
+                    for (size_t l = 0; l < lanes; l++)
+                    {
+                        out[l] += (left[l] + right[l]) * kernel[k];
+                    }
+                }
+            }
+        }
+
+        // Reads count samples of one plane of a planar row as floats, or writes them.
+        void ReadSamples(PixelKernels const& kernels, PlanarRow const& row, int plane, size_t count, float* out)
+        {
+            if (row.Format == PlanarFormat::Float16)
+            {
+                kernels.HalfToFloatSamples(static_cast<const uint16_t*>(row.Planes[plane]), out, count);
+            }
+            else
+            {
+                std::memcpy(out, row.Planes[plane], count * sizeof(float));
+            }
+        }
+
+        void WriteSamples(PixelKernels const& kernels, const float* in, size_t count, PlanarRow const& row, int plane)
+        {
+            if (row.Format == PlanarFormat::Float16)
+            {
+                kernels.FloatToHalfSamples(in, static_cast<uint16_t*>(row.Planes[plane]), count);
+            }
+            else
+            {
+                std::memcpy(row.Planes[plane], in, count * sizeof(float));
+            }
+        }
+
+        // SeparableBlur for planar images. Rows are filtered with their four planes as 4
+        // lanes, into dst; columns in strips of one plane as wide as the BGRA8 strips, in
+        // place in dst. Nothing is rounded between the passes.
+        template <typename Sample, typename Filter>
+        void SeparablePlanarBlur(PlanarView src, PlanarView dst, ThreadPool& pool, Filter const& filter)
+        {
+            auto const& kernels = GetPixelKernels();
+            const uint32_t width = src.Width;
+            const uint32_t height = src.Height;
+
+            // Each row is read completely before it is written, so src may be dst.
+            pool.ParallelFor(0, height, RowsPerBand, [&](size_t begin, size_t end)
+            {
+                auto lineBuffer = GetBufferPool().Acquire(width * sizeof(float));
+                auto sampleBuffer = GetBufferPool().Acquire(static_cast<size_t>(width) * 4 * sizeof(Sample));
+                auto line = reinterpret_cast<float*>(lineBuffer.Data());
+                auto samples = reinterpret_cast<Sample*>(sampleBuffer.Data());
+                thread_local std::vector<Sample> scratch;
+                for (auto y = static_cast<uint32_t>(begin); y < end; y++)
+                {
+                    for (int plane = 0; plane < 4; plane++)
+                    {
+                        ReadSamples(kernels, src.Row(y), plane, width, line);
+                        for (uint32_t x = 0; x < width; x++)
+                        {
+                            samples[x * 4 + plane] = line[x];
+                        }
+                    }
+
+                    filter(samples, width, 4, scratch);
+
+                    for (int plane = 0; plane < 4; plane++)
+                    {
+                        for (uint32_t x = 0; x < width; x++)
+                        {
+                            line[x] = static_cast<float>(samples[x * 4 + plane]);
+                        }
+                        WriteSamples(kernels, line, width, dst.Row(y), plane);
+                    }
+                }
+            });
+
+            const size_t stripSamples = size_t{ StripWidth } * BytesPerPixel;
+            const size_t stripsPerPlane = (width + stripSamples - 1) / stripSamples;
+            pool.ParallelFor(0, stripsPerPlane * 4, 1, [&](size_t begin, size_t end)
+            {
+                auto lineBuffer = GetBufferPool().Acquire(stripSamples * sizeof(float));
+                auto sampleBuffer = GetBufferPool().Acquire(stripSamples * height * sizeof(Sample));
+                auto line = reinterpret_cast<float*>(lineBuffer.Data());
+                auto samples = reinterpret_cast<Sample*>(sampleBuffer.Data());
+                thread_local std::vector<Sample> scratch;
+                for (size_t strip = begin; strip < end; strip++)
+                {
+                    const auto plane = static_cast<int>(strip / stripsPerPlane);
+                    const size_t left = strip % stripsPerPlane * stripSamples;
+                    const size_t lanes = std::min<size_t>(stripSamples, width - left);
+
+                    for (uint32_t y = 0; y < height; y++)
+                    {
+                        ReadSamples(kernels, dst.Row(y).Offset(left), plane, lanes, line);
+                        std::copy(line, line + lanes, samples + y * lanes);
+                    }
+
+                    filter(samples, height, lanes, scratch);
+
+                    for (uint32_t y = 0; y < height; y++)
+                    {
+                        std::transform(samples + y * lanes, samples + (y + 1) * lanes, line, [](Sample value) { return static_cast<float>(value); });
+                        WriteSamples(kernels, line, lanes, dst.Row(y).Offset(left), plane);
+                    }
+                }
+            });
+        }
+    }
+
+    const char* BlurMethodName(BlurMethod method)
+    {
+        switch (method)
+        {
+        case BlurMethod::Automatic:
+            return "Automatic";
+        case BlurMethod::Direct:
+            return "Direct";
+        case BlurMethod::Recursive:
+            return "Recursive";
+        case BlurMethod::Box:
+            return "Box";
+        }
+        return "";
+    }
+
+    BlurMethod SelectBlurMethod(float sigma)
+    {
+        return sigma <= DirectMaxSigma ? BlurMethod::Direct : BlurMethod::Recursive;
+    }
+
+    std::vector<float> GaussianKernel(float sigma)
+    {
+        const int radius = std::max(1, static_cast<int>(std::ceil(3.0f * sigma)));
+        std::vector<float> kernel(radius + 1);
+
+        float total = 0;
+        for (int k = 0; k <= radius; k++)
+        {
+            kernel[k] = std::exp(-0.5f * k * k / (sigma * sigma));
+            total += (k == 0) ? kernel[k] : 2 * kernel[k];
+        }
+
+        for (auto&& weight : kernel)
+        {
+            weight /= total;
+        }
+
+        return kernel;
+    }
+
+    uint32_t GaussianBlurHalo(float sigma, BlurMethod method)
+    {
+        if (sigma <= 0)
+        {
+            return 0;
+        }
+
+        if (method == BlurMethod::Automatic)
+        {
+            method = SelectBlurMethod(sigma);
+        }
+
+        const auto radius = static_cast<uint32_t>(GaussianKernel(sigma).size() - 1);
+        return method == BlurMethod::Direct ? radius : std::max(radius, static_cast<uint32_t>(std::ceil(4.0f * sigma)));
+    }
+
+    void GaussianBlur(ConstImageView src, ImageView dst, float sigma, ThreadPool& pool, BlurMethod method)
+    {
+        if (src.Width != dst.Width || src.Height != dst.Height)
+        {
+            throw std::invalid_argument("GaussianBlur: source and destination sizes differ");
+        }
+
+        if (sigma <= 0 || src.Width == 0 || src.Height == 0)
+        {
+            CopyPixels(src, dst);
+            return;
+        }
+
+        if (method == BlurMethod::Automatic || (method == BlurMethod::Recursive && sigma < RecursiveMinSigma))
+        {
+            method = SelectBlurMethod(sigma);
+        }
+
+        switch (method)
+        {
+        case BlurMethod::Recursive:
+        {
+            const auto coefficients = MakeRecursiveCoefficients(sigma);
+            SeparableBlur<double>(src, dst, pool, [&](double* samples, size_t length, size_t lanes, std::vector<double>& scratch)
+            {
+                RecursiveFilter(samples, length, lanes, coefficients, scratch);
+            });
+            break;
+        }
+        case BlurMethod::Box:
+        {
+            const auto radii = BoxRadii(sigma);
+            SeparableBlur<float>(src, dst, pool, [&](float* samples, size_t length, size_t lanes, std::vector<float>& scratch)
+            {
+                TripleBoxFilter(samples, length, lanes, radii, scratch);
+            });
+            break;
+        }
+        default:
+            DirectBlur(src, dst, sigma, pool);
+            break;
+        }
+    }
+
+    void GaussianBlur(PlanarView src, PlanarView dst, float sigma, ThreadPool& pool, BlurMethod method)
+    {
+        if (src.Width != dst.Width || src.Height != dst.Height || src.Format != dst.Format)
+        {
+            throw std::invalid_argument("GaussianBlur: source and destination sizes differ");
+        }
+
+        if (sigma <= 0 || src.Width == 0 || src.Height == 0)
+        {
+            CopyPixels(src, dst);
+            return;
+        }
+
+        if (method == BlurMethod::Automatic || (method == BlurMethod::Recursive && sigma < RecursiveMinSigma))
+        {
+            method = SelectBlurMethod(sigma);
+        }
+
+        switch (method)
+        {
+        case BlurMethod::Recursive:
+        {
+            const auto coefficients = MakeRecursiveCoefficients(sigma);
+            SeparablePlanarBlur<double>(src, dst, pool, [&](double* samples, size_t length, size_t lanes, std::vector<double>& scratch)
+            {
+                RecursiveFilter(samples, length, lanes, coefficients, scratch);
+            });
+            break;
+        }
+        case BlurMethod::Box:
+        {
+            const auto radii = BoxRadii(sigma);
+            SeparablePlanarBlur<float>(src, dst, pool, [&](float* samples, size_t length, size_t lanes, std::vector<float>& scratch)
+            {
+                TripleBoxFilter(samples, length, lanes, radii, scratch);
+            });
+            break;
+        }
+        default:
+        {
+            const auto kernel = GaussianKernel(sigma);
+            SeparablePlanarBlur<float>(src, dst, pool, [&](float* samples, size_t length, size_t lanes, std::vector<float>& scratch)
+            {
+                DirectFilter(samples, length, lanes, kernel, scratch);
+            });
+            break;
+        }
+        }
+    }
+}
@@ -0,0 +1,80 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Image.h"
+#include "PlanarImage.h"
+#include "ThreadPool.h"
+#include <vector>
+
+namespace PhotoEngine
+{
+    // How GaussianBlur evaluates the Gaussian.
+    enum class BlurMethod
+    {
+        // Direct for small sigma, Recursive otherwise.
+        Automatic,
+
+        // Convolves with the sampled kernel. Exact, but costs O(sigma) per pixel.
+        Direct,
+
+        // Third-order recursive filter run forward and backward. Constant cost per
+        // pixel and within a level or two of Direct.
+        Recursive,
+
+        // Three successive box filters in single precision. Constant cost per pixel,
+        // with a slightly squarer kernel than Recursive.
+        Box
+    };
+
+    // Returns the method name, e.g. "Recursive".
+    const char* BlurMethodName(BlurMethod method);
+
+    // Returns the method Automatic uses for the given standard deviation.
+    BlurMethod SelectBlurMethod(float sigma);
+
+    // Returns normalized weights for a Gaussian with the given standard deviation,
+    // from the center tap outward. The kernel covers three standard deviations.
+    std::vector<float> GaussianKernel(float sigma);
+
+    // Returns how many rows or columns beyond a region influence its blurred pixels:
+    // the kernel radius for Direct, and four standard deviations for the other methods,
+    // past which their response is far below one level.
+    uint32_t GaussianBlurHalo(float sigma, BlurMethod method = BlurMethod::Automatic);
+
+    // Blurs src into dst with a Gaussian of standard deviation sigma (the BlurAmount of
+    // GaussianBlurEffect). Pixels outside the image repeat the nearest edge pixel, which
+    // matches EffectBorderMode::Hard: the result keeps the source bounds and edges stay
+    // opaque. src and dst must have the same size and must not overlap.
+    //
+    // The blur is separable: rows are filtered in parallel bands, then columns in
+    // parallel strips a few cache lines wide.
+    void GaussianBlur(ConstImageView src, ImageView dst, float sigma, ThreadPool& pool, BlurMethod method = BlurMethod::Automatic);
+
+    // Blurs a planar image the same way, without rounding to 8 bits after each pass.
+    // src and dst must have the same size and format. They may be the same image but must
+    // not otherwise overlap.
+    void GaussianBlur(PlanarView src, PlanarView dst, float sigma, ThreadPool& pool, BlurMethod method = BlurMethod::Automatic);
+}
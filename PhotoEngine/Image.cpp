@@ -0,0 +1,83 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "Image.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    Image::Image(uint32_t width, uint32_t height) :
+        Image(Uninitialized(width, height))
+    {
+        if (m_pixels.Data())
+        {
+            std::memset(m_pixels.Data(), 0, m_pixels.Size());
+        }
+    }
+
+    Image Image::Uninitialized(uint32_t width, uint32_t height)
+    {
+        Image image;
+        image.m_width = width;
+        image.m_height = height;
+        image.m_pixels = GetBufferPool().Acquire(static_cast<size_t>(width) * height * BytesPerPixel);
+        return image;
+    }
+
+    Image::Image(Image const& other) :
+        Image(Uninitialized(other.m_width, other.m_height))
+    {
+        if (m_pixels.Data())
+        {
+            std::memcpy(m_pixels.Data(), other.m_pixels.Data(), m_pixels.Size());
+        }
+    }
+
+    Image& Image::operator=(Image const& other)
+    {
+        if (this != &other)
+        {
+            *this = Image(other);
+        }
+        return *this;
+    }
+
+    void CopyPixels(ConstImageView src, ImageView dst)
+    {
+        if (src.Width != dst.Width || src.Height != dst.Height)
+        {
+            throw std::invalid_argument("CopyPixels: source and destination sizes differ");
+        }
+
+        const size_t rowBytes = static_cast<size_t>(src.Width) * BytesPerPixel;
+        for (uint32_t y = 0; y < src.Height; y++)
+        {
+            if (src.Row(y) != dst.Row(y))
+            {
+                std::memcpy(dst.Row(y), src.Row(y), rowBytes);
+            }
+        }
+    }
+}
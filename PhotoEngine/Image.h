@@ -0,0 +1,155 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BufferPool.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace PhotoEngine
+{
+    // Number of bytes in one BGRA8 pixel.
+    constexpr size_t BytesPerPixel = 4;
+
+    // Read-only view of a BGRA8 pixel buffer whose rows are Stride bytes apart.
+    struct ConstImageView
+    {
+        const uint8_t* Data{ nullptr };
+        uint32_t Width{ 0 };
+        uint32_t Height{ 0 };
+        size_t Stride{ 0 };
+
+        const uint8_t* Row(uint32_t y) const
+        {
+            return Data + y * Stride;
+        }
+
+        // Returns a view of the rows [top, top + height).
+        ConstImageView Rows(uint32_t top, uint32_t height) const
+        {
+            return { Row(top), Width, height, Stride };
+        }
+
+        // Returns a view of the width x height pixels whose top left pixel is (left, top).
+        ConstImageView Region(uint32_t left, uint32_t top, uint32_t width, uint32_t height) const
+        {
+            return { Row(top) + left * BytesPerPixel, width, height, Stride };
+        }
+    };
+
+    // Writable view of a BGRA8 pixel buffer whose rows are Stride bytes apart.
+    struct ImageView
+    {
+        uint8_t* Data{ nullptr };
+        uint32_t Width{ 0 };
+        uint32_t Height{ 0 };
+        size_t Stride{ 0 };
+
+        uint8_t* Row(uint32_t y) const
+        {
+            return Data + y * Stride;
+        }
+
+        // Returns a view of the rows [top, top + height).
+        ImageView Rows(uint32_t top, uint32_t height) const
+        {
+            return { Row(top), Width, height, Stride };
+        }
+
+        // Returns a view of the width x height pixels whose top left pixel is (left, top).
+        ImageView Region(uint32_t left, uint32_t top, uint32_t width, uint32_t height) const
+        {
+            return { Row(top) + left * BytesPerPixel, width, height, Stride };
+        }
+
+        operator ConstImageView() const
+        {
+            return { Data, Width, Height, Stride };
+        }
+    };
+
+    // Owning BGRA8 image with tightly packed rows. The pixels come from GetBufferPool(),
+    // so an image of a size that was freed recently reuses that memory.
+    class Image
+    {
+    public:
+        Image() = default;
+
+        // Creates an image of transparent black pixels.
+        Image(uint32_t width, uint32_t height);
+
+        // Creates an image whose pixels are undefined, for a caller that writes all of
+        // them anyway, such as a render intermediate.
+        static Image Uninitialized(uint32_t width, uint32_t height);
+
+        Image(Image const& other);
+        Image& operator=(Image const& other);
+        Image(Image&&) noexcept = default;
+        Image& operator=(Image&&) noexcept = default;
+
+        uint32_t Width() const
+        {
+            return m_width;
+        }
+
+        uint32_t Height() const
+        {
+            return m_height;
+        }
+
+        size_t Stride() const
+        {
+            return static_cast<size_t>(m_width) * BytesPerPixel;
+        }
+
+        uint8_t* Data()
+        {
+            return m_pixels.Data();
+        }
+
+        const uint8_t* Data() const
+        {
+            return m_pixels.Data();
+        }
+
+        ImageView View()
+        {
+            return { m_pixels.Data(), m_width, m_height, Stride() };
+        }
+
+        ConstImageView View() const
+        {
+            return { m_pixels.Data(), m_width, m_height, Stride() };
+        }
+
+    private:
+        uint32_t m_width{ 0 };
+        uint32_t m_height{ 0 };
+        BufferPool::Buffer m_pixels;
+    };
+
+    // Copies the pixels of src into dst. Both views must have the same size.
+    void CopyPixels(ConstImageView src, ImageView dst);
+}
@@ -0,0 +1,470 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ImageProbe.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Bytes ProbeImageFile reads first; it doubles the amount until the headers fit.
+        constexpr size_t InitialProbeBytes = 4096;
+
+        // Headers longer than this are not worth reading for a probe.
+        constexpr size_t MaxProbeBytes = 64 << 20;
+
+        enum class ProbeStatus
+        {
+            Complete,
+            Truncated,
+            Invalid,
+        };
+
+        uint16_t ReadBigEndian16(const uint8_t* p)
+        {
+            return static_cast<uint16_t>(p[0] << 8 | p[1]);
+        }
+
+        uint32_t ReadBigEndian32(const uint8_t* p)
+        {
+            return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 | p[3];
+        }
+
+        void AppendUtf8(std::string& text, uint32_t codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                text += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800)
+            {
+                text += static_cast<char>(0xC0 | codePoint >> 6);
+                text += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else if (codePoint < 0x10000)
+            {
+                text += static_cast<char>(0xE0 | codePoint >> 12);
+                text += static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+                text += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else
+            {
+                text += static_cast<char>(0xF0 | codePoint >> 18);
+                text += static_cast<char>(0x80 | (codePoint >> 12 & 0x3F));
+                text += static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+                text += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        // XPTitle is UTF-16LE, ended by a null character.
+        std::string Utf16LeToUtf8(const uint8_t* data, size_t size)
+        {
+            std::string text;
+            for (size_t i = 0; i + 1 < size; i += 2)
+            {
+                uint32_t unit = static_cast<uint32_t>(data[i] | data[i + 1] << 8);
+                if (unit == 0)
+                {
+                    break;
+                }
+                if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < size)
+                {
+                    const uint32_t low = static_cast<uint32_t>(data[i + 2] | data[i + 3] << 8);
+                    if (low >= 0xDC00 && low < 0xE000)
+                    {
+                        unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                        i += 2;
+                    }
+                }
+                AppendUtf8(text, unit);
+            }
+            return text;
+        }
+
+        // PNG tEXt is Latin-1.
+        std::string Latin1ToUtf8(const uint8_t* data, size_t size)
+        {
+            std::string text;
+            for (size_t i = 0; i < size; i++)
+            {
+                AppendUtf8(text, data[i]);
+            }
+            return text;
+        }
+
+        // Reads the orientation and title from the first IFD of an EXIF TIFF block.
+        class ExifReader
+        {
+        public:
+            ExifReader(const uint8_t* data, size_t size) :
+                m_data(data),
+                m_size(size)
+            {
+            }
+
+            void Read(ImageProbe& probe)
+            {
+                if (m_size < 8 || (std::memcmp(m_data, "II", 2) != 0 && std::memcmp(m_data, "MM", 2) != 0))
+                {
+                    return;
+                }
+                m_littleEndian = m_data[0] == 'I';
+
+                uint16_t magic = 0;
+                uint32_t ifd = 0;
+                uint16_t entryCount = 0;
+                if (!Read16(2, magic) || magic != 42 || !Read32(4, ifd) || !Read16(ifd, entryCount))
+                {
+                    return;
+                }
+
+                std::string description;
+                std::string title;
+                for (size_t i = 0; i < entryCount; i++)
+                {
+                    const size_t entry = ifd + 2 + i * 12;
+                    uint16_t tag = 0;
+                    uint16_t type = 0;
+                    uint32_t count = 0;
+                    if (!Read16(entry, tag) || !Read16(entry + 2, type) || !Read32(entry + 4, count))
+                    {
+                        break;
+                    }
+
+                    if (tag == 0x0112 && type == 3)
+                    {
+                        uint16_t orientation = 0;
+                        if (Read16(entry + 8, orientation) && orientation >= 1 && orientation <= 8)
+                        {
+                            probe.Orientation = orientation;
+                        }
+                    }
+                    else if ((tag == 0x010E && type == 2) || (tag == 0x9C9B && type == 1))
+                    {
+                        // Values over 4 bytes are stored at an offset.
+                        uint32_t offset = static_cast<uint32_t>(entry + 8);
+                        if (count > 4 && !Read32(entry + 8, offset))
+                        {
+                            continue;
+                        }
+                        if (offset > m_size || count > m_size - offset)
+                        {
+                            continue;
+                        }
+
+                        if (tag == 0x010E)
+                        {
+                            description.assign(reinterpret_cast<const char*>(m_data + offset), count);
+                            description.resize(std::strlen(description.c_str()));
+                        }
+                        else
+                        {
+                            title = Utf16LeToUtf8(m_data + offset, count);
+                        }
+                    }
+                }
+
+                probe.Title = title.empty() ? description : title;
+            }
+
+        private:
+            bool Read16(size_t offset, uint16_t& value) const
+            {
+                if (offset + 2 > m_size)
+                {
+                    return false;
+                }
+                const uint8_t* p = m_data + offset;
+                value = m_littleEndian ? static_cast<uint16_t>(p[0] | p[1] << 8) : ReadBigEndian16(p);
+                return true;
+            }
+
+            bool Read32(size_t offset, uint32_t& value) const
+            {
+                if (offset + 4 > m_size)
+                {
+                    return false;
+                }
+                const uint8_t* p = m_data + offset;
+                value = m_littleEndian ? static_cast<uint32_t>(p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24) : ReadBigEndian32(p);
+                return true;
+            }
+
+            const uint8_t* m_data;
+            size_t m_size;
+            bool m_littleEndian{ false };
+        };
+
+        bool IsStartOfFrame(uint8_t marker)
+        {
+            return marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        }
+
+        // Walks the marker segments up to the frame header; EXIF comes before it.
+        ProbeStatus ProbeJpeg(const uint8_t* data, size_t size, ImageProbe& probe)
+        {
+            probe.Format = ImageFormat::Jpeg;
+            size_t position = 2;
+            for (;;)
+            {
+                if (position >= size)
+                {
+                    return ProbeStatus::Truncated;
+                }
+                if (data[position] != 0xFF)
+                {
+                    return ProbeStatus::Invalid;
+                }
+
+                // Markers may be preceded by fill bytes.
+                while (position < size && data[position] == 0xFF)
+                {
+                    position++;
+                }
+                if (position >= size)
+                {
+                    return ProbeStatus::Truncated;
+                }
+
+                const uint8_t marker = data[position++];
+                if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+                {
+                    continue;
+                }
+                if (marker == 0xD9 || marker == 0xDA)
+                {
+                    // The image data starts without a frame header.
+                    return ProbeStatus::Invalid;
+                }
+
+                if (position + 2 > size)
+                {
+                    return ProbeStatus::Truncated;
+                }
+                const size_t length = ReadBigEndian16(data + position);
+                if (length < 2)
+                {
+                    return ProbeStatus::Invalid;
+                }
+                const uint8_t* segment = data + position + 2;
+                const size_t segmentSize = length - 2;
+
+                if (IsStartOfFrame(marker))
+                {
+                    if (segmentSize < 5)
+                    {
+                        return ProbeStatus::Invalid;
+                    }
+                    if (position + 2 + 5 > size)
+                    {
+                        return ProbeStatus::Truncated;
+                    }
+                    probe.Height = ReadBigEndian16(segment + 1);
+                    probe.Width = ReadBigEndian16(segment + 3);
+                    return probe.Width > 0 && probe.Height > 0 ? ProbeStatus::Complete : ProbeStatus::Invalid;
+                }
+
+                if (marker == 0xE1 && segmentSize >= 6 && position + 2 + 6 <= size && std::memcmp(segment, "Exif\0\0", 6) == 0)
+                {
+                    if (position + length > size)
+                    {
+                        return ProbeStatus::Truncated;
+                    }
+                    ExifReader(segment + 6, segmentSize - 6).Read(probe);
+                }
+
+                position += length;
+            }
+        }
+
+        // Reads IHDR, then the text and EXIF chunks up to the image data.
+        ProbeStatus ProbePng(const uint8_t* data, size_t size, ImageProbe& probe)
+        {
+            probe.Format = ImageFormat::Png;
+            if (size < 8 + 8 + 13)
+            {
+                return ProbeStatus::Truncated;
+            }
+            if (std::memcmp(data, "\x89PNG\r\n\x1A\n", 8) != 0 || std::memcmp(data + 12, "IHDR", 4) != 0)
+            {
+                return ProbeStatus::Invalid;
+            }
+            probe.Width = ReadBigEndian32(data + 16);
+            probe.Height = ReadBigEndian32(data + 20);
+            if (probe.Width == 0 || probe.Height == 0)
+            {
+                return ProbeStatus::Invalid;
+            }
+
+            std::string title;
+            size_t position = 8 + 8 + 13 + 4;
+            for (;;)
+            {
+                if (position + 8 > size)
+                {
+                    return ProbeStatus::Truncated;
+                }
+                const size_t length = ReadBigEndian32(data + position);
+                const uint8_t* type = data + position + 4;
+                const uint8_t* chunk = data + position + 8;
+                if (std::memcmp(type, "IDAT", 4) == 0 || std::memcmp(type, "IEND", 4) == 0)
+                {
+                    return ProbeStatus::Complete;
+                }
+
+                const bool text = std::memcmp(type, "tEXt", 4) == 0 || std::memcmp(type, "iTXt", 4) == 0;
+                const bool exif = std::memcmp(type, "eXIf", 4) == 0;
+                if (text || exif)
+                {
+                    if (length > size - position - 8)
+                    {
+                        return ProbeStatus::Truncated;
+                    }
+
+                    if (exif)
+                    {
+                        ExifReader(chunk, length).Read(probe);
+                    }
+                    else if (length > 6 && std::memcmp(chunk, "Title\0", 6) == 0)
+                    {
+                        if (type[0] == 't')
+                        {
+                            probe.Title = Latin1ToUtf8(chunk + 6, length - 6);
+                        }
+                        else if (length > 8 && chunk[6] == 0)
+                        {
+                            // iTXt: compression flag and method, then language and
+                            // translated keyword, each null terminated, then UTF-8 text.
+                            const char* begin = reinterpret_cast<const char*>(chunk + 8);
+                            const char* end = reinterpret_cast<const char*>(chunk + length);
+                            const char* language = static_cast<const char*>(std::memchr(begin, 0, end - begin));
+                            const char* translated = language ? static_cast<const char*>(std::memchr(language + 1, 0, end - language - 1)) : nullptr;
+                            if (translated)
+                            {
+                                probe.Title.assign(translated + 1, end);
+                            }
+                        }
+                    }
+                }
+
+                // Length, type, data, and CRC.
+                if (length > MaxProbeBytes)
+                {
+                    return ProbeStatus::Complete;
+                }
+                position += 8 + length + 4;
+            }
+        }
+
+        ProbeStatus ProbeGif(const uint8_t* data, size_t size, ImageProbe& probe)
+        {
+            probe.Format = ImageFormat::Gif;
+            if (size < 10)
+            {
+                return ProbeStatus::Truncated;
+            }
+            if (std::memcmp(data, "GIF87a", 6) != 0 && std::memcmp(data, "GIF89a", 6) != 0)
+            {
+                return ProbeStatus::Invalid;
+            }
+            probe.Width = static_cast<uint32_t>(data[6] | data[7] << 8);
+            probe.Height = static_cast<uint32_t>(data[8] | data[9] << 8);
+            return probe.Width > 0 && probe.Height > 0 ? ProbeStatus::Complete : ProbeStatus::Invalid;
+        }
+
+        ProbeStatus Probe(const uint8_t* data, size_t size, ImageProbe& probe)
+        {
+            if (size < 4)
+            {
+                return ProbeStatus::Truncated;
+            }
+            if (data[0] == 0xFF && data[1] == 0xD8)
+            {
+                return ProbeJpeg(data, size, probe);
+            }
+            if (std::memcmp(data, "\x89PNG", 4) == 0)
+            {
+                return ProbePng(data, size, probe);
+            }
+            if (std::memcmp(data, "GIF8", 4) == 0)
+            {
+                return ProbeGif(data, size, probe);
+            }
+            return ProbeStatus::Invalid;
+        }
+    }
+
+    std::optional<ImageProbe> ProbeImage(const uint8_t* data, size_t size)
+    {
+        ImageProbe probe;
+        const auto status = Probe(data, size, probe);
+        if (status == ProbeStatus::Invalid || probe.Width == 0)
+        {
+            return std::nullopt;
+        }
+        return probe;
+    }
+
+    std::optional<ImageProbe> ProbeImageFile(std::filesystem::path const& path)
+    {
+        // stdio rather than a stream: a probe is a few microseconds, and opening an
+        // fstream costs about as much again.
+#ifdef _WIN32
+        std::unique_ptr<FILE, int (*)(FILE*)> file(_wfopen(path.c_str(), L"rb"), &std::fclose);
+#else
+        std::unique_ptr<FILE, int (*)(FILE*)> file(std::fopen(path.c_str(), "rb"), &std::fclose);
+#endif
+        if (!file)
+        {
+            return std::nullopt;
+        }
+        std::setvbuf(file.get(), nullptr, _IONBF, 0);
+
+        std::vector<uint8_t> buffer;
+        size_t read = 0;
+        for (size_t wanted = InitialProbeBytes; wanted <= MaxProbeBytes; wanted *= 2)
+        {
+            buffer.resize(wanted);
+            read += std::fread(buffer.data() + read, 1, wanted - read, file.get());
+
+            ImageProbe probe;
+            const auto status = Probe(buffer.data(), read, probe);
+            if (status == ProbeStatus::Invalid)
+            {
+                return std::nullopt;
+            }
+
+            // Truncated at the end of the file keeps whatever was read.
+            if (status == ProbeStatus::Complete || read < wanted)
+            {
+                return probe.Width > 0 ? std::optional<ImageProbe>(std::move(probe)) : std::nullopt;
+            }
+        }
+        return std::nullopt;
+    }
+}
@@ -0,0 +1,81 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace PhotoEngine
+{
+    enum class ImageFormat
+    {
+        Jpeg,
+        Png,
+        Gif,
+    };
+
+    // Dimensions and metadata read from the header of an image file.
+    struct ImageProbe
+    {
+        ImageFormat Format{ ImageFormat::Jpeg };
+
+        // Size of the stored pixels, before Orientation is applied.
+        uint32_t Width{ 0 };
+        uint32_t Height{ 0 };
+
+        // EXIF orientation, 1 to 8; 1 when the file has none.
+        uint16_t Orientation{ 1 };
+
+        // UTF-8 title: EXIF XPTitle or ImageDescription for JPEG, the tEXt or iTXt
+        // "Title" keyword for PNG. Empty when the file has none.
+        std::string Title;
+
+        // Size of the image as displayed: orientations 5 to 8 rotate it a quarter turn.
+        uint32_t DisplayWidth() const
+        {
+            return Orientation >= 5 ? Height : Width;
+        }
+
+        uint32_t DisplayHeight() const
+        {
+            return Orientation >= 5 ? Width : Height;
+        }
+    };
+
+    // Reads the dimensions, orientation, and title of a JPEG, PNG, or GIF from the
+    // start of the file, without decoding pixels. The buffer may be a prefix of the
+    // file, or the whole file mapped with MappedFile, in which case only the pages
+    // holding headers are read. Returns std::nullopt if the data is not one of these
+    // formats or ends before the dimensions; metadata after the end of a prefix is
+    // missing from the result.
+    std::optional<ImageProbe> ProbeImage(const uint8_t* data, size_t size);
+
+    // Probes a file by reading its first 4 KB, and more only if the headers continue
+    // past it, as they do after a large EXIF block. Returns std::nullopt if the file
+    // cannot be read or is not a JPEG, PNG, or GIF.
+    std::optional<ImageProbe> ProbeImageFile(std::filesystem::path const& path);
+}
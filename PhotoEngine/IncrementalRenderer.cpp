@@ -0,0 +1,162 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "IncrementalRenderer.h"
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        bool StageParametersChanged(PipelineStage const& stage, EffectParameters const& before, EffectParameters const& after)
+        {
+            for (auto&& kind : stage.Effects)
+            {
+                if (EffectParametersChanged(kind, before, after))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    IncrementalRenderer::IncrementalRenderer(ThreadPool& pool, ConstImageView source, EffectChain const& chain,
+        PipelineOptions const& options, PixelKernels const& kernels) :
+        m_renderer(pool, kernels),
+        m_source(source),
+        m_pipeline(chain, options)
+    {
+    }
+
+    void IncrementalRenderer::Source(ConstImageView source)
+    {
+        m_source = source;
+        m_validStages = 0;
+    }
+
+    void IncrementalRenderer::Chain(EffectChain const& chain)
+    {
+        m_pipeline = Pipeline(chain, m_pipeline.Options());
+        m_validStages = 0;
+    }
+
+    void IncrementalRenderer::Render(EffectParameters const& params, ImageView dst)
+    {
+        if (m_source.Width != dst.Width || m_source.Height != dst.Height)
+        {
+            throw std::invalid_argument("IncrementalRenderer: source and destination sizes differ");
+        }
+
+        auto const& stages = m_pipeline.Stages();
+        if (stages.empty())
+        {
+            CopyPixels(m_source, dst);
+            return;
+        }
+
+        size_t first = 0;
+        while (first < m_validStages && !StageParametersChanged(stages[first], m_cachedParams, params))
+        {
+            first++;
+        }
+
+        // The outputs from stage first on are overwritten below, so until every stage has
+        // succeeded only the ones before it may be reused. If a stage throws, the next call
+        // renders from first again.
+        m_validStages = first;
+
+        const size_t cachedStages = stages.size() - 1;
+        if (m_pipeline.Options().Format != WorkingFormat::Bgra8)
+        {
+            RenderPlanar(first, params, dst);
+        }
+        else
+        {
+            m_stageOutputs.resize(cachedStages);
+            for (size_t i = first; i < stages.size(); i++)
+            {
+                ConstImageView input = i == 0 ? m_source : m_stageOutputs[i - 1].View();
+                ImageView output = dst;
+                if (i < cachedStages)
+                {
+                    auto& image = m_stageOutputs[i];
+                    if (image.Width() != dst.Width || image.Height() != dst.Height)
+                    {
+                        image = Image::Uninitialized(dst.Width, dst.Height);
+                    }
+                    output = image.View();
+                }
+
+                m_renderer.RenderStage(m_pipeline, i, params, input, output);
+            }
+        }
+
+        m_cachedParams = params;
+        m_validStages = cachedStages;
+        m_firstRenderedStage = first;
+    }
+
+    void IncrementalRenderer::RenderPlanar(size_t first, EffectParameters const& params, ImageView dst)
+    {
+        // Each stage starts from a copy of the previous stage's output, or converts the
+        // source, and runs in place; only the last stage converts back to BGRA8.
+        const auto format = m_pipeline.Options().Format == WorkingFormat::Float16 ? PlanarFormat::Float16 : PlanarFormat::Float32;
+        auto prepare = [&](PlanarImage& image)
+        {
+            if (image.Width() != dst.Width || image.Height() != dst.Height || image.Format() != format)
+            {
+                image = PlanarImage(dst.Width, dst.Height, format);
+            }
+            return image.View();
+        };
+
+        const size_t stageCount = m_pipeline.Stages().size();
+        m_planarOutputs.resize(stageCount - 1);
+        for (size_t i = first; i < stageCount; i++)
+        {
+            const bool last = i + 1 == stageCount;
+            const PlanarView image = prepare(last ? m_planarWork : m_planarOutputs[i]);
+            if (i > 0)
+            {
+                CopyPixels(m_planarOutputs[i - 1].View(), image);
+            }
+            m_renderer.RenderPlanar(m_pipeline, i, i + 1, params, image, i == 0 ? m_source : ConstImageView{}, last ? dst : ImageView{});
+        }
+    }
+
+    size_t IncrementalRenderer::CachedBytes() const
+    {
+        size_t bytes = 0;
+        for (auto&& image : m_stageOutputs)
+        {
+            bytes += image.Stride() * image.Height();
+        }
+        for (auto&& image : m_planarOutputs)
+        {
+            bytes += image.View().Stride * image.Height() * SampleBytes(image.Format()) * 4;
+        }
+        return bytes;
+    }
+}
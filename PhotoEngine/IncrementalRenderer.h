@@ -0,0 +1,97 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "EffectChain.h"
+#include "EffectParameters.h"
+#include "Image.h"
+#include "Pipeline.h"
+#include "PlanarImage.h"
+#include "Renderer.h"
+#include <vector>
+
+namespace PhotoEngine
+{
+    // Renders one source image through one effect chain over and over, as the editor does
+    // while a slider moves. The output of every stage but the last is kept, and a render
+    // only runs the stages from the first one that reads a changed parameter: dragging
+    // the sepia slider after a blur reuses the blurred image instead of blurring again.
+    //
+    // With a planar working format the stage outputs are kept as planar images, so the
+    // result is rounded once, when it is stored, and matches Renderer::Render.
+    //
+    // The source pixels are not copied. Call Source again if they change.
+    class IncrementalRenderer
+    {
+    public:
+        IncrementalRenderer(ThreadPool& pool, ConstImageView source, EffectChain const& chain,
+            PipelineOptions const& options = {}, PixelKernels const& kernels = GetPixelKernels());
+
+        // Sets the image to render; the next render runs every stage.
+        void Source(ConstImageView source);
+
+        // Sets the effect chain to render; the next render runs every stage.
+        void Chain(EffectChain const& chain);
+
+        // Renders the source through the chain into dst, which must be the size of the source.
+        void Render(EffectParameters const& params, ImageView dst);
+
+        // Index of the first stage the last render ran. Stages before it were read from
+        // the cached stage outputs.
+        size_t FirstRenderedStage() const
+        {
+            return m_firstRenderedStage;
+        }
+
+        // Total size of the cached stage outputs.
+        size_t CachedBytes() const;
+
+        size_t StageCount() const
+        {
+            return m_pipeline.Stages().size();
+        }
+
+    private:
+        // Runs the stages from first on with a planar working format.
+        void RenderPlanar(size_t first, EffectParameters const& params, ImageView dst);
+
+        Renderer m_renderer;
+        ConstImageView m_source;
+        Pipeline m_pipeline;
+
+        // Output of stage i, for every stage but the last, computed with m_cachedParams:
+        // m_stageOutputs with the BGRA8 working format, m_planarOutputs with a planar one.
+        std::vector<Image> m_stageOutputs;
+        std::vector<PlanarImage> m_planarOutputs;
+
+        // The image the last stage of a planar pipeline runs in.
+        PlanarImage m_planarWork;
+        EffectParameters m_cachedParams;
+
+        // Number of leading entries of m_stageOutputs that are up to date.
+        size_t m_validStages{ 0 };
+        size_t m_firstRenderedStage{ 0 };
+    };
+}
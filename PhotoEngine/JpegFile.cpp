@@ -0,0 +1,341 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "JpegFile.h"
+#include "ImageProbe.h"
+#include "Resize.h"
+#include <csetjmp>
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+#include <jpeglib.h>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // libjpeg reports errors through a callback that must not return. It jumps back
+        // to the setjmp in the engine function that called into the library, which then
+        // throws; C++ exceptions are not thrown through the C library's frames.
+        //
+        // Warnings, such as data that ends early, go through a second callback that would
+        // print them to stderr; the first one is kept instead for the caller to inspect.
+        struct ErrorManager
+        {
+            jpeg_error_mgr Base;
+            std::jmp_buf Jump;
+            char Message[JMSG_LENGTH_MAX];
+            char Warning[JMSG_LENGTH_MAX];
+        };
+
+        void ExitOnError(j_common_ptr info)
+        {
+            auto error = reinterpret_cast<ErrorManager*>(info->err);
+            info->err->format_message(info, error->Message);
+            std::longjmp(error->Jump, 1);
+        }
+
+        void RecordMessage(j_common_ptr info)
+        {
+            auto error = reinterpret_cast<ErrorManager*>(info->err);
+            if (error->Warning[0] == '\0')
+            {
+                info->err->format_message(info, error->Warning);
+            }
+        }
+
+        void InitializeErrorManager(ErrorManager& error)
+        {
+            jpeg_std_error(&error.Base);
+            error.Base.error_exit = ExitOnError;
+            error.Base.output_message = RecordMessage;
+            error.Warning[0] = '\0';
+        }
+
+        void ThrowJpegError(const char* operation, ErrorManager const& error)
+        {
+            throw std::runtime_error(std::string(operation) + ": " + error.Message);
+        }
+
+        std::FILE* OpenFile(std::string const& path, const char* mode)
+        {
+            std::FILE* file = std::fopen(path.c_str(), mode);
+            if (!file)
+            {
+                throw std::runtime_error("Cannot open " + path);
+            }
+            return file;
+        }
+    }
+
+    struct JpegRowReader::Decoder
+    {
+        jpeg_decompress_struct Info{};
+        ErrorManager Error{};
+
+        // The file being decoded when the reader was given a path, or else the JPEG in
+        // memory.
+        std::FILE* File{ nullptr };
+        const uint8_t* Data{ nullptr };
+        size_t Size{ 0 };
+
+        ~Decoder()
+        {
+            jpeg_destroy_decompress(&Info);
+            if (File)
+            {
+                std::fclose(File);
+            }
+        }
+    };
+
+    JpegRowReader::JpegRowReader(std::string const& path, uint32_t scaleDenominator) :
+        m_decoder(std::make_unique<Decoder>())
+    {
+        m_decoder->File = OpenFile(path, "rb");
+        Start(scaleDenominator);
+    }
+
+    JpegRowReader::JpegRowReader(const uint8_t* data, size_t size, uint32_t scaleDenominator) :
+        m_decoder(std::make_unique<Decoder>())
+    {
+        m_decoder->Data = data;
+        m_decoder->Size = size;
+        Start(scaleDenominator);
+    }
+
+    void JpegRowReader::Start(uint32_t scaleDenominator)
+    {
+        auto& info = m_decoder->Info;
+        InitializeErrorManager(m_decoder->Error);
+        info.err = &m_decoder->Error.Base;
+        jpeg_create_decompress(&info);
+
+        if (scaleDenominator != 1 && scaleDenominator != 2 && scaleDenominator != 4 && scaleDenominator != 8)
+        {
+            throw std::invalid_argument("JpegRowReader: the scale denominator must be 1, 2, 4, or 8");
+        }
+
+        if (setjmp(m_decoder->Error.Jump))
+        {
+            ThrowJpegError("JpegRowReader", m_decoder->Error);
+        }
+
+        if (m_decoder->File)
+        {
+            jpeg_stdio_src(&info, m_decoder->File);
+        }
+        else
+        {
+            // Older libjpeg versions take the buffer as non-const; it is only read.
+            jpeg_mem_src(&info, const_cast<unsigned char*>(m_decoder->Data), static_cast<unsigned long>(m_decoder->Size));
+        }
+        jpeg_read_header(&info, TRUE);
+        if (info.jpeg_color_space == JCS_CMYK || info.jpeg_color_space == JCS_YCCK)
+        {
+            throw std::runtime_error("JpegRowReader: CMYK files are not supported");
+        }
+
+        info.out_color_space = JCS_EXT_BGRA;
+        info.scale_num = 1;
+        info.scale_denom = scaleDenominator;
+        jpeg_start_decompress(&info);
+    }
+
+    JpegRowReader::~JpegRowReader() = default;
+
+    uint32_t JpegRowReader::Width() const
+    {
+        return m_decoder->Info.output_width;
+    }
+
+    uint32_t JpegRowReader::Height() const
+    {
+        return m_decoder->Info.output_height;
+    }
+
+    void JpegRowReader::ReadRows(ImageView rows)
+    {
+        auto& info = m_decoder->Info;
+        if (rows.Width != info.output_width || rows.Height > info.output_height - info.output_scanline)
+        {
+            throw std::out_of_range("JpegRowReader: rows do not match the image");
+        }
+
+        if (rows.Height == 0)
+        {
+            return;
+        }
+
+        if (setjmp(m_decoder->Error.Jump))
+        {
+            ThrowJpegError("JpegRowReader", m_decoder->Error);
+        }
+
+        for (uint32_t y = 0; y < rows.Height;)
+        {
+            JSAMPROW row = rows.Row(y);
+            y += jpeg_read_scanlines(&info, &row, 1);
+        }
+
+        if (info.output_scanline == info.output_height)
+        {
+            jpeg_finish_decompress(&info);
+        }
+    }
+
+    std::string JpegRowReader::Warning() const
+    {
+        return m_decoder->Error.Base.num_warnings > 0 ? m_decoder->Error.Warning : std::string();
+    }
+
+    struct JpegRowWriter::Encoder
+    {
+        jpeg_compress_struct Info{};
+        ErrorManager Error{};
+        std::FILE* File{ nullptr };
+
+        ~Encoder()
+        {
+            jpeg_destroy_compress(&Info);
+            if (File)
+            {
+                std::fclose(File);
+            }
+        }
+    };
+
+    JpegRowWriter::JpegRowWriter(std::string const& path, uint32_t width, uint32_t height, int quality) :
+        m_encoder(std::make_unique<Encoder>())
+    {
+        auto& info = m_encoder->Info;
+        InitializeErrorManager(m_encoder->Error);
+        info.err = &m_encoder->Error.Base;
+        jpeg_create_compress(&info);
+        m_encoder->File = OpenFile(path, "wb");
+
+        if (setjmp(m_encoder->Error.Jump))
+        {
+            ThrowJpegError("JpegRowWriter", m_encoder->Error);
+        }
+
+        jpeg_stdio_dest(&info, m_encoder->File);
+        info.image_width = width;
+        info.image_height = height;
+        info.input_components = 4;
+        info.in_color_space = JCS_EXT_BGRA;
+        jpeg_set_defaults(&info);
+        jpeg_set_quality(&info, quality, TRUE);
+        jpeg_start_compress(&info, TRUE);
+    }
+
+    JpegRowWriter::~JpegRowWriter() = default;
+
+    void JpegRowWriter::WriteRows(ConstImageView rows)
+    {
+        auto& info = m_encoder->Info;
+        if (rows.Width != info.image_width || rows.Height > info.image_height - info.next_scanline)
+        {
+            throw std::out_of_range("JpegRowWriter: rows do not match the image");
+        }
+
+        if (rows.Height == 0)
+        {
+            return;
+        }
+
+        if (setjmp(m_encoder->Error.Jump))
+        {
+            ThrowJpegError("JpegRowWriter", m_encoder->Error);
+        }
+
+        for (uint32_t y = 0; y < rows.Height;)
+        {
+            auto row = const_cast<JSAMPROW>(rows.Row(y));
+            y += jpeg_write_scanlines(&info, &row, 1);
+        }
+
+        if (info.next_scanline == info.image_height)
+        {
+            jpeg_finish_compress(&info);
+            std::FILE* file = std::exchange(m_encoder->File, nullptr);
+            if (std::fclose(file) != 0)
+            {
+                throw std::runtime_error("JpegRowWriter: cannot finish writing the file");
+            }
+        }
+    }
+
+    Image DecodeJpeg(const uint8_t* data, size_t size)
+    {
+        JpegRowReader reader(data, size);
+        auto image = Image::Uninitialized(reader.Width(), reader.Height());
+        reader.ReadRows(image.View());
+        return image;
+    }
+
+    uint32_t JpegScaleDenominator(uint32_t width, uint32_t height, uint32_t minWidth, uint32_t minHeight)
+    {
+        for (uint32_t denominator = 8; denominator > 1; denominator /= 2)
+        {
+            if ((width + denominator - 1) / denominator >= minWidth && (height + denominator - 1) / denominator >= minHeight)
+            {
+                return denominator;
+            }
+        }
+        return 1;
+    }
+
+    Image DecodeJpegThumbnail(std::string const& path, uint32_t maxWidth, uint32_t maxHeight, ThreadPool& pool,
+        PixelKernels const& kernels)
+    {
+        // The probe costs a few microseconds and tells the scale before the decoder starts.
+        auto probe = ProbeImageFile(path);
+        if (!probe || probe->Format != ImageFormat::Jpeg)
+        {
+            throw std::runtime_error("DecodeJpegThumbnail: " + path + " is not a JPEG file");
+        }
+
+        // The thumbnail is fitted as the photo is displayed, then shrunk in the stored
+        // orientation, which is the smaller image to turn upright.
+        auto size = FitWithin(probe->DisplayWidth(), probe->DisplayHeight(), maxWidth, maxHeight);
+        if (probe->Orientation >= 5)
+        {
+            std::swap(size.Width, size.Height);
+        }
+
+        JpegRowReader reader(path, JpegScaleDenominator(probe->Width, probe->Height, size.Width, size.Height));
+        auto decoded = Image::Uninitialized(reader.Width(), reader.Height());
+        reader.ReadRows(decoded.View());
+
+        if (decoded.Width() != size.Width || decoded.Height() != size.Height)
+        {
+            auto resized = Image::Uninitialized(size.Width, size.Height);
+            ResizeArea(decoded.View(), resized.View(), pool, kernels);
+            decoded = std::move(resized);
+        }
+
+        return probe->Orientation == 1 ? std::move(decoded) : ApplyOrientation(decoded.View(), probe->Orientation);
+    }
+}
@@ -0,0 +1,105 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "PixelKernels.h"
+#include "RowStream.h"
+#include "ThreadPool.h"
+#include <memory>
+#include <string>
+
+namespace PhotoEngine
+{
+    // Decodes a baseline or progressive JPEG file a few rows at a time. Grayscale and
+    // color files are expanded to opaque BGRA8.
+    //
+    // A scale denominator of 2, 4, or 8 decodes the image at that fraction of its size
+    // in the inverse DCT, which skips most of the work of a full decode; Width and
+    // Height are then the scaled size, rounded up.
+    //
+    // A file is read through stdio rather than memory mapped, so a file truncated or
+    // replaced while it is decoded, as happens during a camera import or a sync, fails
+    // with an error or a warning instead of a SIGBUS. DecodeSourceImage maps the file
+    // and uses the in-memory constructor.
+    class JpegRowReader : public RowReader
+    {
+    public:
+        explicit JpegRowReader(std::string const& path, uint32_t scaleDenominator = 1);
+
+        // Decodes a JPEG in memory, which must stay valid while the reader is used.
+        JpegRowReader(const uint8_t* data, size_t size, uint32_t scaleDenominator = 1);
+        ~JpegRowReader() override;
+
+        uint32_t Width() const override;
+        uint32_t Height() const override;
+
+        void ReadRows(ImageView rows) override;
+
+        // Returns the first warning libjpeg reported while decoding, e.g. "Premature end
+        // of JPEG file" for a file cut off inside its scan data, whose missing rows decode
+        // as gray; empty if the file decoded cleanly. Check it after the last rows are
+        // read to tell a damaged file from a good one.
+        std::string Warning() const;
+
+    private:
+        struct Decoder;
+
+        void Start(uint32_t scaleDenominator);
+
+        std::unique_ptr<Decoder> m_decoder;
+    };
+
+    // Encodes BGRA8 rows into a JPEG file as they arrive; alpha is dropped. The file is
+    // complete once every row has been written.
+    class JpegRowWriter : public RowWriter
+    {
+    public:
+        JpegRowWriter(std::string const& path, uint32_t width, uint32_t height, int quality = 90);
+        ~JpegRowWriter() override;
+
+        void WriteRows(ConstImageView rows) override;
+
+    private:
+        struct Encoder;
+        std::unique_ptr<Encoder> m_encoder;
+    };
+
+    // Decodes a whole JPEG in memory straight into the returned image. Throws
+    // std::runtime_error if it cannot be decoded; a damaged file that libjpeg can still
+    // decode is returned as decoded, for display.
+    Image DecodeJpeg(const uint8_t* data, size_t size);
+
+    // Returns the largest JPEG scale denominator (1, 2, 4, or 8) at which a width x height
+    // image still decodes to at least minWidth x minHeight.
+    uint32_t JpegScaleDenominator(uint32_t width, uint32_t height, uint32_t minWidth, uint32_t minHeight);
+
+    // Decodes a thumbnail of a JPEG file that fits in maxWidth x maxHeight: the file is
+    // decoded at the smallest DCT scale that still covers the thumbnail, then area
+    // averaged down to it. The file's EXIF orientation is applied, so the thumbnail is
+    // upright and fits the box as the photo is displayed. Throws std::runtime_error if
+    // the file cannot be decoded.
+    Image DecodeJpegThumbnail(std::string const& path, uint32_t maxWidth, uint32_t maxHeight, ThreadPool& pool,
+        PixelKernels const& kernels = GetPixelKernels());
+}
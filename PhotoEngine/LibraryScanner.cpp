@@ -0,0 +1,300 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "LibraryScanner.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Queues and counters shared by the walker, the workers, and the caller.
+        struct ScanState
+        {
+            std::mutex Mutex;
+            std::condition_variable PathAdded;
+            std::condition_variable PathTaken;
+            std::condition_variable ResultAdded;
+            std::condition_variable ResultTaken;
+
+            std::deque<std::filesystem::path> Paths;
+            std::vector<ScannedFile> Results;
+            bool WalkFinished{ false };
+            unsigned RunningWorkers{ 0 };
+            std::atomic<bool> Stopping{ false };
+
+            // Number of results the caller waits for before it takes a batch.
+            size_t BatchTarget{ 1 };
+
+            size_t Directories{ 0 };
+            size_t FilesFound{ 0 };
+            size_t FilesFailed{ 0 };
+        };
+
+        bool HasExtension(std::filesystem::path const& path, std::vector<std::string> const& extensions)
+        {
+            auto extension = path.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(),
+                [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+            return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+        }
+    }
+
+    void LibraryScanner::Scan(std::filesystem::path const& root, BatchHandler const& onBatch, Extractor const& extract)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const size_t maxQueued = std::max<size_t>(m_options.MaxQueuedFiles, 1);
+        const unsigned workerCount = m_options.WorkerCount > 0 ? m_options.WorkerCount :
+            std::max(std::thread::hardware_concurrency(), 4u);
+
+        m_statistics = {};
+        m_cancelled = false;
+        ScanState state;
+        state.RunningWorkers = workerCount;
+
+        auto stopping = [&] { return state.Stopping || m_cancelled; };
+
+        // The root is opened here so that a root that cannot be read is an error for the
+        // caller rather than an empty library.
+        const auto options = std::filesystem::directory_options::skip_permission_denied;
+        std::error_code rootError;
+        std::filesystem::directory_iterator rootEntries(root, options, rootError);
+        if (rootError)
+        {
+            throw std::filesystem::filesystem_error("LibraryScanner: cannot read the folder", root, rootError);
+        }
+        state.Directories = 1;
+
+        // Each folder is listed with its own iterator rather than one recursive iterator,
+        // which ends the whole walk at its first error; this way a folder that cannot be
+        // read, such as one removed during the scan, is counted and skipped.
+        std::thread walker([&, it = std::move(rootEntries)]() mutable
+        {
+            const std::filesystem::directory_iterator end;
+            std::vector<std::filesystem::path> folders;
+            for (;;)
+            {
+                std::error_code error;
+                for (; !error && it != end && !stopping(); it.increment(error))
+                {
+                    std::error_code typeError;
+                    if (it->is_directory(typeError))
+                    {
+                        // Like the recursive iterator, links to folders are not followed.
+                        if (!it->is_symlink(typeError))
+                        {
+                            folders.push_back(it->path());
+                        }
+                        std::lock_guard<std::mutex> lock(state.Mutex);
+                        state.Directories++;
+                        continue;
+                    }
+
+                    if (!it->is_regular_file(typeError) || !HasExtension(it->path(), m_options.Extensions))
+                    {
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(state.Mutex);
+                    state.PathTaken.wait(lock, [&] { return state.Paths.size() < maxQueued || stopping(); });
+                    state.Paths.push_back(it->path());
+                    state.FilesFound++;
+                    lock.unlock();
+                    state.PathAdded.notify_one();
+                }
+
+                if (error)
+                {
+                    std::lock_guard<std::mutex> lock(state.Mutex);
+                    state.FilesFailed++;
+                }
+
+                // Opens the next folder that can be read.
+                bool opened = false;
+                while (!opened && !folders.empty() && !stopping())
+                {
+                    const auto folder = std::move(folders.back());
+                    folders.pop_back();
+
+                    std::error_code openError;
+                    it = std::filesystem::directory_iterator(folder, options, openError);
+                    opened = !openError;
+                    if (openError)
+                    {
+                        std::lock_guard<std::mutex> lock(state.Mutex);
+                        state.FilesFailed++;
+                    }
+                }
+
+                if (!opened)
+                {
+                    break;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(state.Mutex);
+            state.WalkFinished = true;
+            state.PathAdded.notify_all();
+        });
+
+        auto work = [&]
+        {
+            for (;;)
+            {
+                ScannedFile file;
+                {
+                    std::unique_lock<std::mutex> lock(state.Mutex);
+                    state.PathAdded.wait(lock, [&] { return !state.Paths.empty() || state.WalkFinished || stopping(); });
+                    if (state.Paths.empty() || stopping())
+                    {
+                        break;
+                    }
+                    file.Path = std::move(state.Paths.front());
+                    state.Paths.pop_front();
+                }
+                state.PathTaken.notify_one();
+
+                std::error_code sizeError;
+                std::error_code timeError;
+                file.Size = std::filesystem::file_size(file.Path, sizeError);
+                file.LastWriteTime = std::filesystem::last_write_time(file.Path, timeError);
+
+                bool keep = !sizeError && !timeError;
+                bool failed = !keep;
+                if (keep && extract)
+                {
+                    try
+                    {
+                        keep = extract(file);
+                    }
+                    catch (...)
+                    {
+                        keep = false;
+                        failed = true;
+                    }
+                }
+
+                std::unique_lock<std::mutex> lock(state.Mutex);
+                state.FilesFailed += failed ? 1 : 0;
+                if (keep)
+                {
+                    state.ResultTaken.wait(lock, [&] { return state.Results.size() < maxQueued || stopping(); });
+                    state.Results.push_back(std::move(file));
+                    if (state.Results.size() >= state.BatchTarget)
+                    {
+                        state.ResultAdded.notify_one();
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(state.Mutex);
+            state.RunningWorkers--;
+            state.ResultAdded.notify_all();
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount);
+        for (unsigned i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back(work);
+        }
+
+        auto join = [&]
+        {
+            {
+                std::lock_guard<std::mutex> lock(state.Mutex);
+                state.Stopping = true;
+            }
+            state.ResultAdded.notify_all();
+            state.PathAdded.notify_all();
+            state.PathTaken.notify_all();
+            state.ResultTaken.notify_all();
+
+            walker.join();
+            for (auto&& worker : workers)
+            {
+                worker.join();
+            }
+        };
+
+        try
+        {
+            size_t batchSize = std::max<size_t>(m_options.FirstBatchSize, 1);
+            for (;;)
+            {
+                std::vector<ScannedFile> batch;
+                {
+                    // The result queue never holds more than maxQueued files.
+                    std::unique_lock<std::mutex> lock(state.Mutex);
+                    state.BatchTarget = std::min(batchSize, maxQueued);
+                    const auto deadline = std::chrono::steady_clock::now() + m_options.MaxBatchDelay;
+                    state.ResultAdded.wait_until(lock, deadline, [&]
+                    {
+                        return state.Results.size() >= state.BatchTarget || state.RunningWorkers == 0 || m_cancelled;
+                    });
+
+                    if (m_cancelled || (state.Results.empty() && state.RunningWorkers == 0))
+                    {
+                        break;
+                    }
+
+                    const size_t count = std::min(batchSize, state.Results.size());
+                    batch.assign(std::make_move_iterator(state.Results.begin()), std::make_move_iterator(state.Results.begin() + count));
+                    state.Results.erase(state.Results.begin(), state.Results.begin() + count);
+                }
+                state.ResultTaken.notify_all();
+
+                if (batch.empty())
+                {
+                    continue;
+                }
+
+                if (m_statistics.Batches++ == 0)
+                {
+                    m_statistics.TimeToFirstBatch = std::chrono::steady_clock::now() - start;
+                }
+                m_statistics.FilesReported += batch.size();
+                onBatch(std::move(batch));
+                batchSize = std::min(batchSize * 2, std::max(m_options.MaxBatchSize, m_options.FirstBatchSize));
+            }
+        }
+        catch (...)
+        {
+            join();
+            throw;
+        }
+
+        join();
+        m_statistics.Directories = state.Directories;
+        m_statistics.FilesFound = state.FilesFound;
+        m_statistics.FilesFailed = state.FilesFailed;
+        m_statistics.Duration = std::chrono::steady_clock::now() - start;
+    }
+}
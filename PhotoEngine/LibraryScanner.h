@@ -0,0 +1,134 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace PhotoEngine
+{
+    // A file found by LibraryScanner.
+    struct ScannedFile
+    {
+        std::filesystem::path Path;
+        uint64_t Size{ 0 };
+        std::filesystem::file_time_type LastWriteTime{};
+    };
+
+    struct LibraryScanOptions
+    {
+        // Extensions of the files to report, lower case with the dot. Matching ignores case.
+        std::vector<std::string> Extensions{ ".jpg", ".png", ".gif" };
+
+        // Threads reading file properties; 0 picks the hardware thread count, at least 4.
+        // Property reads mostly wait on the disk, so more threads than cores can help.
+        unsigned WorkerCount{ 0 };
+
+        // Paths and results queued between the walker, the workers, and the caller. The
+        // walker and the workers wait when their queue is full.
+        size_t MaxQueuedFiles{ 1024 };
+
+        // The first batch is reported after FirstBatchSize files so the first screenful
+        // appears at once; each later batch may hold twice as many, up to MaxBatchSize.
+        size_t FirstBatchSize{ 64 };
+        size_t MaxBatchSize{ 4096 };
+
+        // A partial batch is reported after this long, so a slow scan still streams.
+        std::chrono::milliseconds MaxBatchDelay{ 100 };
+    };
+
+    struct LibraryScanStatistics
+    {
+        size_t Directories{ 0 };
+        size_t FilesFound{ 0 };
+        size_t FilesReported{ 0 };
+
+        // Files and folders below the root that could not be read, and files that the
+        // extractor threw for.
+        size_t FilesFailed{ 0 };
+
+        size_t Batches{ 0 };
+        std::chrono::steady_clock::duration TimeToFirstBatch{};
+        std::chrono::steady_clock::duration Duration{};
+    };
+
+    // Finds the image files under a folder and reads their properties in parallel,
+    // reporting them in batches while the walk is still running. This is the streaming
+    // counterpart of the Deep file query in MainPage::GetItemsAsync.
+    //
+    // A walker thread enumerates the folders and queues matching paths; a bounded pool of
+    // workers reads each file's size and time and runs the caller's extractor; the
+    // calling thread receives the results in batches.
+    class LibraryScanner
+    {
+    public:
+        // Reads more properties of a file on a worker thread. Returns false to leave the
+        // file out of the results.
+        using Extractor = std::function<bool(ScannedFile&)>;
+
+        // Receives a batch of files on the thread that called Scan.
+        using BatchHandler = std::function<void(std::vector<ScannedFile>&&)>;
+
+        explicit LibraryScanner(LibraryScanOptions const& options = {}) :
+            m_options(options)
+        {
+        }
+
+        LibraryScanOptions const& Options() const
+        {
+            return m_options;
+        }
+
+        // Scans root and passes the matching files to onBatch, in the order their
+        // properties were read. Blocks until every file is reported or Cancel is called.
+        // Folders and files below root that cannot be read are skipped and counted as
+        // failed; if root itself cannot be read, std::filesystem::filesystem_error is
+        // thrown. If onBatch throws, the scan stops and the exception is rethrown.
+        void Scan(std::filesystem::path const& root, BatchHandler const& onBatch, Extractor const& extract = {});
+
+        // Makes a running Scan return early. May be called from any thread.
+        void Cancel()
+        {
+            m_cancelled = true;
+        }
+
+        // Counters of the last Scan.
+        LibraryScanStatistics const& Statistics() const
+        {
+            return m_statistics;
+        }
+
+    private:
+        LibraryScanOptions m_options;
+        LibraryScanStatistics m_statistics;
+        std::atomic<bool> m_cancelled{ false };
+    };
+}
@@ -0,0 +1,806 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "LibraryWatcher.h"
+#include "ImageProbe.h"
+#include <algorithm>
+#include <cctype>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // A change read from the system, before it is filtered and coalesced.
+        struct WatchEvent
+        {
+            LibraryChange Change;
+
+            // True if the path is a folder, or might be one.
+            bool Directory{ false };
+        };
+
+        bool IsUnder(std::filesystem::path const& path, std::filesystem::path const& folder)
+        {
+            auto mismatch = std::mismatch(folder.begin(), folder.end(), path.begin(), path.end());
+            return mismatch.first == folder.end() && mismatch.second != path.end();
+        }
+    }
+
+    void LibraryChangeSet::Add(LibraryChange change)
+    {
+        if (m_rescan)
+        {
+            return;
+        }
+
+        switch (change.Type)
+        {
+        case LibraryChangeType::Rescan:
+            m_rescan = true;
+            m_changes.clear();
+            return;
+
+        case LibraryChangeType::Added:
+        case LibraryChangeType::Modified:
+        {
+            auto [existing, inserted] = m_changes.emplace(change.Path, change);
+            if (!inserted && existing->second.Type == LibraryChangeType::Removed)
+            {
+                existing->second.Type = LibraryChangeType::Modified;
+            }
+            return;
+        }
+
+        case LibraryChangeType::Removed:
+        {
+            // A removed folder takes the changes under it with it.
+            for (auto it = m_changes.begin(); it != m_changes.end();)
+            {
+                if (IsUnder(it->first, change.Path))
+                {
+                    if (it->second.Type == LibraryChangeType::Renamed && !IsUnder(it->second.OldPath, change.Path))
+                    {
+                        m_changes[it->second.OldPath] = { LibraryChangeType::Removed, it->second.OldPath, {} };
+                    }
+                    it = m_changes.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            auto existing = m_changes.find(change.Path);
+            if (existing == m_changes.end())
+            {
+                m_changes.emplace(change.Path, change);
+                return;
+            }
+
+            const auto previous = existing->second;
+            m_changes.erase(existing);
+            if (previous.Type == LibraryChangeType::Renamed)
+            {
+                m_changes[previous.OldPath] = { LibraryChangeType::Removed, previous.OldPath, {} };
+            }
+            else if (previous.Type != LibraryChangeType::Added)
+            {
+                m_changes.emplace(change.Path, change);
+            }
+            return;
+        }
+
+        case LibraryChangeType::Renamed:
+        {
+            LibraryChange result{ LibraryChangeType::Renamed, change.Path, change.OldPath };
+            if (auto existing = m_changes.find(change.OldPath); existing != m_changes.end())
+            {
+                if (existing->second.Type == LibraryChangeType::Added || existing->second.Type == LibraryChangeType::Removed)
+                {
+                    result = { LibraryChangeType::Added, change.Path, {} };
+                }
+                else if (existing->second.Type == LibraryChangeType::Renamed)
+                {
+                    result.OldPath = existing->second.OldPath;
+                }
+                m_changes.erase(existing);
+            }
+
+            // Renamed back to where it started.
+            if (result.Type == LibraryChangeType::Renamed && result.OldPath == result.Path)
+            {
+                result = { LibraryChangeType::Modified, change.Path, {} };
+            }
+            m_changes[change.Path] = result;
+            return;
+        }
+        }
+    }
+
+    std::vector<LibraryChange> LibraryChangeSet::Take()
+    {
+        std::vector<LibraryChange> changes;
+        if (m_rescan)
+        {
+            changes.push_back({ LibraryChangeType::Rescan, {}, {} });
+        }
+        else
+        {
+            changes.reserve(m_changes.size());
+            for (auto&& [path, change] : m_changes)
+            {
+                changes.push_back(std::move(change));
+            }
+        }
+
+        m_changes.clear();
+        m_rescan = false;
+        return changes;
+    }
+
+#if defined(__linux__)
+
+    struct LibraryWatcher::Backend
+    {
+        static constexpr uint32_t Mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR;
+
+        int Notify{ -1 };
+        int StopPipe[2]{ -1, -1 };
+        std::unordered_map<int, std::filesystem::path> Folders;
+
+        explicit Backend(std::filesystem::path const& root)
+        {
+            Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (Notify < 0 || pipe2(StopPipe, O_NONBLOCK | O_CLOEXEC) != 0)
+            {
+                Close();
+                throw std::runtime_error("LibraryWatcher: cannot create an inotify instance");
+            }
+
+            std::vector<WatchEvent> ignored;
+            if (!Watch(root, false, ignored))
+            {
+                Close();
+                throw std::runtime_error("LibraryWatcher: cannot watch " + root.string());
+            }
+        }
+
+        ~Backend()
+        {
+            Close();
+        }
+
+        void Close()
+        {
+            for (int fd : { Notify, StopPipe[0], StopPipe[1] })
+            {
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+            }
+        }
+
+        // inotify watches single folders, so every folder of the tree gets a watch.
+        bool Watch(std::filesystem::path const& folder, bool report, std::vector<WatchEvent>& events)
+        {
+            const int watch = inotify_add_watch(Notify, folder.c_str(), Mask);
+            if (watch < 0)
+            {
+                return false;
+            }
+            Folders[watch] = folder;
+
+            std::error_code error;
+            for (std::filesystem::directory_iterator it(folder, std::filesystem::directory_options::skip_permission_denied, error), end;
+                !error && it != end; it.increment(error))
+            {
+                std::error_code typeError;
+                if (it->is_directory(typeError) && !it->is_symlink(typeError))
+                {
+                    Watch(it->path(), report, events);
+                }
+                else if (report)
+                {
+                    events.push_back({ { LibraryChangeType::Added, it->path(), {} }, false });
+                }
+            }
+            return true;
+        }
+
+        // Stops watching a folder that left the tree, and the folders under it.
+        void Unwatch(std::filesystem::path const& folder)
+        {
+            for (auto it = Folders.begin(); it != Folders.end();)
+            {
+                if (it->second == folder || IsUnder(it->second, folder))
+                {
+                    inotify_rm_watch(Notify, it->first);
+                    it = Folders.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+
+        // Waits up to timeout milliseconds, or without limit if it is negative, and
+        // appends the changes read. Returns false once Stop has been called.
+        bool Read(int timeout, std::vector<WatchEvent>& events)
+        {
+            pollfd descriptors[2] = { { Notify, POLLIN, 0 }, { StopPipe[0], POLLIN, 0 } };
+            const int ready = poll(descriptors, 2, timeout);
+            if (ready < 0)
+            {
+                return errno == EINTR;
+            }
+            if (descriptors[1].revents != 0)
+            {
+                return false;
+            }
+            if ((descriptors[0].revents & POLLIN) == 0)
+            {
+                return true;
+            }
+
+            // The two halves of a rename carry the same cookie and arrive together.
+            struct Move
+            {
+                uint32_t Cookie;
+                std::filesystem::path Path;
+                bool Directory;
+            };
+            std::optional<Move> movedFrom;
+            auto flushMove = [&]
+            {
+                if (movedFrom)
+                {
+                    if (movedFrom->Directory)
+                    {
+                        Unwatch(movedFrom->Path);
+                    }
+                    events.push_back({ { LibraryChangeType::Removed, movedFrom->Path, {} }, movedFrom->Directory });
+                    movedFrom.reset();
+                }
+            };
+
+            alignas(inotify_event) char buffer[64 * 1024];
+            for (;;)
+            {
+                const ssize_t length = read(Notify, buffer, sizeof(buffer));
+                if (length <= 0)
+                {
+                    break;
+                }
+
+                for (const char* p = buffer; p < buffer + length;)
+                {
+                    auto event = reinterpret_cast<const inotify_event*>(p);
+                    p += sizeof(inotify_event) + event->len;
+
+                    if (event->mask & IN_Q_OVERFLOW)
+                    {
+                        events.push_back({ { LibraryChangeType::Rescan, {}, {} }, false });
+                        continue;
+                    }
+                    if (event->mask & IN_IGNORED)
+                    {
+                        Folders.erase(event->wd);
+                        continue;
+                    }
+
+                    auto folder = Folders.find(event->wd);
+                    if (folder == Folders.end() || event->len == 0)
+                    {
+                        continue;
+                    }
+                    const auto path = folder->second / event->name;
+                    const bool directory = (event->mask & IN_ISDIR) != 0;
+
+                    if (event->mask & IN_MOVED_FROM)
+                    {
+                        flushMove();
+                        movedFrom = Move{ event->cookie, path, directory };
+                    }
+                    else if (event->mask & IN_MOVED_TO)
+                    {
+                        const bool paired = movedFrom && movedFrom->Cookie == event->cookie;
+                        if (paired && !directory)
+                        {
+                            events.push_back({ { LibraryChangeType::Renamed, path, movedFrom->Path }, false });
+                            movedFrom.reset();
+                        }
+                        else
+                        {
+                            // A moved folder is reported as removed from its old place
+                            // and its files as added in the new one.
+                            if (paired)
+                            {
+                                flushMove();
+                            }
+                            if (directory)
+                            {
+                                Watch(path, true, events);
+                            }
+                            else
+                            {
+                                events.push_back({ { LibraryChangeType::Added, path, {} }, false });
+                            }
+                        }
+                    }
+                    else if (event->mask & IN_CREATE)
+                    {
+                        if (directory)
+                        {
+                            Watch(path, true, events);
+                        }
+                        else
+                        {
+                            events.push_back({ { LibraryChangeType::Added, path, {} }, false });
+                        }
+                    }
+                    else if (event->mask & IN_DELETE)
+                    {
+                        events.push_back({ { LibraryChangeType::Removed, path, {} }, directory });
+                    }
+                    else if (event->mask & IN_CLOSE_WRITE)
+                    {
+                        events.push_back({ { LibraryChangeType::Modified, path, {} }, false });
+                    }
+                }
+            }
+
+            // A rename whose other half never came moved the file out of the tree.
+            flushMove();
+            return true;
+        }
+
+        void Stop()
+        {
+            const char wake = 0;
+            [[maybe_unused]] auto written = write(StopPipe[1], &wake, 1);
+        }
+    };
+
+#elif defined(_WIN32)
+
+    struct LibraryWatcher::Backend
+    {
+        static constexpr DWORD Filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+            FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+
+        std::filesystem::path Root;
+        HANDLE Folder{ INVALID_HANDLE_VALUE };
+        HANDLE StopEvent{ nullptr };
+        OVERLAPPED Overlapped{};
+        std::vector<DWORD> Buffer = std::vector<DWORD>(16 * 1024);
+        bool Pending{ false };
+
+        // Reports the files already in a folder that has just appeared in the tree.
+        static void ReportFiles(std::filesystem::path const& folder, std::vector<WatchEvent>& events)
+        {
+            std::error_code error;
+            for (std::filesystem::recursive_directory_iterator it(folder, std::filesystem::directory_options::skip_permission_denied, error), end;
+                !error && it != end; it.increment(error))
+            {
+                if (it->is_regular_file(error))
+                {
+                    events.push_back({ { LibraryChangeType::Added, it->path(), {} }, false });
+                }
+            }
+        }
+
+        explicit Backend(std::filesystem::path const& root) :
+            Root(root)
+        {
+            Folder = CreateFileW(root.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+            Overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            StopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            if (Folder == INVALID_HANDLE_VALUE || !Overlapped.hEvent || !StopEvent || !Start())
+            {
+                Close();
+                throw std::runtime_error("LibraryWatcher: cannot watch " + root.string());
+            }
+        }
+
+        ~Backend()
+        {
+            if (Pending)
+            {
+                DWORD bytes = 0;
+                CancelIoEx(Folder, &Overlapped);
+                GetOverlappedResult(Folder, &Overlapped, &bytes, TRUE);
+            }
+            Close();
+        }
+
+        void Close()
+        {
+            if (Folder != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(Folder);
+            }
+            for (HANDLE handle : { Overlapped.hEvent, StopEvent })
+            {
+                if (handle)
+                {
+                    CloseHandle(handle);
+                }
+            }
+        }
+
+        bool Start()
+        {
+            ResetEvent(Overlapped.hEvent);
+            Pending = ReadDirectoryChangesW(Folder, Buffer.data(), static_cast<DWORD>(Buffer.size() * sizeof(DWORD)), TRUE,
+                Filter, nullptr, &Overlapped, nullptr) != FALSE;
+            return Pending;
+        }
+
+        bool Read(int timeout, std::vector<WatchEvent>& events)
+        {
+            HANDLE handles[2] = { Overlapped.hEvent, StopEvent };
+            const DWORD result = WaitForMultipleObjects(2, handles, FALSE, timeout < 0 ? INFINITE : static_cast<DWORD>(timeout));
+            if (result == WAIT_OBJECT_0 + 1)
+            {
+                return false;
+            }
+            if (result != WAIT_OBJECT_0)
+            {
+                return true;
+            }
+
+            DWORD bytes = 0;
+            Pending = false;
+            if (!GetOverlappedResult(Folder, &Overlapped, &bytes, FALSE) || bytes == 0)
+            {
+                // The buffer overflowed and the changes in it are lost.
+                events.push_back({ { LibraryChangeType::Rescan, {}, {} }, false });
+            }
+            else
+            {
+                std::filesystem::path renamedFrom;
+                auto record = reinterpret_cast<const uint8_t*>(Buffer.data());
+                for (;;)
+                {
+                    auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(record);
+                    const auto path = Root / std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                    std::error_code error;
+                    const bool directory = std::filesystem::is_directory(path, error);
+
+                    switch (info->Action)
+                    {
+                    case FILE_ACTION_ADDED:
+                        if (directory)
+                        {
+                            ReportFiles(path, events);
+                        }
+                        else
+                        {
+                            events.push_back({ { LibraryChangeType::Added, path, {} }, false });
+                        }
+                        break;
+                    case FILE_ACTION_REMOVED:
+                        // The path is gone, so it might have been a folder.
+                        events.push_back({ { LibraryChangeType::Removed, path, {} }, true });
+                        break;
+                    case FILE_ACTION_MODIFIED:
+                        if (!directory)
+                        {
+                            events.push_back({ { LibraryChangeType::Modified, path, {} }, false });
+                        }
+                        break;
+                    case FILE_ACTION_RENAMED_OLD_NAME:
+                        renamedFrom = path;
+                        break;
+                    case FILE_ACTION_RENAMED_NEW_NAME:
+                        if (directory)
+                        {
+                            events.push_back({ { LibraryChangeType::Removed, renamedFrom, {} }, true });
+                            ReportFiles(path, events);
+                        }
+                        else
+                        {
+                            events.push_back({ { LibraryChangeType::Renamed, path, renamedFrom }, false });
+                        }
+                        break;
+                    }
+
+                    if (info->NextEntryOffset == 0)
+                    {
+                        break;
+                    }
+                    record += info->NextEntryOffset;
+                }
+            }
+
+            if (!Start())
+            {
+                events.push_back({ { LibraryChangeType::Rescan, {}, {} }, false });
+            }
+            return true;
+        }
+
+        void Stop()
+        {
+            SetEvent(StopEvent);
+        }
+    };
+
+#else
+
+    struct LibraryWatcher::Backend
+    {
+        explicit Backend(std::filesystem::path const&)
+        {
+            throw std::runtime_error("LibraryWatcher: file system notifications are not supported on this platform");
+        }
+
+        bool Read(int, std::vector<WatchEvent>&)
+        {
+            return false;
+        }
+
+        void Stop()
+        {
+        }
+    };
+
+#endif
+
+    LibraryWatcher::LibraryWatcher(std::filesystem::path const& root, BatchHandler onBatch, LibraryWatchOptions const& options) :
+        m_options(options),
+        m_onBatch(std::move(onBatch)),
+        m_backend(std::make_unique<Backend>(root))
+    {
+        m_thread = std::thread([this] { Run(); });
+    }
+
+    LibraryWatcher::~LibraryWatcher()
+    {
+        m_backend->Stop();
+        m_thread.join();
+    }
+
+    LibraryWatchStatistics LibraryWatcher::Statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    bool LibraryWatcher::IsImage(std::filesystem::path const& path) const
+    {
+        auto extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return std::find(m_options.Extensions.begin(), m_options.Extensions.end(), extension) != m_options.Extensions.end();
+    }
+
+    void LibraryWatcher::Filter(LibraryChange change, bool directory, LibraryChangeSet& pending) const
+    {
+        switch (change.Type)
+        {
+        case LibraryChangeType::Rescan:
+            break;
+        case LibraryChangeType::Removed:
+            if (!directory && !IsImage(change.Path))
+            {
+                return;
+            }
+            break;
+        case LibraryChangeType::Added:
+        case LibraryChangeType::Modified:
+            if (!IsImage(change.Path))
+            {
+                return;
+            }
+            break;
+        case LibraryChangeType::Renamed:
+        {
+            // Imports often write a temporary name and rename it when the file is complete.
+            const bool wasImage = IsImage(change.OldPath);
+            const bool isImage = IsImage(change.Path);
+            if (!wasImage && !isImage)
+            {
+                return;
+            }
+            if (!wasImage)
+            {
+                change = { LibraryChangeType::Added, change.Path, {} };
+            }
+            else if (!isImage)
+            {
+                change = { LibraryChangeType::Removed, change.OldPath, {} };
+            }
+            break;
+        }
+        }
+        pending.Add(std::move(change));
+    }
+
+    void LibraryWatcher::Run()
+    {
+        using Clock = std::chrono::steady_clock;
+        LibraryChangeSet pending;
+        std::vector<WatchEvent> events;
+        Clock::time_point firstChange;
+        Clock::time_point lastChange;
+
+        for (;;)
+        {
+            auto deadline = [&] { return std::min(lastChange + m_options.Debounce, firstChange + m_options.MaxDelay); };
+
+            int timeout = -1;
+            if (!pending.Empty())
+            {
+                const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline() - Clock::now());
+                timeout = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+            }
+
+            events.clear();
+            if (!m_backend->Read(timeout, events))
+            {
+                return;
+            }
+
+            const auto now = Clock::now();
+            if (!events.empty())
+            {
+                const bool wasEmpty = pending.Empty();
+                for (auto&& event : events)
+                {
+                    Filter(std::move(event.Change), event.Directory, pending);
+                }
+                if (wasEmpty)
+                {
+                    firstChange = now;
+                }
+                lastChange = now;
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_statistics.Events += events.size();
+            }
+
+            if (!pending.Empty() && now >= deadline())
+            {
+                auto batch = pending.Take();
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_statistics.Changes += batch.size();
+                    m_statistics.Batches++;
+                }
+                m_onBatch(std::move(batch));
+            }
+        }
+    }
+
+    bool ReadPhotoMetadata(PhotoMetadata& metadata)
+    {
+        const auto path = std::filesystem::u8path(metadata.Path);
+        std::error_code sizeError;
+        std::error_code timeError;
+        const auto size = std::filesystem::file_size(path, sizeError);
+        const auto time = std::filesystem::last_write_time(path, timeError);
+        const auto probe = ProbeImageFile(path);
+        if (sizeError || timeError || !probe)
+        {
+            return false;
+        }
+
+        metadata.Size = size;
+        metadata.LastWriteTime = FileTimeTicks(time);
+        metadata.Width = probe->DisplayWidth();
+        metadata.Height = probe->DisplayHeight();
+        metadata.Title = probe->Title;
+        metadata.DisplayName = path.stem().u8string();
+
+        // The shell's type name, such as "JPG File".
+        auto type = path.extension().u8string();
+        type.erase(0, 1);
+        std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+        metadata.DisplayType = type + " File";
+        return true;
+    }
+
+    std::vector<PhotoMetadata> ApplyLibraryChanges(MetadataIndex const& index, std::vector<LibraryChange> const& changes,
+        std::function<bool(PhotoMetadata&)> const& read)
+    {
+        std::unordered_set<std::string> replaced;
+        std::unordered_set<std::string> removedFolders;
+        std::vector<PhotoMetadata> entries;
+        for (auto&& change : changes)
+        {
+            replaced.insert(change.Path.u8string());
+            switch (change.Type)
+            {
+            case LibraryChangeType::Removed:
+                // A removed file is dropped by replaced; only folders drop the entries under them.
+                if (!index.Contains(change.Path.u8string()))
+                {
+                    removedFolders.insert(change.Path.u8string());
+                }
+                break;
+            case LibraryChangeType::Renamed:
+                replaced.insert(change.OldPath.u8string());
+                [[fallthrough]];
+            case LibraryChangeType::Added:
+            case LibraryChangeType::Modified:
+            {
+                PhotoMetadata metadata;
+                metadata.Path = change.Path.u8string();
+                if (read(metadata))
+                {
+                    entries.push_back(std::move(metadata));
+                }
+                break;
+            }
+            case LibraryChangeType::Rescan:
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < index.Size(); i++)
+        {
+            const auto entry = index.Entry(i);
+            if (replaced.count(std::string(entry.Path)) != 0)
+            {
+                continue;
+            }
+
+            // Looks up each folder above the entry, rather than testing every removal.
+            bool removed = false;
+            if (!removedFolders.empty())
+            {
+                for (auto folder = std::filesystem::u8path(entry.Path).parent_path(); folder.has_relative_path() && !removed; folder = folder.parent_path())
+                {
+                    removed = removedFolders.count(folder.u8string()) != 0;
+                }
+            }
+            if (removed)
+            {
+                continue;
+            }
+
+            entries.push_back({ std::string(entry.Path), entry.Size, entry.LastWriteTime, entry.Width, entry.Height,
+                std::string(entry.Title), std::string(entry.DisplayName), std::string(entry.DisplayType) });
+        }
+        return entries;
+    }
+}
@@ -0,0 +1,154 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "MetadataIndex.h"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PhotoEngine
+{
+    enum class LibraryChangeType
+    {
+        Added,
+        Removed,
+        Modified,
+        Renamed,
+
+        // Events were lost, for example because the system's event queue overflowed; the
+        // library must be scanned again.
+        Rescan,
+    };
+
+    struct LibraryChange
+    {
+        LibraryChangeType Type{ LibraryChangeType::Added };
+        std::filesystem::path Path;
+
+        // The previous path of a renamed file.
+        std::filesystem::path OldPath;
+    };
+
+    // Coalesces file changes to their net effect per path: a file added and then removed
+    // is not reported, one removed and added again is modified, one added and then
+    // renamed is added under its new name. A removed path may be a folder, in which case
+    // every file under it is gone.
+    class LibraryChangeSet
+    {
+    public:
+        void Add(LibraryChange change);
+
+        bool Empty() const
+        {
+            return m_changes.empty() && !m_rescan;
+        }
+
+        // Returns the net changes and empties the set. A Rescan replaces all other changes.
+        std::vector<LibraryChange> Take();
+
+    private:
+        std::map<std::filesystem::path, LibraryChange> m_changes;
+        bool m_rescan{ false };
+    };
+
+    struct LibraryWatchOptions
+    {
+        // Extensions of the files to report, lower case with the dot. Matching ignores case.
+        std::vector<std::string> Extensions{ ".jpg", ".png", ".gif" };
+
+        // A batch is reported once no change has arrived for this long...
+        std::chrono::milliseconds Debounce{ 250 };
+
+        // ...or once its first change is this old, so a long import still shows progress.
+        std::chrono::milliseconds MaxDelay{ 2000 };
+    };
+
+    struct LibraryWatchStatistics
+    {
+        // Events read from the system, and net changes reported in batches.
+        size_t Events{ 0 };
+        size_t Changes{ 0 };
+        size_t Batches{ 0 };
+    };
+
+    // Watches a folder tree for image files that are added, removed, modified, or
+    // renamed, and reports the changes in debounced, coalesced batches, so an import of
+    // thousands of files becomes a few updates. Uses inotify on Linux and
+    // ReadDirectoryChangesW on Windows.
+    //
+    // Batches are delivered on the watcher's own thread. Folders created in the tree are
+    // watched as they appear, and the files already in them are reported as added.
+    class LibraryWatcher
+    {
+    public:
+        // Receives a batch of changes on the watcher's thread. Must not throw.
+        using BatchHandler = std::function<void(std::vector<LibraryChange>&&)>;
+
+        // Starts watching root. Throws std::runtime_error if it cannot be watched.
+        LibraryWatcher(std::filesystem::path const& root, BatchHandler onBatch, LibraryWatchOptions const& options = {});
+
+        // Stops watching. A pending partial batch is dropped.
+        ~LibraryWatcher();
+
+        LibraryWatcher(LibraryWatcher const&) = delete;
+        LibraryWatcher& operator=(LibraryWatcher const&) = delete;
+
+        LibraryWatchStatistics Statistics() const;
+
+    private:
+        struct Backend;
+
+        bool IsImage(std::filesystem::path const& path) const;
+        void Filter(LibraryChange change, bool directory, LibraryChangeSet& pending) const;
+        void Run();
+
+        LibraryWatchOptions m_options;
+        BatchHandler m_onBatch;
+        std::unique_ptr<Backend> m_backend;
+
+        mutable std::mutex m_mutex;
+        LibraryWatchStatistics m_statistics;
+        std::thread m_thread;
+    };
+
+    // Fills the size, last write time, dimensions, title, and display name and type of
+    // the file at metadata.Path from its header. Returns false if it is not a readable
+    // JPEG, PNG, or GIF.
+    bool ReadPhotoMetadata(PhotoMetadata& metadata);
+
+    // Returns the entries of index updated with a batch of changes, for
+    // MetadataIndex::Write. Added, modified, and renamed files are read with read;
+    // entries under removed paths are dropped. A Rescan change is not handled here: the
+    // caller scans the library again instead.
+    std::vector<PhotoMetadata> ApplyLibraryChanges(MetadataIndex const& index, std::vector<LibraryChange> const& changes,
+        std::function<bool(PhotoMetadata&)> const& read = ReadPhotoMetadata);
+}
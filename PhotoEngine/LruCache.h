@@ -0,0 +1,136 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace PhotoEngine
+{
+    // Map with a fixed capacity that evicts its least recently used entry to make room,
+    // and counts how often lookups succeed. Values keep their address until they are
+    // evicted. Not thread-safe.
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class LruCache
+    {
+    public:
+        explicit LruCache(size_t capacity) :
+            m_capacity(std::max<size_t>(capacity, 1))
+        {
+        }
+
+        size_t Capacity() const
+        {
+            return m_capacity;
+        }
+
+        size_t Size() const
+        {
+            return m_entries.size();
+        }
+
+        // Number of Find calls that found their key.
+        size_t Hits() const
+        {
+            return m_hits;
+        }
+
+        // Number of Find calls that did not find their key.
+        size_t Misses() const
+        {
+            return m_misses;
+        }
+
+        // Number of entries removed to make room for new ones.
+        size_t Evictions() const
+        {
+            return m_evictions;
+        }
+
+        // Returns the value stored for key and marks it most recently used, or returns
+        // nullptr if there is none.
+        Value* Find(Key const& key)
+        {
+            auto found = m_index.find(key);
+            if (found == m_index.end())
+            {
+                m_misses++;
+                return nullptr;
+            }
+
+            m_hits++;
+            m_entries.splice(m_entries.begin(), m_entries, found->second);
+            return &found->second->second;
+        }
+
+        // Stores value for key as the most recently used entry, evicting the least
+        // recently used one if the cache is full.
+        Value& Insert(Key const& key, Value value)
+        {
+            auto found = m_index.find(key);
+            if (found != m_index.end())
+            {
+                found->second->second = std::move(value);
+                m_entries.splice(m_entries.begin(), m_entries, found->second);
+                return found->second->second;
+            }
+
+            if (m_entries.size() == m_capacity)
+            {
+                m_index.erase(m_entries.back().first);
+                m_entries.pop_back();
+                m_evictions++;
+            }
+
+            m_entries.emplace_front(key, std::move(value));
+            m_index.emplace(key, m_entries.begin());
+            return m_entries.front().second;
+        }
+
+        // Removes every entry. The counters are kept.
+        void Clear()
+        {
+            m_index.clear();
+            m_entries.clear();
+        }
+
+    private:
+        using Entry = std::pair<Key, Value>;
+
+        size_t m_capacity;
+
+        // Most recently used first.
+        std::list<Entry> m_entries;
+        std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> m_index;
+
+        size_t m_hits{ 0 };
+        size_t m_misses{ 0 };
+        size_t m_evictions{ 0 };
+    };
+}
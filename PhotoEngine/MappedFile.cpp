@@ -0,0 +1,172 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "MappedFile.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PhotoEngine
+{
+    MappedFile::MappedFile(std::filesystem::path const& path, MappedFileAccess access)
+    {
+        const std::string error = "MappedFile: cannot map " + path.string();
+
+#if defined(_WIN32)
+        const DWORD flags = access == MappedFileAccess::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN :
+            access == MappedFileAccess::Random ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL;
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+            OPEN_EXISTING, flags, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error(error);
+        }
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            throw std::runtime_error(error);
+        }
+
+        if (size.QuadPart > 0)
+        {
+            // The view keeps the mapping alive, so both handles can be closed.
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (mapping)
+            {
+                CloseHandle(mapping);
+            }
+            if (!view)
+            {
+                CloseHandle(file);
+                throw std::runtime_error(error);
+            }
+            m_data = static_cast<const uint8_t*>(view);
+            m_size = static_cast<size_t>(size.QuadPart);
+        }
+        CloseHandle(file);
+#else
+        const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0)
+        {
+            throw std::runtime_error(error);
+        }
+
+        struct stat status{};
+        if (fstat(file, &status) != 0)
+        {
+            close(file);
+            throw std::runtime_error(error);
+        }
+
+        if (status.st_size > 0)
+        {
+            void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+            if (view == MAP_FAILED)
+            {
+                close(file);
+                throw std::runtime_error(error);
+            }
+            m_data = static_cast<const uint8_t*>(view);
+            m_size = static_cast<size_t>(status.st_size);
+
+            if (access != MappedFileAccess::Normal)
+            {
+                posix_madvise(view, m_size, access == MappedFileAccess::Sequential ? POSIX_MADV_SEQUENTIAL : POSIX_MADV_RANDOM);
+            }
+        }
+        close(file);
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept :
+        m_data(std::exchange(other.m_data, nullptr)),
+        m_size(std::exchange(other.m_size, 0))
+    {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    void MappedFile::Prefetch(size_t offset, size_t length) const
+    {
+        if (offset >= m_size)
+        {
+            return;
+        }
+        length = std::min(length, m_size - offset);
+
+#if defined(_WIN32)
+#if _WIN32_WINNT >= 0x0602
+        WIN32_MEMORY_RANGE_ENTRY range{ const_cast<uint8_t*>(m_data + offset), length };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+        // The advice must start on a page boundary.
+        static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t start = offset - offset % pageSize;
+        posix_madvise(const_cast<uint8_t*>(m_data + start), length + offset - start, POSIX_MADV_WILLNEED);
+#endif
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data)
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile(m_data);
+#else
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
@@ -0,0 +1,80 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace PhotoEngine
+{
+    // How a mapping will be read, so the system can read ahead of it or not.
+    enum class MappedFileAccess
+    {
+        Normal,
+        Sequential,
+        Random,
+    };
+
+    // A read-only memory mapping of a whole file. Pages are read from disk the first
+    // time they are touched, and the mapping stays valid until the object is destroyed.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+
+        // Maps the file. Throws std::runtime_error if it cannot be opened or mapped. An
+        // empty file maps to Data() == nullptr and Size() == 0.
+        explicit MappedFile(std::filesystem::path const& path, MappedFileAccess access = MappedFileAccess::Normal);
+
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        const uint8_t* Data() const
+        {
+            return m_data;
+        }
+
+        size_t Size() const
+        {
+            return m_size;
+        }
+
+        // Asks the system to read the bytes [offset, offset + length) from disk in the
+        // background, so they are in memory by the time they are touched. The range is
+        // clipped to the file. Only a hint; it may do nothing.
+        void Prefetch(size_t offset = 0, size_t length = SIZE_MAX) const;
+
+    private:
+        void Close();
+
+        const uint8_t* m_data{ nullptr };
+        size_t m_size{ 0 };
+    };
+}
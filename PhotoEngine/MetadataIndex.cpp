@@ -0,0 +1,303 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "MetadataIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        constexpr char Magic[4] = { 'P', 'E', 'M', 'I' };
+        constexpr uint32_t Version = 1;
+
+        struct Header
+        {
+            char Magic[4];
+            uint32_t Version;
+            uint64_t EntryCount;
+            uint64_t StringsOffset;
+            uint64_t StringsSize;
+        };
+
+        static_assert(sizeof(Header) == 32, "The index header layout is part of the file format");
+    }
+
+    uint64_t HashPath(std::string_view path)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : path)
+        {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    struct MetadataIndex::Record
+    {
+        uint64_t PathHash;
+        uint64_t Size;
+        int64_t LastWriteTime;
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t PathOffset;
+        uint32_t PathLength;
+        uint32_t TitleOffset;
+        uint32_t TitleLength;
+        uint32_t DisplayNameOffset;
+        uint32_t DisplayNameLength;
+        uint32_t DisplayTypeOffset;
+        uint32_t DisplayTypeLength;
+    };
+
+    MetadataIndex MetadataIndex::Load(std::filesystem::path const& path)
+    {
+        MetadataIndex index;
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(path, error))
+        {
+            return index;
+        }
+
+        try
+        {
+            index.m_file = MappedFile(path);
+        }
+        catch (std::runtime_error const&)
+        {
+            return {};
+        }
+
+        const size_t fileSize = index.m_file.Size();
+        if (fileSize < sizeof(Header))
+        {
+            return {};
+        }
+
+        Header header;
+        std::memcpy(&header, index.m_file.Data(), sizeof(header));
+        const uint64_t recordsEnd = sizeof(Header) + header.EntryCount * sizeof(Record);
+        if (std::memcmp(header.Magic, Magic, sizeof(Magic)) != 0 || header.Version != Version ||
+            header.EntryCount > fileSize / sizeof(Record) || header.StringsOffset < recordsEnd ||
+            header.StringsOffset > fileSize || header.StringsSize > fileSize - header.StringsOffset)
+        {
+            return {};
+        }
+
+        index.m_entryCount = static_cast<size_t>(header.EntryCount);
+        index.m_strings = reinterpret_cast<const char*>(index.m_file.Data() + header.StringsOffset);
+
+        // Check every string once so lookups can trust the offsets.
+        for (size_t i = 0; i < index.m_entryCount; i++)
+        {
+            auto const& record = index.RecordAt(i);
+            for (auto [offset, length] : { std::pair{ record.PathOffset, record.PathLength }, std::pair{ record.TitleOffset, record.TitleLength },
+                std::pair{ record.DisplayNameOffset, record.DisplayNameLength }, std::pair{ record.DisplayTypeOffset, record.DisplayTypeLength } })
+            {
+                if (uint64_t{ offset } + length > header.StringsSize)
+                {
+                    return {};
+                }
+            }
+        }
+        return index;
+    }
+
+    void MetadataIndex::Write(std::filesystem::path const& path, std::vector<PhotoMetadata> entries)
+    {
+        std::vector<std::pair<uint64_t, size_t>> order(entries.size());
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            order[i] = { HashPath(entries[i].Path), i };
+        }
+        std::sort(order.begin(), order.end(), [&](auto const& a, auto const& b)
+        {
+            return a.first != b.first ? a.first < b.first : entries[a.second].Path < entries[b.second].Path;
+        });
+
+        std::string strings;
+        auto addString = [&](std::string const& value, uint32_t& offset, uint32_t& length)
+        {
+            if (strings.size() + value.size() > UINT32_MAX)
+            {
+                throw std::length_error("MetadataIndex: the string pool is too large");
+            }
+            offset = static_cast<uint32_t>(strings.size());
+            length = static_cast<uint32_t>(value.size());
+            strings += value;
+        };
+
+        std::vector<Record> records(entries.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            auto const& entry = entries[order[i].second];
+            auto& record = records[i];
+            record.PathHash = order[i].first;
+            record.Size = entry.Size;
+            record.LastWriteTime = entry.LastWriteTime;
+            record.Width = entry.Width;
+            record.Height = entry.Height;
+            addString(entry.Path, record.PathOffset, record.PathLength);
+            addString(entry.Title, record.TitleOffset, record.TitleLength);
+            addString(entry.DisplayName, record.DisplayNameOffset, record.DisplayNameLength);
+            addString(entry.DisplayType, record.DisplayTypeOffset, record.DisplayTypeLength);
+        }
+
+        Header header{};
+        std::memcpy(header.Magic, Magic, sizeof(Magic));
+        header.Version = Version;
+        header.EntryCount = records.size();
+        header.StringsOffset = sizeof(Header) + records.size() * sizeof(Record);
+        header.StringsSize = strings.size();
+
+        auto temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record)));
+            file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+            if (!file.flush())
+            {
+                throw std::runtime_error("MetadataIndex: cannot write " + temporary.string());
+            }
+        }
+        std::filesystem::rename(temporary, path);
+    }
+
+    MetadataIndex::Record const& MetadataIndex::RecordAt(size_t index) const
+    {
+        static_assert(sizeof(Record) == 64, "The index entry layout is part of the file format");
+        return reinterpret_cast<Record const*>(m_file.Data() + sizeof(Header))[index];
+    }
+
+    std::string_view MetadataIndex::String(uint32_t offset, uint32_t length) const
+    {
+        return { m_strings + offset, length };
+    }
+
+    PhotoMetadataView MetadataIndex::Entry(size_t index) const
+    {
+        if (index >= m_entryCount)
+        {
+            throw std::out_of_range("MetadataIndex: entry index out of range");
+        }
+
+        auto const& record = RecordAt(index);
+        return {
+            String(record.PathOffset, record.PathLength),
+            record.Size,
+            record.LastWriteTime,
+            record.Width,
+            record.Height,
+            String(record.TitleOffset, record.TitleLength),
+            String(record.DisplayNameOffset, record.DisplayNameLength),
+            String(record.DisplayTypeOffset, record.DisplayTypeLength) };
+    }
+
+    std::optional<size_t> MetadataIndex::FindRecord(std::string_view path) const
+    {
+        const uint64_t hash = HashPath(path);
+        size_t first = 0;
+        size_t count = m_entryCount;
+        while (count > 0)
+        {
+            const size_t half = count / 2;
+            if (RecordAt(first + half).PathHash < hash)
+            {
+                first += half + 1;
+                count -= half + 1;
+            }
+            else
+            {
+                count = half;
+            }
+        }
+
+        for (size_t i = first; i < m_entryCount && RecordAt(i).PathHash == hash; i++)
+        {
+            auto const& record = RecordAt(i);
+            if (String(record.PathOffset, record.PathLength) == path)
+            {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<PhotoMetadataView> MetadataIndex::Find(std::string_view path, uint64_t size, int64_t lastWriteTime) const
+    {
+        const auto found = FindRecord(path);
+        if (!found)
+        {
+            return std::nullopt;
+        }
+
+        auto const& record = RecordAt(*found);
+        if (record.Size != size || record.LastWriteTime != lastWriteTime)
+        {
+            return std::nullopt;
+        }
+        return Entry(*found);
+    }
+
+    bool MetadataIndex::Contains(std::string_view path) const
+    {
+        return FindRecord(path).has_value();
+    }
+
+    std::vector<size_t> MetadataIndex::FindStaleEntries(ThreadPool& pool) const
+    {
+        std::mutex mutex;
+        std::vector<size_t> stale;
+        pool.ParallelFor(0, m_entryCount, 256, [&](size_t begin, size_t end)
+        {
+            std::vector<size_t> found;
+            for (size_t i = begin; i < end; i++)
+            {
+                auto const& record = RecordAt(i);
+                const auto path = std::filesystem::u8path(String(record.PathOffset, record.PathLength));
+
+                std::error_code sizeError;
+                std::error_code timeError;
+                const auto size = std::filesystem::file_size(path, sizeError);
+                const auto time = std::filesystem::last_write_time(path, timeError);
+                if (sizeError || timeError || size != record.Size || FileTimeTicks(time) != record.LastWriteTime)
+                {
+                    found.push_back(i);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            stale.insert(stale.end(), found.begin(), found.end());
+        });
+
+        std::sort(stale.begin(), stale.end());
+        return stale;
+    }
+}
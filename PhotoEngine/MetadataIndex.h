@@ -0,0 +1,131 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace PhotoEngine
+{
+    // The properties MainPage reads for each photo with GetImagePropertiesAsync, plus the
+    // file identity they were read for.
+    struct PhotoMetadata
+    {
+        // UTF-8 path of the file.
+        std::string Path;
+        uint64_t Size{ 0 };
+
+        // FileTimeTicks of the file's last write time.
+        int64_t LastWriteTime{ 0 };
+
+        uint32_t Width{ 0 };
+        uint32_t Height{ 0 };
+        std::string Title;
+        std::string DisplayName;
+        std::string DisplayType;
+    };
+
+    // A PhotoMetadata entry of a loaded index. The strings point into the index file.
+    struct PhotoMetadataView
+    {
+        std::string_view Path;
+        uint64_t Size;
+        int64_t LastWriteTime;
+        uint32_t Width;
+        uint32_t Height;
+        std::string_view Title;
+        std::string_view DisplayName;
+        std::string_view DisplayType;
+    };
+
+    // Returns the FNV-1a hash of a UTF-8 path. MetadataIndex and ThumbnailStore store it in
+    // their files, so it is part of both formats.
+    uint64_t HashPath(std::string_view path);
+
+    // Returns a file time as a tick count for PhotoMetadata::LastWriteTime.
+    inline int64_t FileTimeTicks(std::filesystem::file_time_type time)
+    {
+        return static_cast<int64_t>(time.time_since_epoch().count());
+    }
+
+    // A persistent index of photo metadata, keyed by path and valid while the file's
+    // size and last write time are unchanged, so a launch can list the library without
+    // reading the properties of every photo again.
+    //
+    // The file is a header, an array of fixed-size entries sorted by path hash, and a
+    // pool of UTF-8 strings, all in native little-endian layout. Load maps it and
+    // checks its bounds once; lookups are binary searches over the mapping, and only
+    // the pages that are touched are read from disk.
+    class MetadataIndex
+    {
+    public:
+        MetadataIndex() = default;
+
+        // Maps an index written by Write. A missing, truncated, or corrupt file, or one
+        // written by another version, loads as an empty index.
+        static MetadataIndex Load(std::filesystem::path const& path);
+
+        // Writes entries to a temporary file next to path and renames it over path, so a
+        // crash never leaves a partial index. On Windows, indexes mapping path must be
+        // destroyed first.
+        static void Write(std::filesystem::path const& path, std::vector<PhotoMetadata> entries);
+
+        size_t Size() const
+        {
+            return m_entryCount;
+        }
+
+        // Returns the entry at index, in path hash order.
+        PhotoMetadataView Entry(size_t index) const;
+
+        // Returns the entry for path if its size and last write time match.
+        std::optional<PhotoMetadataView> Find(std::string_view path, uint64_t size, int64_t lastWriteTime) const;
+
+        // Returns true if there is an entry for path, whatever its size and time.
+        bool Contains(std::string_view path) const;
+
+        // Checks every entry against its file on the pool's threads and returns the
+        // indexes of the entries whose file changed or no longer exists. Meant to run in
+        // the background after the index has been shown.
+        std::vector<size_t> FindStaleEntries(ThreadPool& pool) const;
+
+    private:
+        struct Record;
+
+        Record const& RecordAt(size_t index) const;
+        std::optional<size_t> FindRecord(std::string_view path) const;
+        std::string_view String(uint32_t offset, uint32_t length) const;
+
+        MappedFile m_file;
+        size_t m_entryCount{ 0 };
+        const char* m_strings{ nullptr };
+    };
+}
@@ -0,0 +1,90 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "MipPyramid.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Number of rows handed to a thread at a time.
+        constexpr size_t RowsPerBand = 16;
+    }
+
+    void Downsample(ConstImageView src, ImageView dst, ThreadPool& pool)
+    {
+        if (dst.Width != (src.Width + 1) / 2 || dst.Height != (src.Height + 1) / 2)
+        {
+            throw std::invalid_argument("Downsample: destination is not half the source size");
+        }
+
+        pool.ParallelFor(0, dst.Height, RowsPerBand, [&](size_t begin, size_t end)
+        {
+            for (auto y = static_cast<uint32_t>(begin); y < end; y++)
+            {
+                const uint8_t* top = src.Row(2 * y);
+                const uint8_t* bottom = src.Row(std::min(2 * y + 1, src.Height - 1));
+                uint8_t* out = dst.Row(y);
+
+                for (uint32_t x = 0; x < dst.Width; x++)
+                {
+                    const size_t left = 2 * x * BytesPerPixel;
+                    const size_t right = std::min(2 * x + 1, src.Width - 1) * BytesPerPixel;
+                    for (size_t c = 0; c < BytesPerPixel; c++)
+                    {
+                        const int sum = top[left + c] + top[right + c] + bottom[left + c] + bottom[right + c];
+                        out[x * BytesPerPixel + c] = static_cast<uint8_t>((sum + 2) / 4);
+                    }
+                }
+            }
+        });
+    }
+
+    MipPyramid::MipPyramid(ConstImageView source, ThreadPool& pool) :
+        m_source(source)
+    {
+        ConstImageView level = source;
+        while (level.Width > 1 && level.Height > 1)
+        {
+            auto half = Image::Uninitialized((level.Width + 1) / 2, (level.Height + 1) / 2);
+            Downsample(level, half.View(), pool);
+            m_levels.push_back(std::move(half));
+            level = m_levels.back().View();
+        }
+    }
+
+    size_t MipPyramid::LevelForZoom(float zoomFactor) const
+    {
+        if (!(zoomFactor > 0) || zoomFactor >= 1)
+        {
+            return 0;
+        }
+
+        const auto level = static_cast<size_t>(std::floor(std::log2(1.0f / zoomFactor)));
+        return std::min(level, LevelCount() - 1);
+    }
+}
@@ -0,0 +1,64 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Image.h"
+#include "ThreadPool.h"
+#include <vector>
+
+namespace PhotoEngine
+{
+    // Successively halved copies of an image. Level 0 is the image itself and is not
+    // copied; level n is 2^n times smaller in each dimension, rounded up, down to a
+    // single pixel in the shorter dimension.
+    class MipPyramid
+    {
+    public:
+        MipPyramid() = default;
+        MipPyramid(ConstImageView source, ThreadPool& pool);
+
+        size_t LevelCount() const
+        {
+            return m_levels.size() + 1;
+        }
+
+        ConstImageView Level(size_t level) const
+        {
+            return level == 0 ? m_source : m_levels.at(level - 1).View();
+        }
+
+        // Returns the smallest level that still has at least as many pixels as the
+        // screen shows at zoomFactor, the ScrollViewer zoom of the source image.
+        size_t LevelForZoom(float zoomFactor) const;
+
+    private:
+        ConstImageView m_source;
+        std::vector<Image> m_levels;
+    };
+
+    // Halves src into dst by averaging 2x2 blocks. dst must be (src + 1) / 2 in each
+    // dimension; an odd last column or row is averaged with itself.
+    void Downsample(ConstImageView src, ImageView dst, ThreadPool& pool);
+}
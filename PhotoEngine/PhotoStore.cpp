@@ -0,0 +1,329 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "PhotoStore.h"
+#include <algorithm>
+#include <array>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        constexpr size_t MaxStringLength = UINT16_MAX - 1;
+
+        // A DisplayNameLength meaning the display name is the file name without its extension.
+        constexpr uint16_t StemDisplayName = UINT16_MAX;
+
+        std::string_view Stem(std::string_view fileName)
+        {
+            const auto dot = fileName.rfind('.');
+            return dot == std::string_view::npos || dot == 0 ? fileName : fileName.substr(0, dot);
+        }
+
+        std::string_view Clamp(std::string_view text)
+        {
+            return text.substr(0, std::min(text.size(), MaxStringLength));
+        }
+    }
+
+    struct PhotoStore::Chunk
+    {
+        std::array<uint64_t, ChunkSize> Size;
+        std::array<int64_t, ChunkSize> LastWriteTime;
+        std::array<uint32_t, ChunkSize> Width;
+        std::array<uint32_t, ChunkSize> Height;
+        std::array<uint32_t, ChunkSize> Folder;
+
+        // The file name, display name, and title of an entry are stored one after the
+        // other in Strings, starting at StringOffset.
+        std::array<uint32_t, ChunkSize> StringOffset;
+        std::array<uint16_t, ChunkSize> FileNameLength;
+        std::array<uint16_t, ChunkSize> DisplayNameLength;
+        std::array<uint16_t, ChunkSize> TitleLength;
+        std::array<uint16_t, ChunkSize> Type;
+        std::string Strings;
+        size_t Count{ 0 };
+    };
+
+    PhotoStore::PhotoStore() = default;
+
+    PhotoStore::~PhotoStore() = default;
+
+    PhotoEntry PhotoStore::Entry(size_t index) const
+    {
+        return Entry(*m_chunks[index / ChunkSize], index % ChunkSize);
+    }
+
+    PhotoEntry PhotoStore::Entry(Chunk const& chunk, size_t i) const
+    {
+        PhotoEntry entry;
+        entry.Folder = m_folders[chunk.Folder[i]];
+        entry.Size = chunk.Size[i];
+        entry.LastWriteTime = chunk.LastWriteTime[i];
+        entry.Width = chunk.Width[i];
+        entry.Height = chunk.Height[i];
+        entry.DisplayType = m_types[chunk.Type[i]];
+
+        const std::string_view strings(chunk.Strings);
+        size_t offset = chunk.StringOffset[i];
+        entry.FileName = strings.substr(offset, chunk.FileNameLength[i]);
+        offset += chunk.FileNameLength[i];
+        if (chunk.DisplayNameLength[i] == StemDisplayName)
+        {
+            entry.DisplayName = Stem(entry.FileName);
+        }
+        else
+        {
+            entry.DisplayName = strings.substr(offset, chunk.DisplayNameLength[i]);
+            offset += chunk.DisplayNameLength[i];
+        }
+        entry.Title = strings.substr(offset, chunk.TitleLength[i]);
+        return entry;
+    }
+
+    void PhotoStore::Append(PhotoMetadata const& photo)
+    {
+        std::string_view path(photo.Path);
+        const auto separator = path.find_last_of("/\\");
+        const size_t nameStart = separator == std::string_view::npos ? 0 : separator + 1;
+        AppendEntry(path.substr(0, nameStart), path.substr(nameStart), photo.Size, photo.LastWriteTime,
+            photo.Width, photo.Height, photo.Title, photo.DisplayName, photo.DisplayType);
+        Notify({ PhotoStoreChangeType::Inserted, m_size - 1, 1 });
+    }
+
+    void PhotoStore::Append(std::vector<PhotoMetadata> const& photos)
+    {
+        BeginUpdate();
+        for (auto&& photo : photos)
+        {
+            Append(photo);
+        }
+        EndUpdate();
+    }
+
+    void PhotoStore::AppendEntry(std::string_view folder, std::string_view fileName, uint64_t size, int64_t lastWriteTime,
+        uint32_t width, uint32_t height, std::string_view title, std::string_view displayName, std::string_view displayType)
+    {
+        if (m_size == m_chunks.size() * ChunkSize)
+        {
+            m_chunks.push_back(std::make_unique<Chunk>());
+        }
+        auto& chunk = *m_chunks.back();
+        const size_t i = chunk.Count;
+
+        chunk.Size[i] = size;
+        chunk.LastWriteTime[i] = lastWriteTime;
+        chunk.Width[i] = width;
+        chunk.Height[i] = height;
+        chunk.Folder[i] = Intern(folder);
+        chunk.Type[i] = InternType(displayType);
+
+        fileName = Clamp(fileName);
+        title = Clamp(title);
+        chunk.StringOffset[i] = static_cast<uint32_t>(chunk.Strings.size());
+        chunk.FileNameLength[i] = static_cast<uint16_t>(fileName.size());
+        chunk.TitleLength[i] = static_cast<uint16_t>(title.size());
+        chunk.Strings.append(fileName);
+        if (displayName == Stem(fileName))
+        {
+            chunk.DisplayNameLength[i] = StemDisplayName;
+        }
+        else
+        {
+            displayName = Clamp(displayName);
+            chunk.DisplayNameLength[i] = static_cast<uint16_t>(displayName.size());
+            chunk.Strings.append(displayName);
+        }
+        chunk.Strings.append(title);
+
+        // A full chunk's strings never grow again.
+        if (++chunk.Count == ChunkSize)
+        {
+            chunk.Strings.shrink_to_fit();
+        }
+        m_size++;
+    }
+
+    uint32_t PhotoStore::Intern(std::string_view folder)
+    {
+        if (m_lastFolder != UINT32_MAX && m_folders[m_lastFolder] == folder)
+        {
+            return m_lastFolder;
+        }
+
+        auto found = m_folderIndex.find(folder);
+        if (found == m_folderIndex.end())
+        {
+            const auto index = static_cast<uint32_t>(m_folders.size());
+            m_folders.emplace_back(folder);
+            found = m_folderIndex.emplace(m_folders.back(), index).first;
+        }
+        m_lastFolder = found->second;
+        return m_lastFolder;
+    }
+
+    uint16_t PhotoStore::InternType(std::string_view type)
+    {
+        auto found = std::find(m_types.begin(), m_types.end(), type);
+        if (found != m_types.end())
+        {
+            return static_cast<uint16_t>(found - m_types.begin());
+        }
+        if (m_types.size() == UINT16_MAX)
+        {
+            // An unlikely number of distinct types: share the last one.
+            return UINT16_MAX - 1;
+        }
+        m_types.emplace_back(type);
+        return static_cast<uint16_t>(m_types.size() - 1);
+    }
+
+    size_t PhotoStore::RemoveIf(std::function<bool(PhotoEntry const&)> const& predicate)
+    {
+        // Copy the entries that stay into new chunks. The old chunks, which the entries
+        // being copied point into, are freed at the end.
+        auto chunks = std::move(m_chunks);
+        const size_t size = m_size;
+        m_chunks.clear();
+        m_size = 0;
+
+        std::vector<PhotoStoreChange> removed;
+        for (size_t index = 0; index < size; index++)
+        {
+            const auto entry = Entry(*chunks[index / ChunkSize], index % ChunkSize);
+            if (predicate(entry))
+            {
+                if (!removed.empty() && removed.back().Index + removed.back().Count == index)
+                {
+                    removed.back().Count++;
+                }
+                else
+                {
+                    removed.push_back({ PhotoStoreChangeType::Removed, index, 1 });
+                }
+                continue;
+            }
+
+            AppendEntry(entry.Folder, entry.FileName, entry.Size, entry.LastWriteTime, entry.Width, entry.Height,
+                entry.Title, entry.DisplayName, entry.DisplayType);
+        }
+
+        BeginUpdate();
+        for (auto change = removed.rbegin(); change != removed.rend(); ++change)
+        {
+            Notify(*change);
+        }
+        EndUpdate();
+        return size - m_size;
+    }
+
+    void PhotoStore::Clear()
+    {
+        const size_t size = m_size;
+        m_chunks.clear();
+        m_size = 0;
+        m_folders.clear();
+        m_folderIndex.clear();
+        m_lastFolder = UINT32_MAX;
+        m_types.clear();
+        if (size != 0)
+        {
+            Notify({ PhotoStoreChangeType::Removed, 0, size });
+        }
+    }
+
+    size_t PhotoStore::MemoryUsage() const
+    {
+        size_t bytes = sizeof(*this) + m_chunks.capacity() * sizeof(m_chunks[0]);
+        for (auto&& chunk : m_chunks)
+        {
+            bytes += sizeof(Chunk) + chunk->Strings.capacity();
+        }
+        for (auto&& folder : m_folders)
+        {
+            // The string, its index entry, and the hash node around it.
+            bytes += sizeof(folder) + folder.capacity() + sizeof(std::pair<std::string_view, uint32_t>) + 2 * sizeof(void*);
+        }
+        for (auto&& type : m_types)
+        {
+            bytes += sizeof(type) + type.capacity();
+        }
+        return bytes;
+    }
+
+    size_t PhotoStore::Subscribe(ChangeHandler handler)
+    {
+        m_handlers.emplace_back(m_nextToken, std::move(handler));
+        return m_nextToken++;
+    }
+
+    void PhotoStore::Unsubscribe(size_t token)
+    {
+        m_handlers.erase(std::remove_if(m_handlers.begin(), m_handlers.end(), [&](auto&& handler) { return handler.first == token; }),
+            m_handlers.end());
+    }
+
+    void PhotoStore::BeginUpdate()
+    {
+        m_updateDepth++;
+    }
+
+    void PhotoStore::EndUpdate()
+    {
+        if (--m_updateDepth != 0)
+        {
+            return;
+        }
+
+        auto pending = std::move(m_pending);
+        m_pending.clear();
+        for (auto&& change : pending)
+        {
+            Notify(change);
+        }
+    }
+
+    void PhotoStore::Notify(PhotoStoreChange const& change)
+    {
+        if (m_updateDepth != 0)
+        {
+            // An insert right after the previous one extends it.
+            if (!m_pending.empty() && change.Type == PhotoStoreChangeType::Inserted &&
+                m_pending.back().Type == PhotoStoreChangeType::Inserted && m_pending.back().Index + m_pending.back().Count == change.Index)
+            {
+                m_pending.back().Count += change.Count;
+            }
+            else
+            {
+                m_pending.push_back(change);
+            }
+            return;
+        }
+
+        for (auto&& handler : m_handlers)
+        {
+            handler.second(change);
+        }
+    }
+}
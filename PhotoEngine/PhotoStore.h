@@ -0,0 +1,157 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "MetadataIndex.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace PhotoEngine
+{
+    // A photo of a PhotoStore. The strings point into the store and stay valid until
+    // the store is next changed.
+    struct PhotoEntry
+    {
+        // The folder ends with its separator, so Folder + FileName is the path.
+        std::string_view Folder;
+        std::string_view FileName;
+        uint64_t Size{ 0 };
+        int64_t LastWriteTime{ 0 };
+        uint32_t Width{ 0 };
+        uint32_t Height{ 0 };
+        std::string_view Title;
+        std::string_view DisplayName;
+        std::string_view DisplayType;
+
+        std::string Path() const
+        {
+            std::string path;
+            path.reserve(Folder.size() + FileName.size());
+            path.append(Folder).append(FileName);
+            return path;
+        }
+    };
+
+    enum class PhotoStoreChangeType
+    {
+        Inserted,
+        Removed,
+    };
+
+    // Count entries were inserted or removed at Index.
+    struct PhotoStoreChange
+    {
+        PhotoStoreChangeType Type{ PhotoStoreChangeType::Inserted };
+        size_t Index{ 0 };
+        size_t Count{ 0 };
+    };
+
+    // A compact list of photos for libraries of millions of files, holding the
+    // PhotoMetadata of each in a few dozen bytes so only the items on screen need full
+    // objects.
+    //
+    // Entries live in fixed-size chunks of parallel arrays, one per field, so an append
+    // never moves existing entries. Folders and display types are stored once and
+    // shared; a photo's file name, display name, and title go in its chunk's string
+    // block, and a display name equal to the file name without its extension, the
+    // usual case, takes no space at all. Strings longer than 65535 bytes are truncated.
+    //
+    // Observers are told of changes as ranges; between BeginUpdate and EndUpdate they
+    // are held back and adjacent inserts merged, so an import of thousands of photos is
+    // a single notification. Not thread-safe.
+    class PhotoStore
+    {
+    public:
+        static constexpr size_t ChunkSize = 4096;
+
+        using ChangeHandler = std::function<void(PhotoStoreChange const&)>;
+
+        PhotoStore();
+        ~PhotoStore();
+
+        PhotoStore(PhotoStore const&) = delete;
+        PhotoStore& operator=(PhotoStore const&) = delete;
+
+        size_t Size() const
+        {
+            return m_size;
+        }
+
+        PhotoEntry Entry(size_t index) const;
+
+        // Appends photos at the end in amortized constant time each.
+        void Append(PhotoMetadata const& photo);
+        void Append(std::vector<PhotoMetadata> const& photos);
+
+        // Removes the entries predicate returns true for and returns how many were
+        // removed. Each run of removed entries is one notification, latest first, so
+        // observers can apply them in order.
+        size_t RemoveIf(std::function<bool(PhotoEntry const&)> const& predicate);
+
+        void Clear();
+
+        // Bytes allocated by the store.
+        size_t MemoryUsage() const;
+
+        // Registers a handler for changes and returns a token for Unsubscribe.
+        size_t Subscribe(ChangeHandler handler);
+        void Unsubscribe(size_t token);
+
+        // Holds back change notifications until the matching EndUpdate. Calls nest.
+        void BeginUpdate();
+        void EndUpdate();
+
+    private:
+        struct Chunk;
+
+        PhotoEntry Entry(Chunk const& chunk, size_t i) const;
+        uint32_t Intern(std::string_view folder);
+        uint16_t InternType(std::string_view type);
+        void AppendEntry(std::string_view folder, std::string_view fileName, uint64_t size, int64_t lastWriteTime,
+            uint32_t width, uint32_t height, std::string_view title, std::string_view displayName, std::string_view displayType);
+        void Notify(PhotoStoreChange const& change);
+
+        std::vector<std::unique_ptr<Chunk>> m_chunks;
+        size_t m_size{ 0 };
+
+        // Interned folders, with the last one looked up, since photos arrive folder by folder.
+        std::deque<std::string> m_folders;
+        std::unordered_map<std::string_view, uint32_t> m_folderIndex;
+        uint32_t m_lastFolder{ UINT32_MAX };
+        std::vector<std::string> m_types;
+
+        std::vector<std::pair<size_t, ChangeHandler>> m_handlers;
+        size_t m_nextToken{ 1 };
+        size_t m_updateDepth{ 0 };
+        std::vector<PhotoStoreChange> m_pending;
+    };
+}
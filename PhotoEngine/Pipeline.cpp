@@ -0,0 +1,268 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "Pipeline.h"
+#include "ColorMatrix.h"
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Removes the "Effect" suffix from an effect name for Describe.
+        std::string ShortName(EffectKind kind)
+        {
+            std::string name = EffectName(kind);
+            const auto suffix = name.rfind("Effect");
+            return suffix == std::string::npos ? name : name.substr(0, suffix);
+        }
+
+        PointOp BuildPointOp(PointNode const& node, EffectParameters const& params)
+        {
+            if (node.Effects.front() == EffectKind::Contrast)
+            {
+                return PointOp::FromContrast(params.Contrast);
+            }
+
+            auto matrix = EffectMatrix(node.Effects.front(), params);
+            for (size_t i = 1; i < node.Effects.size(); i++)
+            {
+                matrix = Concatenate(matrix, EffectMatrix(node.Effects[i], params));
+            }
+            return PointOp::FromMatrix(matrix);
+        }
+
+        bool NodeParametersChanged(PointNode const& node, EffectParameters const& before, EffectParameters const& after)
+        {
+            for (auto&& kind : node.Effects)
+            {
+                if (EffectParametersChanged(kind, before, after))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    const char* WorkingFormatName(WorkingFormat format)
+    {
+        switch (format)
+        {
+        case WorkingFormat::Bgra8:
+            return "Bgra8";
+        case WorkingFormat::Float32:
+            return "Float32";
+        case WorkingFormat::Float16:
+            return "Float16";
+        }
+        return "";
+    }
+
+    Pipeline::Pipeline(EffectChain const& chain, PipelineOptions const& options) :
+        m_chain(chain),
+        m_options(options)
+    {
+        for (auto&& kind : chain.Effects())
+        {
+            if (!IsPointEffect(kind))
+            {
+                m_stages.push_back({ StageType::GaussianBlur, { kind }, {} });
+                continue;
+            }
+
+            PipelineStage* run = nullptr;
+            if (!m_stages.empty() && m_stages.back().Type == StageType::PointEffects)
+            {
+                run = &m_stages.back();
+            }
+
+            // Fold into the previous node when both it and this effect are linear.
+            if (options.FoldColorMatrices && run && IsLinearEffect(kind) && IsLinearEffect(run->Effects.back()))
+            {
+                run->Effects.push_back(kind);
+                run->Nodes.back().Effects.push_back(kind);
+                continue;
+            }
+
+            if (options.FusePointEffects && run && run->Nodes.size() < MaxPointOps)
+            {
+                run->Effects.push_back(kind);
+                run->Nodes.push_back({ { kind } });
+                continue;
+            }
+
+            m_stages.push_back({ StageType::PointEffects, { kind }, { PointNode{ { kind } } } });
+        }
+
+        m_programs.resize(m_stages.size());
+    }
+
+    std::vector<PointOp> const& Pipeline::PointProgram(size_t stageIndex, EffectParameters const& params)
+    {
+        auto const& stage = m_stages.at(stageIndex);
+        if (stage.Type != StageType::PointEffects)
+        {
+            throw std::invalid_argument("PointProgram: not a point effects stage");
+        }
+
+        auto& program = m_programs[stageIndex];
+        if (!program.Valid)
+        {
+            program.Ops.clear();
+            for (auto&& node : stage.Nodes)
+            {
+                program.Ops.push_back(BuildPointOp(node, params));
+            }
+            m_builtOperations += stage.Nodes.size();
+        }
+        else if (program.Params != params)
+        {
+            for (size_t i = 0; i < stage.Nodes.size(); i++)
+            {
+                if (NodeParametersChanged(stage.Nodes[i], program.Params, params))
+                {
+                    program.Ops[i] = BuildPointOp(stage.Nodes[i], params);
+                    m_builtOperations++;
+                }
+            }
+        }
+
+        program.Params = params;
+        program.Valid = true;
+        return program.Ops;
+    }
+
+    ColorLut const* Pipeline::StageLut(size_t stageIndex, EffectParameters const& params, size_t pixelCount)
+    {
+        auto const& stage = m_stages.at(stageIndex);
+        if (m_options.ColorLutSize == 0 || stage.Type != StageType::PointEffects)
+        {
+            return nullptr;
+        }
+
+        auto& program = m_programs[stageIndex];
+        for (auto&& node : stage.Nodes)
+        {
+            if (NodeParametersChanged(node, program.LutParams, params))
+            {
+                program.Lut.reset();
+                program.LutParams = params;
+                program.PendingPixels = 0;
+                program.LutError = -1;
+                break;
+            }
+        }
+
+        if (!program.Lut)
+        {
+            const size_t nodes = static_cast<size_t>(m_options.ColorLutSize) * m_options.ColorLutSize * m_options.ColorLutSize;
+            program.PendingPixels += pixelCount;
+            if (program.PendingPixels < nodes)
+            {
+                return nullptr;
+            }
+
+            auto const& ops = PointProgram(stageIndex, params);
+            if (!ColorLut::CanBake(ops.data(), ops.size()))
+            {
+                return nullptr;
+            }
+
+            program.Lut = std::make_shared<const ColorLut>(m_options.ColorLutSize, ops.data(), ops.size());
+            m_bakedLuts++;
+        }
+        return program.Lut.get();
+    }
+
+    int Pipeline::ColorLutMaxError(size_t stageIndex)
+    {
+        auto& program = m_programs.at(stageIndex);
+        if (!program.Lut)
+        {
+            return -1;
+        }
+
+        if (program.LutError < 0)
+        {
+            program.LutError = program.Lut->MaxError();
+        }
+        return program.LutError;
+    }
+
+    uint32_t Pipeline::Halo(EffectParameters const& params) const
+    {
+        uint32_t halo = 0;
+        for (auto&& stage : m_stages)
+        {
+            if (stage.Type == StageType::GaussianBlur)
+            {
+                halo += GaussianBlurHalo(params.BlurAmount, m_options.Blur);
+            }
+        }
+        return halo;
+    }
+
+    size_t Pipeline::FoldedEffectCount() const
+    {
+        size_t folded = 0;
+        for (auto&& stage : m_stages)
+        {
+            for (auto&& node : stage.Nodes)
+            {
+                folded += node.Effects.size() - 1;
+            }
+        }
+        return folded;
+    }
+
+    std::string Pipeline::Describe() const
+    {
+        std::string description;
+        for (auto&& stage : m_stages)
+        {
+            if (!description.empty())
+            {
+                description += " | ";
+            }
+
+            if (stage.Type == StageType::GaussianBlur)
+            {
+                description += ShortName(EffectKind::GaussianBlur);
+                continue;
+            }
+
+            for (size_t i = 0; i < stage.Nodes.size(); i++)
+            {
+                description += i == 0 ? "" : ", ";
+                auto const& effects = stage.Nodes[i].Effects;
+                for (size_t j = 0; j < effects.size(); j++)
+                {
+                    description += (j == 0 ? "" : " x ") + ShortName(effects[j]);
+                }
+            }
+        }
+        return description;
+    }
+}
@@ -0,0 +1,215 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ColorLut.h"
+#include "EffectChain.h"
+#include "EffectParameters.h"
+#include "GaussianBlur.h"
+#include "PixelKernels.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace PhotoEngine
+{
+    // Pixel format the stages of a pipeline hand each other.
+    enum class WorkingFormat
+    {
+        // Interleaved BGRA8, like the images: every stage rounds its output to 8 bits.
+        Bgra8,
+
+        // Planar single-precision floats: the result is rounded once, when it is stored.
+        Float32,
+
+        // Planar half floats: half the memory traffic of Float32, with 11 significant bits,
+        // which is plenty for linear light.
+        Float16
+    };
+
+    // Returns the format name, e.g. "Float16".
+    const char* WorkingFormatName(WorkingFormat format);
+
+    // Optimizations applied when an effect chain is compiled.
+    struct PipelineOptions
+    {
+        // Evaluate runs of consecutive point effects in a single pass.
+        bool FusePointEffects{ true };
+
+        // Multiply the matrices of consecutive linear effects into one matrix.
+        bool FoldColorMatrices{ true };
+
+        // How Gaussian blur stages are evaluated.
+        BlurMethod Blur{ BlurMethod::Automatic };
+
+        // Bake point stages into 3D LUTs with this many nodes per axis, typically
+        // ColorLut::SmallSize or ColorLut::LargeSize. 0 runs the point programs directly.
+        uint32_t ColorLutSize{ 0 };
+
+        // The format the stages run in. A planar format converts the image once on the way
+        // in and once on the way out, so no stage adds rounding or banding of its own.
+        WorkingFormat Format{ WorkingFormat::Bgra8 };
+
+        // With a planar format, decode sRGB to linear light on the way in and encode it on
+        // the way out, so exposure scales light and blurs mix it physically. Changes the
+        // look of the curves, which are tuned for sRGB. Ignored for Bgra8.
+        bool LinearLight{ false };
+
+        bool operator==(PipelineOptions const& other) const
+        {
+            return FusePointEffects == other.FusePointEffects && FoldColorMatrices == other.FoldColorMatrices &&
+                Blur == other.Blur && ColorLutSize == other.ColorLutSize && Format == other.Format &&
+                LinearLight == other.LinearLight;
+        }
+    };
+
+    enum class StageType
+    {
+        PointEffects,
+        GaussianBlur
+    };
+
+    // One operation of a point stage: a contrast effect, or one or more consecutive
+    // linear effects whose color matrices are folded into a single matrix.
+    struct PointNode
+    {
+        std::vector<EffectKind> Effects;
+
+        bool IsFolded() const
+        {
+            return Effects.size() > 1;
+        }
+    };
+
+    // One pass over the image.
+    struct PipelineStage
+    {
+        StageType Type;
+
+        // The effects this stage evaluates, in chain order.
+        std::vector<EffectKind> Effects;
+
+        // The operations of a PointEffects stage.
+        std::vector<PointNode> Nodes;
+    };
+
+    // An effect chain compiled into passes over the image.
+    //
+    // Consecutive linear effects (exposure, temperature and tint, saturation, sepia,
+    // grayscale, invert) are folded into one color matrix node, so N of them cost one
+    // matrix multiply per pixel. Runs of consecutive point nodes are fused into one
+    // stage that loads each pixel once, applies the whole run in registers, and stores
+    // it once. A Gaussian blur reads neighboring pixels, so it always gets a stage of
+    // its own and ends the run before it.
+    //
+    // With PipelineOptions::ColorLutSize set, a point stage is baked into a ColorLut once
+    // enough pixels have been rendered with the same parameters to pay for the baking.
+    // Copies of a pipeline share the baked LUTs, so tiles of an export or a run of
+    // thumbnails with the same edits bake them once.
+    //
+    // A Pipeline keeps the point programs it last built and is meant to be used by one
+    // renderer at a time.
+    class Pipeline
+    {
+    public:
+        Pipeline() = default;
+        explicit Pipeline(EffectChain const& chain, PipelineOptions const& options = {});
+
+        EffectChain const& Chain() const
+        {
+            return m_chain;
+        }
+
+        PipelineOptions const& Options() const
+        {
+            return m_options;
+        }
+
+        std::vector<PipelineStage> const& Stages() const
+        {
+            return m_stages;
+        }
+
+        // Returns the point program of a PointEffects stage for the given parameter values.
+        // Only the operations whose effects read a parameter that changed since the
+        // previous call are rebuilt; the others are reused.
+        std::vector<PointOp> const& PointProgram(size_t stageIndex, EffectParameters const& params);
+
+        // Returns the baked LUT of a PointEffects stage for the given parameter values, or
+        // nullptr if the stage should run its point program for these pixelCount pixels.
+        // A LUT is baked once the pixels rendered since the stage's parameters last changed
+        // reach its node count, which bounds the baking overhead at one extra render.
+        ColorLut const* StageLut(size_t stageIndex, EffectParameters const& params, size_t pixelCount);
+
+        // Returns the largest difference, in 8-bit levels, between the stage's baked LUT
+        // and direct evaluation of its point program, or -1 if no LUT is baked.
+        int ColorLutMaxError(size_t stageIndex);
+
+        // Total number of LUTs baked by StageLut so far.
+        size_t BakedLutCount() const
+        {
+            return m_bakedLuts;
+        }
+
+        // Returns how many rows or columns beyond a region influence its rendered pixels,
+        // summed over the blur stages. Point stages need no neighbors.
+        uint32_t Halo(EffectParameters const& params) const;
+
+        // Total number of point operations built by PointProgram so far.
+        size_t BuiltOperationCount() const
+        {
+            return m_builtOperations;
+        }
+
+        // Number of chain effects that were folded into another effect's matrix.
+        size_t FoldedEffectCount() const;
+
+        // Describes the compiled stages, e.g. "Contrast, Exposure x Saturation | Blur".
+        // Stages are separated by '|', operations by ',' and folded effects by 'x'.
+        std::string Describe() const;
+
+    private:
+        struct ProgramCache
+        {
+            std::vector<PointOp> Ops;
+            EffectParameters Params;
+            bool Valid{ false };
+
+            // Shared by copies of the pipeline. LutParams are the parameters the LUT was
+            // baked for, or that PendingPixels were rendered with while it was not.
+            std::shared_ptr<const ColorLut> Lut;
+            EffectParameters LutParams;
+            size_t PendingPixels{ 0 };
+            int LutError{ -1 };
+        };
+
+        EffectChain m_chain;
+        PipelineOptions m_options;
+        std::vector<PipelineStage> m_stages;
+        std::vector<ProgramCache> m_programs;
+        size_t m_builtOperations{ 0 };
+        size_t m_bakedLuts{ 0 };
+    };
+}
@@ -0,0 +1,55 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "PipelineCache.h"
+
+namespace PhotoEngine
+{
+    size_t PipelineCache::KeyHash::operator()(Key const& key) const
+    {
+        size_t hash = key.Chain.Size();
+        for (auto&& kind : key.Chain.Effects())
+        {
+            hash = hash * 31 + static_cast<size_t>(kind);
+        }
+
+        hash = hash * 31 + (key.Options.FusePointEffects ? 1 : 0);
+        hash = hash * 31 + (key.Options.FoldColorMatrices ? 1 : 0);
+        hash = hash * 31 + static_cast<size_t>(key.Options.Blur);
+        hash = hash * 31 + key.Options.ColorLutSize;
+        hash = hash * 31 + static_cast<size_t>(key.Options.Format);
+        return hash * 31 + (key.Options.LinearLight ? 1 : 0);
+    }
+
+    Pipeline& PipelineCache::Get(EffectChain const& chain, PipelineOptions const& options)
+    {
+        Key key{ chain, options };
+        if (auto pipeline = m_pipelines.Find(key))
+        {
+            return *pipeline;
+        }
+
+        return m_pipelines.Insert(key, Pipeline(chain, options));
+    }
+}
@@ -0,0 +1,88 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "EffectChain.h"
+#include "LruCache.h"
+#include "Pipeline.h"
+
+namespace PhotoEngine
+{
+    // Compiled pipelines keyed by effect chain and options, so switching back to a chain
+    // that was used recently costs a lookup instead of a compile. Parameter values are
+    // not part of the key: a cached pipeline keeps the point programs it last built and
+    // only rebuilds the operations whose parameters change.
+    class PipelineCache
+    {
+    public:
+        explicit PipelineCache(size_t capacity = 16) :
+            m_pipelines(capacity)
+        {
+        }
+
+        // Returns the pipeline for chain compiled with options, compiling it on a miss.
+        // The reference stays valid until the pipeline is evicted.
+        Pipeline& Get(EffectChain const& chain, PipelineOptions const& options);
+
+        size_t Size() const
+        {
+            return m_pipelines.Size();
+        }
+
+        size_t Hits() const
+        {
+            return m_pipelines.Hits();
+        }
+
+        size_t Misses() const
+        {
+            return m_pipelines.Misses();
+        }
+
+        size_t Evictions() const
+        {
+            return m_pipelines.Evictions();
+        }
+
+    private:
+        struct Key
+        {
+            EffectChain Chain;
+            PipelineOptions Options;
+
+            bool operator==(Key const& other) const
+            {
+                return Chain == other.Chain && Options == other.Options;
+            }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(Key const& key) const;
+        };
+
+        LruCache<Key, Pipeline, KeyHash> m_pipelines;
+    };
+}
@@ -0,0 +1,500 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "PixelKernels.h"
+#include "PixelKernelsSimd.h"
+#include "PointEffects.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(PHOTOENGINE_X86_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        Color Transform(ColorMatrix const& matrix, Color color)
+        {
+            const float in[4] = { color.B, color.G, color.R, color.A };
+            float out[4];
+            for (int row = 0; row < 4; row++)
+            {
+                out[row] = matrix.M[row][0] * in[0] + matrix.M[row][1] * in[1] +
+                    matrix.M[row][2] * in[2] + matrix.M[row][3] * in[3] + matrix.M[row][4];
+            }
+            return { out[0], out[1], out[2], out[3] };
+        }
+
+        void ScalarColorMatrixBgra8(ColorMatrix const& matrix, const uint8_t* src, uint8_t* dst, size_t count)
+        {
+            for (size_t i = 0; i < count; i++, src += BytesPerPixel, dst += BytesPerPixel)
+            {
+                StorePixel(Transform(matrix, LoadPixel(src)), dst);
+            }
+        }
+
+        void ScalarColorMatrixFloat(ColorMatrix const& matrix, const float* src, float* dst, size_t count)
+        {
+            for (size_t i = 0; i < count; i++, src += 4, dst += 4)
+            {
+                const auto color = Transform(matrix, { src[0], src[1], src[2], src[3] });
+                dst[0] = color.B;
+                dst[1] = color.G;
+                dst[2] = color.R;
+                dst[3] = color.A;
+            }
+        }
+
+        void ScalarContrastBgra8(float contrast, const uint8_t* src, uint8_t* dst, size_t count)
+        {
+            for (size_t i = 0; i < count; i++, src += BytesPerPixel, dst += BytesPerPixel)
+            {
+                StorePixel(Contrast(LoadPixel(src), contrast), dst);
+            }
+        }
+
+        void ScalarContrastFloat(float contrast, const float* src, float* dst, size_t count)
+        {
+            for (size_t i = 0; i < count; i++, src += 4, dst += 4)
+            {
+                const auto color = Contrast({ src[0], src[1], src[2], src[3] }, contrast);
+                dst[0] = color.B;
+                dst[1] = color.G;
+                dst[2] = color.R;
+                dst[3] = color.A;
+            }
+        }
+
+        Color RunProgram(PointOp const* ops, size_t opCount, Color color)
+        {
+            for (size_t i = 0; i < opCount; i++)
+            {
+                color = ops[i].Type == PointOpType::Contrast ?
+                    Contrast(color, ops[i].Contrast) :
+                    Transform(ops[i].Matrix, color);
+            }
+            return color;
+        }
+
+        void ScalarPointProgramBgra8(PointOp const* ops, size_t opCount, const uint8_t* src, uint8_t* dst, size_t count)
+        {
+            for (size_t i = 0; i < count; i++, src += BytesPerPixel, dst += BytesPerPixel)
+            {
+                StorePixel(RunProgram(ops, opCount, LoadPixel(src)), dst);
+            }
+        }
+
+        void ScalarPointProgramFloat(PointOp const* ops, size_t opCount, const float* src, float* dst, size_t count)
+        {
+            for (size_t i = 0; i < count; i++, src += 4, dst += 4)
+            {
+                const auto color = RunProgram(ops, opCount, { src[0], src[1], src[2], src[3] });
+                dst[0] = color.B;
+                dst[1] = color.G;
+                dst[2] = color.R;
+                dst[3] = color.A;
+            }
+        }
+
+        // Scalar form of the tetrahedral lookup in PixelKernelsSimd.h.
+        Color LookUp(const float* table, uint32_t size, Color color)
+        {
+            const float in[3] = { color.B, color.G, color.R };
+            const size_t strides[3] = { 3, 3 * size_t{ size }, 3 * size_t{ size } * size };
+            size_t origin = 0;
+            float fractions[3];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                const float value = std::clamp(in[axis], 0.0f, 1.0f) * (size - 1);
+                const float base = std::min(std::floor(value), static_cast<float>(size - 2));
+                origin += static_cast<size_t>(base) * strides[axis];
+                fractions[axis] = value - base;
+            }
+
+            // Axes ordered by decreasing fraction; ties keep B before G before R.
+            int order[3] = { 0, 1, 2 };
+            std::stable_sort(order, order + 3, [&](int a, int b) { return fractions[a] > fractions[b]; });
+
+            const size_t corners[4] = {
+                origin,
+                origin + strides[order[0]],
+                origin + strides[order[0]] + strides[order[1]],
+                origin + strides[0] + strides[1] + strides[2] };
+            const float weights[4] = {
+                1.0f - fractions[order[0]],
+                fractions[order[0]] - fractions[order[1]],
+                fractions[order[1]] - fractions[order[2]],
+                fractions[order[2]] };
+
+            float out[3] = {};
+            for (int corner = 0; corner < 4; corner++)
+            {
+                for (int channel = 0; channel < 3; channel++)
+                {
+                    out[channel] += weights[corner] * table[corners[corner] + channel];
+                }
+            }
+            return { out[0], out[1], out[2], color.A };
+        }
+
+        void ScalarColorLutBgra8(const float* table, uint32_t size, const uint8_t* src, uint8_t* dst, size_t count)
+        {
+            for (size_t i = 0; i < count; i++, src += BytesPerPixel, dst += BytesPerPixel)
+            {
+                StorePixel(LookUp(table, size, LoadPixel(src)), dst);
+            }
+        }
+
+        void ScalarColorLutFloat(const float* table, uint32_t size, const float* src, float* dst, size_t count)
+        {
+            for (size_t i = 0; i < count; i++, src += 4, dst += 4)
+            {
+                const auto color = LookUp(table, size, { src[0], src[1], src[2], src[3] });
+                dst[0] = color.B;
+                dst[1] = color.G;
+                dst[2] = color.R;
+                dst[3] = color.A;
+            }
+        }
+
+        void ScalarAccumulateBgra8(const uint8_t* src, float weight, float* sum, size_t count)
+        {
+            for (size_t i = 0; i < count * BytesPerPixel; i++)
+            {
+                sum[i] += weight * src[i];
+            }
+        }
+
+        Color LoadPlanarPixel(PlanarRow const& row, size_t i)
+        {
+            float channels[4];
+            for (int c = 0; c < 4; c++)
+            {
+                channels[c] = row.Format == PlanarFormat::Float16 ?
+                    HalfToFloat(static_cast<const uint16_t*>(row.Planes[c])[i]) :
+                    static_cast<const float*>(row.Planes[c])[i];
+            }
+            return { channels[0], channels[1], channels[2], channels[3] };
+        }
+
+        void StorePlanarPixel(Color color, PlanarRow const& row, size_t i)
+        {
+            const float channels[4] = { color.B, color.G, color.R, color.A };
+            for (int c = 0; c < 4; c++)
+            {
+                if (row.Format == PlanarFormat::Float16)
+                {
+                    static_cast<uint16_t*>(row.Planes[c])[i] = FloatToHalf(channels[c]);
+                }
+                else
+                {
+                    static_cast<float*>(row.Planes[c])[i] = channels[c];
+                }
+            }
+        }
+
+        // Scalar form of SrgbVectors::ToSrgb in PixelKernelsSimd.h.
+        float EncodeSrgb(const float* table, float value)
+        {
+            const float x = std::clamp(value, 0.0f, 1.0f) * SrgbEncodeTableSize;
+            const float base = std::min(std::floor(x), static_cast<float>(SrgbEncodeTableSize - 1));
+            const auto index = static_cast<size_t>(base);
+            return table[index] + (x - base) * (table[index + 1] - table[index]);
+        }
+
+        void ScalarBgra8ToPlanar(const uint8_t* src, PlanarRow dst, size_t count, bool linear)
+        {
+            const float* decode = SrgbDecodeTable();
+            for (size_t i = 0; i < count; i++, src += BytesPerPixel)
+            {
+                auto color = LoadPixel(src);
+                if (linear)
+                {
+                    color = { decode[src[0]], decode[src[1]], decode[src[2]], color.A };
+                }
+                StorePlanarPixel(color, dst, i);
+            }
+        }
+
+        void ScalarPlanarToBgra8(PlanarRow src, uint8_t* dst, size_t count, bool linear)
+        {
+            const float* encode = SrgbEncodeTable();
+            for (size_t i = 0; i < count; i++, dst += BytesPerPixel)
+            {
+                auto color = LoadPlanarPixel(src, i);
+                if (linear)
+                {
+                    color = { EncodeSrgb(encode, color.B), EncodeSrgb(encode, color.G), EncodeSrgb(encode, color.R), color.A };
+                }
+                StorePixel(color, dst);
+            }
+        }
+
+        void ScalarPointProgramPlanar(PointOp const* ops, size_t opCount, PlanarRow pixels, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                StorePlanarPixel(RunProgram(ops, opCount, LoadPlanarPixel(pixels, i)), pixels, i);
+            }
+        }
+
+        void ScalarColorLutPlanar(const float* table, uint32_t size, PlanarRow pixels, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                StorePlanarPixel(LookUp(table, size, LoadPlanarPixel(pixels, i)), pixels, i);
+            }
+        }
+
+        void ScalarHalfToFloatSamples(const uint16_t* src, float* dst, size_t count)
+        {
+            std::transform(src, src + count, dst, HalfToFloat);
+        }
+
+        void ScalarFloatToHalfSamples(const float* src, uint16_t* dst, size_t count)
+        {
+            std::transform(src, src + count, dst, FloatToHalf);
+        }
+
+        const PixelKernels ScalarKernels{
+            SimdLevel::Scalar,
+            1,
+            &ScalarColorMatrixBgra8,
+            &ScalarColorMatrixFloat,
+            &ScalarContrastBgra8,
+            &ScalarContrastFloat,
+            &ScalarPointProgramBgra8,
+            &ScalarPointProgramFloat,
+            &ScalarColorLutBgra8,
+            &ScalarColorLutFloat,
+            &ScalarAccumulateBgra8,
+            &ScalarBgra8ToPlanar,
+            &ScalarPlanarToBgra8,
+            &ScalarPointProgramPlanar,
+            &ScalarColorLutPlanar,
+            &ScalarHalfToFloatSamples,
+            &ScalarFloatToHalfSamples };
+
+#if defined(PHOTOENGINE_X86_KERNELS)
+        struct X86Features
+        {
+            bool Sse41{ false };
+            bool Avx2{ false };
+            bool Avx512{ false };
+        };
+
+        X86Features DetectX86Features()
+        {
+            X86Features features;
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            const int maxLeaf = info[0];
+
+            __cpuid(info, 1);
+            features.Sse41 = (info[2] & (1 << 19)) != 0;
+            const bool fma = (info[2] & (1 << 12)) != 0;
+            const bool f16c = (info[2] & (1 << 29)) != 0;
+            const bool osXsave = (info[2] & (1 << 27)) != 0;
+
+            // The OS must save the YMM and ZMM registers for AVX code to be usable.
+            const unsigned long long xcr0 = osXsave ? _xgetbv(0) : 0;
+            const bool osAvx = (xcr0 & 0x6) == 0x6;
+            const bool osAvx512 = (xcr0 & 0xE6) == 0xE6;
+
+            if (maxLeaf >= 7)
+            {
+                __cpuidex(info, 7, 0);
+                features.Avx2 = osAvx && fma && f16c && (info[1] & (1 << 5)) != 0;
+                features.Avx512 = features.Avx2 && osAvx512 && (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0;
+            }
+#else
+            __builtin_cpu_init();
+            features.Sse41 = __builtin_cpu_supports("sse4.1");
+            features.Avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+            features.Avx512 = features.Avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+            return features;
+        }
+
+        X86Features const& CpuFeatures()
+        {
+            static const X86Features features = DetectX86Features();
+            return features;
+        }
+#endif
+    }
+
+    const char* SimdLevelName(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::Scalar:
+            return "Scalar";
+        case SimdLevel::Sse41:
+            return "SSE4.1";
+        case SimdLevel::Avx2:
+            return "AVX2";
+        case SimdLevel::Avx512:
+            return "AVX-512";
+        case SimdLevel::Neon:
+            return "NEON";
+        }
+        return "";
+    }
+
+    bool IsSimdLevelSupported(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::Scalar:
+            return true;
+#if defined(PHOTOENGINE_X86_KERNELS)
+        case SimdLevel::Sse41:
+            return CpuFeatures().Sse41;
+        case SimdLevel::Avx2:
+            return CpuFeatures().Avx2;
+        case SimdLevel::Avx512:
+            return CpuFeatures().Avx512;
+#endif
+#if defined(PHOTOENGINE_NEON_KERNELS)
+        case SimdLevel::Neon:
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    SimdLevel BestSimdLevel()
+    {
+        for (auto level : { SimdLevel::Avx512, SimdLevel::Avx2, SimdLevel::Sse41, SimdLevel::Neon })
+        {
+            if (IsSimdLevelSupported(level))
+            {
+                return level;
+            }
+        }
+        return SimdLevel::Scalar;
+    }
+
+    PixelKernels const& GetPixelKernels(SimdLevel level)
+    {
+        if (!IsSimdLevelSupported(level))
+        {
+            throw std::invalid_argument(std::string("Pixel kernels are not supported: ") + SimdLevelName(level));
+        }
+
+        switch (level)
+        {
+#if defined(PHOTOENGINE_X86_KERNELS)
+        case SimdLevel::Sse41:
+            return Sse41PixelKernels();
+        case SimdLevel::Avx2:
+            return Avx2PixelKernels();
+        case SimdLevel::Avx512:
+            return Avx512PixelKernels();
+#endif
+#if defined(PHOTOENGINE_NEON_KERNELS)
+        case SimdLevel::Neon:
+            return NeonPixelKernels();
+#endif
+        default:
+            return ScalarKernels;
+        }
+    }
+
+    PixelKernels const& GetPixelKernels()
+    {
+        static PixelKernels const& best = GetPixelKernels(BestSimdLevel());
+        return best;
+    }
+
+    const float* SrgbDecodeTable()
+    {
+        static const auto table = []
+        {
+            std::array<float, 256> values{};
+            for (size_t level = 0; level < values.size(); level++)
+            {
+                values[level] = SrgbToLinear(level / 255.0f);
+            }
+            return values;
+        }();
+        return table.data();
+    }
+
+    const float* SrgbEncodeTable()
+    {
+        static const auto table = []
+        {
+            std::array<float, SrgbEncodeTableSize + 1> values{};
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                values[i] = LinearToSrgb(static_cast<float>(i) / SrgbEncodeTableSize);
+            }
+            return values;
+        }();
+        return table.data();
+    }
+
+    PointOp MakePointOp(EffectKind kind, EffectParameters const& params)
+    {
+        if (kind == EffectKind::Contrast)
+        {
+            return PointOp::FromContrast(params.Contrast);
+        }
+        return PointOp::FromMatrix(EffectMatrix(kind, params));
+    }
+
+    void ApplyPointEffect(PixelKernels const& kernels, EffectKind kind, EffectParameters const& params,
+        const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        if (kind == EffectKind::Contrast)
+        {
+            kernels.ContrastBgra8(params.Contrast, src, dst, count);
+        }
+        else
+        {
+            kernels.ColorMatrixBgra8(EffectMatrix(kind, params), src, dst, count);
+        }
+    }
+
+    void ApplyPointEffect(PixelKernels const& kernels, EffectKind kind, EffectParameters const& params,
+        const float* src, float* dst, size_t count)
+    {
+        if (kind == EffectKind::Contrast)
+        {
+            kernels.ContrastFloat(params.Contrast, src, dst, count);
+        }
+        else
+        {
+            kernels.ColorMatrixFloat(EffectMatrix(kind, params), src, dst, count);
+        }
+    }
+}
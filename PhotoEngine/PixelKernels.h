@@ -0,0 +1,160 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ColorMatrix.h"
+#include "EffectChain.h"
+#include "EffectParameters.h"
+#include "PlanarImage.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace PhotoEngine
+{
+    // Instruction sets the pixel kernels are compiled for.
+    enum class SimdLevel
+    {
+        Scalar,
+        Sse41,
+        Avx2,
+        Avx512,
+        Neon
+    };
+
+    const char* SimdLevelName(SimdLevel level);
+
+    // Returns true if this build contains kernels for the level and the CPU can run them.
+    bool IsSimdLevelSupported(SimdLevel level);
+
+    // Returns the widest instruction set supported by this build and CPU.
+    SimdLevel BestSimdLevel();
+
+    enum class PointOpType : uint8_t
+    {
+        ColorMatrix,
+        Contrast
+    };
+
+    // One step of a point program: a sequence of per-pixel operations that the program
+    // kernels apply to each pixel while it stays in registers.
+    struct PointOp
+    {
+        PointOpType Type;
+
+        // Used by ColorMatrix operations.
+        ColorMatrix Matrix;
+
+        // Used by Contrast operations.
+        float Contrast;
+
+        static PointOp FromMatrix(ColorMatrix const& matrix)
+        {
+            return { PointOpType::ColorMatrix, matrix, 0 };
+        }
+
+        static PointOp FromContrast(float contrast)
+        {
+            return { PointOpType::Contrast, ColorMatrix::Identity(), contrast };
+        }
+    };
+
+    // Longest point program the program kernels accept.
+    constexpr size_t MaxPointOps = 16;
+
+    // Returns the point operation equivalent to a point effect.
+    PointOp MakePointOp(EffectKind kind, EffectParameters const& params);
+
+    // Number of intervals of the table the planar kernels encode linear light to sRGB with.
+    constexpr uint32_t SrgbEncodeTableSize = 4096;
+
+    // Returns the 256 linear-light values of the 8-bit sRGB levels.
+    const float* SrgbDecodeTable();
+
+    // Returns the sRGB values of SrgbEncodeTableSize + 1 linear-light values evenly spaced
+    // over [0, 1]. Interpolating between them stays within 0.01 of a level of the curve.
+    const float* SrgbEncodeTable();
+
+    // Per-pixel kernels for one instruction set. Each kernel processes count pixels
+    // and may be called with src == dst.
+    //
+    // The Bgra8 kernels read and write BGRA8 pixels and clamp their output to [0, 255].
+    // The Float kernels read and write interleaved BGRA float pixels in [0, 1] and do
+    // not clamp, so out-of-range values survive until the image is quantized.
+    //
+    // The PointProgram kernels load each pixel once, run all opCount (at most MaxPointOps)
+    // operations on it in float, and store it once. Values are not clamped between
+    // operations, the same way Direct2D links the shaders of consecutive effects.
+    //
+    // The ColorLut kernels look up each pixel in a 3D table of size^3 lattice nodes that
+    // spans the BGR cube (see ColorLut.h) with tetrahedral interpolation. Colors are
+    // clamped to [0, 1] before the lookup and alpha passes through.
+    //
+    // The Accumulate kernel adds weight times every channel of count BGRA8 pixels to
+    // interleaved float sums; ResizeArea builds its vertical pass from it.
+    //
+    // The Planar kernels work on planar rows of either PlanarFormat, which keep each channel
+    // of a block of pixels in its own vector with no shuffling. Bgra8ToPlanar and
+    // PlanarToBgra8 convert between the layouts; with linear set, they also decode sRGB to
+    // linear light through SrgbDecodeTable and encode it back through SrgbEncodeTable.
+    // Alpha is never converted. The other Planar kernels work in place and, like the Float
+    // kernels, do not clamp. The Half kernels convert count samples between precisions.
+    struct PixelKernels
+    {
+        SimdLevel Level;
+
+        // Pixels processed per loop iteration.
+        size_t Width;
+
+        void (*ColorMatrixBgra8)(ColorMatrix const& matrix, const uint8_t* src, uint8_t* dst, size_t count);
+        void (*ColorMatrixFloat)(ColorMatrix const& matrix, const float* src, float* dst, size_t count);
+        void (*ContrastBgra8)(float contrast, const uint8_t* src, uint8_t* dst, size_t count);
+        void (*ContrastFloat)(float contrast, const float* src, float* dst, size_t count);
+        void (*PointProgramBgra8)(PointOp const* ops, size_t opCount, const uint8_t* src, uint8_t* dst, size_t count);
+        void (*PointProgramFloat)(PointOp const* ops, size_t opCount, const float* src, float* dst, size_t count);
+        void (*ColorLutBgra8)(const float* table, uint32_t size, const uint8_t* src, uint8_t* dst, size_t count);
+        void (*ColorLutFloat)(const float* table, uint32_t size, const float* src, float* dst, size_t count);
+        void (*AccumulateBgra8)(const uint8_t* src, float weight, float* sum, size_t count);
+        void (*Bgra8ToPlanar)(const uint8_t* src, PlanarRow dst, size_t count, bool linear);
+        void (*PlanarToBgra8)(PlanarRow src, uint8_t* dst, size_t count, bool linear);
+        void (*PointProgramPlanar)(PointOp const* ops, size_t opCount, PlanarRow pixels, size_t count);
+        void (*ColorLutPlanar)(const float* table, uint32_t size, PlanarRow pixels, size_t count);
+        void (*HalfToFloatSamples)(const uint16_t* src, float* dst, size_t count);
+        void (*FloatToHalfSamples)(const float* src, uint16_t* dst, size_t count);
+    };
+
+    // Returns the kernels for a level. Throws std::invalid_argument if the level is not supported.
+    PixelKernels const& GetPixelKernels(SimdLevel level);
+
+    // Returns the kernels for BestSimdLevel().
+    PixelKernels const& GetPixelKernels();
+
+    // Applies one point effect to count BGRA8 pixels with the given kernels.
+    void ApplyPointEffect(PixelKernels const& kernels, EffectKind kind, EffectParameters const& params,
+        const uint8_t* src, uint8_t* dst, size_t count);
+
+    // Applies one point effect to count interleaved BGRA float pixels with the given kernels.
+    void ApplyPointEffect(PixelKernels const& kernels, EffectKind kind, EffectParameters const& params,
+        const float* src, float* dst, size_t count);
+}
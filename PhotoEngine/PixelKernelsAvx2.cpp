@@ -0,0 +1,126 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "PixelKernelsSimd.h"
+#include <immintrin.h>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Transposes the 4x4 float blocks in each 128-bit lane of four vectors.
+        inline void TransposeLanes(__m256& v0, __m256& v1, __m256& v2, __m256& v3)
+        {
+            const __m256 t0 = _mm256_unpacklo_ps(v0, v1);
+            const __m256 t1 = _mm256_unpackhi_ps(v0, v1);
+            const __m256 t2 = _mm256_unpacklo_ps(v2, v3);
+            const __m256 t3 = _mm256_unpackhi_ps(v2, v3);
+            v0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            v1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            v2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            v3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        }
+
+        struct Avx2Vector
+        {
+            using Float = __m256;
+            static constexpr size_t Width = 8;
+
+            static Float Set(float value) { return _mm256_set1_ps(value); }
+            static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+            static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+            static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+            static Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+            static Float Max(Float a, Float b) { return _mm256_max_ps(a, b); }
+            static Float MulAdd(Float a, Float b, Float c) { return _mm256_fmadd_ps(a, b, c); }
+            static Float Floor(Float a) { return _mm256_floor_ps(a); }
+            static Float SelectGreaterEqual(Float a, Float b, Float x, Float y) { return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_GE_OQ)); }
+            static Float Gather(const float* table, Float index) { return _mm256_i32gather_ps(table, _mm256_cvttps_epi32(index), 4); }
+
+            static void Load(const uint8_t* pixels, Float& b, Float& g, Float& r, Float& a)
+            {
+                const __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels));
+                const __m256i mask = _mm256_set1_epi32(0xFF);
+                const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+
+                b = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(packed, mask)), scale);
+                g = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(packed, 8), mask)), scale);
+                r = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(packed, 16), mask)), scale);
+                a = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(packed, 24)), scale);
+            }
+
+            static __m256i Quantize(Float value)
+            {
+                value = _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(0.0f)), _mm256_set1_ps(1.0f));
+                return _mm256_cvttps_epi32(_mm256_fmadd_ps(value, _mm256_set1_ps(255.0f), _mm256_set1_ps(0.5f)));
+            }
+
+            static void Store(uint8_t* pixels, Float b, Float g, Float r, Float a)
+            {
+                // Packs and the shuffle work within 128-bit lanes, so each lane ends up
+                // holding its own four interleaved pixels.
+                const __m256i bg = _mm256_packus_epi32(Quantize(b), Quantize(g));
+                const __m256i ra = _mm256_packus_epi32(Quantize(r), Quantize(a));
+                const __m256i planar = _mm256_packus_epi16(bg, ra);
+                const __m256i interleave = _mm256_setr_epi8(
+                    0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+                    0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels), _mm256_shuffle_epi8(planar, interleave));
+            }
+
+            static void Load(const float* pixels, Float& b, Float& g, Float& r, Float& a)
+            {
+                b = _mm256_loadu_ps(pixels);
+                g = _mm256_loadu_ps(pixels + 8);
+                r = _mm256_loadu_ps(pixels + 16);
+                a = _mm256_loadu_ps(pixels + 24);
+                TransposeLanes(b, g, r, a);
+            }
+
+            static void Store(float* pixels, Float b, Float g, Float r, Float a)
+            {
+                TransposeLanes(b, g, r, a);
+                _mm256_storeu_ps(pixels, b);
+                _mm256_storeu_ps(pixels + 8, g);
+                _mm256_storeu_ps(pixels + 16, r);
+                _mm256_storeu_ps(pixels + 24, a);
+            }
+
+            static Float LoadPlane(const float* samples) { return _mm256_loadu_ps(samples); }
+            static void StorePlane(float* samples, Float value) { _mm256_storeu_ps(samples, value); }
+            static Float LoadHalf(const uint16_t* samples) { return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(samples))); }
+
+            static void StoreHalf(uint16_t* samples, Float value)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(samples), _mm256_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+            }
+        };
+    }
+
+    PixelKernels const& Avx2PixelKernels()
+    {
+        static const PixelKernels kernels = MakePixelKernels<Avx2Vector>(SimdLevel::Avx2);
+        return kernels;
+    }
+}
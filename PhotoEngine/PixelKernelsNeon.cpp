@@ -0,0 +1,108 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "PixelKernelsSimd.h"
+#include <arm_neon.h>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        struct NeonVector
+        {
+            using Float = float32x4_t;
+            static constexpr size_t Width = 4;
+
+            static Float Set(float value) { return vdupq_n_f32(value); }
+            static Float Add(Float a, Float b) { return vaddq_f32(a, b); }
+            static Float Sub(Float a, Float b) { return vsubq_f32(a, b); }
+            static Float Mul(Float a, Float b) { return vmulq_f32(a, b); }
+            static Float Min(Float a, Float b) { return vminq_f32(a, b); }
+            static Float Max(Float a, Float b) { return vmaxq_f32(a, b); }
+            static Float MulAdd(Float a, Float b, Float c) { return vmlaq_f32(c, a, b); }
+            static Float Floor(Float a) { return vrndmq_f32(a); }
+            static Float SelectGreaterEqual(Float a, Float b, Float x, Float y) { return vbslq_f32(vcgeq_f32(a, b), x, y); }
+
+            static Float Gather(const float* table, Float index)
+            {
+                const uint32x4_t i = vcvtq_u32_f32(index);
+                const float values[4] = { table[vgetq_lane_u32(i, 0)], table[vgetq_lane_u32(i, 1)],
+                    table[vgetq_lane_u32(i, 2)], table[vgetq_lane_u32(i, 3)] };
+                return vld1q_f32(values);
+            }
+
+            static void Load(const uint8_t* pixels, Float& b, Float& g, Float& r, Float& a)
+            {
+                const uint32x4_t packed = vreinterpretq_u32_u8(vld1q_u8(pixels));
+                const uint32x4_t mask = vdupq_n_u32(0xFF);
+                const float scale = 1.0f / 255.0f;
+
+                b = vmulq_n_f32(vcvtq_f32_u32(vandq_u32(packed, mask)), scale);
+                g = vmulq_n_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(packed, 8), mask)), scale);
+                r = vmulq_n_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(packed, 16), mask)), scale);
+                a = vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(packed, 24)), scale);
+            }
+
+            static uint32x4_t Quantize(Float value)
+            {
+                value = vminq_f32(vmaxq_f32(value, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+                return vcvtq_u32_f32(vmlaq_n_f32(vdupq_n_f32(0.5f), value, 255.0f));
+            }
+
+            static void Store(uint8_t* pixels, Float b, Float g, Float r, Float a)
+            {
+                uint32x4_t packed = Quantize(b);
+                packed = vorrq_u32(packed, vshlq_n_u32(Quantize(g), 8));
+                packed = vorrq_u32(packed, vshlq_n_u32(Quantize(r), 16));
+                packed = vorrq_u32(packed, vshlq_n_u32(Quantize(a), 24));
+                vst1q_u8(pixels, vreinterpretq_u8_u32(packed));
+            }
+
+            static void Load(const float* pixels, Float& b, Float& g, Float& r, Float& a)
+            {
+                const float32x4x4_t channels = vld4q_f32(pixels);
+                b = channels.val[0];
+                g = channels.val[1];
+                r = channels.val[2];
+                a = channels.val[3];
+            }
+
+            static void Store(float* pixels, Float b, Float g, Float r, Float a)
+            {
+                vst4q_f32(pixels, float32x4x4_t{ { b, g, r, a } });
+            }
+
+            static Float LoadPlane(const float* samples) { return vld1q_f32(samples); }
+            static void StorePlane(float* samples, Float value) { vst1q_f32(samples, value); }
+            static Float LoadHalf(const uint16_t* samples) { return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(samples))); }
+            static void StoreHalf(uint16_t* samples, Float value) { vst1_u16(samples, vreinterpret_u16_f16(vcvt_f16_f32(value))); }
+        };
+    }
+
+    PixelKernels const& NeonPixelKernels()
+    {
+        static const PixelKernels kernels = MakePixelKernels<NeonVector>(SimdLevel::Neon);
+        return kernels;
+    }
+}
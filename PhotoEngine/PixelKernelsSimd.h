@@ -0,0 +1,587 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+// Kernel bodies shared by the instruction-set specific translation units
+// (PixelKernelsSse41.cpp, PixelKernelsAvx2.cpp, ...). Each unit is compiled with its
+// own target flags and instantiates MakePixelKernels with a vector traits type that
+// provides:
+//
+//     using Float = <native float vector>;
+//     static constexpr size_t Width;          // float lanes = pixels per block
+//     Set, Add, Sub, Mul, Min, Max, MulAdd(a, b, c) = a * b + c, Floor
+//     SelectGreaterEqual(a, b, x, y)          // per lane: a >= b ? x : y
+//     Gather(const float* table, index)       // per lane: table[index], index a whole float
+//     Load / Store(uint8_t*, ...)             // Width BGRA8 pixels <-> 4 channel vectors
+//     Load / Store(float*, ...)               // Width float pixels <-> 4 channel vectors
+//     LoadPlane / StorePlane(float*, ...)     // Width consecutive floats <-> one vector
+//     LoadHalf / StoreHalf(uint16_t*, ...)    // Width consecutive halves <-> one vector
+//
+// The BGRA8 Store must round like QuantizeChannel and saturate to [0, 255], and StoreHalf
+// must round to nearest even like FloatToHalf. The float pixel Load and Store may hold
+// the pixels of a block in any order as long as they put them back; the BGRA8 ones keep
+// the pixels in order, since the planar kernels pair them with plane loads.
+//
+// The templates live in an unnamed namespace so the differently compiled copies are
+// never merged by the linker.
+
+#include "PixelKernels.h"
+#include <cstring>
+
+namespace PhotoEngine
+{
+    // Kernel tables of the instruction-set specific translation units.
+    PixelKernels const& Sse41PixelKernels();
+    PixelKernels const& Avx2PixelKernels();
+    PixelKernels const& Avx512PixelKernels();
+    PixelKernels const& NeonPixelKernels();
+
+    namespace
+    {
+        // A block of V::Width pixels with one vector per channel.
+        template <typename V>
+        struct PixelBlock
+        {
+            typename V::Float B;
+            typename V::Float G;
+            typename V::Float R;
+            typename V::Float A;
+        };
+
+        // A color matrix with every coefficient broadcast to a vector.
+        template <typename V>
+        struct MatrixVectors
+        {
+            typename V::Float M[4][5];
+
+            explicit MatrixVectors(ColorMatrix const& matrix)
+            {
+                for (int row = 0; row < 4; row++)
+                {
+                    for (int column = 0; column < 5; column++)
+                    {
+                        M[row][column] = V::Set(matrix.M[row][column]);
+                    }
+                }
+            }
+        };
+
+        template <typename V>
+        inline void Transform(const typename V::Float (&matrix)[4][5], PixelBlock<V>& pixels)
+        {
+            const typename V::Float in[4] = { pixels.B, pixels.G, pixels.R, pixels.A };
+            typename V::Float out[4];
+
+            for (int row = 0; row < 4; row++)
+            {
+                auto sum = V::MulAdd(matrix[row][0], in[0], matrix[row][4]);
+                sum = V::MulAdd(matrix[row][1], in[1], sum);
+                sum = V::MulAdd(matrix[row][2], in[2], sum);
+                out[row] = V::MulAdd(matrix[row][3], in[3], sum);
+            }
+
+            pixels = { out[0], out[1], out[2], out[3] };
+        }
+
+        // Vector form of the smoothstep contrast curve in PointEffects.cpp.
+        template <typename V>
+        inline typename V::Float ContrastCurve(typename V::Float value, typename V::Float contrast)
+        {
+            value = V::Min(V::Max(value, V::Set(0.0f)), V::Set(1.0f));
+            const auto smooth = V::Mul(V::Mul(value, value), V::Sub(V::Set(3.0f), V::Add(value, value)));
+            return V::MulAdd(contrast, V::Sub(smooth, value), value);
+        }
+
+        template <typename V>
+        inline void ApplyContrast(typename V::Float contrast, PixelBlock<V>& pixels)
+        {
+            pixels.B = ContrastCurve<V>(pixels.B, contrast);
+            pixels.G = ContrastCurve<V>(pixels.G, contrast);
+            pixels.R = ContrastCurve<V>(pixels.R, contrast);
+        }
+
+        // Runs op over count pixels, one block at a time. A final partial block is copied
+        // through a padded buffer so every pixel goes through the same vector code.
+        template <typename V, typename T, typename Op>
+        inline void ForEachBlock(const T* src, T* dst, size_t count, Op const& op)
+        {
+            auto run = [&op](const T* in, T* out)
+            {
+                PixelBlock<V> pixels;
+                V::Load(in, pixels.B, pixels.G, pixels.R, pixels.A);
+                op(pixels);
+                V::Store(out, pixels.B, pixels.G, pixels.R, pixels.A);
+            };
+
+            size_t i = 0;
+            for (; i + V::Width <= count; i += V::Width)
+            {
+                run(src + i * 4, dst + i * 4);
+            }
+
+            if (i < count)
+            {
+                alignas(64) T block[V::Width * 4] = {};
+                std::memcpy(block, src + i * 4, (count - i) * 4 * sizeof(T));
+                run(block, block);
+                std::memcpy(dst + i * 4, block, (count - i) * 4 * sizeof(T));
+            }
+        }
+
+        template <typename V>
+        void ColorMatrixBgra8(ColorMatrix const& matrix, const uint8_t* src, uint8_t* dst, size_t count)
+        {
+            const MatrixVectors<V> vectors(matrix);
+            ForEachBlock<V>(src, dst, count, [&vectors](PixelBlock<V>& pixels) { Transform<V>(vectors.M, pixels); });
+        }
+
+        template <typename V>
+        void ColorMatrixFloat(ColorMatrix const& matrix, const float* src, float* dst, size_t count)
+        {
+            const MatrixVectors<V> vectors(matrix);
+            ForEachBlock<V>(src, dst, count, [&vectors](PixelBlock<V>& pixels) { Transform<V>(vectors.M, pixels); });
+        }
+
+        template <typename V>
+        void ContrastBgra8(float contrast, const uint8_t* src, uint8_t* dst, size_t count)
+        {
+            const auto amount = V::Set(contrast);
+            ForEachBlock<V>(src, dst, count, [amount](PixelBlock<V>& pixels) { ApplyContrast<V>(amount, pixels); });
+        }
+
+        template <typename V>
+        void ContrastFloat(float contrast, const float* src, float* dst, size_t count)
+        {
+            const auto amount = V::Set(contrast);
+            ForEachBlock<V>(src, dst, count, [amount](PixelBlock<V>& pixels) { ApplyContrast<V>(amount, pixels); });
+        }
+
+        // A point program with every coefficient broadcast to a vector.
+        template <typename V>
+        struct ProgramVectors
+        {
+            PointOpType Types[MaxPointOps];
+            typename V::Float Coefficients[MaxPointOps][4][5];
+            size_t Count;
+
+            ProgramVectors(PointOp const* ops, size_t count) :
+                Count(count)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    Types[i] = ops[i].Type;
+                    if (ops[i].Type == PointOpType::Contrast)
+                    {
+                        Coefficients[i][0][0] = V::Set(ops[i].Contrast);
+                        continue;
+                    }
+
+                    for (int row = 0; row < 4; row++)
+                    {
+                        for (int column = 0; column < 5; column++)
+                        {
+                            Coefficients[i][row][column] = V::Set(ops[i].Matrix.M[row][column]);
+                        }
+                    }
+                }
+            }
+
+            void Run(PixelBlock<V>& pixels) const
+            {
+                for (size_t i = 0; i < Count; i++)
+                {
+                    if (Types[i] == PointOpType::Contrast)
+                    {
+                        ApplyContrast<V>(Coefficients[i][0][0], pixels);
+                    }
+                    else
+                    {
+                        Transform<V>(Coefficients[i], pixels);
+                    }
+                }
+            }
+        };
+
+        template <typename V>
+        void PointProgramBgra8(PointOp const* ops, size_t opCount, const uint8_t* src, uint8_t* dst, size_t count)
+        {
+            const ProgramVectors<V> program(ops, opCount);
+            ForEachBlock<V>(src, dst, count, [&program](PixelBlock<V>& pixels) { program.Run(pixels); });
+        }
+
+        template <typename V>
+        void PointProgramFloat(PointOp const* ops, size_t opCount, const float* src, float* dst, size_t count)
+        {
+            const ProgramVectors<V> program(ops, opCount);
+            ForEachBlock<V>(src, dst, count, [&program](PixelBlock<V>& pixels) { program.Run(pixels); });
+        }
+
+        // A 3D LUT with its lattice constants broadcast to vectors. The table holds B, G, R
+        // floats per node with B varying fastest; strides are in floats.
+        template <typename V>
+        struct LutVectors
+        {
+            const float* Table;
+            typename V::Float Scale;
+            typename V::Float MaxBase;
+            typename V::Float StrideB;
+            typename V::Float StrideG;
+            typename V::Float StrideR;
+
+            LutVectors(const float* table, uint32_t size) :
+                Table(table),
+                Scale(V::Set(static_cast<float>(size - 1))),
+                MaxBase(V::Set(static_cast<float>(size - 2))),
+                StrideB(V::Set(3.0f)),
+                StrideG(V::Set(3.0f * size)),
+                StrideR(V::Set(3.0f * size * size))
+            {
+            }
+
+            // Splits the lattice cell around each pixel into six tetrahedra along its main
+            // diagonal. Sorting the fractional coordinates picks the tetrahedron, whose four
+            // corners are gathered and blended with barycentric weights.
+            void Run(PixelBlock<V>& pixels) const
+            {
+                const auto zero = V::Set(0.0f);
+                const auto one = V::Set(1.0f);
+                const auto b = V::Mul(V::Min(V::Max(pixels.B, zero), one), Scale);
+                const auto g = V::Mul(V::Min(V::Max(pixels.G, zero), one), Scale);
+                const auto r = V::Mul(V::Min(V::Max(pixels.R, zero), one), Scale);
+
+                // The top node of each axis is reached from the cell below it.
+                const auto baseB = V::Min(V::Floor(b), MaxBase);
+                const auto baseG = V::Min(V::Floor(g), MaxBase);
+                const auto baseR = V::Min(V::Floor(r), MaxBase);
+                const auto fb = V::Sub(b, baseB);
+                const auto fg = V::Sub(g, baseG);
+                const auto fr = V::Sub(r, baseR);
+
+                const auto high = V::Max(fb, V::Max(fg, fr));
+                const auto low = V::Min(fb, V::Min(fg, fr));
+                const auto middle = V::Sub(V::Add(fb, V::Add(fg, fr)), V::Add(high, low));
+
+                // The second corner is one step along the axis with the largest fraction; the
+                // third is one step short of the far corner along the axis with the smallest.
+                const auto origin = V::MulAdd(baseR, StrideR, V::MulAdd(baseG, StrideG, V::Mul(baseB, StrideB)));
+                const auto far = V::Add(origin, V::Add(StrideB, V::Add(StrideG, StrideR)));
+                const auto first = V::Add(origin, V::SelectGreaterEqual(fb, V::Max(fg, fr), StrideB,
+                    V::SelectGreaterEqual(fg, fr, StrideG, StrideR)));
+                const auto second = V::Sub(far, V::SelectGreaterEqual(fb, V::Min(fg, fr),
+                    V::SelectGreaterEqual(fg, fr, StrideR, StrideG), StrideB));
+
+                const auto w0 = V::Sub(one, high);
+                const auto w1 = V::Sub(high, middle);
+                const auto w2 = V::Sub(middle, low);
+
+                typename V::Float* channels[3] = { &pixels.B, &pixels.G, &pixels.R };
+                for (int channel = 0; channel < 3; channel++)
+                {
+                    const auto offset = V::Set(static_cast<float>(channel));
+                    auto value = V::Mul(low, V::Gather(Table, V::Add(far, offset)));
+                    value = V::MulAdd(w2, V::Gather(Table, V::Add(second, offset)), value);
+                    value = V::MulAdd(w1, V::Gather(Table, V::Add(first, offset)), value);
+                    *channels[channel] = V::MulAdd(w0, V::Gather(Table, V::Add(origin, offset)), value);
+                }
+            }
+        };
+
+        template <typename V>
+        void ColorLutBgra8(const float* table, uint32_t size, const uint8_t* src, uint8_t* dst, size_t count)
+        {
+            const LutVectors<V> lut(table, size);
+            ForEachBlock<V>(src, dst, count, [&lut](PixelBlock<V>& pixels) { lut.Run(pixels); });
+        }
+
+        template <typename V>
+        void ColorLutFloat(const float* table, uint32_t size, const float* src, float* dst, size_t count)
+        {
+            const LutVectors<V> lut(table, size);
+            ForEachBlock<V>(src, dst, count, [&lut](PixelBlock<V>& pixels) { lut.Run(pixels); });
+        }
+
+        template <typename V>
+        inline typename V::Float LoadSamples(const float* samples)
+        {
+            return V::LoadPlane(samples);
+        }
+
+        template <typename V>
+        inline typename V::Float LoadSamples(const uint16_t* samples)
+        {
+            return V::LoadHalf(samples);
+        }
+
+        template <typename V>
+        inline void StoreSamples(float* samples, typename V::Float value)
+        {
+            V::StorePlane(samples, value);
+        }
+
+        template <typename V>
+        inline void StoreSamples(uint16_t* samples, typename V::Float value)
+        {
+            V::StoreHalf(samples, value);
+        }
+
+        // Runs op on the block of pixels at offset of the planes. The block is loaded from
+        // the BGRA8 pixels at src if there are any and from the planes otherwise, and stored
+        // to the BGRA8 pixels at dst if there are any and to the planes otherwise.
+        template <typename V, typename T, typename Op>
+        inline void RunPlanarBlock(T* const (&planes)[4], size_t offset, const uint8_t* src, uint8_t* dst, Op const& op)
+        {
+            PixelBlock<V> pixels;
+            if (src)
+            {
+                V::Load(src, pixels.B, pixels.G, pixels.R, pixels.A);
+            }
+            else
+            {
+                pixels.B = LoadSamples<V>(planes[0] + offset);
+                pixels.G = LoadSamples<V>(planes[1] + offset);
+                pixels.R = LoadSamples<V>(planes[2] + offset);
+                pixels.A = LoadSamples<V>(planes[3] + offset);
+            }
+
+            op(pixels);
+
+            if (dst)
+            {
+                V::Store(dst, pixels.B, pixels.G, pixels.R, pixels.A);
+            }
+            else
+            {
+                StoreSamples<V>(planes[0] + offset, pixels.B);
+                StoreSamples<V>(planes[1] + offset, pixels.G);
+                StoreSamples<V>(planes[2] + offset, pixels.R);
+                StoreSamples<V>(planes[3] + offset, pixels.A);
+            }
+        }
+
+        // Runs op over count pixels of a planar row of T samples, one block at a time; see
+        // RunPlanarBlock for src and dst. A final partial block goes through padded buffers.
+        template <typename V, typename T, typename Op>
+        inline void ForEachPlanarBlock(T* const (&planes)[4], const uint8_t* src, uint8_t* dst, size_t count, Op const& op)
+        {
+            size_t i = 0;
+            for (; i + V::Width <= count; i += V::Width)
+            {
+                RunPlanarBlock<V>(planes, i, src ? src + i * 4 : nullptr, dst ? dst + i * 4 : nullptr, op);
+            }
+
+            if (i < count)
+            {
+                const size_t rest = count - i;
+                alignas(64) T samples[4][V::Width] = {};
+                alignas(64) uint8_t pixels[V::Width * 4] = {};
+                T* const padded[4] = { samples[0], samples[1], samples[2], samples[3] };
+
+                if (src)
+                {
+                    std::memcpy(pixels, src + i * 4, rest * 4);
+                }
+                else
+                {
+                    for (int plane = 0; plane < 4; plane++)
+                    {
+                        std::memcpy(samples[plane], planes[plane] + i, rest * sizeof(T));
+                    }
+                }
+
+                RunPlanarBlock<V>(padded, 0, src ? pixels : nullptr, dst ? pixels : nullptr, op);
+
+                if (dst)
+                {
+                    std::memcpy(dst + i * 4, pixels, rest * 4);
+                }
+                else
+                {
+                    for (int plane = 0; plane < 4; plane++)
+                    {
+                        std::memcpy(planes[plane] + i, samples[plane], rest * sizeof(T));
+                    }
+                }
+            }
+        }
+
+        template <typename V, typename Op>
+        inline void ForEachPlanarBlock(PlanarRow row, const uint8_t* src, uint8_t* dst, size_t count, Op const& op)
+        {
+            if (row.Format == PlanarFormat::Float16)
+            {
+                uint16_t* const planes[4] = { static_cast<uint16_t*>(row.Planes[0]), static_cast<uint16_t*>(row.Planes[1]),
+                    static_cast<uint16_t*>(row.Planes[2]), static_cast<uint16_t*>(row.Planes[3]) };
+                ForEachPlanarBlock<V>(planes, src, dst, count, op);
+            }
+            else
+            {
+                float* const planes[4] = { static_cast<float*>(row.Planes[0]), static_cast<float*>(row.Planes[1]),
+                    static_cast<float*>(row.Planes[2]), static_cast<float*>(row.Planes[3]) };
+                ForEachPlanarBlock<V>(planes, src, dst, count, op);
+            }
+        }
+
+        // The sRGB tables with their constants broadcast to vectors.
+        template <typename V>
+        struct SrgbVectors
+        {
+            const float* Decode{ SrgbDecodeTable() };
+            const float* Encode{ SrgbEncodeTable() };
+            typename V::Float Zero{ V::Set(0.0f) };
+            typename V::Float One{ V::Set(1.0f) };
+            typename V::Float Half{ V::Set(0.5f) };
+            typename V::Float Levels{ V::Set(255.0f) };
+            typename V::Float Intervals{ V::Set(static_cast<float>(SrgbEncodeTableSize)) };
+            typename V::Float MaxBase{ V::Set(static_cast<float>(SrgbEncodeTableSize - 1)) };
+
+            // Looks up the level a Load produced, value * 255 give or take rounding.
+            typename V::Float ToLinear(typename V::Float value) const
+            {
+                return V::Gather(Decode, V::MulAdd(value, Levels, Half));
+            }
+
+            typename V::Float ToSrgb(typename V::Float value) const
+            {
+                const auto x = V::Mul(V::Min(V::Max(value, Zero), One), Intervals);
+                const auto base = V::Min(V::Floor(x), MaxBase);
+                const auto low = V::Gather(Encode, base);
+                const auto high = V::Gather(Encode, V::Add(base, One));
+                return V::MulAdd(V::Sub(x, base), V::Sub(high, low), low);
+            }
+        };
+
+        template <typename V>
+        void Bgra8ToPlanar(const uint8_t* src, PlanarRow dst, size_t count, bool linear)
+        {
+            if (!linear)
+            {
+                ForEachPlanarBlock<V>(dst, src, nullptr, count, [](PixelBlock<V>&) {});
+                return;
+            }
+
+            const SrgbVectors<V> srgb;
+            ForEachPlanarBlock<V>(dst, src, nullptr, count, [&srgb](PixelBlock<V>& pixels)
+            {
+                pixels.B = srgb.ToLinear(pixels.B);
+                pixels.G = srgb.ToLinear(pixels.G);
+                pixels.R = srgb.ToLinear(pixels.R);
+            });
+        }
+
+        template <typename V>
+        void PlanarToBgra8(PlanarRow src, uint8_t* dst, size_t count, bool linear)
+        {
+            if (!linear)
+            {
+                ForEachPlanarBlock<V>(src, nullptr, dst, count, [](PixelBlock<V>&) {});
+                return;
+            }
+
+            const SrgbVectors<V> srgb;
+            ForEachPlanarBlock<V>(src, nullptr, dst, count, [&srgb](PixelBlock<V>& pixels)
+            {
+                pixels.B = srgb.ToSrgb(pixels.B);
+                pixels.G = srgb.ToSrgb(pixels.G);
+                pixels.R = srgb.ToSrgb(pixels.R);
+            });
+        }
+
+        template <typename V>
+        void PointProgramPlanar(PointOp const* ops, size_t opCount, PlanarRow pixels, size_t count)
+        {
+            const ProgramVectors<V> program(ops, opCount);
+            ForEachPlanarBlock<V>(pixels, nullptr, nullptr, count, [&program](PixelBlock<V>& block) { program.Run(block); });
+        }
+
+        template <typename V>
+        void ColorLutPlanar(const float* table, uint32_t size, PlanarRow pixels, size_t count)
+        {
+            const LutVectors<V> lut(table, size);
+            ForEachPlanarBlock<V>(pixels, nullptr, nullptr, count, [&lut](PixelBlock<V>& block) { lut.Run(block); });
+        }
+
+        template <typename V>
+        void HalfToFloatSamples(const uint16_t* src, float* dst, size_t count)
+        {
+            size_t i = 0;
+            for (; i + V::Width <= count; i += V::Width)
+            {
+                V::StorePlane(dst + i, V::LoadHalf(src + i));
+            }
+            for (; i < count; i++)
+            {
+                dst[i] = HalfToFloat(src[i]);
+            }
+        }
+
+        template <typename V>
+        void FloatToHalfSamples(const float* src, uint16_t* dst, size_t count)
+        {
+            size_t i = 0;
+            for (; i + V::Width <= count; i += V::Width)
+            {
+                V::StoreHalf(dst + i, V::LoadPlane(src + i));
+            }
+            for (; i < count; i++)
+            {
+                dst[i] = FloatToHalf(src[i]);
+            }
+        }
+
+        // Every channel gets the same weight, so this needs no deinterleaving; the
+        // compiler vectorizes the loop for the unit's target.
+        template <typename V>
+        void AccumulateBgra8(const uint8_t* src, float weight, float* sum, size_t count)
+        {
+            for (size_t i = 0; i < count * 4; i++)
+            {
+                sum[i] += weight * src[i];
+            }
+        }
+
+        template <typename V>
+        PixelKernels MakePixelKernels(SimdLevel level)
+        {
+            return {
+                level,
+                V::Width,
+                &ColorMatrixBgra8<V>,
+                &ColorMatrixFloat<V>,
+                &ContrastBgra8<V>,
+                &ContrastFloat<V>,
+                &PointProgramBgra8<V>,
+                &PointProgramFloat<V>,
+                &ColorLutBgra8<V>,
+                &ColorLutFloat<V>,
+                &AccumulateBgra8<V>,
+                &Bgra8ToPlanar<V>,
+                &PlanarToBgra8<V>,
+                &PointProgramPlanar<V>,
+                &ColorLutPlanar<V>,
+                &HalfToFloatSamples<V>,
+                &FloatToHalfSamples<V> };
+        }
+    }
+}
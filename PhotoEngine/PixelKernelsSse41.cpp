@@ -0,0 +1,129 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "PixelKernelsSimd.h"
+#include <smmintrin.h>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        struct Sse41Vector
+        {
+            using Float = __m128;
+            static constexpr size_t Width = 4;
+
+            static Float Set(float value) { return _mm_set1_ps(value); }
+            static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+            static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+            static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+            static Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+            static Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+            static Float MulAdd(Float a, Float b, Float c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+            static Float Floor(Float a) { return _mm_floor_ps(a); }
+            static Float SelectGreaterEqual(Float a, Float b, Float x, Float y) { return _mm_blendv_ps(y, x, _mm_cmpge_ps(a, b)); }
+
+            static Float Gather(const float* table, Float index)
+            {
+                const __m128i i = _mm_cvttps_epi32(index);
+                return _mm_setr_ps(table[_mm_cvtsi128_si32(i)], table[_mm_extract_epi32(i, 1)],
+                    table[_mm_extract_epi32(i, 2)], table[_mm_extract_epi32(i, 3)]);
+            }
+
+            static void Load(const uint8_t* pixels, Float& b, Float& g, Float& r, Float& a)
+            {
+                // Gather each channel into its own 32-bit lane group, then widen.
+                const __m128i planar = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels)),
+                    _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15));
+                const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+
+                b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(planar)), scale);
+                g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(planar, 4))), scale);
+                r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(planar, 8))), scale);
+                a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(planar, 12))), scale);
+            }
+
+            static __m128i Quantize(Float value)
+            {
+                value = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(0.0f)), _mm_set1_ps(1.0f));
+                return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+            }
+
+            static void Store(uint8_t* pixels, Float b, Float g, Float r, Float a)
+            {
+                // Narrow with saturating packs, then interleave the channels.
+                const __m128i bg = _mm_packus_epi32(Quantize(b), Quantize(g));
+                const __m128i ra = _mm_packus_epi32(Quantize(r), Quantize(a));
+                const __m128i planar = _mm_packus_epi16(bg, ra);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), _mm_shuffle_epi8(planar,
+                    _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15)));
+            }
+
+            static void Load(const float* pixels, Float& b, Float& g, Float& r, Float& a)
+            {
+                b = _mm_loadu_ps(pixels);
+                g = _mm_loadu_ps(pixels + 4);
+                r = _mm_loadu_ps(pixels + 8);
+                a = _mm_loadu_ps(pixels + 12);
+                _MM_TRANSPOSE4_PS(b, g, r, a);
+            }
+
+            static void Store(float* pixels, Float b, Float g, Float r, Float a)
+            {
+                _MM_TRANSPOSE4_PS(b, g, r, a);
+                _mm_storeu_ps(pixels, b);
+                _mm_storeu_ps(pixels + 4, g);
+                _mm_storeu_ps(pixels + 8, r);
+                _mm_storeu_ps(pixels + 12, a);
+            }
+
+            static Float LoadPlane(const float* samples) { return _mm_loadu_ps(samples); }
+            static void StorePlane(float* samples, Float value) { _mm_storeu_ps(samples, value); }
+
+            // The half conversion instructions came with AVX, so here each lane is converted
+            // on its own.
+            static Float LoadHalf(const uint16_t* samples)
+            {
+                return _mm_setr_ps(HalfToFloat(samples[0]), HalfToFloat(samples[1]), HalfToFloat(samples[2]), HalfToFloat(samples[3]));
+            }
+
+            static void StoreHalf(uint16_t* samples, Float value)
+            {
+                alignas(16) float values[4];
+                _mm_store_ps(values, value);
+                for (int i = 0; i < 4; i++)
+                {
+                    samples[i] = FloatToHalf(values[i]);
+                }
+            }
+        };
+    }
+
+    PixelKernels const& Sse41PixelKernels()
+    {
+        static const PixelKernels kernels = MakePixelKernels<Sse41Vector>(SimdLevel::Sse41);
+        return kernels;
+    }
+}
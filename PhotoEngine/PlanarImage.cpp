@@ -0,0 +1,126 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "PlanarImage.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        bits &= 0x7FFFFFFF;
+
+        // Infinity and NaN keep their class; NaN stays quiet.
+        if (bits >= 0x7F800000)
+        {
+            return sign | 0x7C00 | (bits > 0x7F800000 ? 0x200 : 0);
+        }
+
+        // Halfway between the largest half, 65504, and the next power of two rounds up.
+        if (bits >= 0x477FF000)
+        {
+            return sign | 0x7C00;
+        }
+
+        // Below the smallest normal half, adding 0.5 lines the float's mantissa up with the
+        // half's subnormal steps and lets the FPU do the rounding.
+        if (bits < 0x38800000)
+        {
+            float magnitude;
+            std::memcpy(&magnitude, &bits, sizeof(bits));
+            magnitude += 0.5f;
+            std::memcpy(&bits, &magnitude, sizeof(bits));
+            return sign | static_cast<uint16_t>(bits - 0x3F000000);
+        }
+
+        // Rebias the exponent and round the 13 dropped mantissa bits to nearest even.
+        const uint32_t odd = (bits >> 13) & 1;
+        bits += 0xC8000FFF + odd;
+        return sign | static_cast<uint16_t>(bits >> 13);
+    }
+
+    float HalfToFloat(uint16_t value)
+    {
+        const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+        const uint32_t exponent = (value >> 10) & 0x1F;
+        const uint32_t mantissa = value & 0x3FF;
+
+        if (exponent == 0)
+        {
+            // Zero or subnormal: mantissa units of 2^-24.
+            const float magnitude = mantissa * 5.9604645e-8f;
+            return sign ? -magnitude : magnitude;
+        }
+
+        // Rebias the exponent; infinity and NaN map to their float counterparts.
+        const uint32_t bits = sign | (exponent == 0x1F ? 0x7F800000 : (exponent + 112) << 23) | (mantissa << 13);
+        float result;
+        std::memcpy(&result, &bits, sizeof(bits));
+        return result;
+    }
+
+    PlanarImage::PlanarImage(uint32_t width, uint32_t height, PlanarFormat format)
+    {
+        // Round rows up to whole 64-byte lines.
+        const size_t samplesPerLine = BufferPool::Alignment / SampleBytes(format);
+        const size_t stride = (width + samplesPerLine - 1) / samplesPerLine * samplesPerLine;
+        const size_t planeBytes = stride * height * SampleBytes(format);
+
+        m_samples = GetBufferPool().Acquire(planeBytes * 4);
+        m_view.Format = format;
+        m_view.Width = width;
+        m_view.Height = height;
+        m_view.Stride = stride;
+        for (size_t plane = 0; plane < 4; plane++)
+        {
+            m_view.Planes[plane] = m_samples.Data() + plane * planeBytes;
+        }
+    }
+
+    void CopyPixels(PlanarView src, PlanarView dst)
+    {
+        if (src.Width != dst.Width || src.Height != dst.Height || src.Format != dst.Format)
+        {
+            throw std::invalid_argument("CopyPixels: source and destination sizes differ");
+        }
+
+        const size_t rowBytes = src.Width * SampleBytes(src.Format);
+        for (uint32_t y = 0; y < src.Height; y++)
+        {
+            const auto in = src.Row(y);
+            const auto out = dst.Row(y);
+            for (int plane = 0; plane < 4; plane++)
+            {
+                if (in.Planes[plane] != out.Planes[plane])
+                {
+                    std::memcpy(out.Planes[plane], in.Planes[plane], rowBytes);
+                }
+            }
+        }
+    }
+}
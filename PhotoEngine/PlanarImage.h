@@ -0,0 +1,128 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "BufferPool.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace PhotoEngine
+{
+    // Precision of the samples of a planar image.
+    enum class PlanarFormat : uint8_t
+    {
+        Float32,
+
+        // IEEE half precision: 11 significant bits, at half the memory of Float32.
+        Float16
+    };
+
+    // Returns the size of one sample in bytes.
+    constexpr size_t SampleBytes(PlanarFormat format)
+    {
+        return format == PlanarFormat::Float16 ? 2 : 4;
+    }
+
+    // Converts between single and half precision, rounding to nearest even. Values past
+    // the largest half become infinity.
+    uint16_t FloatToHalf(float value);
+    float HalfToFloat(uint16_t value);
+
+    // The B, G, R and A samples of a run of pixels, one pointer per plane. The samples of
+    // the following pixels of the run follow each pointer.
+    struct PlanarRow
+    {
+        PlanarFormat Format;
+        void* Planes[4];
+
+        // Returns the run that starts count pixels later.
+        PlanarRow Offset(size_t count) const
+        {
+            const size_t bytes = count * SampleBytes(Format);
+            return { Format, {
+                static_cast<uint8_t*>(Planes[0]) + bytes,
+                static_cast<uint8_t*>(Planes[1]) + bytes,
+                static_cast<uint8_t*>(Planes[2]) + bytes,
+                static_cast<uint8_t*>(Planes[3]) + bytes } };
+        }
+    };
+
+    // View of an image stored as separate B, G, R and A planes. Rows of each plane are
+    // Stride samples apart. Values are nominally in [0, 1] but are not clamped, so out of
+    // range intermediate results survive until the image is converted back to BGRA8.
+    struct PlanarView
+    {
+        PlanarFormat Format{ PlanarFormat::Float32 };
+        uint8_t* Planes[4]{};
+        uint32_t Width{ 0 };
+        uint32_t Height{ 0 };
+        size_t Stride{ 0 };
+
+        PlanarRow Row(uint32_t y) const
+        {
+            const size_t offset = y * Stride * SampleBytes(Format);
+            return { Format, { Planes[0] + offset, Planes[1] + offset, Planes[2] + offset, Planes[3] + offset } };
+        }
+    };
+
+    // Owning planar image. The planes share one buffer from GetBufferPool(), and each row
+    // starts on a 64-byte boundary.
+    class PlanarImage
+    {
+    public:
+        PlanarImage() = default;
+
+        // Creates an image whose samples are undefined, for a caller that writes all of
+        // them anyway, such as a working image that is converted from BGRA8.
+        PlanarImage(uint32_t width, uint32_t height, PlanarFormat format);
+
+        uint32_t Width() const
+        {
+            return m_view.Width;
+        }
+
+        uint32_t Height() const
+        {
+            return m_view.Height;
+        }
+
+        PlanarFormat Format() const
+        {
+            return m_view.Format;
+        }
+
+        PlanarView View() const
+        {
+            return m_view;
+        }
+
+    private:
+        PlanarView m_view;
+        BufferPool::Buffer m_samples;
+    };
+
+    // Copies the samples of src into dst. Both views must have the same size and format.
+    void CopyPixels(PlanarView src, PlanarView dst);
+}
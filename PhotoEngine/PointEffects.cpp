@@ -0,0 +1,143 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "PointEffects.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    float SrgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSrgb(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    Color Exposure(Color color, float exposure)
+    {
+        const float gain = std::exp2(exposure);
+        return { color.B * gain, color.G * gain, color.R * gain, color.A };
+    }
+
+    Color Contrast(Color color, float contrast)
+    {
+        auto curve = [contrast](float value)
+        {
+            value = std::clamp(value, 0.0f, 1.0f);
+            const float smooth = value * value * (3.0f - 2.0f * value);
+            return value + contrast * (smooth - value);
+        };
+
+        return { curve(color.B), curve(color.G), curve(color.R), color.A };
+    }
+
+    Color TemperatureAndTint(Color color, float temperature, float tint)
+    {
+        return {
+            color.B * (1.0f - TemperatureTintStrength * temperature),
+            color.G * (1.0f + TemperatureTintStrength * tint),
+            color.R * (1.0f + TemperatureTintStrength * temperature),
+            color.A };
+    }
+
+    Color Saturation(Color color, float saturation)
+    {
+        const float luma = SaturationLumaR * color.R + SaturationLumaG * color.G + SaturationLumaB * color.B;
+        return {
+            luma + saturation * (color.B - luma),
+            luma + saturation * (color.G - luma),
+            luma + saturation * (color.R - luma),
+            color.A };
+    }
+
+    Color Sepia(Color color, float intensity)
+    {
+        const float r = 0.393f * color.R + 0.769f * color.G + 0.189f * color.B;
+        const float g = 0.349f * color.R + 0.686f * color.G + 0.168f * color.B;
+        const float b = 0.272f * color.R + 0.534f * color.G + 0.131f * color.B;
+        return {
+            color.B + intensity * (b - color.B),
+            color.G + intensity * (g - color.G),
+            color.R + intensity * (r - color.R),
+            color.A };
+    }
+
+    Color Grayscale(Color color)
+    {
+        const float luma = GrayscaleLumaR * color.R + GrayscaleLumaG * color.G + GrayscaleLumaB * color.B;
+        return { luma, luma, luma, color.A };
+    }
+
+    Color Invert(Color color)
+    {
+        return { 1.0f - color.B, 1.0f - color.G, 1.0f - color.R, color.A };
+    }
+
+    Color ApplyPointEffect(EffectKind kind, EffectParameters const& params, Color color)
+    {
+        switch (kind)
+        {
+        case EffectKind::Contrast:
+            return Contrast(color, params.Contrast);
+        case EffectKind::Exposure:
+            return Exposure(color, params.Exposure);
+        case EffectKind::TemperatureAndTint:
+            return TemperatureAndTint(color, params.Temperature, params.Tint);
+        case EffectKind::Saturation:
+            return Saturation(color, params.Saturation);
+        case EffectKind::Sepia:
+            return Sepia(color, params.Intensity);
+        case EffectKind::Grayscale:
+            return Grayscale(color);
+        case EffectKind::Invert:
+            return Invert(color);
+        case EffectKind::GaussianBlur:
+            break;
+        }
+        throw std::invalid_argument("ApplyPointEffect: not a point effect");
+    }
+
+    void ApplyPointEffect(EffectKind kind, EffectParameters const& params, ConstImageView src, ImageView dst)
+    {
+        if (src.Width != dst.Width || src.Height != dst.Height)
+        {
+            throw std::invalid_argument("ApplyPointEffect: source and destination sizes differ");
+        }
+
+        for (uint32_t y = 0; y < src.Height; y++)
+        {
+            const uint8_t* in = src.Row(y);
+            uint8_t* out = dst.Row(y);
+
+            for (uint32_t x = 0; x < src.Width; x++, in += BytesPerPixel, out += BytesPerPixel)
+            {
+                StorePixel(ApplyPointEffect(kind, params, LoadPixel(in)), out);
+            }
+        }
+    }
+}
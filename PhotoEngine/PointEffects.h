@@ -0,0 +1,110 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "EffectChain.h"
+#include "EffectParameters.h"
+#include "Image.h"
+#include <algorithm>
+
+namespace PhotoEngine
+{
+    // Normalized color in BGRA order. Channels are nominally in [0, 1] and alpha is
+    // straight (not premultiplied); effects leave alpha untouched.
+    struct Color
+    {
+        float B;
+        float G;
+        float R;
+        float A;
+    };
+
+    // Luminance weights used by the saturation effect.
+    constexpr float SaturationLumaR = 0.2125f;
+    constexpr float SaturationLumaG = 0.7154f;
+    constexpr float SaturationLumaB = 0.0721f;
+
+    // Luminance weights used by the grayscale effect.
+    constexpr float GrayscaleLumaR = 0.299f;
+    constexpr float GrayscaleLumaG = 0.587f;
+    constexpr float GrayscaleLumaB = 0.114f;
+
+    // Largest change in channel gain produced by a temperature or tint of +/-1.
+    constexpr float TemperatureTintStrength = 0.2f;
+
+    inline Color LoadPixel(const uint8_t* pixel)
+    {
+        constexpr float scale = 1.0f / 255.0f;
+        return { pixel[0] * scale, pixel[1] * scale, pixel[2] * scale, pixel[3] * scale };
+    }
+
+    inline uint8_t QuantizeChannel(float value)
+    {
+        return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    inline void StorePixel(Color color, uint8_t* pixel)
+    {
+        pixel[0] = QuantizeChannel(color.B);
+        pixel[1] = QuantizeChannel(color.G);
+        pixel[2] = QuantizeChannel(color.R);
+        pixel[3] = QuantizeChannel(color.A);
+    }
+
+    // The sRGB transfer curve: converts an encoded value in [0, 1] to linear light, and back.
+    float SrgbToLinear(float value);
+    float LinearToSrgb(float value);
+
+    // Reference definitions of the per-pixel effects. Vectorized paths are
+    // verified against these.
+
+    // Scales the color by 2^exposure.
+    Color Exposure(Color color, float exposure);
+
+    // Blends each channel toward (contrast > 0) or away from (contrast < 0) a
+    // smoothstep S-curve centered on mid-gray.
+    Color Contrast(Color color, float contrast);
+
+    // Warms (temperature > 0) or cools the image, and shifts it toward green
+    // (tint > 0) or magenta.
+    Color TemperatureAndTint(Color color, float temperature, float tint);
+
+    // Interpolates between the luminance (0) and the original color (1).
+    Color Saturation(Color color, float saturation);
+
+    // Interpolates between the original color (0) and a full sepia tone (1).
+    Color Sepia(Color color, float intensity);
+
+    Color Grayscale(Color color);
+
+    Color Invert(Color color);
+
+    // Applies one point effect to a color using the matching effect parameters.
+    Color ApplyPointEffect(EffectKind kind, EffectParameters const& params, Color color);
+
+    // Applies one point effect to every pixel of src and writes the result to dst.
+    // The views must have the same size and may refer to the same pixels.
+    void ApplyPointEffect(EffectKind kind, EffectParameters const& params, ConstImageView src, ImageView dst);
+}
@@ -0,0 +1,81 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ProgressiveRenderer.h"
+
+namespace PhotoEngine
+{
+    EffectParameters ScaleParametersForLevel(EffectParameters const& params, size_t level)
+    {
+        EffectParameters scaled = params;
+        scaled.BlurAmount = params.BlurAmount / static_cast<float>(size_t{ 1 } << level);
+        return scaled;
+    }
+
+    ProgressiveRenderer::ProgressiveRenderer(ThreadPool& pool, ConstImageView source, EffectChain const& chain, PipelineOptions const& options) :
+        m_pool(pool),
+        m_pyramid(source, pool),
+        m_chain(chain),
+        m_options(options),
+        m_levels(m_pyramid.LevelCount())
+    {
+    }
+
+    void ProgressiveRenderer::Chain(EffectChain const& chain)
+    {
+        m_chain = chain;
+        for (auto&& level : m_levels)
+        {
+            if (level.Renderer)
+            {
+                level.Renderer->Chain(chain);
+            }
+        }
+    }
+
+    ConstImageView ProgressiveRenderer::RenderPreview(EffectParameters const& params, float zoomFactor)
+    {
+        return RenderLevel(params, m_pyramid.LevelForZoom(zoomFactor));
+    }
+
+    ConstImageView ProgressiveRenderer::RenderFull(EffectParameters const& params)
+    {
+        return RenderLevel(params, 0);
+    }
+
+    ConstImageView ProgressiveRenderer::RenderLevel(EffectParameters const& params, size_t level)
+    {
+        auto& state = m_levels.at(level);
+        const ConstImageView source = m_pyramid.Level(level);
+        if (!state.Renderer)
+        {
+            state.Renderer = std::make_unique<IncrementalRenderer>(m_pool, source, m_chain, m_options);
+            state.Output = Image::Uninitialized(source.Width, source.Height);
+        }
+
+        state.Renderer->Render(ScaleParametersForLevel(params, level), state.Output.View());
+        m_lastLevel = level;
+        return state.Output.View();
+    }
+}
@@ -0,0 +1,90 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "EffectChain.h"
+#include "EffectParameters.h"
+#include "IncrementalRenderer.h"
+#include "MipPyramid.h"
+#include <memory>
+#include <vector>
+
+namespace PhotoEngine
+{
+    // Returns params for rendering at a pyramid level: the blur amount is in pixels of
+    // the level, so it shrinks by half per level and the proxy looks like a scaled-down
+    // full render.
+    EffectParameters ScaleParametersForLevel(EffectParameters const& params, size_t level);
+
+    // Renders an effect chain on a mip pyramid of the source. While a slider is dragged,
+    // RenderPreview renders the level that matches the zoom factor, so its cost follows
+    // the screen size rather than the file size. Once the input settles, RenderFull renders
+    // level 0. Each level keeps its own stage buffers, so either call only reruns the
+    // stages after the first changed parameter.
+    class ProgressiveRenderer
+    {
+    public:
+        // Builds the pyramid once. The source pixels must stay valid and unchanged.
+        ProgressiveRenderer(ThreadPool& pool, ConstImageView source, EffectChain const& chain, PipelineOptions const& options = {});
+
+        MipPyramid const& Pyramid() const
+        {
+            return m_pyramid;
+        }
+
+        // Sets the effect chain to render.
+        void Chain(EffectChain const& chain);
+
+        // Renders at the level for zoomFactor and returns the result, which stays valid
+        // until the next render at the same level.
+        ConstImageView RenderPreview(EffectParameters const& params, float zoomFactor);
+
+        // Renders at full resolution and returns the result.
+        ConstImageView RenderFull(EffectParameters const& params);
+
+        // Renders at the given pyramid level and returns the result.
+        ConstImageView RenderLevel(EffectParameters const& params, size_t level);
+
+        // Level of the last render.
+        size_t LastLevel() const
+        {
+            return m_lastLevel;
+        }
+
+    private:
+        struct LevelRenderer
+        {
+            std::unique_ptr<IncrementalRenderer> Renderer;
+            Image Output;
+        };
+
+        ThreadPool& m_pool;
+        MipPyramid m_pyramid;
+        EffectChain m_chain;
+        PipelineOptions m_options;
+        std::vector<LevelRenderer> m_levels;
+        size_t m_lastLevel{ 0 };
+    };
+}
@@ -0,0 +1,226 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "Renderer.h"
+#include "GaussianBlur.h"
+#include <stdexcept>
+#include <vector>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Number of rows handed to a thread at a time.
+        constexpr size_t RowsPerBand = 16;
+    }
+
+    void Renderer::Render(EffectChain const& chain, EffectParameters const& params, ConstImageView src, ImageView dst)
+    {
+        Render(m_pipelines.Get(chain, m_options), params, src, dst);
+    }
+
+    void Renderer::Render(Pipeline& pipeline, EffectParameters const& params, ConstImageView src, ImageView dst)
+    {
+        if (src.Width != dst.Width || src.Height != dst.Height)
+        {
+            throw std::invalid_argument("Render: source and destination sizes differ");
+        }
+
+        if (pipeline.Stages().empty())
+        {
+            CopyPixels(src, dst);
+            return;
+        }
+
+        if (pipeline.Options().Format != WorkingFormat::Bgra8)
+        {
+            RenderPlanar(pipeline, 0, pipeline.Stages().size(), params, src, dst);
+            return;
+        }
+
+        // Each stage reads the output of the previous one and writes dst in place.
+        ConstImageView input = src;
+        for (size_t i = 0; i < pipeline.Stages().size(); i++)
+        {
+            RenderStage(pipeline, i, params, input, dst);
+            input = dst;
+        }
+    }
+
+    void Renderer::RenderStage(Pipeline& pipeline, size_t stageIndex, EffectParameters const& params, ConstImageView src, ImageView dst)
+    {
+        if (src.Width != dst.Width || src.Height != dst.Height)
+        {
+            throw std::invalid_argument("RenderStage: source and destination sizes differ");
+        }
+
+        if (pipeline.Options().Format != WorkingFormat::Bgra8)
+        {
+            if (stageIndex >= pipeline.Stages().size())
+            {
+                throw std::out_of_range("RenderStage: stage index out of range");
+            }
+            RenderPlanar(pipeline, stageIndex, stageIndex + 1, params, src, dst);
+            return;
+        }
+
+        if (pipeline.Stages().at(stageIndex).Type == StageType::GaussianBlur)
+        {
+            // A blur needs a separate input, so in-place stages first copy dst to m_scratch.
+            if (src.Data == dst.Data)
+            {
+                if (m_scratch.Width() != dst.Width || m_scratch.Height() != dst.Height)
+                {
+                    m_scratch = Image::Uninitialized(dst.Width, dst.Height);
+                }
+                CopyPixels(src, m_scratch.View());
+                src = m_scratch.View();
+            }
+
+            GaussianBlur(src, dst, params.BlurAmount, m_pool, pipeline.Options().Blur);
+        }
+        else if (auto lut = pipeline.StageLut(stageIndex, params, static_cast<size_t>(dst.Width) * dst.Height))
+        {
+            m_pool.ParallelFor(0, dst.Height, RowsPerBand, [&](size_t begin, size_t end)
+            {
+                for (auto y = static_cast<uint32_t>(begin); y < end; y++)
+                {
+                    lut->Apply(m_kernels, src.Row(y), dst.Row(y), dst.Width);
+                }
+            });
+        }
+        else
+        {
+            auto const& program = pipeline.PointProgram(stageIndex, params);
+            m_pool.ParallelFor(0, dst.Height, RowsPerBand, [&](size_t begin, size_t end)
+            {
+                for (auto y = static_cast<uint32_t>(begin); y < end; y++)
+                {
+                    m_kernels.PointProgramBgra8(program.data(), program.size(), src.Row(y), dst.Row(y), dst.Width);
+                }
+            });
+        }
+    }
+
+    void Renderer::RenderPlanar(Pipeline& pipeline, size_t first, size_t last, EffectParameters const& params, ConstImageView src, ImageView dst)
+    {
+        const auto format = pipeline.Options().Format == WorkingFormat::Float16 ? PlanarFormat::Float16 : PlanarFormat::Float32;
+        if (m_planar.Width() != dst.Width || m_planar.Height() != dst.Height || m_planar.Format() != format)
+        {
+            m_planar = PlanarImage(dst.Width, dst.Height, format);
+        }
+        RenderPlanar(pipeline, first, last, params, m_planar.View(), src, dst);
+    }
+
+    void Renderer::RenderPlanar(Pipeline& pipeline, size_t first, size_t last, EffectParameters const& params, PlanarView planar,
+        ConstImageView src, ImageView dst)
+    {
+        auto const& options = pipeline.Options();
+        auto const& stages = pipeline.Stages();
+        if (options.Format == WorkingFormat::Bgra8 || last > stages.size() || first > last)
+        {
+            throw std::invalid_argument("RenderPlanar: the pipeline is not planar or the stages are out of range");
+        }
+        if ((src.Data && (src.Width != planar.Width || src.Height != planar.Height))
+            || (dst.Data && (dst.Width != planar.Width || dst.Height != planar.Height)))
+        {
+            throw std::invalid_argument("RenderPlanar: image sizes differ");
+        }
+
+        const uint32_t width = planar.Width;
+        const size_t pixelCount = static_cast<size_t>(width) * planar.Height;
+
+        // A run of point stages shares one pass over the rows with the conversion before it
+        // and the one after it, so each row is converted and processed while it is in cache.
+        // A blur takes passes of its own.
+        struct PointPass
+        {
+            ColorLut const* Lut;
+            PointOp const* Ops;
+            size_t OpCount;
+        };
+        std::vector<PointPass> passes;
+
+        bool load = src.Data != nullptr;
+        for (size_t begin = first;;)
+        {
+            // The programs and LUTs are built here, since building them is not thread safe.
+            size_t end = begin;
+            passes.clear();
+            for (; end < last && stages[end].Type == StageType::PointEffects; end++)
+            {
+                if (auto lut = pipeline.StageLut(end, params, pixelCount))
+                {
+                    passes.push_back({ lut, nullptr, 0 });
+                }
+                else
+                {
+                    auto const& program = pipeline.PointProgram(end, params);
+                    passes.push_back({ nullptr, program.data(), program.size() });
+                }
+            }
+            const bool done = end == last;
+            const bool store = done && dst.Data != nullptr;
+
+            if (load || store || !passes.empty())
+            {
+                m_pool.ParallelFor(0, planar.Height, RowsPerBand, [&](size_t bandBegin, size_t bandEnd)
+                {
+                    for (auto y = static_cast<uint32_t>(bandBegin); y < bandEnd; y++)
+                    {
+                        const PlanarRow row = planar.Row(y);
+                        if (load)
+                        {
+                            m_kernels.Bgra8ToPlanar(src.Row(y), row, width, options.LinearLight);
+                        }
+                        for (auto&& pass : passes)
+                        {
+                            if (pass.Lut)
+                            {
+                                m_kernels.ColorLutPlanar(pass.Lut->Table(), pass.Lut->Size(), row, width);
+                            }
+                            else
+                            {
+                                m_kernels.PointProgramPlanar(pass.Ops, pass.OpCount, row, width);
+                            }
+                        }
+                        if (store)
+                        {
+                            m_kernels.PlanarToBgra8(row, dst.Row(y), width, options.LinearLight);
+                        }
+                    }
+                });
+            }
+
+            load = false;
+            if (done)
+            {
+                break;
+            }
+
+            GaussianBlur(planar, planar, params.BlurAmount, m_pool, options.Blur);
+            begin = end + 1;
+        }
+    }
+}
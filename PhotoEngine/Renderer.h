@@ -0,0 +1,109 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "EffectChain.h"
+#include "EffectParameters.h"
+#include "Image.h"
+#include "Pipeline.h"
+#include "PipelineCache.h"
+#include "PixelKernels.h"
+#include "PlanarImage.h"
+#include "ThreadPool.h"
+
+namespace PhotoEngine
+{
+    // Renders an effect chain on the CPU. This is the headless counterpart of the
+    // composition brush DetailPage builds in UpdateMainImageBrush.
+    class Renderer
+    {
+    public:
+        // Point effects run with the given kernels; by default the widest instruction
+        // set the CPU supports.
+        explicit Renderer(ThreadPool& pool, PixelKernels const& kernels = GetPixelKernels()) :
+            m_pool(pool),
+            m_kernels(kernels)
+        {
+        }
+
+        // Gets or sets how Render compiles an effect chain. Fusion and matrix folding are
+        // on by default; turning fusion off runs one pass per effect and quantizes to BGRA8
+        // in between, which is useful for comparisons. Setting ColorLutSize bakes point
+        // stages into 3D LUTs that are reused while their parameters stay the same.
+        PipelineOptions const& Options() const
+        {
+            return m_options;
+        }
+
+        void Options(PipelineOptions const& value)
+        {
+            m_options = value;
+        }
+
+        // Pipelines compiled by Render, most recently used first.
+        PipelineCache const& Pipelines() const
+        {
+            return m_pipelines;
+        }
+
+        // Runs src through each effect of chain in order and writes the result to dst.
+        // src and dst must have the same size; they may be the same pixels. The chain is
+        // compiled on first use and looked up in Pipelines() afterwards.
+        void Render(EffectChain const& chain, EffectParameters const& params, ConstImageView src, ImageView dst);
+
+        // Runs src through the stages of a compiled pipeline. Point programs are rebuilt
+        // only for the effects whose parameters changed since the pipeline's last render.
+        void Render(Pipeline& pipeline, EffectParameters const& params, ConstImageView src, ImageView dst);
+
+        // Runs src through one stage of a compiled pipeline. src and dst must have the same
+        // size; they may be the same pixels. With a planar working format the stage runs
+        // between a conversion from src and one to dst.
+        void RenderStage(Pipeline& pipeline, size_t stageIndex, EffectParameters const& params, ConstImageView src, ImageView dst);
+
+        // Runs stages [first, last) of a pipeline whose working format is planar on image,
+        // in place. If src has pixels, image is converted from it first; otherwise image
+        // holds the input. If dst has pixels, the result is converted into it. Callers that
+        // keep intermediate results, like IncrementalRenderer, keep them at full precision
+        // this way.
+        void RenderPlanar(Pipeline& pipeline, size_t first, size_t last, EffectParameters const& params, PlanarView image,
+            ConstImageView src, ImageView dst);
+
+    private:
+        // Runs stages [first, last) of a pipeline whose working format is planar: converts
+        // src into m_planar, runs the stages there, and converts the result into dst.
+        void RenderPlanar(Pipeline& pipeline, size_t first, size_t last, EffectParameters const& params, ConstImageView src, ImageView dst);
+
+        ThreadPool& m_pool;
+        PixelKernels const& m_kernels;
+        PipelineOptions m_options;
+        PipelineCache m_pipelines;
+
+        // Holds the blur input when the chain contains a Gaussian blur.
+        Image m_scratch;
+
+        // Holds the image while the stages of a planar pipeline run.
+        PlanarImage m_planar;
+    };
+}
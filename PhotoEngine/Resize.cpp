@@ -0,0 +1,183 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "Resize.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Number of output rows handed to a thread at a time.
+        constexpr size_t RowsPerBand = 8;
+
+        // The source pixels one output pixel covers along one axis, and their weights.
+        struct Span
+        {
+            uint32_t First{ 0 };
+            uint32_t Count{ 0 };
+            size_t Weights{ 0 };
+        };
+
+        // Splits sourceLength pixels into outputLength equal spans. The weights of each
+        // span add up to one.
+        std::vector<Span> MakeSpans(uint32_t sourceLength, uint32_t outputLength, std::vector<float>& weights)
+        {
+            const double scale = static_cast<double>(sourceLength) / outputLength;
+            std::vector<Span> spans(outputLength);
+            for (uint32_t i = 0; i < outputLength; i++)
+            {
+                const double begin = i * scale;
+                const double end = std::min((i + 1) * scale, static_cast<double>(sourceLength));
+                auto& span = spans[i];
+                span.First = static_cast<uint32_t>(begin);
+                span.Count = static_cast<uint32_t>(std::ceil(end)) - span.First;
+                span.Weights = weights.size();
+
+                for (uint32_t j = 0; j < span.Count; j++)
+                {
+                    const double covered = std::min(end, span.First + j + 1.0) - std::max(begin, static_cast<double>(span.First + j));
+                    weights.push_back(static_cast<float>(covered / scale));
+                }
+            }
+            return spans;
+        }
+    }
+
+    ImageSize FitWithin(uint32_t width, uint32_t height, uint32_t maxWidth, uint32_t maxHeight)
+    {
+        if (width <= maxWidth && height <= maxHeight)
+        {
+            return { width, height };
+        }
+
+        const double scale = std::min(static_cast<double>(maxWidth) / width, static_cast<double>(maxHeight) / height);
+        return {
+            std::max(1u, std::min(maxWidth, static_cast<uint32_t>(std::lround(width * scale)))),
+            std::max(1u, std::min(maxHeight, static_cast<uint32_t>(std::lround(height * scale)))) };
+    }
+
+    void ResizeArea(ConstImageView src, ImageView dst, ThreadPool& pool, PixelKernels const& kernels)
+    {
+        if (dst.Width == 0 || dst.Height == 0 || dst.Width > src.Width || dst.Height > src.Height)
+        {
+            throw std::invalid_argument("ResizeArea: the destination must be smaller than the source");
+        }
+
+        std::vector<float> columnWeights;
+        std::vector<float> rowWeights;
+        const auto columns = MakeSpans(src.Width, dst.Width, columnWeights);
+        const auto rows = MakeSpans(src.Height, dst.Height, rowWeights);
+
+        pool.ParallelFor(0, dst.Height, RowsPerBand, [&](size_t begin, size_t end)
+        {
+            std::vector<float> sum(static_cast<size_t>(src.Width) * BytesPerPixel);
+            for (auto y = static_cast<uint32_t>(begin); y < end; y++)
+            {
+                // Vertical pass: the weighted sum of the source rows, which touches every
+                // source pixel and is where the time goes.
+                std::fill(sum.begin(), sum.end(), 0.0f);
+                auto const& row = rows[y];
+                for (uint32_t i = 0; i < row.Count; i++)
+                {
+                    kernels.AccumulateBgra8(src.Row(row.First + i), rowWeights[row.Weights + i], sum.data(), src.Width);
+                }
+
+                // Horizontal pass over the one summed row.
+                uint8_t* out = dst.Row(y);
+                for (uint32_t x = 0; x < dst.Width; x++)
+                {
+                    auto const& column = columns[x];
+                    const float* in = &sum[static_cast<size_t>(column.First) * BytesPerPixel];
+                    const float* weights = &columnWeights[column.Weights];
+                    float pixel[BytesPerPixel] = {};
+                    for (uint32_t i = 0; i < column.Count; i++, in += BytesPerPixel)
+                    {
+                        for (size_t c = 0; c < BytesPerPixel; c++)
+                        {
+                            pixel[c] += weights[i] * in[c];
+                        }
+                    }
+                    for (size_t c = 0; c < BytesPerPixel; c++)
+                    {
+                        out[x * BytesPerPixel + c] = static_cast<uint8_t>(std::min(pixel[c] + 0.5f, 255.0f));
+                    }
+                }
+            }
+        });
+    }
+
+    Image ApplyOrientation(ConstImageView src, uint16_t orientation)
+    {
+        const bool transposed = orientation >= 5 && orientation <= 8;
+        const uint32_t width = transposed ? src.Height : src.Width;
+        const uint32_t height = transposed ? src.Width : src.Height;
+        auto result = Image::Uninitialized(width, height);
+
+        // Maps each displayed pixel (x, y) back to the stored pixel it shows.
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t* row = result.View().Row(y);
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint32_t sourceX = x;
+                uint32_t sourceY = y;
+                switch (orientation)
+                {
+                case 2:
+                    sourceX = src.Width - 1 - x;
+                    break;
+                case 3:
+                    sourceX = src.Width - 1 - x;
+                    sourceY = src.Height - 1 - y;
+                    break;
+                case 4:
+                    sourceY = src.Height - 1 - y;
+                    break;
+                case 5:
+                    sourceX = y;
+                    sourceY = x;
+                    break;
+                case 6:
+                    sourceX = y;
+                    sourceY = src.Height - 1 - x;
+                    break;
+                case 7:
+                    sourceX = src.Width - 1 - y;
+                    sourceY = src.Height - 1 - x;
+                    break;
+                case 8:
+                    sourceX = src.Width - 1 - y;
+                    sourceY = x;
+                    break;
+                }
+                std::copy_n(src.Row(sourceY) + static_cast<size_t>(sourceX) * BytesPerPixel, BytesPerPixel, row + static_cast<size_t>(x) * BytesPerPixel);
+            }
+        }
+        return result;
+    }
+}
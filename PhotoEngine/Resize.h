@@ -0,0 +1,54 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Image.h"
+#include "PixelKernels.h"
+#include "ThreadPool.h"
+
+namespace PhotoEngine
+{
+    struct ImageSize
+    {
+        uint32_t Width{ 0 };
+        uint32_t Height{ 0 };
+    };
+
+    // Returns the largest size with the aspect ratio of width x height that fits in
+    // maxWidth x maxHeight, at least one pixel in each dimension and never larger
+    // than the image itself.
+    ImageSize FitWithin(uint32_t width, uint32_t height, uint32_t maxWidth, uint32_t maxHeight);
+
+    // Shrinks src into dst by area averaging: each output pixel is the mean of the
+    // source pixels it covers, with fractional weights for the pixels on its edges. dst
+    // must be no larger than src in either dimension. Throws std::invalid_argument if
+    // it is larger.
+    void ResizeArea(ConstImageView src, ImageView dst, ThreadPool& pool, PixelKernels const& kernels = GetPixelKernels());
+
+    // Returns src turned upright for display according to an EXIF orientation, 1 to 8
+    // (see ImageProbe::Orientation). Orientations 5 to 8 swap the width and height; other
+    // values return an unchanged copy.
+    Image ApplyOrientation(ConstImageView src, uint16_t orientation);
+}
@@ -0,0 +1,51 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "RowStream.h"
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    void ImageRowReader::ReadRows(ImageView rows)
+    {
+        if (rows.Height > m_image.Height - m_nextRow)
+        {
+            throw std::out_of_range("ImageRowReader: read past the last row");
+        }
+
+        CopyPixels(m_image.Rows(m_nextRow, rows.Height), rows);
+        m_nextRow += rows.Height;
+    }
+
+    void ImageRowWriter::WriteRows(ConstImageView rows)
+    {
+        if (rows.Height > m_image.Height - m_nextRow)
+        {
+            throw std::out_of_range("ImageRowWriter: write past the last row");
+        }
+
+        CopyPixels(rows, m_image.Rows(m_nextRow, rows.Height));
+        m_nextRow += rows.Height;
+    }
+}
@@ -0,0 +1,96 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Image.h"
+
+namespace PhotoEngine
+{
+    // Produces the rows of an image from top to bottom, e.g. from a decoder that never
+    // holds the whole image.
+    class RowReader
+    {
+    public:
+        virtual ~RowReader() = default;
+
+        virtual uint32_t Width() const = 0;
+        virtual uint32_t Height() const = 0;
+
+        // Reads the next rows.Height rows into rows, which must be Width() pixels wide.
+        virtual void ReadRows(ImageView rows) = 0;
+    };
+
+    // Consumes the rows of an image from top to bottom, e.g. an encoder.
+    class RowWriter
+    {
+    public:
+        virtual ~RowWriter() = default;
+
+        // Writes the next rows.Height rows.
+        virtual void WriteRows(ConstImageView rows) = 0;
+    };
+
+    // Reads the rows of an image in memory.
+    class ImageRowReader : public RowReader
+    {
+    public:
+        explicit ImageRowReader(ConstImageView image) :
+            m_image(image)
+        {
+        }
+
+        uint32_t Width() const override
+        {
+            return m_image.Width;
+        }
+
+        uint32_t Height() const override
+        {
+            return m_image.Height;
+        }
+
+        void ReadRows(ImageView rows) override;
+
+    private:
+        ConstImageView m_image;
+        uint32_t m_nextRow{ 0 };
+    };
+
+    // Writes rows into an image in memory.
+    class ImageRowWriter : public RowWriter
+    {
+    public:
+        explicit ImageRowWriter(ImageView image) :
+            m_image(image)
+        {
+        }
+
+        void WriteRows(ConstImageView rows) override;
+
+    private:
+        ImageView m_image;
+        uint32_t m_nextRow{ 0 };
+    };
+}
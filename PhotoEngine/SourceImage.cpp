@@ -0,0 +1,137 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "SourceImage.h"
+#include "ImageProbe.h"
+#include "MappedFile.h"
+#include "MetadataIndex.h"
+#include <stdexcept>
+
+#ifdef PHOTOENGINE_HAS_JPEG
+#include "JpegFile.h"
+#endif
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Identifies the version of a file, so an image decoded before the file was
+        // saved is not handed out for it.
+        std::string VersionKey(std::filesystem::path const& path)
+        {
+            std::error_code error;
+            const auto time = std::filesystem::last_write_time(path, error);
+            return path.u8string() + '|' + std::to_string(error ? 0 : FileTimeTicks(time));
+        }
+    }
+
+    std::shared_ptr<const Image> SourceImageCache::Load(std::filesystem::path const& path)
+    {
+        const auto key = VersionKey(path);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (auto found = m_images.find(key); found != m_images.end())
+        {
+            if (auto image = found->second.lock())
+            {
+                m_statistics.Shared++;
+                return image;
+            }
+            m_images.erase(found);
+        }
+
+        if (auto loading = m_loading.find(key); loading != m_loading.end())
+        {
+            auto result = loading->second;
+            m_statistics.Coalesced++;
+            lock.unlock();
+            return result.get();
+        }
+
+        std::promise<std::shared_ptr<const Image>> promise;
+        m_loading.emplace(key, promise.get_future().share());
+        m_statistics.Decodes++;
+        lock.unlock();
+
+        std::shared_ptr<const Image> image;
+        try
+        {
+            image = std::make_shared<const Image>(DecodeSourceImage(path));
+        }
+        catch (...)
+        {
+            lock.lock();
+            m_loading.erase(key);
+            lock.unlock();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        lock.lock();
+        m_loading.erase(key);
+
+        // Forget the images nobody holds any more before adding another.
+        for (auto it = m_images.begin(); it != m_images.end();)
+        {
+            it = it->second.expired() ? m_images.erase(it) : std::next(it);
+        }
+        m_images.emplace(key, image);
+        lock.unlock();
+        promise.set_value(image);
+        return image;
+    }
+
+    SourceImageStatistics SourceImageCache::Statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    SourceImageCache& GetSourceImageCache()
+    {
+        static SourceImageCache cache;
+        return cache;
+    }
+
+    Image DecodeSourceImage(std::filesystem::path const& path)
+    {
+        // Start reading the whole file now, so the disk works ahead of the decoder.
+        MappedFile file(path, MappedFileAccess::Sequential);
+        file.Prefetch();
+
+        const auto probe = ProbeImage(file.Data(), file.Size());
+        if (!probe)
+        {
+            throw std::runtime_error("DecodeSourceImage: " + path.string() + " is not an image file");
+        }
+
+#ifdef PHOTOENGINE_HAS_JPEG
+        if (probe->Format == ImageFormat::Jpeg)
+        {
+            return DecodeJpeg(file.Data(), file.Size());
+        }
+#endif
+        throw std::runtime_error("DecodeSourceImage: the format of " + path.string() + " is not supported");
+    }
+}
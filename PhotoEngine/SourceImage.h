@@ -0,0 +1,88 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Image.h"
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace PhotoEngine
+{
+    struct SourceImageStatistics
+    {
+        // Load calls that decoded the file.
+        size_t Decodes{ 0 };
+
+        // Load calls answered with an image another caller still held.
+        size_t Shared{ 0 };
+
+        // Load calls that waited for another caller's decode of the same file.
+        size_t Coalesced{ 0 };
+    };
+
+    // Full-size decoded photos, shared by everything that uses a photo at the same
+    // time: the detail view, the effect renderers, and the exporter, which reads it
+    // through an ImageRowReader. An image is shared for as long as anyone holds it and
+    // freed with the last reference; unlike thumbnails, nothing is kept beyond that,
+    // since a full-size photo is too large to cache on speculation.
+    //
+    // Concurrent Load calls for a file decode it once. All methods may be called from
+    // any thread.
+    class SourceImageCache
+    {
+    public:
+        // Returns the decoded image of the file at path, decoding it with
+        // DecodeSourceImage unless a caller still holds the image of this version of
+        // the file. Throws what DecodeSourceImage throws.
+        std::shared_ptr<const Image> Load(std::filesystem::path const& path);
+
+        SourceImageStatistics Statistics() const;
+
+    private:
+        mutable std::mutex m_mutex;
+        std::unordered_map<std::string, std::weak_ptr<const Image>> m_images;
+        std::unordered_map<std::string, std::shared_future<std::shared_ptr<const Image>>> m_loading;
+        SourceImageStatistics m_statistics;
+    };
+
+    // The process-wide source image cache.
+    SourceImageCache& GetSourceImageCache();
+
+    // Decodes a photo file at full size. The file is memory mapped, read ahead
+    // sequentially, and decoded from the mapping straight into the returned image, so
+    // its bytes are read from disk once and not copied on the way to the decoder.
+    // Throws std::runtime_error if the file cannot be read or its format is not
+    // supported; JPEG is decoded when the engine is built with libjpeg.
+    //
+    // Because of the mapping, a file truncated by another process during the decode
+    // raises SIGBUS (EXCEPTION_IN_PAGE_ERROR on Windows) instead of an error. It is
+    // meant for the photo the user opened; batch and export work reads files with
+    // JpegRowReader's path constructor, which uses stdio.
+    Image DecodeSourceImage(std::filesystem::path const& path);
+}
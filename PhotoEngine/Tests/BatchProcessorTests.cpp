@@ -0,0 +1,225 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include <filesystem>
+#include <fstream>
+
+#ifdef PHOTOENGINE_HAS_JPEG
+#include "BatchProcessor.h"
+#include "BufferPool.h"
+#include "JpegFile.h"
+#include "Renderer.h"
+#endif
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+#ifdef PHOTOENGINE_HAS_JPEG
+namespace
+{
+    const char* TestRecipe = R"(
+        # A warm, bright look.
+        effects = light, Color , sepia
+        Exposure = 0.5
+        contrast = 0.25   # ignores case
+        Temperature = 0.3
+        Intensity = 0.6
+        BlurAmount = 1.5
+    )";
+
+    std::filesystem::path MakeBatchFolder(const char* name)
+    {
+        const auto folder = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove_all(folder);
+        std::filesystem::create_directories(folder / "input" / "nested");
+        return folder;
+    }
+
+    Image ReadJpeg(std::filesystem::path const& path)
+    {
+        JpegRowReader reader(path.string());
+        Image image(reader.Width(), reader.Height());
+        reader.ReadRows(image.View());
+        return image;
+    }
+
+    void WriteJpeg(std::filesystem::path const& path, ConstImageView image)
+    {
+        JpegRowWriter writer(path.string(), image.Width, image.Height);
+        writer.WriteRows(image);
+    }
+
+    // Writes count noise photos of varying size into folder/input and its nested folder.
+    std::vector<BatchItem> MakeBatch(std::filesystem::path const& folder, uint32_t count)
+    {
+        std::vector<BatchItem> items;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const auto name = std::string(i % 2 ? "nested/" : "") + "photo" + std::to_string(i) + ".jpg";
+            WriteJpeg(folder / "input" / name, MakeNoiseImage(40 + i * 2, 30 + i, i).View());
+            items.push_back({ folder / "input" / name, folder / "output" / name });
+        }
+        return items;
+    }
+}
+
+TEST(BatchProcessorTests, RecipeParsesPhotoValues)
+{
+    const auto recipe = BatchRecipe::Parse(TestRecipe);
+    EXPECT_EQ(recipe.Effects.size(), 3u);
+    EXPECT_TRUE(recipe.Effects[1] == "color");
+    EXPECT_EQ(recipe.Parameters.Exposure, 0.5f);
+    EXPECT_EQ(recipe.Parameters.Contrast, 0.25f);
+    EXPECT_EQ(recipe.Parameters.Temperature, 0.3f);
+    EXPECT_EQ(recipe.Parameters.Intensity, 0.6f);
+    EXPECT_EQ(recipe.Parameters.BlurAmount, 1.5f);
+    EXPECT_EQ(recipe.Parameters.Saturation, 1.0f);
+    EXPECT_TRUE(recipe.Chain() == EffectChain::FromSelection({ "light", "color", "sepia" }));
+
+    EXPECT_THROW(BatchRecipe::Parse("Vignette = 1"), std::invalid_argument);
+    EXPECT_THROW(BatchRecipe::Parse("Exposure = bright"), std::invalid_argument);
+    EXPECT_THROW(BatchRecipe::Parse("effects = light, vignette"), std::invalid_argument);
+    EXPECT_THROW(BatchRecipe::Parse("Exposure"), std::invalid_argument);
+}
+
+TEST(BatchProcessorTests, ResultsMatchRenderingEachPhoto)
+{
+    const auto folder = MakeBatchFolder("PhotoEngineTests-batch");
+    auto items = MakeBatch(folder, 9);
+
+    // A file that is not a JPEG fails without stopping the others.
+    std::ofstream(folder / "input" / "broken.jpg") << "not a photo";
+    items.push_back({ folder / "input" / "broken.jpg", folder / "output" / "broken.jpg" });
+
+    const auto recipe = BatchRecipe::Parse(TestRecipe);
+    BatchOptions options;
+    options.ThreadCount = 3;
+    BatchProcessor processor(recipe, options);
+
+    size_t reports = 0;
+    size_t lastCompleted = 0;
+    processor.Run(items, [&](BatchItemResult const& result, size_t completed, size_t total)
+    {
+        reports++;
+        EXPECT_EQ(total, items.size());
+        EXPECT_EQ(completed, lastCompleted + 1);
+        EXPECT_EQ(result.Succeeded, result.Item->Source.filename() != "broken.jpg");
+        lastCompleted = completed;
+    });
+
+    EXPECT_EQ(reports, items.size());
+    EXPECT_EQ(processor.Statistics().Succeeded, 9u);
+    EXPECT_EQ(processor.Statistics().Failed, 1u);
+    EXPECT_TRUE(processor.Statistics().MedianLatency <= processor.Statistics().P99Latency);
+    EXPECT_TRUE(processor.Statistics().P99Latency <= processor.Statistics().MaxLatency);
+    EXPECT_GT(processor.Statistics().ImagesPerSecond(), 0.0);
+    EXPECT_TRUE(!std::filesystem::exists(folder / "output" / "broken.jpg"));
+    EXPECT_EQ(GetBufferPool().Statistics().BytesCached, 0u);
+
+    // The encoder is deterministic, so rendering and encoding a photo by hand gives the
+    // same file contents.
+    ThreadPool pool(1);
+    for (size_t i = 0; i < 9; i++)
+    {
+        auto expected = ReadJpeg(items[i].Source);
+        Renderer(pool).Render(recipe.Chain(), recipe.Parameters, expected.View(), expected.View());
+        WriteJpeg(folder / "expected.jpg", expected.View());
+
+        EXPECT_EQ(MaxDifference(ReadJpeg(folder / "expected.jpg").View(), ReadJpeg(items[i].Destination).View()), 0);
+    }
+
+    std::filesystem::remove_all(folder);
+}
+
+TEST(BatchProcessorTests, DamagedPhotosAndOverwritesFail)
+{
+    const auto folder = MakeBatchFolder("PhotoEngineTests-batch-damaged");
+    auto items = MakeBatch(folder, 2);
+
+    // A file cut off inside its scan data decodes, but with gray rows.
+    const auto damaged = folder / "input" / "damaged.jpg";
+    std::filesystem::copy_file(items[0].Source, damaged);
+    std::filesystem::resize_file(damaged, std::filesystem::file_size(damaged) * 2 / 3);
+    items.push_back({ damaged, folder / "output" / "damaged.jpg" });
+
+    // A result that would replace its own photo.
+    const auto original = ReadJpeg(items[1].Source);
+    items.push_back({ items[1].Source, items[1].Source });
+
+    std::vector<std::string> errors;
+    BatchProcessor processor(BatchRecipe::Parse(TestRecipe));
+    processor.Run(items, [&](BatchItemResult const& result, size_t, size_t)
+    {
+        if (!result.Succeeded)
+        {
+            errors.push_back(result.Error);
+        }
+    });
+
+    EXPECT_EQ(processor.Statistics().Succeeded, 2u);
+    EXPECT_EQ(errors.size(), 2u);
+    EXPECT_TRUE(!std::filesystem::exists(folder / "output" / "damaged.jpg"));
+    EXPECT_EQ(MaxDifference(original.View(), ReadJpeg(items[1].Source).View()), 0);
+
+    // No temporary files are left beside the results.
+    for (auto&& entry : std::filesystem::recursive_directory_iterator(folder / "output"))
+    {
+        EXPECT_TRUE(entry.path().extension() != ".partial");
+    }
+
+    std::filesystem::remove_all(folder);
+}
+
+TEST(BatchProcessorTests, MemoryBudgetBoundsPhotosInFlight)
+{
+    const auto folder = MakeBatchFolder("PhotoEngineTests-batch-memory");
+    const auto items = MakeBatch(folder, 8);
+    const auto recipe = BatchRecipe::Parse(TestRecipe);
+
+    // The budget fits the largest photo but no two of them, even the two smallest, so
+    // they run one at a time on four threads.
+    BatchOptions options;
+    options.ThreadCount = 4;
+    BatchProcessor processor(recipe, options);
+    const size_t largest = processor.EstimateBytes(40 + 7 * 2, 30 + 7);
+    EXPECT_LT(largest, processor.EstimateBytes(40, 30) + processor.EstimateBytes(42, 31));
+    options.MaxInFlightBytes = largest;
+
+    BatchProcessor bounded(recipe, options);
+    bounded.Run(items);
+    EXPECT_EQ(bounded.Statistics().Succeeded, 8u);
+    EXPECT_EQ(bounded.Statistics().PeakInFlightBytes, largest);
+
+    // A photo larger than the whole budget still runs, on its own.
+    options.MaxInFlightBytes = 1;
+    BatchProcessor tiny(recipe, options);
+    tiny.Run(items);
+    EXPECT_EQ(tiny.Statistics().Succeeded, 8u);
+    EXPECT_EQ(tiny.Statistics().PeakInFlightBytes, largest);
+
+    std::filesystem::remove_all(folder);
+}
+#endif
@@ -0,0 +1,129 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "BufferPool.h"
+#include "IncrementalRenderer.h"
+#include "Test.h"
+#include "TestImages.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+TEST(BufferPoolTests, BuffersAreAlignedAndRoundedToClasses)
+{
+    EXPECT_EQ(BufferPool::ClassBytes(1), 4096u);
+    EXPECT_EQ(BufferPool::ClassBytes(4097), 5120u);
+    EXPECT_EQ(BufferPool::ClassBytes(8192), 8192u);
+    EXPECT_EQ(BufferPool::ClassBytes(8193), 10240u);
+
+    bool bounded = true;
+    for (size_t bytes = 4096; bytes < (size_t{ 1 } << 34); bytes = bytes * 9 / 8 + 7)
+    {
+        const size_t classBytes = BufferPool::ClassBytes(bytes);
+        bounded = bounded && classBytes >= bytes && classBytes <= bytes + bytes / 4;
+    }
+    EXPECT_TRUE(bounded);
+
+    BufferPoolOptions options;
+    options.HugePages = true;
+    BufferPool pool(options);
+    for (size_t bytes : { size_t{ 100 }, size_t{ 70000 }, size_t{ 3 } << 20, size_t{ 5 } << 20 })
+    {
+        auto buffer = pool.Acquire(bytes);
+        EXPECT_EQ(buffer.Size(), bytes);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.Data()) % BufferPool::Alignment, 0u);
+        std::memset(buffer.Data(), 0xAB, bytes);
+    }
+    EXPECT_TRUE(pool.Acquire(0).Data() == nullptr);
+}
+
+TEST(BufferPoolTests, ReleasedBuffersAreReused)
+{
+    BufferPool pool;
+    {
+        auto a = pool.Acquire(10 << 20);
+        auto b = pool.Acquire(1 << 20);
+        EXPECT_EQ(pool.Statistics().BytesInUse, 11u << 20);
+    }
+    auto statistics = pool.Statistics();
+    EXPECT_EQ(statistics.BytesInUse, 0u);
+    EXPECT_EQ(statistics.PeakBytesInUse, 11u << 20);
+    EXPECT_EQ(statistics.BytesCached, (11u << 20));
+
+    // A buffer of another size in the same class is served from the cache.
+    for (int i = 0; i < 10; i++)
+    {
+        auto a = pool.Acquire((10 << 20) - 4096);
+    }
+    statistics = pool.Statistics();
+    EXPECT_EQ(statistics.Allocations, 2u);
+    EXPECT_EQ(statistics.Reuses, 10u);
+    EXPECT_NEAR(statistics.ReuseRate(), 10.0 / 12.0, 1e-9);
+
+    pool.Trim();
+    EXPECT_EQ(pool.Statistics().BytesCached, 0u);
+
+    // Releases beyond the cache limit free the buffer.
+    BufferPoolOptions options;
+    options.MaxCachedBytes = 1 << 20;
+    BufferPool small(options);
+    small.Acquire(2 << 20);
+    EXPECT_EQ(small.Statistics().BytesCached, 0u);
+}
+
+TEST(BufferPoolTests, SteadyStateRenderingAllocatesNoBuffers)
+{
+    // One thread, so the warm-up frames are sure to have used every buffer a frame
+    // needs; with more, a thread that first joins a pass later still allocates once.
+    ThreadPool threads(1);
+    auto source = MakeNoiseImage(640, 480);
+    IncrementalRenderer renderer(threads, source.View(), EffectChain::FromSelection({ "light", "blur", "sepia" }));
+    Image output(640, 480);
+
+    // Every frame moves the blur slider, so the blur and the stages after it render again.
+    EffectParameters params;
+    auto frame = [&](int i)
+    {
+        params.BlurAmount = 2.0f + (i % 5);
+        renderer.Render(params, output.View());
+    };
+    for (int i = 0; i < 5; i++)
+    {
+        frame(i);
+    }
+
+    const auto before = GetBufferPool().Statistics();
+    for (int i = 5; i < 30; i++)
+    {
+        frame(i);
+    }
+    const auto after = GetBufferPool().Statistics();
+    EXPECT_EQ(after.Allocations, before.Allocations);
+    EXPECT_GT(after.Reuses, before.Reuses);
+
+    // The process-wide pool is in use, so its options can no longer change.
+    EXPECT_THROW(ConfigureBufferPool({}), std::logic_error);
+}
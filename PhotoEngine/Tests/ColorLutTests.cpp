@@ -0,0 +1,139 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ColorLut.h"
+#include "PointEffects.h"
+#include "Renderer.h"
+#include "Test.h"
+#include "TestImages.h"
+#include <vector>
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+namespace
+{
+    EffectParameters EditedParameters()
+    {
+        EffectParameters params;
+        params.Exposure = 0.4f;
+        params.Temperature = 0.5f;
+        params.Tint = -0.2f;
+        params.Contrast = 0.8f;
+        params.Saturation = 1.6f;
+        params.Intensity = 0.3f;
+        return params;
+    }
+
+    std::vector<PointOp> ProgramOf(std::vector<EffectKind> const& kinds, EffectParameters const& params)
+    {
+        std::vector<PointOp> ops;
+        for (auto kind : kinds)
+        {
+            ops.push_back(MakePointOp(kind, params));
+        }
+        return ops;
+    }
+}
+
+TEST(ColorLutTests, KernelsMatchScalarLookup)
+{
+    const auto ops = ProgramOf({ EffectKind::Contrast, EffectKind::Saturation, EffectKind::Sepia }, EditedParameters());
+    const ColorLut lut(ColorLut::SmallSize, ops.data(), ops.size());
+
+    // 67 pixels leaves a partial block for every vector width.
+    auto source = MakeNoiseImage(67, 1, 3);
+    Image expected(67, 1);
+    GetPixelKernels(SimdLevel::Scalar).ColorLutBgra8(lut.Table(), lut.Size(), source.Data(), expected.Data(), 67);
+
+    for (auto level : { SimdLevel::Sse41, SimdLevel::Avx2, SimdLevel::Avx512, SimdLevel::Neon })
+    {
+        if (!IsSimdLevelSupported(level))
+        {
+            continue;
+        }
+
+        auto image = source;
+        lut.Apply(GetPixelKernels(level), image.Data(), image.Data(), 67);
+        EXPECT_LE(MaxDifference(expected.View(), image.View()), 1);
+    }
+}
+
+TEST(ColorLutTests, LookupMatchesDirectEvaluation)
+{
+    const auto params = EditedParameters();
+
+    // A linear program is reproduced exactly by the interpolation; a curve is not.
+    const auto linear = ProgramOf({ EffectKind::Exposure, EffectKind::TemperatureAndTint, EffectKind::Invert }, params);
+    EXPECT_LE(ColorLut(ColorLut::SmallSize, linear.data(), linear.size()).MaxError(), 1);
+
+    const auto curved = ProgramOf({ EffectKind::Exposure, EffectKind::Contrast, EffectKind::Saturation, EffectKind::Sepia }, params);
+    const ColorLut small(ColorLut::SmallSize, curved.data(), curved.size());
+    const ColorLut large(ColorLut::LargeSize, curved.data(), curved.size());
+    EXPECT_LE(small.MaxError(), 2);
+    EXPECT_LE(large.MaxError(), small.MaxError());
+
+    auto withAlpha = ColorMatrix::Identity();
+    withAlpha.M[0][3] = 0.5f;
+    const auto alphaOp = PointOp::FromMatrix(withAlpha);
+    EXPECT_FALSE(ColorLut::CanBake(&alphaOp, 1));
+    EXPECT_THROW(ColorLut(ColorLut::SmallSize, &alphaOp, 1), std::invalid_argument);
+}
+
+TEST(ColorLutTests, PipelineBakesOnceThePixelsPayForIt)
+{
+    ThreadPool pool(2);
+    auto params = EditedParameters();
+    auto chain = EffectChain::FromSelection({ "light", "color", "sepia" });
+
+    // 33^3 nodes cost about as much to bake as 35 renders of a 32x32 thumbnail.
+    auto source = MakeNoiseImage(32, 32);
+    Image direct(32, 32);
+    Image baked(32, 32);
+    Renderer(pool).Render(chain, params, source.View(), direct.View());
+
+    PipelineOptions options;
+    options.ColorLutSize = ColorLut::SmallSize;
+    Pipeline pipeline(chain, options);
+    Renderer renderer(pool);
+    for (int i = 0; i < 35; i++)
+    {
+        renderer.Render(pipeline, params, source.View(), baked.View());
+    }
+    EXPECT_EQ(pipeline.BakedLutCount(), size_t{ 0 });
+    EXPECT_EQ(pipeline.ColorLutMaxError(0), -1);
+
+    renderer.Render(pipeline, params, source.View(), baked.View());
+    EXPECT_EQ(pipeline.BakedLutCount(), size_t{ 1 });
+    EXPECT_LE(MaxDifference(direct.View(), baked.View()), pipeline.ColorLutMaxError(0) + 1);
+    EXPECT_GE(pipeline.ColorLutMaxError(0), 0);
+
+    // Copies share the LUT until the parameters change; a blur amount is not part of it.
+    auto copy = pipeline;
+    params.BlurAmount = 7.0f;
+    EXPECT_TRUE(copy.StageLut(0, params, 1) == pipeline.StageLut(0, params, 1));
+    params.Saturation = 0.5f;
+    EXPECT_TRUE(copy.StageLut(0, params, 1) == nullptr);
+    EXPECT_EQ(copy.ColorLutMaxError(0), -1);
+}
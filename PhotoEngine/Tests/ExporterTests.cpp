@@ -0,0 +1,153 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "Exporter.h"
+#include "Renderer.h"
+#include "Test.h"
+#include "TestImages.h"
+#include <filesystem>
+
+#ifdef PHOTOENGINE_HAS_JPEG
+#include "JpegFile.h"
+#endif
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+namespace
+{
+    EffectParameters ExportParameters(float blurAmount)
+    {
+        EffectParameters params;
+        params.Exposure = 0.3f;
+        params.Contrast = 0.2f;
+        params.BlurAmount = blurAmount;
+        params.Intensity = 0.7f;
+        return params;
+    }
+}
+
+TEST(ExporterTests, TiledExportMatchesFullFrameRender)
+{
+    ThreadPool pool(4);
+    auto chain = EffectChain::FromSelection({ "light", "blur", "sepia" });
+    auto source = MakeNoiseImage(61, 203);
+
+    for (float blurAmount : { 0.0f, 1.5f, 6.0f })
+    {
+        const auto params = ExportParameters(blurAmount);
+        Image expected(61, 203);
+        Renderer(pool).Render(chain, params, source.View(), expected.View());
+
+        Exporter exporter(pool);
+        exporter.TileHeight(16);
+        Image exported(61, 203);
+        ImageRowReader reader(source.View());
+        ImageRowWriter writer(exported.View());
+        exporter.Export(chain, params, reader, writer);
+
+        // The direct kernel sees identical neighbors; the recursive filter's response past
+        // the halo is cut off.
+        EXPECT_LE(MaxDifference(expected.View(), exported.View()), blurAmount > 2.0f ? 1 : 0);
+        EXPECT_GE(exporter.Statistics().Tiles, 203u / exporter.Statistics().TileHeight);
+    }
+}
+
+TEST(ExporterTests, PeakMemoryDoesNotGrowWithImageHeight)
+{
+    ThreadPool pool(2);
+    auto chain = EffectChain::FromSelection({ "blur", "invert" });
+    const auto params = ExportParameters(2.0f);
+
+    size_t peak[2];
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        auto source = MakeNoiseImage(32, 1000 * (i + 1));
+        Image exported(source.Width(), source.Height());
+        ImageRowReader reader(source.View());
+        ImageRowWriter writer(exported.View());
+
+        Exporter exporter(pool);
+        exporter.TileHeight(32);
+        exporter.MaxTilesInFlight(3);
+        exporter.Export(chain, params, reader, writer);
+        peak[i] = exporter.Statistics().PeakBufferBytes;
+    }
+
+    EXPECT_EQ(peak[0], peak[1]);
+    EXPECT_LT(peak[0], size_t{ 32 } * 1000 * BytesPerPixel);
+}
+
+#ifdef PHOTOENGINE_HAS_JPEG
+TEST(ExporterTests, StreamsJpegToJpeg)
+{
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto inputPath = (directory / "PhotoEngineTests-input.jpg").string();
+    const auto outputPath = (directory / "PhotoEngineTests-output.jpg").string();
+
+    // A smooth gradient survives JPEG compression almost unchanged.
+    Image gradient(120, 90);
+    for (uint32_t y = 0; y < 90; y++)
+    {
+        for (uint32_t x = 0; x < 120; x++)
+        {
+            uint8_t* pixel = gradient.View().Row(y) + x * BytesPerPixel;
+            pixel[0] = static_cast<uint8_t>(x * 2);
+            pixel[1] = static_cast<uint8_t>(y * 2);
+            pixel[2] = 128;
+            pixel[3] = 255;
+        }
+    }
+
+    {
+        JpegRowWriter writer(inputPath, 120, 90, 95);
+        writer.WriteRows(gradient.View().Rows(0, 50));
+        writer.WriteRows(gradient.View().Rows(50, 40));
+    }
+
+    ThreadPool pool(2);
+    {
+        JpegRowReader reader(inputPath);
+        EXPECT_EQ(reader.Width(), 120u);
+        EXPECT_EQ(reader.Height(), 90u);
+
+        JpegRowWriter writer(outputPath, reader.Width(), reader.Height());
+        Exporter exporter(pool);
+        exporter.TileHeight(8);
+        exporter.Export(EffectChain::FromSelection({ "blur" }), ExportParameters(1.0f), reader, writer);
+    }
+
+    JpegRowReader reader(outputPath);
+    Image decoded(120, 90);
+    reader.ReadRows(decoded.View());
+
+    Image expected(120, 90);
+    Renderer(pool).Render(EffectChain::FromSelection({ "blur" }), ExportParameters(1.0f), gradient.View(), expected.View());
+    EXPECT_LE(MaxDifference(expected.View(), decoded.View()), 8);
+
+    EXPECT_THROW(JpegRowReader((directory / "PhotoEngineTests-missing.jpg").string()), std::runtime_error);
+    std::filesystem::remove(inputPath);
+    std::filesystem::remove(outputPath);
+}
+#endif
@@ -0,0 +1,105 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "GaussianBlur.h"
+#include "Test.h"
+#include "TestImages.h"
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+TEST(GaussianBlurTests, AutomaticSwitchesToRecursiveForLargeSigma)
+{
+    EXPECT_TRUE(SelectBlurMethod(1.0f) == BlurMethod::Direct);
+    EXPECT_TRUE(SelectBlurMethod(5.0f) == BlurMethod::Recursive);
+    EXPECT_TRUE(SelectBlurMethod(500.0f) == BlurMethod::Recursive);
+}
+
+TEST(GaussianBlurTests, ConstantTimeMethodsMatchDirectKernel)
+{
+    ThreadPool pool(3);
+    auto source = MakeNoiseImage(150, 97);
+
+    for (float sigma : { 2.5f, 12.0f, 40.0f })
+    {
+        Image direct(150, 97);
+        Image recursive(150, 97);
+        Image box(150, 97);
+        GaussianBlur(source.View(), direct.View(), sigma, pool, BlurMethod::Direct);
+        GaussianBlur(source.View(), recursive.View(), sigma, pool, BlurMethod::Recursive);
+        GaussianBlur(source.View(), box.View(), sigma, pool, BlurMethod::Box);
+
+        EXPECT_LE(MaxDifference(direct.View(), recursive.View()), 2);
+        EXPECT_LE(MaxDifference(direct.View(), box.View()), 4);
+    }
+}
+
+TEST(GaussianBlurTests, HardBorderKeepsEdgesOpaque)
+{
+    // With EffectBorderMode::Hard the image is not blended with transparent pixels
+    // outside its bounds, so an opaque image stays opaque up to its edges.
+    ThreadPool pool(2);
+    auto source = MakeNoiseImage(70, 50);
+    for (uint32_t y = 0; y < 50; y++)
+    {
+        for (uint32_t x = 0; x < 70; x++)
+        {
+            source.View().Row(y)[x * BytesPerPixel + 3] = 255;
+        }
+    }
+
+    for (auto method : { BlurMethod::Direct, BlurMethod::Recursive, BlurMethod::Box })
+    {
+        Image result(70, 50);
+        GaussianBlur(source.View(), result.View(), 30.0f, pool, method);
+
+        int minAlpha = 255;
+        for (uint32_t y = 0; y < 50; y++)
+        {
+            for (uint32_t x = 0; x < 70; x++)
+            {
+                minAlpha = std::min<int>(minAlpha, result.View().Row(y)[x * BytesPerPixel + 3]);
+            }
+        }
+        EXPECT_EQ(minAlpha, 255);
+    }
+}
+
+TEST(GaussianBlurTests, HandlesImagesSmallerThanKernel)
+{
+    ThreadPool pool(2);
+    for (auto method : { BlurMethod::Recursive, BlurMethod::Box })
+    {
+        for (uint32_t size : { 1u, 2u, 5u })
+        {
+            auto source = MakeNoiseImage(size, size + 1);
+            Image direct(size, size + 1);
+            Image result(size, size + 1);
+            GaussianBlur(source.View(), direct.View(), 8.0f, pool, BlurMethod::Direct);
+            GaussianBlur(source.View(), result.View(), 8.0f, pool, method);
+
+            EXPECT_LE(MaxDifference(direct.View(), result.View()), 4);
+        }
+    }
+}
@@ -0,0 +1,245 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ImageProbe.h"
+#include "Test.h"
+#include <fstream>
+#include <vector>
+
+#ifdef PHOTOENGINE_HAS_JPEG
+#include "JpegFile.h"
+#include "TestImages.h"
+#endif
+
+using namespace PhotoEngine;
+
+namespace
+{
+    using Bytes = std::vector<uint8_t>;
+
+    void Append(Bytes& bytes, std::string const& text)
+    {
+        bytes.insert(bytes.end(), text.begin(), text.end());
+    }
+
+    void AppendBigEndian16(Bytes& bytes, uint32_t value)
+    {
+        bytes.push_back(static_cast<uint8_t>(value >> 8));
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+
+    void AppendBigEndian32(Bytes& bytes, uint32_t value)
+    {
+        AppendBigEndian16(bytes, value >> 16);
+        AppendBigEndian16(bytes, value);
+    }
+
+    void AppendJpegSegment(Bytes& bytes, uint8_t marker, Bytes const& segment)
+    {
+        bytes.push_back(0xFF);
+        bytes.push_back(marker);
+        AppendBigEndian16(bytes, static_cast<uint32_t>(segment.size() + 2));
+        bytes.insert(bytes.end(), segment.begin(), segment.end());
+    }
+
+    // A JPEG header with a big-endian EXIF block holding an orientation, an
+    // ImageDescription, and an XPTitle, then paddingBytes of APP2, then a 4000 x 3000
+    // frame header.
+    Bytes MakeJpegHeader(size_t paddingBytes)
+    {
+        Bytes tiff;
+        Append(tiff, "MM");
+        AppendBigEndian16(tiff, 42);
+        AppendBigEndian32(tiff, 8);
+
+        // Three entries, then the values that do not fit in them.
+        const uint32_t values = 8 + 2 + 3 * 12 + 4;
+        const std::string description = "Harbor at dusk";
+        const Bytes xpTitle = { 'C', 0, 'a', 0, 'f', 0, 0xE9, 0, 0, 0 };
+        AppendBigEndian16(tiff, 3);
+        AppendBigEndian16(tiff, 0x010E);
+        AppendBigEndian16(tiff, 2);
+        AppendBigEndian32(tiff, static_cast<uint32_t>(description.size() + 1));
+        AppendBigEndian32(tiff, values);
+        AppendBigEndian16(tiff, 0x0112);
+        AppendBigEndian16(tiff, 3);
+        AppendBigEndian32(tiff, 1);
+        AppendBigEndian16(tiff, 6);
+        AppendBigEndian16(tiff, 0);
+        AppendBigEndian16(tiff, 0x9C9B);
+        AppendBigEndian16(tiff, 1);
+        AppendBigEndian32(tiff, static_cast<uint32_t>(xpTitle.size()));
+        AppendBigEndian32(tiff, values + static_cast<uint32_t>(description.size() + 1));
+        AppendBigEndian32(tiff, 0);
+        Append(tiff, description);
+        tiff.push_back(0);
+        tiff.insert(tiff.end(), xpTitle.begin(), xpTitle.end());
+
+        Bytes exif;
+        Append(exif, std::string("Exif\0\0", 6));
+        exif.insert(exif.end(), tiff.begin(), tiff.end());
+
+        Bytes frame;
+        frame.push_back(8);
+        AppendBigEndian16(frame, 3000);
+        AppendBigEndian16(frame, 4000);
+        frame.push_back(3);
+
+        Bytes jpeg = { 0xFF, 0xD8 };
+        AppendJpegSegment(jpeg, 0xE1, exif);
+        for (size_t padded = 0; padded < paddingBytes; padded += 60000)
+        {
+            AppendJpegSegment(jpeg, 0xE2, Bytes(std::min<size_t>(paddingBytes - padded, 60000)));
+        }
+        AppendJpegSegment(jpeg, 0xC2, frame);
+        AppendJpegSegment(jpeg, 0xDA, Bytes(10));
+        return jpeg;
+    }
+
+    void AppendPngChunk(Bytes& bytes, std::string const& type, Bytes const& data)
+    {
+        AppendBigEndian32(bytes, static_cast<uint32_t>(data.size()));
+        Append(bytes, type);
+        bytes.insert(bytes.end(), data.begin(), data.end());
+
+        // The prober does not check CRCs.
+        AppendBigEndian32(bytes, 0);
+    }
+
+    Bytes MakePngHeader(std::string const& textType, Bytes const& text)
+    {
+        Bytes ihdr;
+        AppendBigEndian32(ihdr, 640);
+        AppendBigEndian32(ihdr, 480);
+        ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 });
+
+        Bytes png;
+        Append(png, "\x89PNG\r\n\x1A\n");
+        AppendPngChunk(png, "IHDR", ihdr);
+        AppendPngChunk(png, "gAMA", Bytes(4));
+        AppendPngChunk(png, textType, text);
+        AppendPngChunk(png, "IDAT", Bytes(20));
+        return png;
+    }
+
+    void WriteFile(std::filesystem::path const& path, Bytes const& bytes)
+    {
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+}
+
+TEST(ImageProbeTests, JpegFrameAndExifAreRead)
+{
+    const auto jpeg = MakeJpegHeader(0);
+    auto probe = ProbeImage(jpeg.data(), jpeg.size());
+    EXPECT_TRUE(probe.has_value());
+    EXPECT_TRUE(probe->Format == ImageFormat::Jpeg);
+    EXPECT_EQ(probe->Width, 4000u);
+    EXPECT_EQ(probe->Height, 3000u);
+    EXPECT_EQ(probe->Orientation, 6);
+    EXPECT_EQ(probe->DisplayWidth(), 3000u);
+    EXPECT_EQ(probe->DisplayHeight(), 4000u);
+
+    // XPTitle wins over ImageDescription and is converted to UTF-8.
+    EXPECT_TRUE(probe->Title == "Caf\xC3\xA9");
+
+    // A prefix that ends before the frame header has no dimensions.
+    EXPECT_FALSE(ProbeImage(jpeg.data(), jpeg.size() - 20).has_value());
+    EXPECT_FALSE(ProbeImage(jpeg.data(), 3).has_value());
+
+    // The headers of this file continue past the first read.
+    const auto path = std::filesystem::temp_directory_path() / "PhotoEngineProbeTest.jpg";
+    WriteFile(path, MakeJpegHeader(100000));
+    probe = ProbeImageFile(path);
+    EXPECT_TRUE(probe.has_value());
+    EXPECT_EQ(probe->Width, 4000u);
+    EXPECT_EQ(probe->Orientation, 6);
+    std::filesystem::remove(path);
+
+#ifdef PHOTOENGINE_HAS_JPEG
+    {
+        auto image = Testing::MakeNoiseImage(40, 30);
+        JpegRowWriter writer(path.string(), 40, 30);
+        writer.WriteRows(image.View());
+    }
+    probe = ProbeImageFile(path);
+    EXPECT_TRUE(probe.has_value());
+    EXPECT_EQ(probe->Width, 40u);
+    EXPECT_EQ(probe->Height, 30u);
+    EXPECT_EQ(probe->Orientation, 1);
+    EXPECT_TRUE(probe->Title.empty());
+    std::filesystem::remove(path);
+#endif
+}
+
+TEST(ImageProbeTests, PngAndGifHeadersAreRead)
+{
+    Bytes text;
+    Append(text, std::string("Title\0Caf\xE9", 10));
+    auto png = MakePngHeader("tEXt", text);
+    auto probe = ProbeImage(png.data(), png.size());
+    EXPECT_TRUE(probe.has_value());
+    EXPECT_TRUE(probe->Format == ImageFormat::Png);
+    EXPECT_EQ(probe->Width, 640u);
+    EXPECT_EQ(probe->Height, 480u);
+    EXPECT_TRUE(probe->Title == "Caf\xC3\xA9");
+
+    Bytes internationalText;
+    Append(internationalText, std::string("Title\0\0\0fr\0Titre\0Caf\xC3\xA9", 22));
+    png = MakePngHeader("iTXt", internationalText);
+    probe = ProbeImage(png.data(), png.size());
+    EXPECT_TRUE(probe.has_value());
+    EXPECT_TRUE(probe->Title == "Caf\xC3\xA9");
+
+    // A prefix that ends in the text chunk still has the dimensions.
+    probe = ProbeImage(png.data(), 40);
+    EXPECT_TRUE(probe.has_value());
+    EXPECT_EQ(probe->Width, 640u);
+    EXPECT_TRUE(probe->Title.empty());
+
+    Bytes gif;
+    Append(gif, "GIF89a");
+    gif.insert(gif.end(), { 0x20, 0x01, 0x10, 0x00, 0xF7, 0, 0 });
+    probe = ProbeImage(gif.data(), gif.size());
+    EXPECT_TRUE(probe.has_value());
+    EXPECT_TRUE(probe->Format == ImageFormat::Gif);
+    EXPECT_EQ(probe->Width, 288u);
+    EXPECT_EQ(probe->Height, 16u);
+}
+
+TEST(ImageProbeTests, OtherFilesAreRejected)
+{
+    Bytes bmp;
+    Append(bmp, "BM this is not a supported image");
+    EXPECT_FALSE(ProbeImage(bmp.data(), bmp.size()).has_value());
+
+    Bytes corrupt = { 0xFF, 0xD8, 0x12, 0x34, 0x56 };
+    EXPECT_FALSE(ProbeImage(corrupt.data(), corrupt.size()).has_value());
+
+    const auto path = std::filesystem::temp_directory_path() / "PhotoEngineProbeEmpty.png";
+    WriteFile(path, {});
+    EXPECT_FALSE(ProbeImageFile(path).has_value());
+    std::filesystem::remove(path);
+    EXPECT_FALSE(ProbeImageFile(path).has_value());
+}
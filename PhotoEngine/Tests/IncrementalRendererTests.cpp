@@ -0,0 +1,125 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "IncrementalRenderer.h"
+#include "Test.h"
+#include "TestImages.h"
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+TEST(IncrementalRendererTests, LateSliderDoesNotRerunBlur)
+{
+    ThreadPool pool(2);
+    auto source = MakeNoiseImage(80, 60);
+    auto chain = EffectChain::FromSelection({ "light", "blur", "sepia" });
+    IncrementalRenderer incremental(pool, source.View(), chain);
+    EXPECT_EQ(incremental.StageCount(), 3u);
+
+    EffectParameters params;
+    params.Contrast = 0.3f;
+    params.BlurAmount = 4.0f;
+    Image result(80, 60);
+    incremental.Render(params, result.View());
+    EXPECT_EQ(incremental.FirstRenderedStage(), 0u);
+
+    params.Intensity = 0.9f;
+    incremental.Render(params, result.View());
+    EXPECT_EQ(incremental.FirstRenderedStage(), 2u);
+
+    params.BlurAmount = 2.0f;
+    incremental.Render(params, result.View());
+    EXPECT_EQ(incremental.FirstRenderedStage(), 1u);
+
+    // Parameters of effects that are not in the chain change nothing.
+    params.Saturation = 0.2f;
+    incremental.Render(params, result.View());
+    EXPECT_EQ(incremental.FirstRenderedStage(), 2u);
+    EXPECT_EQ(incremental.CachedBytes(), 2u * 80 * 60 * BytesPerPixel);
+
+    Image expected(80, 60);
+    Renderer(pool).Render(chain, params, source.View(), expected.View());
+    EXPECT_EQ(MaxDifference(expected.View(), result.View()), 0);
+}
+
+TEST(IncrementalRendererTests, NewSourceOrChainRendersEveryStage)
+{
+    ThreadPool pool(1);
+    auto first = MakeNoiseImage(20, 10, 1);
+    auto second = MakeNoiseImage(20, 10, 2);
+    IncrementalRenderer incremental(pool, first.View(), EffectChain::FromSelection({ "blur", "invert" }));
+
+    EffectParameters params;
+    params.BlurAmount = 1.0f;
+    Image result(20, 10);
+    incremental.Render(params, result.View());
+    incremental.Source(second.View());
+    incremental.Render(params, result.View());
+    EXPECT_EQ(incremental.FirstRenderedStage(), 0u);
+
+    Image expected(20, 10);
+    Renderer(pool).Render(EffectChain::FromSelection({ "blur", "invert" }), params, second.View(), expected.View());
+    EXPECT_EQ(MaxDifference(expected.View(), result.View()), 0);
+
+    incremental.Chain(EffectChain::FromSelection({ "grayscale" }));
+    incremental.Render(params, result.View());
+    EXPECT_EQ(incremental.FirstRenderedStage(), 0u);
+    EXPECT_EQ(incremental.StageCount(), 1u);
+}
+
+TEST(IncrementalRendererTests, PlanarStagesAreRoundedOnce)
+{
+    ThreadPool pool(2);
+    auto source = MakeNoiseImage(64, 48);
+    auto chain = EffectChain::FromSelection({ "light", "color", "blur", "sepia" });
+
+    for (auto format : { WorkingFormat::Float32, WorkingFormat::Float16 })
+    {
+        PipelineOptions options;
+        options.Format = format;
+        options.LinearLight = true;
+        IncrementalRenderer incremental(pool, source.View(), chain, options);
+        Renderer renderer(pool);
+        renderer.Options(options);
+
+        EffectParameters params;
+        params.Exposure = 0.4f;
+        params.Temperature = 0.3f;
+        params.BlurAmount = 3.0f;
+        params.Intensity = 0.7f;
+        Image result(64, 48);
+        Image expected(64, 48);
+        incremental.Render(params, result.View());
+        renderer.Render(chain, params, source.View(), expected.View());
+        EXPECT_EQ(MaxDifference(expected.View(), result.View()), 0);
+
+        // Starting from a cached planar stage output gives the same result too.
+        params.Intensity = 0.2f;
+        incremental.Render(params, result.View());
+        renderer.Render(chain, params, source.View(), expected.View());
+        EXPECT_EQ(incremental.FirstRenderedStage(), incremental.StageCount() - 1);
+        EXPECT_EQ(MaxDifference(expected.View(), result.View()), 0);
+        EXPECT_EQ(incremental.CachedBytes(), (incremental.StageCount() - 1) * 64 * 48 * 4 * SampleBytes(format == WorkingFormat::Float16 ? PlanarFormat::Float16 : PlanarFormat::Float32));
+    }
+}
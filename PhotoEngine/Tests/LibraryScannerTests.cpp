@@ -0,0 +1,183 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "LibraryScanner.h"
+#include "Test.h"
+#include <fstream>
+#include <set>
+
+using namespace PhotoEngine;
+
+namespace
+{
+    // A folder tree under the temp folder that is removed at the end of a test.
+    struct TemporaryLibrary
+    {
+        std::filesystem::path Root;
+
+        explicit TemporaryLibrary(std::string const& name) :
+            Root(std::filesystem::temp_directory_path() / name)
+        {
+            std::filesystem::remove_all(Root);
+            std::filesystem::create_directories(Root);
+        }
+
+        ~TemporaryLibrary()
+        {
+            std::error_code error;
+            std::filesystem::remove_all(Root, error);
+        }
+
+        std::filesystem::path Add(std::filesystem::path const& relative, size_t size = 16)
+        {
+            const auto path = Root / relative;
+            std::filesystem::create_directories(path.parent_path());
+            std::ofstream(path, std::ios::binary) << std::string(size, 'x');
+            return path;
+        }
+    };
+}
+
+TEST(LibraryScannerTests, ReportsEveryImageOnceInGrowingBatches)
+{
+    TemporaryLibrary library("PhotoEngineScanTest");
+    std::set<std::filesystem::path> expected;
+    for (int folder = 0; folder < 5; folder++)
+    {
+        for (int file = 0; file < 60; file++)
+        {
+            const auto name = std::to_string(folder) + "/nested/" + std::to_string(file);
+            expected.insert(library.Add(name + (file % 2 ? ".jpg" : ".PNG"), file));
+            library.Add(name + ".txt");
+        }
+    }
+
+    LibraryScanOptions options;
+    options.WorkerCount = 3;
+    options.MaxQueuedFiles = 16;
+    options.FirstBatchSize = 8;
+    options.MaxBatchSize = 64;
+    LibraryScanner scanner(options);
+
+    std::set<std::filesystem::path> found;
+    std::vector<size_t> batchSizes;
+    scanner.Scan(library.Root, [&](std::vector<ScannedFile>&& batch)
+    {
+        batchSizes.push_back(batch.size());
+        for (auto&& file : batch)
+        {
+            EXPECT_TRUE(found.insert(file.Path).second);
+            EXPECT_EQ(file.Size, std::filesystem::file_size(file.Path));
+        }
+    });
+
+    EXPECT_TRUE(found == expected);
+    EXPECT_LE(batchSizes.front(), size_t{ 8 });
+    for (auto size : batchSizes)
+    {
+        EXPECT_LE(size, size_t{ 16 });
+    }
+    EXPECT_EQ(scanner.Statistics().FilesFound, size_t{ 300 });
+    EXPECT_EQ(scanner.Statistics().FilesReported, size_t{ 300 });
+    EXPECT_EQ(scanner.Statistics().Directories, size_t{ 11 });
+}
+
+TEST(LibraryScannerTests, ExtractorFiltersAndFailuresAreCounted)
+{
+    TemporaryLibrary library("PhotoEngineScanFilterTest");
+    for (int file = 0; file < 40; file++)
+    {
+        library.Add(std::to_string(file) + ".gif", file);
+    }
+
+    LibraryScanner scanner;
+    size_t reported = 0;
+    scanner.Scan(library.Root, [&](std::vector<ScannedFile>&& batch) { reported += batch.size(); }, [](ScannedFile& file)
+    {
+        if (file.Size % 10 == 0)
+        {
+            throw std::runtime_error("unreadable");
+        }
+        return file.Size % 2 == 0;
+    });
+
+    EXPECT_EQ(reported, size_t{ 16 });
+    EXPECT_EQ(scanner.Statistics().FilesFailed, size_t{ 4 });
+
+    // A root that cannot be read is an error, not an empty library.
+    EXPECT_THROW(scanner.Scan(library.Root / "missing", [&](std::vector<ScannedFile>&&) { reported++; }),
+        std::filesystem::filesystem_error);
+    EXPECT_EQ(reported, size_t{ 16 });
+}
+
+TEST(LibraryScannerTests, FolderRemovedDuringTheScanIsSkipped)
+{
+    TemporaryLibrary library("PhotoEngineScanRemovedTest");
+    for (int file = 0; file < 4; file++)
+    {
+        library.Add("a/" + std::to_string(file) + ".jpg");
+        library.Add("b/" + std::to_string(file) + ".jpg");
+    }
+
+    // With one worker and a queue of one path, the walker is still in the first folder
+    // it lists while the first file is extracted, so the other folder is removed before
+    // the walker opens it.
+    LibraryScanOptions options;
+    options.WorkerCount = 1;
+    options.MaxQueuedFiles = 1;
+    LibraryScanner scanner(options);
+
+    std::filesystem::path removed;
+    size_t reported = 0;
+    scanner.Scan(library.Root, [&](std::vector<ScannedFile>&& batch) { reported += batch.size(); }, [&](ScannedFile& file)
+    {
+        if (removed.empty())
+        {
+            removed = library.Root / (file.Path.parent_path().filename() == "a" ? "b" : "a");
+            std::filesystem::remove_all(removed);
+        }
+        return true;
+    });
+
+    EXPECT_EQ(reported, size_t{ 4 });
+    EXPECT_EQ(scanner.Statistics().FilesFailed, size_t{ 1 });
+    EXPECT_EQ(scanner.Statistics().Directories, size_t{ 3 });
+}
+
+TEST(LibraryScannerTests, HandlerExceptionStopsTheScan)
+{
+    TemporaryLibrary library("PhotoEngineScanStopTest");
+    for (int file = 0; file < 200; file++)
+    {
+        library.Add(std::to_string(file) + ".jpg");
+    }
+
+    LibraryScanOptions options;
+    options.FirstBatchSize = 1;
+    options.MaxQueuedFiles = 4;
+    LibraryScanner scanner(options);
+    EXPECT_THROW(scanner.Scan(library.Root, [](std::vector<ScannedFile>&&) { throw std::runtime_error("stop"); }),
+        std::runtime_error);
+    EXPECT_EQ(scanner.Statistics().Batches, size_t{ 1 });
+}
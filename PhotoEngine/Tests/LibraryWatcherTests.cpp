@@ -0,0 +1,296 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "LibraryWatcher.h"
+#include "Test.h"
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <set>
+
+using namespace PhotoEngine;
+
+namespace
+{
+    // Renders changes as "+a.jpg -b.jpg ~c.jpg d.jpg<e.jpg" for comparison.
+    std::string Describe(std::vector<LibraryChange> const& changes, std::filesystem::path const& root = {})
+    {
+        auto relative = [&](std::filesystem::path const& path) { return (root.empty() ? path : path.lexically_relative(root)).generic_string(); };
+
+        std::string text;
+        for (auto&& change : changes)
+        {
+            if (!text.empty())
+            {
+                text += ' ';
+            }
+            switch (change.Type)
+            {
+            case LibraryChangeType::Added: text += "+" + relative(change.Path); break;
+            case LibraryChangeType::Removed: text += "-" + relative(change.Path); break;
+            case LibraryChangeType::Modified: text += "~" + relative(change.Path); break;
+            case LibraryChangeType::Renamed: text += relative(change.Path) + "<" + relative(change.OldPath); break;
+            case LibraryChangeType::Rescan: text += "*"; break;
+            }
+        }
+        return text;
+    }
+
+    // Coalesces the batches of a LibraryWatcher, so a test sees the net changes whether
+    // they arrive in one batch or several.
+    struct ChangeLog
+    {
+        std::mutex Mutex;
+        std::condition_variable Changed;
+        LibraryChangeSet Changes;
+        size_t Batches{ 0 };
+
+        void Add(std::vector<LibraryChange>&& batch)
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            for (auto&& change : batch)
+            {
+                Changes.Add(std::move(change));
+            }
+            Batches++;
+            Changed.notify_all();
+        }
+
+        // Waits until the net changes since the last call satisfy complete and no batch
+        // has arrived for quiet, so late changes of the same step are coalesced too, then
+        // returns them. Gives up after 30 seconds.
+        template <typename Complete>
+        std::vector<LibraryChange> Next(Complete&& complete, std::chrono::milliseconds quiet)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+            std::unique_lock<std::mutex> lock(Mutex);
+            auto net = Peek();
+            while (std::chrono::steady_clock::now() < deadline)
+            {
+                if (!complete(net))
+                {
+                    Changed.wait_until(lock, deadline);
+                }
+                else
+                {
+                    const size_t batches = Batches;
+                    if (!Changed.wait_for(lock, quiet, [&] { return Batches != batches; }))
+                    {
+                        break;
+                    }
+                }
+                net = Peek();
+            }
+            Changes.Take();
+            return net;
+        }
+
+    private:
+        std::vector<LibraryChange> Peek()
+        {
+            auto net = Changes.Take();
+            for (auto&& change : net)
+            {
+                Changes.Add(change);
+            }
+            return net;
+        }
+    };
+
+    void WriteFile(std::filesystem::path const& path)
+    {
+        std::ofstream(path, std::ios::binary) << "pixels";
+    }
+}
+
+TEST(LibraryWatcherTests, CoalescesChangesToTheirNetEffect)
+{
+    LibraryChangeSet changes;
+    changes.Add({ LibraryChangeType::Added, "a.jpg", {} });
+    changes.Add({ LibraryChangeType::Modified, "a.jpg", {} });
+    changes.Add({ LibraryChangeType::Added, "b.jpg", {} });
+    changes.Add({ LibraryChangeType::Removed, "b.jpg", {} });
+    changes.Add({ LibraryChangeType::Removed, "c.jpg", {} });
+    changes.Add({ LibraryChangeType::Added, "c.jpg", {} });
+    changes.Add({ LibraryChangeType::Added, "d.tmp", {} });
+    changes.Add({ LibraryChangeType::Renamed, "d.jpg", "d.tmp" });
+    changes.Add({ LibraryChangeType::Renamed, "f.jpg", "e.jpg" });
+    changes.Add({ LibraryChangeType::Renamed, "g.jpg", "f.jpg" });
+    changes.Add({ LibraryChangeType::Renamed, "i.jpg", "h.jpg" });
+    changes.Add({ LibraryChangeType::Removed, "i.jpg", {} });
+    EXPECT_EQ(Describe(changes.Take()), "+a.jpg ~c.jpg +d.jpg g.jpg<e.jpg -h.jpg");
+    EXPECT_TRUE(changes.Empty());
+
+    // A removed folder absorbs the changes under it.
+    changes.Add({ LibraryChangeType::Added, "x/a.jpg", {} });
+    changes.Add({ LibraryChangeType::Modified, "x/b.jpg", {} });
+    changes.Add({ LibraryChangeType::Renamed, "x/c.jpg", "y/c.jpg" });
+    changes.Add({ LibraryChangeType::Added, "xy.jpg", {} });
+    changes.Add({ LibraryChangeType::Removed, "x", {} });
+    EXPECT_EQ(Describe(changes.Take()), "-x +xy.jpg -y/c.jpg");
+
+    // A rescan replaces everything else.
+    changes.Add({ LibraryChangeType::Added, "a.jpg", {} });
+    changes.Add({ LibraryChangeType::Rescan, {}, {} });
+    changes.Add({ LibraryChangeType::Removed, "b.jpg", {} });
+    EXPECT_EQ(Describe(changes.Take()), "*");
+    EXPECT_TRUE(changes.Empty());
+}
+
+TEST(LibraryWatcherTests, AppliesChangesToTheIndex)
+{
+    const auto indexPath = std::filesystem::temp_directory_path() / "PhotoEngineWatcherIndex.bin";
+    std::vector<PhotoMetadata> entries;
+    for (auto name : { "keep.jpg", "gone.jpg", "old.jpg", "edited.jpg", "folder/a.jpg", "folder/b.jpg", "folder2/c.jpg" })
+    {
+        entries.push_back({ name, 1, 1, 10, 10, "", name, "JPG File" });
+    }
+    MetadataIndex::Write(indexPath, entries);
+
+    std::vector<LibraryChange> changes{
+        { LibraryChangeType::Removed, "gone.jpg", {} },
+        { LibraryChangeType::Renamed, "new.jpg", "old.jpg" },
+        { LibraryChangeType::Modified, "edited.jpg", {} },
+        { LibraryChangeType::Added, "added.jpg", {} },
+        { LibraryChangeType::Added, "unreadable.jpg", {} },
+        { LibraryChangeType::Removed, "folder", {} },
+    };
+
+    std::set<std::string> read;
+    std::map<std::string, uint32_t> widths;
+    {
+        auto index = MetadataIndex::Load(indexPath);
+        for (auto&& entry : ApplyLibraryChanges(index, changes, [&](PhotoMetadata& metadata)
+        {
+            read.insert(metadata.Path);
+            metadata.Width = 20;
+            return metadata.Path != "unreadable.jpg";
+        }))
+        {
+            widths[entry.Path] = entry.Width;
+        }
+    }
+    std::filesystem::remove(indexPath);
+
+    EXPECT_EQ(read.size(), 4u);
+    EXPECT_EQ(widths.size(), 5u);
+    EXPECT_EQ(widths["keep.jpg"], 10u);
+    EXPECT_EQ(widths["folder2/c.jpg"], 10u);
+    EXPECT_EQ(widths["new.jpg"], 20u);
+    EXPECT_EQ(widths["edited.jpg"], 20u);
+    EXPECT_EQ(widths["added.jpg"], 20u);
+}
+
+TEST(LibraryWatcherTests, AppliesThousandsOfRemovals)
+{
+    // 20,000 photos in 100 folders; half of the photos of the first 40 folders are
+    // deleted one by one, and the last 10 folders are deleted whole.
+    const auto indexPath = std::filesystem::temp_directory_path() / "PhotoEngineWatcherRemovals.bin";
+    std::vector<PhotoMetadata> entries;
+    for (int folder = 0; folder < 100; folder++)
+    {
+        for (int photo = 0; photo < 200; photo++)
+        {
+            auto name = "library/" + std::to_string(folder) + "/" + std::to_string(photo) + ".jpg";
+            entries.push_back({ name, 1, 1, 10, 10, "", name, "JPG File" });
+        }
+    }
+    MetadataIndex::Write(indexPath, entries);
+
+    std::vector<LibraryChange> changes;
+    for (int folder = 0; folder < 40; folder++)
+    {
+        for (int photo = 0; photo < 200; photo += 2)
+        {
+            changes.push_back({ LibraryChangeType::Removed, std::filesystem::u8path("library/" + std::to_string(folder) + "/" + std::to_string(photo) + ".jpg"), {} });
+        }
+    }
+    for (int folder = 90; folder < 100; folder++)
+    {
+        changes.push_back({ LibraryChangeType::Removed, std::filesystem::u8path("library/" + std::to_string(folder)), {} });
+    }
+
+    size_t remaining = 0;
+    {
+        auto index = MetadataIndex::Load(indexPath);
+        EXPECT_TRUE(index.Contains("library/0/0.jpg"));
+        EXPECT_TRUE(!index.Contains("library/0"));
+        remaining = ApplyLibraryChanges(index, changes, [](PhotoMetadata&) { return true; }).size();
+    }
+    std::filesystem::remove(indexPath);
+
+    EXPECT_EQ(changes.size(), 4010u);
+    EXPECT_EQ(remaining, 20000u - 4000u - 2000u);
+}
+
+#if defined(__linux__) || defined(_WIN32)
+TEST(LibraryWatcherTests, ReportsFileSystemChangesInBatches)
+{
+    const auto root = std::filesystem::temp_directory_path() / "PhotoEngineWatchTest";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    ChangeLog log;
+    LibraryWatchOptions options;
+    options.Debounce = std::chrono::milliseconds(100);
+
+    // How long the log waits after the last batch, so a step is complete before the next.
+    const auto quiet = std::chrono::milliseconds(1000);
+    {
+        LibraryWatcher watcher(root, [&](auto&& batch) { log.Add(std::move(batch)); }, options);
+
+        // An import of many files, with a temporary file renamed into place, adds the
+        // images only.
+        for (int i = 0; i < 200; i++)
+        {
+            WriteFile(root / (std::to_string(1000 + i) + ".jpg"));
+            WriteFile(root / (std::to_string(1000 + i) + ".txt"));
+        }
+        WriteFile(root / "import.part");
+        std::filesystem::rename(root / "import.part", root / "imported.PNG");
+        auto imported = log.Next([](auto&& net) { return net.size() >= 201; }, quiet);
+        EXPECT_EQ(imported.size(), 201u);
+        EXPECT_TRUE(std::all_of(imported.begin(), imported.end(), [](auto&& change) { return change.Type == LibraryChangeType::Added; }));
+
+        // Renames, removals, and a new folder with files in it.
+        std::filesystem::rename(root / "1000.jpg", root / "renamed.jpg");
+        std::filesystem::remove(root / "1001.jpg");
+        std::filesystem::remove(root / "1002.txt");
+        std::filesystem::create_directories(root / "trip" / "day1");
+        WriteFile(root / "trip" / "day1" / "a.gif");
+        const std::string expected = "-1001.jpg renamed.jpg<1000.jpg +trip/day1/a.gif";
+        EXPECT_EQ(Describe(log.Next([&](auto&& net) { return Describe(net, root) == expected; }, quiet), root), expected);
+
+        // Removing the folder reports the folder itself.
+        std::filesystem::remove_all(root / "trip");
+        auto removed = Describe(log.Next([&](auto&& net) { return Describe(net, root).find("-trip") != std::string::npos; }, quiet), root);
+        EXPECT_TRUE(removed.find("-trip") != std::string::npos);
+        EXPECT_TRUE(removed.find('+') == std::string::npos);
+
+        EXPECT_GE(watcher.Statistics().Batches, 3u);
+    }
+    std::filesystem::remove_all(root);
+}
+#endif
@@ -0,0 +1,126 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "MetadataIndex.h"
+#include "Test.h"
+#include <fstream>
+
+using namespace PhotoEngine;
+
+namespace
+{
+    PhotoMetadata MakeMetadata(size_t i)
+    {
+        PhotoMetadata metadata;
+        metadata.Path = "/photos/" + std::to_string(i % 7) + "/IMG_" + std::to_string(i) + ".jpg";
+        metadata.Size = 1000 + i;
+        metadata.LastWriteTime = 5000 + static_cast<int64_t>(i);
+        metadata.Width = 4000 + static_cast<uint32_t>(i);
+        metadata.Height = 3000;
+        metadata.Title = i % 3 == 0 ? "" : "Title " + std::to_string(i);
+        metadata.DisplayName = "IMG_" + std::to_string(i);
+        metadata.DisplayType = "JPG File";
+        return metadata;
+    }
+}
+
+TEST(MetadataIndexTests, WrittenEntriesAreFoundByPathSizeAndTime)
+{
+    const auto path = std::filesystem::temp_directory_path() / "PhotoEngineMetadataIndexTest.idx";
+    std::vector<PhotoMetadata> entries;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        entries.push_back(MakeMetadata(i));
+    }
+    MetadataIndex::Write(path, entries);
+
+    {
+        const auto index = MetadataIndex::Load(path);
+        EXPECT_EQ(index.Size(), size_t{ 1000 });
+
+        for (size_t i = 0; i < 1000; i += 37)
+        {
+            auto const& expected = entries[i];
+            auto found = index.Find(expected.Path, expected.Size, expected.LastWriteTime);
+            EXPECT_TRUE(found.has_value());
+            EXPECT_TRUE(found->Path == expected.Path);
+            EXPECT_EQ(found->Width, expected.Width);
+            EXPECT_TRUE(found->Title == expected.Title);
+            EXPECT_TRUE(found->DisplayName == expected.DisplayName);
+            EXPECT_TRUE(found->DisplayType == expected.DisplayType);
+
+            // A changed file is a miss.
+            EXPECT_FALSE(index.Find(expected.Path, expected.Size + 1, expected.LastWriteTime).has_value());
+            EXPECT_FALSE(index.Find(expected.Path, expected.Size, expected.LastWriteTime - 1).has_value());
+        }
+        EXPECT_FALSE(index.Find("/photos/missing.jpg", 0, 0).has_value());
+    }
+
+    // Truncated and foreign files load as empty indexes.
+    std::filesystem::resize_file(path, 100);
+    EXPECT_EQ(MetadataIndex::Load(path).Size(), size_t{ 0 });
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << std::string(64, 'x');
+    EXPECT_EQ(MetadataIndex::Load(path).Size(), size_t{ 0 });
+    std::filesystem::remove(path);
+    EXPECT_EQ(MetadataIndex::Load(path).Size(), size_t{ 0 });
+}
+
+TEST(MetadataIndexTests, StaleEntriesAreFound)
+{
+    const auto folder = std::filesystem::temp_directory_path() / "PhotoEngineMetadataStaleTest";
+    std::filesystem::remove_all(folder);
+    std::filesystem::create_directories(folder);
+
+    std::vector<PhotoMetadata> entries;
+    for (int i = 0; i < 6; i++)
+    {
+        const auto file = folder / (std::to_string(i) + ".png");
+        std::ofstream(file, std::ios::binary) << std::string(10 + i, 'x');
+
+        PhotoMetadata metadata;
+        metadata.Path = file.u8string();
+        metadata.Size = std::filesystem::file_size(file);
+        metadata.LastWriteTime = FileTimeTicks(std::filesystem::last_write_time(file));
+        entries.push_back(metadata);
+    }
+
+    const auto indexPath = folder / "index";
+    MetadataIndex::Write(indexPath, entries);
+
+    std::ofstream(folder / "2.png", std::ios::binary | std::ios::app) << "more";
+    std::filesystem::remove(folder / "4.png");
+
+    ThreadPool pool(3);
+    const auto index = MetadataIndex::Load(indexPath);
+    const auto stale = index.FindStaleEntries(pool);
+    EXPECT_EQ(stale.size(), size_t{ 2 });
+    for (auto i : stale)
+    {
+        const auto name = std::filesystem::u8path(index.Entry(i).Path).filename();
+        EXPECT_TRUE(name == "2.png" || name == "4.png");
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all(folder, error);
+}
@@ -0,0 +1,151 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "PhotoStore.h"
+#include "Test.h"
+
+using namespace PhotoEngine;
+
+namespace
+{
+    PhotoMetadata MakePhoto(size_t i)
+    {
+        PhotoMetadata photo;
+        photo.Path = "C:\\Pictures\\" + std::to_string(i / 500) + "\\IMG_" + std::to_string(i) + (i % 3 ? ".jpg" : ".png");
+        photo.Size = 1000 + i;
+        photo.LastWriteTime = static_cast<int64_t>(i) * 7;
+        photo.Width = static_cast<uint32_t>(i % 4000);
+        photo.Height = static_cast<uint32_t>(i % 3000);
+        photo.Title = i % 10 == 0 ? "Title " + std::to_string(i) : "";
+        photo.DisplayName = i % 7 == 0 ? "Renamed " + std::to_string(i) : "IMG_" + std::to_string(i);
+        photo.DisplayType = i % 3 ? "JPG File" : "PNG File";
+        return photo;
+    }
+}
+
+TEST(PhotoStoreTests, EntriesReadBackAcrossChunks)
+{
+    PhotoStore store;
+    const size_t count = PhotoStore::ChunkSize * 2 + 100;
+    for (size_t i = 0; i < count; i++)
+    {
+        store.Append(MakePhoto(i));
+    }
+    EXPECT_EQ(store.Size(), count);
+
+    for (size_t i : { size_t{ 0 }, size_t{ 1 }, size_t{ 7 }, size_t{ 10 }, PhotoStore::ChunkSize - 1, PhotoStore::ChunkSize, count - 1 })
+    {
+        const auto expected = MakePhoto(i);
+        const auto entry = store.Entry(i);
+        EXPECT_EQ(entry.Path(), expected.Path);
+        EXPECT_EQ(entry.Size, expected.Size);
+        EXPECT_EQ(entry.LastWriteTime, expected.LastWriteTime);
+        EXPECT_EQ(entry.Width, expected.Width);
+        EXPECT_EQ(entry.Height, expected.Height);
+        EXPECT_EQ(entry.Title, expected.Title);
+        EXPECT_EQ(entry.DisplayName, expected.DisplayName);
+        EXPECT_EQ(entry.DisplayType, expected.DisplayType);
+    }
+    EXPECT_EQ(store.Entry(3).Folder, "C:\\Pictures\\0\\");
+    EXPECT_EQ(store.Entry(3).FileName, "IMG_3.png");
+
+    // Removing keeps the order of the rest.
+    EXPECT_EQ(store.RemoveIf([](auto&& entry) { return entry.Size % 2 == 0; }), count / 2);
+    EXPECT_EQ(store.Size(), count / 2);
+    for (size_t i = 0; i < store.Size(); i += 997)
+    {
+        const auto expected = MakePhoto(i * 2 + 1);
+        EXPECT_EQ(store.Entry(i).Path(), expected.Path);
+        EXPECT_EQ(store.Entry(i).DisplayName, expected.DisplayName);
+        EXPECT_EQ(store.Entry(i).Title, expected.Title);
+    }
+}
+
+TEST(PhotoStoreTests, NotificationsAreBatched)
+{
+    PhotoStore store;
+    std::vector<PhotoStoreChange> changes;
+    const auto token = store.Subscribe([&](auto&& change) { changes.push_back(change); });
+
+    store.Append(MakePhoto(0));
+    EXPECT_EQ(changes.size(), 1u);
+
+    std::vector<PhotoMetadata> batch;
+    for (size_t i = 1; i < 5000; i++)
+    {
+        batch.push_back(MakePhoto(i));
+    }
+    store.BeginUpdate();
+    store.Append(batch);
+    store.Append(MakePhoto(5000));
+    EXPECT_EQ(changes.size(), 1u);
+    store.EndUpdate();
+    EXPECT_EQ(changes.size(), 2u);
+    EXPECT_TRUE(changes[1].Type == PhotoStoreChangeType::Inserted);
+    EXPECT_EQ(changes[1].Index, 1u);
+    EXPECT_EQ(changes[1].Count, 5000u);
+
+    // Removed runs arrive latest first, so applying them in order to a mirror of the
+    // store gives the same list.
+    std::vector<uint64_t> mirror;
+    for (size_t i = 0; i < store.Size(); i++)
+    {
+        mirror.push_back(store.Entry(i).Size);
+    }
+    changes.clear();
+    store.RemoveIf([](auto&& entry) { return (entry.Size / 10) % 3 == 0 || entry.Size > 5990; });
+    for (auto&& change : changes)
+    {
+        EXPECT_TRUE(change.Type == PhotoStoreChangeType::Removed);
+        mirror.erase(mirror.begin() + change.Index, mirror.begin() + change.Index + change.Count);
+    }
+    EXPECT_EQ(mirror.size(), store.Size());
+    bool same = true;
+    for (size_t i = 0; i < store.Size(); i++)
+    {
+        same = same && mirror[i] == store.Entry(i).Size;
+    }
+    EXPECT_TRUE(same);
+
+    store.Unsubscribe(token);
+    changes.clear();
+    store.Clear();
+    EXPECT_TRUE(changes.empty());
+    EXPECT_EQ(store.Size(), 0u);
+}
+
+TEST(PhotoStoreTests, EntriesTakeAFewDozenBytes)
+{
+    PhotoStore store;
+    const size_t count = 200000;
+    for (size_t i = 0; i < count; i++)
+    {
+        store.Append(MakePhoto(i));
+    }
+
+    // About 40 bytes of fields plus the file name; the strings of a PhotoMetadata alone
+    // take more than that.
+    const size_t perEntry = store.MemoryUsage() / count;
+    EXPECT_LT(perEntry, 64u);
+}
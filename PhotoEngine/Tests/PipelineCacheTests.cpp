@@ -0,0 +1,90 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "LruCache.h"
+#include "PipelineCache.h"
+#include "Renderer.h"
+#include "Test.h"
+#include "TestImages.h"
+#include <string>
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+TEST(LruCacheTests, EvictsLeastRecentlyUsedEntry)
+{
+    LruCache<std::string, int> cache(2);
+    cache.Insert("light", 1);
+    cache.Insert("blur", 2);
+
+    EXPECT_TRUE(cache.Find("light") != nullptr);
+    cache.Insert("sepia", 3);
+
+    EXPECT_TRUE(cache.Find("blur") == nullptr);
+    EXPECT_EQ(*cache.Find("light"), 1);
+    EXPECT_EQ(*cache.Find("sepia"), 3);
+    EXPECT_EQ(cache.Size(), 2u);
+    EXPECT_EQ(cache.Hits(), 3u);
+    EXPECT_EQ(cache.Misses(), 1u);
+    EXPECT_EQ(cache.Evictions(), 1u);
+}
+
+TEST(PipelineCacheTests, ReturnsCompiledPipelineForRepeatedChain)
+{
+    PipelineCache cache(4);
+    auto light = EffectChain::FromSelection({ "light", "blur" });
+    auto sepia = EffectChain::FromSelection({ "sepia" });
+
+    Pipeline& first = cache.Get(light, {});
+    cache.Get(sepia, {});
+    Pipeline& second = cache.Get(light, {});
+
+    EXPECT_TRUE(&first == &second);
+    EXPECT_EQ(cache.Hits(), 1u);
+    EXPECT_EQ(cache.Misses(), 2u);
+
+    PipelineOptions unfused;
+    unfused.FusePointEffects = false;
+    EXPECT_TRUE(&cache.Get(light, unfused) != &first);
+    EXPECT_EQ(cache.Size(), 3u);
+}
+
+TEST(PipelineCacheTests, RendererReusesPipelineAcrossParameterChanges)
+{
+    ThreadPool pool(1);
+    Renderer renderer(pool);
+    auto chain = EffectChain::FromSelection({ "color", "light", "sepia" });
+    auto source = MakeNoiseImage(16, 8);
+    Image result(16, 8);
+
+    EffectParameters params;
+    for (int i = 0; i < 5; i++)
+    {
+        params.Exposure = 0.1f * i;
+        renderer.Render(chain, params, source.View(), result.View());
+    }
+
+    EXPECT_EQ(renderer.Pipelines().Misses(), 1u);
+    EXPECT_EQ(renderer.Pipelines().Hits(), 4u);
+}
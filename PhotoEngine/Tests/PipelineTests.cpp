@@ -0,0 +1,174 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ColorMatrix.h"
+#include "Pipeline.h"
+#include "Renderer.h"
+#include "Test.h"
+#include "TestImages.h"
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+TEST(PipelineTests, FusesPointEffectsBetweenBlurs)
+{
+    Pipeline pipeline(EffectChain::FromSelection({ "light", "blur", "color", "sepia" }));
+
+    auto const& stages = pipeline.Stages();
+    EXPECT_EQ(stages.size(), 3u);
+    EXPECT_TRUE(stages[0].Type == StageType::PointEffects);
+    EXPECT_EQ(stages[0].Effects.size(), 2u);
+    EXPECT_TRUE(stages[1].Type == StageType::GaussianBlur);
+    EXPECT_TRUE(stages[2].Type == StageType::PointEffects);
+    EXPECT_EQ(stages[2].Effects.size(), 3u);
+
+    PipelineOptions options;
+    options.FusePointEffects = false;
+    options.FoldColorMatrices = false;
+    Pipeline unfused(pipeline.Chain(), options);
+    EXPECT_EQ(unfused.Stages().size(), 6u);
+}
+
+TEST(PipelineTests, SplitsRunsLongerThanMaxPointOps)
+{
+    EffectChain chain;
+    for (size_t i = 0; i < MaxPointOps + 3; i++)
+    {
+        chain.Append(EffectKind::Contrast);
+    }
+
+    Pipeline pipeline(chain);
+    EXPECT_EQ(pipeline.Stages().size(), 2u);
+    EXPECT_EQ(pipeline.Stages()[0].Effects.size(), MaxPointOps);
+}
+
+TEST(PipelineTests, ProgramKernelsMatchScalarProgram)
+{
+    EffectParameters params;
+    params.Exposure = -0.5f;
+    params.Contrast = 0.4f;
+    params.Temperature = 0.6f;
+    params.Saturation = 0.5f;
+
+    PipelineOptions options;
+    options.FoldColorMatrices = false;
+    Pipeline pipeline(EffectChain::FromSelection({ "light", "color", "sepia", "invert" }), options);
+    const auto program = pipeline.PointProgram(0, params);
+
+    auto source = MakeNoiseImage(93, 1);
+    Image expected(93, 1);
+    GetPixelKernels(SimdLevel::Scalar).PointProgramBgra8(program.data(), program.size(), source.Data(), expected.Data(), 93);
+
+    for (auto level : { SimdLevel::Sse41, SimdLevel::Avx2, SimdLevel::Avx512, SimdLevel::Neon })
+    {
+        if (IsSimdLevelSupported(level))
+        {
+            Image actual(93, 1);
+            GetPixelKernels(level).PointProgramBgra8(program.data(), program.size(), source.Data(), actual.Data(), 93);
+            EXPECT_LE(MaxDifference(expected.View(), actual.View()), 1);
+        }
+    }
+}
+
+TEST(PipelineTests, FusedRenderMatchesOnePassPerEffect)
+{
+    EffectParameters params;
+    params.Exposure = 0.25f;
+    params.Contrast = 0.5f;
+    params.Temperature = -0.3f;
+    params.Tint = 0.2f;
+    params.Saturation = 0.7f;
+    params.BlurAmount = 1.0f;
+    params.Intensity = 0.6f;
+
+    auto chain = EffectChain::FromSelection({ "color", "light", "blur", "sepia", "grayscale" });
+    auto source = MakeNoiseImage(50, 40);
+    Image fused(50, 40);
+    Image unfused(50, 40);
+
+    ThreadPool pool(4);
+    Renderer renderer(pool);
+    renderer.Render(chain, params, source.View(), fused.View());
+    renderer.Options({ false, false });
+    renderer.Render(chain, params, source.View(), unfused.View());
+
+    // The unfused path rounds to 8 bits after every effect; the fused path only at the end.
+    EXPECT_LE(MaxDifference(fused.View(), unfused.View()), 3);
+}
+
+TEST(PipelineTests, FoldsConsecutiveLinearEffects)
+{
+    Pipeline pipeline(EffectChain::FromSelection({ "light", "color", "sepia", "blur", "grayscale", "invert" }));
+
+    EXPECT_EQ(pipeline.Stages().size(), 3u);
+    EXPECT_EQ(pipeline.Stages()[0].Nodes.size(), 2u);
+    EXPECT_FALSE(pipeline.Stages()[0].Nodes[0].IsFolded());
+    EXPECT_TRUE(pipeline.Stages()[0].Nodes[1].IsFolded());
+    EXPECT_EQ(pipeline.FoldedEffectCount(), 4u);
+    EXPECT_TRUE(pipeline.Describe() ==
+        "Contrast, Exposure x TemperatureAndTint x Saturation x Sepia | Blur | Grayscale x Invert");
+}
+
+TEST(PipelineTests, FoldedRenderMatchesUnfoldedRender)
+{
+    EffectParameters params;
+    params.Exposure = 0.4f;
+    params.Contrast = -0.3f;
+    params.Temperature = 0.5f;
+    params.Tint = -0.4f;
+    params.Saturation = 1.6f;
+    params.Intensity = 0.9f;
+
+    auto chain = EffectChain::FromSelection({ "light", "color", "sepia", "grayscale", "invert" });
+    auto source = MakeNoiseImage(71, 23);
+    Image folded(71, 23);
+    Image unfolded(71, 23);
+
+    ThreadPool pool(2);
+    Renderer renderer(pool);
+    renderer.Render(chain, params, source.View(), folded.View());
+    renderer.Options({ true, false });
+    renderer.Render(chain, params, source.View(), unfolded.View());
+
+    EXPECT_LE(MaxDifference(folded.View(), unfolded.View()), 1);
+}
+
+TEST(PipelineTests, RebuildsOnlyChangedOperations)
+{
+    PipelineOptions options;
+    options.FoldColorMatrices = false;
+    Pipeline pipeline(EffectChain::FromSelection({ "light", "color", "sepia" }), options);
+
+    EffectParameters params;
+    pipeline.PointProgram(0, params);
+    EXPECT_EQ(pipeline.BuiltOperationCount(), 5u);
+
+    pipeline.PointProgram(0, params);
+    EXPECT_EQ(pipeline.BuiltOperationCount(), 5u);
+
+    params.Intensity = 0.8f;
+    auto const& program = pipeline.PointProgram(0, params);
+    EXPECT_EQ(pipeline.BuiltOperationCount(), 6u);
+    EXPECT_TRUE(program[4].Matrix == SepiaMatrix(0.8f));
+}
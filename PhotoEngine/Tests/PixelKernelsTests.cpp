@@ -0,0 +1,363 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ColorLut.h"
+#include "PixelKernels.h"
+#include "PlanarImage.h"
+#include "PointEffects.h"
+#include "Test.h"
+#include "TestImages.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+namespace
+{
+    const EffectKind PointEffectKinds[] = {
+        EffectKind::Contrast,
+        EffectKind::Exposure,
+        EffectKind::TemperatureAndTint,
+        EffectKind::Saturation,
+        EffectKind::Sepia,
+        EffectKind::Grayscale,
+        EffectKind::Invert };
+
+    EffectParameters EditedParameters()
+    {
+        EffectParameters params;
+        params.Exposure = 0.7f;
+        params.Temperature = -0.4f;
+        params.Tint = 0.3f;
+        params.Contrast = 0.6f;
+        params.Saturation = 0.25f;
+        params.Intensity = 0.8f;
+        return params;
+    }
+
+    std::vector<SimdLevel> SupportedLevels()
+    {
+        std::vector<SimdLevel> levels;
+        for (auto level : { SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2, SimdLevel::Avx512, SimdLevel::Neon })
+        {
+            if (IsSimdLevelSupported(level))
+            {
+                levels.push_back(level);
+            }
+        }
+        return levels;
+    }
+
+    // Copies interleaved BGRA floats into a planar row of either format.
+    void ToPlanar(std::vector<float> const& pixels, PlanarRow row, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            for (int channel = 0; channel < 4; channel++)
+            {
+                const float value = pixels[i * 4 + channel];
+                if (row.Format == PlanarFormat::Float16)
+                {
+                    static_cast<uint16_t*>(row.Planes[channel])[i] = FloatToHalf(value);
+                }
+                else
+                {
+                    static_cast<float*>(row.Planes[channel])[i] = value;
+                }
+            }
+        }
+    }
+
+    float PlanarSample(PlanarRow row, int channel, size_t i)
+    {
+        return row.Format == PlanarFormat::Float16 ?
+            HalfToFloat(static_cast<const uint16_t*>(row.Planes[channel])[i]) :
+            static_cast<const float*>(row.Planes[channel])[i];
+    }
+}
+
+TEST(PixelKernelsTests, EffectMatricesMatchReferenceEffects)
+{
+    const auto params = EditedParameters();
+    const Color color{ 0.1f, 0.45f, 0.9f, 0.7f };
+
+    for (auto kind : PointEffectKinds)
+    {
+        if (!IsLinearEffect(kind))
+        {
+            continue;
+        }
+
+        const auto matrix = EffectMatrix(kind, params);
+        const auto expected = ApplyPointEffect(kind, params, color);
+        const float in[4] = { color.B, color.G, color.R, color.A };
+        const float out[4] = { expected.B, expected.G, expected.R, expected.A };
+
+        for (int row = 0; row < 4; row++)
+        {
+            float value = matrix.M[row][4];
+            for (int column = 0; column < 4; column++)
+            {
+                value += matrix.M[row][column] * in[column];
+            }
+            EXPECT_NEAR(value, out[row], 1e-5f);
+        }
+    }
+}
+
+TEST(PixelKernelsTests, Bgra8KernelsMatchScalarReference)
+{
+    const auto params = EditedParameters();
+
+    // 67 pixels leaves a partial block for every vector width.
+    auto source = MakeNoiseImage(67, 1);
+    Image expected(67, 1);
+
+    for (auto level : SupportedLevels())
+    {
+        auto const& kernels = GetPixelKernels(level);
+        for (auto kind : PointEffectKinds)
+        {
+            ApplyPointEffect(kind, params, source.View(), expected.View());
+
+            Image actual(67, 1);
+            ApplyPointEffect(kernels, kind, params, source.Data(), actual.Data(), 67);
+            EXPECT_LE(MaxDifference(expected.View(), actual.View()), 1);
+
+            // In place.
+            auto inPlace = source;
+            ApplyPointEffect(kernels, kind, params, inPlace.Data(), inPlace.Data(), 67);
+            EXPECT_LE(MaxDifference(expected.View(), inPlace.View()), 1);
+        }
+    }
+}
+
+TEST(PixelKernelsTests, FloatKernelsMatchScalarReference)
+{
+    const auto params = EditedParameters();
+    auto source = MakeNoiseImage(37, 1, 7);
+
+    std::vector<float> input(37 * 4);
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        // Include values outside [0, 1]; the float kernels must not clamp them.
+        input[i] = source.Data()[i] / 200.0f - 0.1f;
+    }
+
+    for (auto level : SupportedLevels())
+    {
+        auto const& kernels = GetPixelKernels(level);
+        for (auto kind : PointEffectKinds)
+        {
+            std::vector<float> output(input.size());
+            ApplyPointEffect(kernels, kind, params, input.data(), output.data(), 37);
+
+            for (size_t pixel = 0; pixel < 37; pixel++)
+            {
+                const float* in = &input[pixel * 4];
+                const auto expected = ApplyPointEffect(kind, params, Color{ in[0], in[1], in[2], in[3] });
+                EXPECT_NEAR(output[pixel * 4 + 0], expected.B, 1e-5f);
+                EXPECT_NEAR(output[pixel * 4 + 1], expected.G, 1e-5f);
+                EXPECT_NEAR(output[pixel * 4 + 2], expected.R, 1e-5f);
+                EXPECT_NEAR(output[pixel * 4 + 3], expected.A, 1e-5f);
+            }
+        }
+    }
+}
+
+TEST(PixelKernelsTests, AccumulateMatchesScalarReference)
+{
+    auto source = MakeNoiseImage(67, 1, 11);
+    for (auto level : SupportedLevels())
+    {
+        std::vector<float> sum(67 * 4, 1.0f);
+        GetPixelKernels(level).AccumulateBgra8(source.Data(), 0.375f, sum.data(), 67);
+        for (size_t i = 0; i < sum.size(); i++)
+        {
+            EXPECT_NEAR(sum[i], 1.0f + 0.375f * source.Data()[i], 1e-4f);
+        }
+    }
+}
+
+TEST(PixelKernelsTests, UnsupportedLevelThrows)
+{
+    for (auto level : { SimdLevel::Sse41, SimdLevel::Avx2, SimdLevel::Avx512, SimdLevel::Neon })
+    {
+        if (!IsSimdLevelSupported(level))
+        {
+            EXPECT_THROW(GetPixelKernels(level), std::invalid_argument);
+        }
+    }
+    EXPECT_TRUE(IsSimdLevelSupported(BestSimdLevel()));
+}
+
+TEST(PixelKernelsTests, HalfConversionMatchesScalarReference)
+{
+    std::vector<float> values;
+    for (int i = -300; i < 300; i++)
+    {
+        values.push_back(i / 97.0f);
+    }
+    values.insert(values.end(), { 0.0f, -0.0f, 65504.0f, 70000.0f, 1e-6f, 6.1e-5f });
+
+    EXPECT_EQ(FloatToHalf(1.0f), 0x3c00);
+    EXPECT_EQ(FloatToHalf(70000.0f), 0x7c00);
+    EXPECT_EQ(HalfToFloat(0x3555), 0.333251953125f);
+
+    for (auto level : SupportedLevels())
+    {
+        auto const& kernels = GetPixelKernels(level);
+        std::vector<uint16_t> halves(values.size());
+        std::vector<float> floats(values.size());
+        kernels.FloatToHalfSamples(values.data(), halves.data(), values.size());
+        kernels.HalfToFloatSamples(halves.data(), floats.data(), values.size());
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            EXPECT_EQ(halves[i], FloatToHalf(values[i]));
+            EXPECT_EQ(floats[i], HalfToFloat(halves[i]));
+        }
+    }
+}
+
+TEST(PixelKernelsTests, PlanarConversionRoundTrips)
+{
+    // 67 pixels leaves a partial block for every vector width.
+    auto source = MakeNoiseImage(67, 1, 5);
+
+    for (auto level : SupportedLevels())
+    {
+        auto const& kernels = GetPixelKernels(level);
+        for (auto format : { PlanarFormat::Float32, PlanarFormat::Float16 })
+        {
+            for (bool linear : { false, true })
+            {
+                PlanarImage planar(67, 1, format);
+                const auto row = planar.View().Row(0);
+                kernels.Bgra8ToPlanar(source.Data(), row, 67, linear);
+
+                for (size_t i = 0; i < 67; i++)
+                {
+                    for (int channel = 0; channel < 4; channel++)
+                    {
+                        const uint8_t level8 = source.Data()[i * 4 + channel];
+                        const float expected = linear && channel < 3 ? SrgbToLinear(level8 / 255.0f) : level8 / 255.0f;
+                        EXPECT_NEAR(PlanarSample(row, channel, i), expected, format == PlanarFormat::Float16 ? 1e-3f : 1e-6f);
+                    }
+                }
+
+                Image result(67, 1);
+                kernels.PlanarToBgra8(row, result.Data(), 67, linear);
+                EXPECT_EQ(MaxDifference(source.View(), result.View()), 0);
+            }
+        }
+    }
+}
+
+TEST(PixelKernelsTests, PlanarEncodingMatchesSrgbCurve)
+{
+    // Every level, and values past both ends that must clamp.
+    std::vector<float> input;
+    for (int i = -4; i <= 1024 + 4; i++)
+    {
+        const float value = i / 1024.0f;
+        input.insert(input.end(), { value, value, value, value });
+    }
+    const size_t count = input.size() / 4;
+
+    for (auto level : SupportedLevels())
+    {
+        PlanarImage planar(static_cast<uint32_t>(count), 1, PlanarFormat::Float32);
+        const auto row = planar.View().Row(0);
+        ToPlanar(input, row, count);
+
+        std::vector<uint8_t> output(count * 4);
+        GetPixelKernels(level).PlanarToBgra8(row, output.data(), count, true);
+        for (size_t i = 0; i < count; i++)
+        {
+            const float value = std::min(std::max(input[i * 4], 0.0f), 1.0f);
+            EXPECT_LE(std::abs(output[i * 4] - LinearToSrgb(value) * 255.0f), 0.51f);
+            EXPECT_LE(std::abs(output[i * 4 + 3] - value * 255.0f), 0.51f);
+        }
+    }
+}
+
+TEST(PixelKernelsTests, PlanarKernelsMatchFloatKernels)
+{
+    const auto params = EditedParameters();
+    auto source = MakeNoiseImage(67, 1, 9);
+
+    std::vector<float> input(67 * 4);
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        // Values outside [0, 1] must survive the program kernels unclamped.
+        input[i] = source.Data()[i] / 200.0f - 0.1f;
+    }
+
+    std::vector<PointOp> ops;
+    for (auto kind : PointEffectKinds)
+    {
+        ops.push_back(MakePointOp(kind, params));
+    }
+    const ColorLut lut(ColorLut::SmallSize, ops.data(), 3);
+
+    auto const& scalar = GetPixelKernels(SimdLevel::Scalar);
+    std::vector<float> programmed(input.size());
+    std::vector<float> looked(input.size());
+    scalar.PointProgramFloat(ops.data(), ops.size(), input.data(), programmed.data(), 67);
+    scalar.ColorLutFloat(lut.Table(), lut.Size(), input.data(), looked.data(), 67);
+
+    for (auto level : SupportedLevels())
+    {
+        auto const& kernels = GetPixelKernels(level);
+        for (auto format : { PlanarFormat::Float32, PlanarFormat::Float16 })
+        {
+            // Half precision keeps 11 significant bits through each step.
+            const float tolerance = format == PlanarFormat::Float16 ? 4e-3f : 1e-5f;
+            PlanarImage planar(67, 1, format);
+            const auto row = planar.View().Row(0);
+
+            ToPlanar(input, row, 67);
+            kernels.PointProgramPlanar(ops.data(), ops.size(), row, 67);
+            for (size_t i = 0; i < 67; i++)
+            {
+                for (int channel = 0; channel < 4; channel++)
+                {
+                    EXPECT_NEAR(PlanarSample(row, channel, i), programmed[i * 4 + channel], tolerance);
+                }
+            }
+
+            ToPlanar(input, row, 67);
+            kernels.ColorLutPlanar(lut.Table(), lut.Size(), row, 67);
+            for (size_t i = 0; i < 67; i++)
+            {
+                for (int channel = 0; channel < 4; channel++)
+                {
+                    EXPECT_NEAR(PlanarSample(row, channel, i), looked[i * 4 + channel], tolerance);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,183 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "GaussianBlur.h"
+#include "PlanarImage.h"
+#include "Renderer.h"
+#include "Test.h"
+#include "TestImages.h"
+#include <cstring>
+#include <set>
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+namespace
+{
+    EffectParameters EditedParameters()
+    {
+        EffectParameters params;
+        params.Exposure = 0.5f;
+        params.Temperature = 0.3f;
+        params.Tint = -0.2f;
+        params.Contrast = 0.4f;
+        params.Saturation = 0.6f;
+        params.Intensity = 0.7f;
+        params.BlurAmount = 2.0f;
+        return params;
+    }
+
+    Image RenderIn(WorkingFormat format, bool linear, EffectChain const& chain, EffectParameters const& params, Image const& source)
+    {
+        ThreadPool pool(2);
+        Renderer renderer(pool);
+        PipelineOptions options;
+        options.Format = format;
+        options.LinearLight = linear;
+        Pipeline pipeline(chain, options);
+
+        Image result(source.Width(), source.Height());
+        renderer.Render(pipeline, params, source.View(), result.View());
+        return result;
+    }
+}
+
+TEST(PlanarImageTests, PlanarRendersMatchBgra8)
+{
+    const auto params = EditedParameters();
+    auto source = MakeNoiseImage(61, 23, 4);
+    const EffectChain chain{ EffectKind::Contrast, EffectKind::Exposure, EffectKind::TemperatureAndTint, EffectKind::Saturation };
+
+    // A point chain is a single program in every format, so only the final rounding differs.
+    const auto bgra8 = RenderIn(WorkingFormat::Bgra8, false, chain, params, source);
+    const auto float32 = RenderIn(WorkingFormat::Float32, false, chain, params, source);
+    const auto float16 = RenderIn(WorkingFormat::Float16, false, chain, params, source);
+    EXPECT_LE(MaxDifference(bgra8.View(), float32.View()), 1);
+    EXPECT_LE(MaxDifference(float32.View(), float16.View()), 1);
+
+    // With a blur in the chain the BGRA8 render also rounds the blurred image. Point
+    // stages before the blur would differ more, since BGRA8 clamps what they produce.
+    const EffectChain blurChain{ EffectKind::GaussianBlur, EffectKind::Sepia, EffectKind::Exposure };
+    const auto blurredBgra8 = RenderIn(WorkingFormat::Bgra8, false, blurChain, params, source);
+    const auto blurred32 = RenderIn(WorkingFormat::Float32, false, blurChain, params, source);
+    const auto blurred16 = RenderIn(WorkingFormat::Float16, false, blurChain, params, source);
+    EXPECT_LE(MaxDifference(blurredBgra8.View(), blurred32.View()), 2);
+    EXPECT_LE(MaxDifference(blurred32.View(), blurred16.View()), 1);
+}
+
+TEST(PlanarImageTests, PlanarFormatsAvoidBandingBetweenStages)
+{
+    // A dark gradient that spans 16 levels, blurred and then brightened three stops.
+    Image source(256, 4);
+    for (uint32_t y = 0; y < 4; y++)
+    {
+        for (uint32_t x = 0; x < 256; x++)
+        {
+            std::memset(source.View().Row(y) + x * BytesPerPixel, static_cast<int>(x / 16), 3);
+            source.View().Row(y)[x * BytesPerPixel + 3] = 255;
+        }
+    }
+
+    EffectParameters params;
+    params.BlurAmount = 6.0f;
+    params.Exposure = 3.0f;
+    const EffectChain chain{ EffectKind::GaussianBlur, EffectKind::Exposure };
+
+    auto levels = [](Image const& image)
+    {
+        std::set<uint8_t> values;
+        for (uint32_t x = 0; x < image.Width(); x++)
+        {
+            values.insert(image.View().Row(2)[x * BytesPerPixel + 1]);
+        }
+        return values.size();
+    };
+
+    // BGRA8 rounds the blur to the 16 source levels, which the exposure spreads 8 apart.
+    const auto bgra8 = levels(RenderIn(WorkingFormat::Bgra8, false, chain, params, source));
+    EXPECT_LE(bgra8, 16u);
+    EXPECT_GE(levels(RenderIn(WorkingFormat::Float32, false, chain, params, source)), 4 * bgra8);
+    EXPECT_GE(levels(RenderIn(WorkingFormat::Float16, false, chain, params, source)), 4 * bgra8);
+}
+
+TEST(PlanarImageTests, LinearLightScalesLight)
+{
+    Image source(9, 3);
+    for (uint32_t y = 0; y < 3; y++)
+    {
+        std::memset(source.View().Row(y), 128, source.Stride());
+    }
+
+    EffectParameters params;
+    params.Exposure = 1.0f;
+    const EffectChain chain{ EffectKind::Exposure };
+
+    // One stop doubles the sRGB value, but in linear light it doubles the light: level 128
+    // is 0.216 linear, and 0.432 linear is level 176.
+    const auto gamma = RenderIn(WorkingFormat::Float32, false, chain, params, source);
+    const auto linear = RenderIn(WorkingFormat::Float32, true, chain, params, source);
+    const auto linearHalf = RenderIn(WorkingFormat::Float16, true, chain, params, source);
+    EXPECT_EQ(int(gamma.View().Row(1)[0]), 255);
+    EXPECT_EQ(int(linear.View().Row(1)[0]), 176);
+    EXPECT_EQ(int(linearHalf.View().Row(1)[0]), 176);
+
+    // Alpha is not decoded, so it comes back unchanged.
+    EXPECT_EQ(int(linear.View().Row(1)[3]), 128);
+}
+
+TEST(PlanarImageTests, BlurRunsInPlace)
+{
+    ThreadPool pool(2);
+    auto source = MakeNoiseImage(45, 37, 8);
+
+    for (auto format : { PlanarFormat::Float32, PlanarFormat::Float16 })
+    {
+        for (auto method : { BlurMethod::Direct, BlurMethod::Box, BlurMethod::Recursive })
+        {
+            PlanarImage input(45, 37, format);
+            PlanarImage output(45, 37, format);
+            for (uint32_t y = 0; y < 37; y++)
+            {
+                GetPixelKernels().Bgra8ToPlanar(source.View().Row(y), input.View().Row(y), 45, false);
+            }
+
+            GaussianBlur(input.View(), output.View(), 3.0f, pool, method);
+            GaussianBlur(input.View(), input.View(), 3.0f, pool, method);
+
+            Image expected(45, 37);
+            Image actual(45, 37);
+            for (uint32_t y = 0; y < 37; y++)
+            {
+                GetPixelKernels().PlanarToBgra8(output.View().Row(y), expected.View().Row(y), 45, false);
+                GetPixelKernels().PlanarToBgra8(input.View().Row(y), actual.View().Row(y), 45, false);
+            }
+            EXPECT_EQ(MaxDifference(expected.View(), actual.View()), 0);
+
+            // And matches the BGRA8 blur up to its rounding.
+            Image blurred(45, 37);
+            GaussianBlur(source.View(), blurred.View(), 3.0f, pool, method);
+            EXPECT_LE(MaxDifference(expected.View(), blurred.View()), 1);
+        }
+    }
+}
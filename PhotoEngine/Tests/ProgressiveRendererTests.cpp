@@ -0,0 +1,94 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ProgressiveRenderer.h"
+#include "Renderer.h"
+#include "Test.h"
+#include "TestImages.h"
+#include <cmath>
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+namespace
+{
+    // Returns an image with soft color gradients, closer to a photo than noise.
+    Image MakeGradientImage(uint32_t width, uint32_t height)
+    {
+        Image image(width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint8_t* pixel = image.View().Row(y) + x * BytesPerPixel;
+                pixel[0] = static_cast<uint8_t>(127.5f + 127.5f * std::sin(x * 0.07f));
+                pixel[1] = static_cast<uint8_t>(127.5f + 127.5f * std::cos(y * 0.05f));
+                pixel[2] = static_cast<uint8_t>((x + y) / 2);
+                pixel[3] = 255;
+            }
+        }
+        return image;
+    }
+}
+
+TEST(MipPyramidTests, HalvesEachLevel)
+{
+    ThreadPool pool(2);
+    auto source = MakeNoiseImage(37, 20);
+    MipPyramid pyramid(source.View(), pool);
+
+    EXPECT_EQ(pyramid.LevelCount(), 6u);
+    EXPECT_EQ(pyramid.Level(1).Width, 19u);
+    EXPECT_EQ(pyramid.Level(1).Height, 10u);
+    EXPECT_EQ(pyramid.Level(5).Height, 1u);
+
+    EXPECT_EQ(pyramid.LevelForZoom(1.0f), 0u);
+    EXPECT_EQ(pyramid.LevelForZoom(0.6f), 0u);
+    EXPECT_EQ(pyramid.LevelForZoom(0.5f), 1u);
+    EXPECT_EQ(pyramid.LevelForZoom(0.2f), 2u);
+    EXPECT_EQ(pyramid.LevelForZoom(0.0001f), 5u);
+}
+
+TEST(ProgressiveRendererTests, PreviewMatchesDownsampledFullRender)
+{
+    ThreadPool pool(2);
+    auto source = MakeGradientImage(256, 192);
+    auto chain = EffectChain::FromSelection({ "light", "blur", "sepia" });
+    EffectParameters params;
+    params.Contrast = 0.2f;
+    params.BlurAmount = 6.0f;
+
+    ProgressiveRenderer progressive(pool, source.View(), chain);
+    auto preview = progressive.RenderPreview(params, 0.25f);
+    EXPECT_EQ(progressive.LastLevel(), 2u);
+    EXPECT_EQ(preview.Width, 64u);
+
+    auto full = progressive.RenderFull(params);
+    Image half(128, 96);
+    Image quarter(64, 48);
+    Downsample(full, half.View(), pool);
+    Downsample(half.View(), quarter.View(), pool);
+
+    EXPECT_LE(MaxDifference(quarter.View(), preview), 4);
+}
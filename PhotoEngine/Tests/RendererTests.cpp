@@ -0,0 +1,134 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "GaussianBlur.h"
+#include "PointEffects.h"
+#include "Renderer.h"
+#include "Test.h"
+#include "TestImages.h"
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+TEST(EffectChainTests, FromSelectionMatchesPrepareSelectedEffects)
+{
+    auto chain = EffectChain::FromSelection({ "light", "blur", "color", "sepia" });
+
+    EffectChain expected{
+        EffectKind::Contrast, EffectKind::Exposure,
+        EffectKind::GaussianBlur,
+        EffectKind::TemperatureAndTint, EffectKind::Saturation,
+        EffectKind::Sepia };
+    EXPECT_TRUE(chain == expected);
+    EXPECT_THROW(EffectChain::FromSelection({ "vignette" }), std::invalid_argument);
+}
+
+TEST(PointEffectTests, DefaultParametersLeavePixelsUnchanged)
+{
+    ThreadPool pool(1);
+    Renderer renderer(pool);
+    auto source = MakeNoiseImage(37, 11);
+    Image result(37, 11);
+
+    EffectChain chain{ EffectKind::Contrast, EffectKind::Exposure, EffectKind::TemperatureAndTint, EffectKind::Saturation };
+    renderer.Render(chain, EffectParameters{}, source.View(), result.View());
+
+    EXPECT_EQ(MaxDifference(source.View(), result.View()), 0);
+}
+
+TEST(PointEffectTests, EffectsMatchReferenceFormulas)
+{
+    const Color color{ 0.2f, 0.5f, 0.8f, 0.6f };
+
+    auto inverted = Invert(color);
+    EXPECT_NEAR(inverted.R, 0.2f, 1e-6f);
+    EXPECT_NEAR(inverted.A, 0.6f, 1e-6f);
+
+    auto gray = Grayscale(color);
+    EXPECT_NEAR(gray.R, gray.G, 1e-6f);
+    EXPECT_NEAR(gray.G, gray.B, 1e-6f);
+
+    auto brighter = Exposure(color, 1.0f);
+    EXPECT_NEAR(brighter.B, 0.4f, 1e-6f);
+
+    auto desaturated = Saturation(color, 0.0f);
+    EXPECT_NEAR(desaturated.R, desaturated.B, 1e-6f);
+
+    auto warmer = TemperatureAndTint(color, 1.0f, 0.0f);
+    EXPECT_GT(warmer.R, color.R);
+    EXPECT_LT(warmer.B, color.B);
+
+    auto flat = Contrast(color, -1.0f);
+    EXPECT_GT(flat.B, color.B);
+    EXPECT_LT(flat.R, color.R);
+}
+
+TEST(GaussianBlurTests, ConstantImageIsUnchanged)
+{
+    ThreadPool pool(4);
+    Image source(64, 48);
+    std::fill(source.Data(), source.Data() + source.Stride() * source.Height(), uint8_t{ 173 });
+    Image result(64, 48);
+
+    GaussianBlur(source.View(), result.View(), 4.0f, pool);
+
+    EXPECT_EQ(MaxDifference(source.View(), result.View()), 0);
+}
+
+TEST(RendererTests, ThreadCountDoesNotChangeResult)
+{
+    auto source = MakeNoiseImage(129, 77);
+    EffectParameters params;
+    params.Exposure = 0.5f;
+    params.Contrast = 0.3f;
+    params.BlurAmount = 2.5f;
+    params.Intensity = 0.8f;
+
+    auto chain = EffectChain::FromSelection({ "light", "blur", "sepia", "invert" });
+
+    ThreadPool serialPool(1);
+    ThreadPool parallelPool(8);
+    Image serial(129, 77);
+    Image parallel(129, 77);
+    Renderer(serialPool).Render(chain, params, source.View(), serial.View());
+    Renderer(parallelPool).Render(chain, params, source.View(), parallel.View());
+
+    EXPECT_EQ(MaxDifference(serial.View(), parallel.View()), 0);
+}
+
+TEST(RendererTests, RendersInPlace)
+{
+    ThreadPool pool(4);
+    auto source = MakeNoiseImage(40, 30);
+    auto image = source;
+    Image expected(40, 30);
+    EffectParameters params;
+    params.BlurAmount = 1.5f;
+
+    auto chain = EffectChain::FromSelection({ "blur", "grayscale" });
+    Renderer(pool).Render(chain, params, source.View(), expected.View());
+    Renderer(pool).Render(chain, params, image.View(), image.View());
+
+    EXPECT_EQ(MaxDifference(expected.View(), image.View()), 0);
+}
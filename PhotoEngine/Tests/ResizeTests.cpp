@@ -0,0 +1,245 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "MipPyramid.h"
+#include "Resize.h"
+#include "Test.h"
+#include "TestImages.h"
+
+#ifdef PHOTOENGINE_HAS_JPEG
+#include "JpegFile.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#endif
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+namespace
+{
+    // A smooth image, which survives JPEG compression and DCT scaling nearly intact.
+    Image MakeGradientImage(uint32_t width, uint32_t height)
+    {
+        Image image(width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t* row = image.View().Row(y);
+            for (uint32_t x = 0; x < width; x++)
+            {
+                row[x * 4 + 0] = static_cast<uint8_t>(x * 255 / width);
+                row[x * 4 + 1] = static_cast<uint8_t>(y * 255 / height);
+                row[x * 4 + 2] = static_cast<uint8_t>((x + y) * 127 / (width + height));
+                row[x * 4 + 3] = 255;
+            }
+        }
+        return image;
+    }
+}
+
+TEST(ResizeTests, OrientationTurnsImagesUpright)
+{
+    // Pixels numbered 0 to 5 in reading order, in a 3 x 2 image.
+    Image image(3, 2);
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        image.View().Row(i / 3)[(i % 3) * BytesPerPixel] = static_cast<uint8_t>(i);
+    }
+
+    auto pixel = [](Image const& oriented, uint32_t x, uint32_t y) { return oriented.View().Row(y)[x * BytesPerPixel]; };
+
+    // Orientation 6 is stored rotated a quarter turn counterclockwise, so it is turned
+    // clockwise: the first stored row becomes the last column.
+    const auto clockwise = ApplyOrientation(image.View(), 6);
+    EXPECT_EQ(clockwise.Width(), 2u);
+    EXPECT_EQ(clockwise.Height(), 3u);
+    EXPECT_EQ(pixel(clockwise, 0, 0), 3);
+    EXPECT_EQ(pixel(clockwise, 1, 0), 0);
+    EXPECT_EQ(pixel(clockwise, 0, 2), 5);
+
+    const auto counterclockwise = ApplyOrientation(image.View(), 8);
+    EXPECT_EQ(pixel(counterclockwise, 0, 0), 2);
+    EXPECT_EQ(pixel(counterclockwise, 1, 2), 3);
+
+    const auto halfTurn = ApplyOrientation(image.View(), 3);
+    EXPECT_EQ(halfTurn.Width(), 3u);
+    EXPECT_EQ(pixel(halfTurn, 0, 0), 5);
+
+    const auto mirrored = ApplyOrientation(image.View(), 2);
+    EXPECT_EQ(pixel(mirrored, 0, 1), 5);
+    EXPECT_EQ(MaxDifference(ApplyOrientation(image.View(), 1).View(), image.View()), 0);
+}
+
+TEST(ResizeTests, FitWithinKeepsAspectRatio)
+{
+    auto size = FitWithin(4000, 3000, 250, 250);
+    EXPECT_EQ(size.Width, 250u);
+    EXPECT_EQ(size.Height, 188u);
+
+    size = FitWithin(3000, 4000, 188, 88);
+    EXPECT_EQ(size.Width, 66u);
+    EXPECT_EQ(size.Height, 88u);
+
+    size = FitWithin(100, 1, 10, 10);
+    EXPECT_EQ(size.Width, 10u);
+    EXPECT_EQ(size.Height, 1u);
+
+    size = FitWithin(120, 80, 250, 250);
+    EXPECT_EQ(size.Width, 120u);
+    EXPECT_EQ(size.Height, 80u);
+}
+
+TEST(ResizeTests, AreaAveragesCoveredPixels)
+{
+    ThreadPool pool(3);
+    auto source = MakeNoiseImage(120, 90, 3);
+
+    // Halving matches the 2x2 box filter of the mip pyramid.
+    Image expected(60, 45);
+    Downsample(source.View(), expected.View(), pool);
+    Image actual(60, 45);
+    ResizeArea(source.View(), actual.View(), pool);
+    EXPECT_LE(MaxDifference(expected.View(), actual.View()), 1);
+
+    // A 3x reduction is the mean of each 3x3 block.
+    Image third(40, 30);
+    ResizeArea(source.View(), third.View(), pool);
+    int worst = 0;
+    for (uint32_t y = 0; y < 30; y++)
+    {
+        for (uint32_t x = 0; x < 40; x++)
+        {
+            for (size_t c = 0; c < 4; c++)
+            {
+                int sum = 0;
+                for (uint32_t dy = 0; dy < 3; dy++)
+                {
+                    for (uint32_t dx = 0; dx < 3; dx++)
+                    {
+                        sum += source.View().Row(3 * y + dy)[(3 * x + dx) * 4 + c];
+                    }
+                }
+                worst = std::max(worst, std::abs(static_cast<int>(third.View().Row(y)[x * 4 + c]) - (sum + 4) / 9));
+            }
+        }
+    }
+    EXPECT_LE(worst, 1);
+
+    // Fractional ratios keep the mean of the image.
+    Image odd(37, 29);
+    ResizeArea(source.View(), odd.View(), pool);
+    double sourceSum = 0;
+    double oddSum = 0;
+    for (size_t i = 0; i < 120 * 90 * 4; i++)
+    {
+        sourceSum += source.Data()[i];
+    }
+    for (size_t i = 0; i < 37 * 29 * 4; i++)
+    {
+        oddSum += odd.Data()[i];
+    }
+    EXPECT_NEAR(sourceSum / (120 * 90 * 4), oddSum / (37 * 29 * 4), 0.5);
+
+    Image larger(121, 90);
+    EXPECT_THROW(ResizeArea(source.View(), larger.View(), pool), std::invalid_argument);
+}
+
+#ifdef PHOTOENGINE_HAS_JPEG
+
+TEST(ResizeTests, ScaledJpegThumbnailMatchesFullDecode)
+{
+    EXPECT_EQ(JpegScaleDenominator(4000, 3000, 250, 188), 8u);
+    EXPECT_EQ(JpegScaleDenominator(1000, 750, 250, 188), 4u);
+    EXPECT_EQ(JpegScaleDenominator(1000, 750, 251, 188), 2u);
+    EXPECT_EQ(JpegScaleDenominator(300, 200, 250, 167), 1u);
+
+    const auto path = (std::filesystem::temp_directory_path() / "PhotoEngineThumbnailTest.jpg").string();
+    auto image = MakeGradientImage(800, 600);
+    {
+        JpegRowWriter writer(path, 800, 600, 95);
+        writer.WriteRows(image.View());
+    }
+
+    JpegRowReader scaled(path, 4);
+    EXPECT_EQ(scaled.Width(), 200u);
+    EXPECT_EQ(scaled.Height(), 150u);
+    EXPECT_THROW(JpegRowReader(path, 3), std::invalid_argument);
+
+    ThreadPool pool(2);
+    auto thumbnail = DecodeJpegThumbnail(path, 188, 188, pool);
+    EXPECT_EQ(thumbnail.Width(), 188u);
+    EXPECT_EQ(thumbnail.Height(), 141u);
+
+    JpegRowReader full(path);
+    Image decoded(800, 600);
+    full.ReadRows(decoded.View());
+    Image expected(188, 141);
+    ResizeArea(decoded.View(), expected.View(), pool);
+    EXPECT_LE(MaxDifference(expected.View(), thumbnail.View()), 4);
+
+    std::filesystem::remove(path);
+}
+
+TEST(ResizeTests, JpegThumbnailFollowsExifOrientation)
+{
+    const auto path = (std::filesystem::temp_directory_path() / "PhotoEngineOrientedThumbnailTest.jpg").string();
+    auto image = MakeGradientImage(800, 600);
+    {
+        JpegRowWriter writer(path, 800, 600, 95);
+        writer.WriteRows(image.View());
+    }
+
+    // Inserts an EXIF block with orientation 6 after the start of image marker, the way
+    // a camera held upright stores a portrait photo.
+    {
+        std::ifstream input(path, std::ios::binary);
+        std::vector<uint8_t> jpeg((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        const std::vector<uint8_t> exif = {
+            0xFF, 0xE1, 0x00, 0x22, 'E', 'x', 'i', 'f', 0, 0,
+            'M', 'M', 0x00, 0x2A, 0x00, 0x00, 0x00, 0x08,
+            0x00, 0x01, 0x01, 0x12, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x06, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00 };
+        jpeg.insert(jpeg.begin() + 2, exif.begin(), exif.end());
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(jpeg.data()), jpeg.size());
+    }
+
+    // Displayed, the photo is 600 x 800, so it fits a 188 x 188 box by its height.
+    ThreadPool pool(2);
+    auto thumbnail = DecodeJpegThumbnail(path, 188, 188, pool);
+    EXPECT_EQ(thumbnail.Width(), 141u);
+    EXPECT_EQ(thumbnail.Height(), 188u);
+
+    JpegRowReader full(path);
+    Image decoded(800, 600);
+    full.ReadRows(decoded.View());
+    const auto upright = ApplyOrientation(decoded.View(), 6);
+    Image expected(141, 188);
+    ResizeArea(upright.View(), expected.View(), pool);
+    EXPECT_LE(MaxDifference(expected.View(), thumbnail.View()), 4);
+
+    std::filesystem::remove(path);
+}
+
+#endif
@@ -0,0 +1,137 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "SourceImage.h"
+#include "Test.h"
+#include "TestImages.h"
+#include <fstream>
+
+#ifdef PHOTOENGINE_HAS_JPEG
+#include "JpegFile.h"
+#include "MappedFile.h"
+#include <thread>
+#include <vector>
+#endif
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+TEST(SourceImageTests, UnsupportedFilesThrow)
+{
+    const auto path = std::filesystem::temp_directory_path() / "PhotoEngineSourceTest.txt";
+    std::ofstream(path, std::ios::binary) << "not an image";
+    EXPECT_THROW(DecodeSourceImage(path), std::runtime_error);
+    EXPECT_THROW(GetSourceImageCache().Load(path), std::runtime_error);
+    std::filesystem::remove(path);
+    EXPECT_THROW(DecodeSourceImage(path), std::runtime_error);
+}
+
+#ifdef PHOTOENGINE_HAS_JPEG
+
+TEST(SourceImageTests, MappedDecodeMatchesFileDecode)
+{
+    const auto path = (std::filesystem::temp_directory_path() / "PhotoEngineSourceTest.jpg").string();
+    {
+        auto image = MakeNoiseImage(321, 203);
+        JpegRowWriter writer(path, image.Width(), image.Height(), 90);
+        writer.WriteRows(image.View());
+    }
+
+    {
+        MappedFile file(path, MappedFileAccess::Sequential);
+        file.Prefetch(100, 1000);
+        for (uint32_t scale : { 1u, 4u })
+        {
+            JpegRowReader fromFile(path, scale);
+            JpegRowReader fromMemory(file.Data(), file.Size(), scale);
+            EXPECT_EQ(fromMemory.Width(), fromFile.Width());
+            EXPECT_EQ(fromMemory.Height(), fromFile.Height());
+
+            Image a(fromFile.Width(), fromFile.Height());
+            Image b(fromMemory.Width(), fromMemory.Height());
+            fromFile.ReadRows(a.View());
+            fromMemory.ReadRows(b.View());
+            EXPECT_EQ(MaxDifference(a.View(), b.View()), 0);
+        }
+
+        auto decoded = DecodeSourceImage(path);
+        EXPECT_EQ(decoded.Width(), 321u);
+        EXPECT_EQ(decoded.Height(), 203u);
+
+        // A truncated file fails cleanly.
+        EXPECT_THROW(DecodeJpeg(file.Data(), 100), std::runtime_error);
+
+        // A file cut off inside its scan data still decodes, with a warning to tell it
+        // from a good one; the complete file has none.
+        JpegRowReader complete(file.Data(), file.Size());
+        JpegRowReader damaged(file.Data(), file.Size() * 2 / 3);
+        Image rows(321, 203);
+        complete.ReadRows(rows.View());
+        damaged.ReadRows(rows.View());
+        EXPECT_TRUE(complete.Warning().empty());
+        EXPECT_TRUE(!damaged.Warning().empty());
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(SourceImageTests, ConcurrentUsersShareOneDecode)
+{
+    const auto path = std::filesystem::temp_directory_path() / "PhotoEngineSharedSourceTest.jpg";
+    {
+        auto image = MakeNoiseImage(640, 480);
+        JpegRowWriter writer(path.string(), image.Width(), image.Height(), 90);
+        writer.WriteRows(image.View());
+    }
+
+    SourceImageCache cache;
+    std::vector<std::shared_ptr<const Image>> images(4);
+    {
+        std::vector<std::thread> users;
+        for (auto& image : images)
+        {
+            users.emplace_back([&] { image = cache.Load(path); });
+        }
+        for (auto& user : users)
+        {
+            user.join();
+        }
+    }
+
+    for (auto&& image : images)
+    {
+        EXPECT_TRUE(image == images[0]);
+    }
+    auto statistics = cache.Statistics();
+    EXPECT_EQ(statistics.Decodes, 1u);
+    EXPECT_EQ(statistics.Shared + statistics.Coalesced, 3u);
+
+    // Once nobody holds the image it is gone, and the next user decodes it again.
+    images.clear();
+    auto image = cache.Load(path);
+    EXPECT_EQ(image->Width(), 640u);
+    EXPECT_EQ(cache.Statistics().Decodes, 2u);
+    std::filesystem::remove(path);
+}
+
+#endif
@@ -0,0 +1,108 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal test registration and assertion macros for the engine tests, so the
+// tests build anywhere the engine does without an external test framework.
+
+namespace PhotoEngine::Testing
+{
+    struct TestCase
+    {
+        const char* Suite;
+        const char* Name;
+        void (*Body)();
+    };
+
+    std::vector<TestCase>& Registry();
+
+    struct Registrar
+    {
+        Registrar(const char* suite, const char* name, void (*body)())
+        {
+            Registry().push_back({ suite, name, body });
+        }
+    };
+
+    // Records a failed expectation for the running test.
+    void ReportFailure(const char* file, int line, std::string const& message);
+}
+
+#define TEST(suite, name) \
+    static void suite##_##name(); \
+    static ::PhotoEngine::Testing::Registrar suite##_##name##_registrar(#suite, #name, &suite##_##name); \
+    static void suite##_##name()
+
+#define PHOTOENGINE_EXPECT(condition, text) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            ::PhotoEngine::Testing::ReportFailure(__FILE__, __LINE__, text); \
+        } \
+    } while (false)
+
+#define PHOTOENGINE_EXPECT_COMPARE(a, op, b) \
+    do \
+    { \
+        const auto& actual_ = (a); \
+        const auto& expected_ = (b); \
+        if (!(actual_ op expected_)) \
+        { \
+            std::ostringstream message_; \
+            message_ << #a " " #op " " #b " (" << actual_ << " vs " << expected_ << ")"; \
+            ::PhotoEngine::Testing::ReportFailure(__FILE__, __LINE__, message_.str()); \
+        } \
+    } while (false)
+
+#define EXPECT_TRUE(condition) PHOTOENGINE_EXPECT(condition, #condition)
+#define EXPECT_FALSE(condition) PHOTOENGINE_EXPECT(!(condition), "!(" #condition ")")
+#define EXPECT_EQ(a, b) PHOTOENGINE_EXPECT_COMPARE(a, ==, b)
+#define EXPECT_NE(a, b) PHOTOENGINE_EXPECT_COMPARE(a, !=, b)
+#define EXPECT_LT(a, b) PHOTOENGINE_EXPECT_COMPARE(a, <, b)
+#define EXPECT_LE(a, b) PHOTOENGINE_EXPECT_COMPARE(a, <=, b)
+#define EXPECT_GT(a, b) PHOTOENGINE_EXPECT_COMPARE(a, >, b)
+#define EXPECT_GE(a, b) PHOTOENGINE_EXPECT_COMPARE(a, >=, b)
+#define EXPECT_NEAR(a, b, tolerance) PHOTOENGINE_EXPECT(std::fabs((a) - (b)) <= (tolerance), #a " near " #b)
+
+#define EXPECT_THROW(statement, exception) \
+    do \
+    { \
+        bool thrown_ = false; \
+        try \
+        { \
+            statement; \
+        } \
+        catch (exception const&) \
+        { \
+            thrown_ = true; \
+        } \
+        PHOTOENGINE_EXPECT(thrown_, #statement " throws " #exception); \
+    } while (false)
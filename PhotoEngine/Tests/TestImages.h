@@ -0,0 +1,65 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Image.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+namespace PhotoEngine::Testing
+{
+    // Returns an image filled with reproducible random bytes.
+    inline Image MakeNoiseImage(uint32_t width, uint32_t height, uint32_t seed = 1)
+    {
+        Image image(width, height);
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<int> channel(0, 255);
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t* row = image.View().Row(y);
+            for (size_t i = 0; i < image.Stride(); i++)
+            {
+                row[i] = static_cast<uint8_t>(channel(random));
+            }
+        }
+        return image;
+    }
+
+    // Returns the largest per-channel difference between two images of the same size.
+    inline int MaxDifference(ConstImageView a, ConstImageView b)
+    {
+        int result = 0;
+        for (uint32_t y = 0; y < a.Height; y++)
+        {
+            for (size_t i = 0; i < a.Width * BytesPerPixel; i++)
+            {
+                result = std::max(result, std::abs(a.Row(y)[i] - b.Row(y)[i]));
+            }
+        }
+        return result;
+    }
+}
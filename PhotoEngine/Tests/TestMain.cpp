@@ -0,0 +1,86 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "Test.h"
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+namespace PhotoEngine::Testing
+{
+    namespace
+    {
+        int s_failures = 0;
+    }
+
+    std::vector<TestCase>& Registry()
+    {
+        static std::vector<TestCase> tests;
+        return tests;
+    }
+
+    void ReportFailure(const char* file, int line, std::string const& message)
+    {
+        std::cerr << file << "(" << line << "): expectation failed: " << message << std::endl;
+        s_failures++;
+    }
+}
+
+// Runs every registered test, or only the tests whose "Suite.Name" contains the
+// first command line argument. Returns non-zero if any expectation failed.
+int main(int argc, char** argv)
+{
+    using namespace PhotoEngine::Testing;
+
+    const char* filter = argc > 1 ? argv[1] : "";
+    int failedTests = 0;
+    int ranTests = 0;
+
+    for (auto&& test : Registry())
+    {
+        const std::string name = std::string(test.Suite) + "." + test.Name;
+        if (name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        const int failuresBefore = s_failures;
+        try
+        {
+            test.Body();
+        }
+        catch (std::exception const& e)
+        {
+            ReportFailure(name.c_str(), 0, std::string("unexpected exception: ") + e.what());
+        }
+
+        const bool passed = s_failures == failuresBefore;
+        std::cout << (passed ? "[  PASSED  ] " : "[  FAILED  ] ") << name << std::endl;
+        failedTests += passed ? 0 : 1;
+        ranTests++;
+    }
+
+    std::cout << ranTests - failedTests << " of " << ranTests << " tests passed." << std::endl;
+    return failedTests == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ThumbnailCache.h"
+#include "Test.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace PhotoEngine;
+
+TEST(ThumbnailCacheTests, ClockEvictsUnreferencedThumbnailsFirst)
+{
+    // Each 4 x 4 thumbnail is 64 bytes.
+    ThumbnailCache cache(3 * 64);
+    size_t loads = 0;
+    auto load = [&] { loads++; return Image(4, 4); };
+
+    cache.Get("a", load);
+    cache.Get("b", load);
+    cache.Get("c", load);
+    EXPECT_TRUE(cache.Get("a", load) != nullptr);
+    EXPECT_EQ(loads, size_t{ 3 });
+
+    // "a" was read, so the hand passes it and evicts "b".
+    cache.Get("d", load);
+    EXPECT_TRUE(cache.Find("a") != nullptr);
+    EXPECT_TRUE(cache.Find("b") == nullptr);
+    EXPECT_TRUE(cache.Find("c") != nullptr);
+    EXPECT_TRUE(cache.Find("d") != nullptr);
+
+    auto statistics = cache.Statistics();
+    EXPECT_EQ(statistics.Hits, size_t{ 4 });
+    EXPECT_EQ(statistics.Misses, size_t{ 4 });
+    EXPECT_EQ(statistics.Evictions, size_t{ 1 });
+    EXPECT_EQ(statistics.Count, size_t{ 3 });
+    EXPECT_EQ(statistics.Bytes, size_t{ 3 * 64 });
+
+    // A thumbnail larger than the budget is returned but not kept.
+    auto large = cache.Get("large", [] { return Image(16, 16); });
+    EXPECT_EQ(large->Width(), 16u);
+    EXPECT_TRUE(cache.Find("large") == nullptr);
+    EXPECT_EQ(cache.Statistics().Count, size_t{ 3 });
+
+    EXPECT_TRUE(cache.Remove("c"));
+    EXPECT_FALSE(cache.Remove("c"));
+    cache.Budget(64);
+    EXPECT_EQ(cache.Statistics().Count, size_t{ 1 });
+    EXPECT_EQ(cache.Statistics().Bytes, size_t{ 64 });
+}
+
+TEST(ThumbnailCacheTests, ConcurrentRequestsLoadOnce)
+{
+    ThumbnailCache cache;
+    std::atomic<int> loads{ 0 };
+    auto load = [&]
+    {
+        loads++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return Image(8, 8);
+    };
+
+    std::vector<std::shared_ptr<const Image>> results(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        threads.emplace_back([&, i] { results[i] = cache.Get("photo", load); });
+    }
+    for (auto&& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(loads.load(), 1);
+    for (auto&& result : results)
+    {
+        EXPECT_TRUE(result == results[0]);
+    }
+
+    auto statistics = cache.Statistics();
+    EXPECT_EQ(statistics.Misses, size_t{ 1 });
+    EXPECT_EQ(statistics.Hits + statistics.Coalesced, size_t{ 3 });
+}
+
+TEST(ThumbnailCacheTests, FailedLoadsAreNotCached)
+{
+    ThumbnailCache cache;
+    EXPECT_THROW(cache.Get("photo", []() -> Image { throw std::runtime_error("corrupt"); }), std::runtime_error);
+    EXPECT_TRUE(cache.Find("photo") == nullptr);
+
+    auto thumbnail = cache.Get("photo", [] { return Image(2, 2); });
+    EXPECT_EQ(thumbnail->Width(), 2u);
+    EXPECT_EQ(cache.Statistics().Misses, size_t{ 2 });
+}
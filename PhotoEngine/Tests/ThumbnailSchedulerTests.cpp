@@ -0,0 +1,187 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ThumbnailScheduler.h"
+#include "Test.h"
+#include <algorithm>
+#include <future>
+#include <set>
+
+using namespace PhotoEngine;
+
+namespace
+{
+    // Holds the scheduler's only worker until Open is called.
+    class Gate
+    {
+    public:
+        ThumbnailScheduler::Load Load()
+        {
+            return [this](std::atomic<bool> const&) { m_entered.set_value(); m_opened.get_future().wait(); };
+        }
+
+        void WaitUntilEntered()
+        {
+            m_entered.get_future().wait();
+        }
+
+        void Open()
+        {
+            m_opened.set_value();
+        }
+
+    private:
+        std::promise<void> m_entered;
+        std::promise<void> m_opened;
+    };
+}
+
+TEST(ThumbnailSchedulerTests, NearestItemsLoadFirst)
+{
+    ThumbnailSchedulerOptions options;
+    options.MaxConcurrentLoads = 1;
+    ThumbnailScheduler scheduler(options);
+    scheduler.Viewport(20, 5, 100);
+
+    Gate gate;
+    scheduler.Request(0, gate.Load());
+    gate.WaitUntilEntered();
+
+    std::mutex mutex;
+    std::vector<size_t> order;
+    for (size_t index : { 40, 22, 10, 27, 18 })
+    {
+        scheduler.Request(index, [&, index](std::atomic<bool> const&)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(index);
+        });
+    }
+
+    // Visible first; then ahead of the scroll before the same distance behind.
+    gate.Open();
+    scheduler.WaitIdle();
+    EXPECT_TRUE((order == std::vector<size_t>{ 22, 27, 18, 40, 10 }));
+
+    // Scrolling back turns the order around.
+    Gate secondGate;
+    scheduler.Request(0, secondGate.Load());
+    secondGate.WaitUntilEntered();
+    order.clear();
+    scheduler.Viewport(15, 5, 100);
+    for (size_t index : { 24, 12 })
+    {
+        scheduler.Request(index, [&, index](std::atomic<bool> const&)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(index);
+        });
+    }
+    secondGate.Open();
+    scheduler.WaitIdle();
+    EXPECT_TRUE((order == std::vector<size_t>{ 12, 24 }));
+}
+
+TEST(ThumbnailSchedulerTests, CancelledRequestsDoNotRun)
+{
+    ThumbnailSchedulerOptions options;
+    options.MaxConcurrentLoads = 1;
+    ThumbnailScheduler scheduler(options);
+
+    std::promise<void> entered;
+    std::promise<void> cancelled;
+    const auto running = scheduler.Request(0, [&](std::atomic<bool> const& flag)
+    {
+        entered.set_value();
+        while (!flag.load())
+        {
+            std::this_thread::yield();
+        }
+        cancelled.set_value();
+    });
+    entered.get_future().wait();
+
+    bool ran = false;
+    const auto queued = scheduler.Request(1, [&](std::atomic<bool> const&) { ran = true; });
+    EXPECT_TRUE(scheduler.Cancel(queued));
+    EXPECT_TRUE(scheduler.Cancel(running));
+    cancelled.get_future().wait();
+    scheduler.WaitIdle();
+
+    EXPECT_FALSE(ran);
+    EXPECT_FALSE(scheduler.Cancel(queued));
+    auto statistics = scheduler.Statistics();
+    EXPECT_EQ(statistics.Started, size_t{ 1 });
+    EXPECT_EQ(statistics.CancelledQueued, size_t{ 1 });
+    EXPECT_EQ(statistics.CancelledRunning, size_t{ 1 });
+}
+
+TEST(ThumbnailSchedulerTests, PrefetchFollowsTheScrollDirection)
+{
+    std::mutex mutex;
+    std::set<size_t> loaded;
+    auto prefetch = [&](size_t index) -> ThumbnailScheduler::Load
+    {
+        return [&, index](std::atomic<bool> const&)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            loaded.insert(index);
+        };
+    };
+
+    ThumbnailSchedulerOptions options;
+    options.MaxConcurrentLoads = 1;
+    options.PrefetchItems = 5;
+    ThumbnailScheduler scheduler(options, prefetch);
+
+    scheduler.Viewport(0, 10, 1000);
+    scheduler.WaitIdle();
+    scheduler.Viewport(5, 10, 1000);
+    scheduler.WaitIdle();
+    EXPECT_TRUE((loaded == std::set<size_t>{ 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 }));
+
+    // Scrolling back prefetches above the visible range.
+    scheduler.Viewport(3, 10, 1000);
+    scheduler.WaitIdle();
+    EXPECT_EQ(loaded.size(), size_t{ 13 });
+    EXPECT_TRUE(loaded.count(0) == 1 && loaded.count(2) == 1);
+
+    // Prefetches still queued when a fling moves on are dropped.
+    Gate gate;
+    scheduler.Request(0, gate.Load());
+    gate.WaitUntilEntered();
+    loaded.clear();
+    scheduler.Viewport(100, 10, 1000);
+    scheduler.Viewport(500, 10, 1000);
+    gate.Open();
+    scheduler.WaitIdle();
+    EXPECT_TRUE((loaded == std::set<size_t>{ 510, 511, 512, 513, 514 }));
+    EXPECT_EQ(scheduler.Statistics().CancelledQueued, size_t{ 5 });
+
+    // The end of the list is not passed.
+    loaded.clear();
+    scheduler.Viewport(995, 10, 1000);
+    scheduler.WaitIdle();
+    EXPECT_TRUE(loaded.empty());
+}
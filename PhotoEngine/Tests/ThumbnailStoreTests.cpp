@@ -0,0 +1,226 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ThumbnailStore.h"
+#include "Test.h"
+#include "TestImages.h"
+#include <fstream>
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+namespace
+{
+    ThumbnailStoreOptions SmallOptions(size_t slots)
+    {
+        ThumbnailStoreOptions options;
+        options.MaxWidth = 32;
+        options.MaxHeight = 32;
+        options.MaxBytes = 4096 + slots * 8192;
+        return options;
+    }
+
+    std::string PhotoPath(int i)
+    {
+        return "/photos/IMG_" + std::to_string(i) + ".jpg";
+    }
+}
+
+TEST(ThumbnailStoreTests, ThumbnailsPersistAcrossReopen)
+{
+    const auto path = std::filesystem::temp_directory_path() / "PhotoEngineThumbnailStoreTest.pack";
+    std::filesystem::remove(path);
+
+    std::vector<Image> thumbnails;
+    {
+        ThumbnailStore store(path, SmallOptions(16));
+        EXPECT_EQ(store.SlotBytes(), size_t{ 8192 });
+        EXPECT_EQ(store.Capacity(), size_t{ 16 });
+
+        for (int i = 0; i < 5; i++)
+        {
+            thumbnails.push_back(MakeNoiseImage(20 + i, 32 - i, i));
+            store.Add(PhotoPath(i), 100 + i, 500 + i, thumbnails.back().View());
+        }
+        EXPECT_THROW(store.Add(PhotoPath(9), 0, 0, MakeNoiseImage(33, 8, 1).View()), std::invalid_argument);
+
+        auto found = store.Find(PhotoPath(2), 102, 502);
+        EXPECT_TRUE(static_cast<bool>(found));
+        EXPECT_EQ(MaxDifference(found.View(), thumbnails[2].View()), 0);
+
+        // A changed file is a miss.
+        EXPECT_FALSE(static_cast<bool>(store.Find(PhotoPath(2), 103, 502)));
+        EXPECT_FALSE(static_cast<bool>(store.Find(PhotoPath(2), 102, 501)));
+        EXPECT_FALSE(static_cast<bool>(store.Find(PhotoPath(7), 0, 0)));
+
+        // Replacing a thumbnail reuses its slot.
+        thumbnails[3] = MakeNoiseImage(16, 16, 33);
+        store.Add(PhotoPath(3), 203, 603, thumbnails[3].View());
+        EXPECT_EQ(store.Count(), size_t{ 5 });
+
+        EXPECT_TRUE(store.Remove(PhotoPath(4)));
+        EXPECT_FALSE(store.Remove(PhotoPath(4)));
+
+        auto statistics = store.Statistics();
+        EXPECT_EQ(statistics.Hits, size_t{ 1 });
+        EXPECT_EQ(statistics.Misses, size_t{ 3 });
+        EXPECT_EQ(statistics.Adds, size_t{ 6 });
+    }
+
+    {
+        ThumbnailStore store(path, SmallOptions(16));
+        EXPECT_EQ(store.Count(), size_t{ 4 });
+        EXPECT_FALSE(static_cast<bool>(store.Find(PhotoPath(4), 104, 504)));
+        EXPECT_FALSE(static_cast<bool>(store.Find(PhotoPath(3), 103, 503)));
+        for (int i = 0; i < 4; i++)
+        {
+            auto found = i == 3 ? store.Find(PhotoPath(3), 203, 603) : store.Find(PhotoPath(i), 100 + i, 500 + i);
+            EXPECT_TRUE(static_cast<bool>(found));
+            EXPECT_EQ(MaxDifference(found.View(), thumbnails[i].View()), 0);
+        }
+    }
+
+    // Other slot dimensions start an empty pack.
+    {
+        auto options = SmallOptions(16);
+        options.MaxWidth = 16;
+        ThumbnailStore store(path, options);
+        EXPECT_EQ(store.Count(), size_t{ 0 });
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST(ThumbnailStoreTests, TornSlotsReadAsFree)
+{
+    const auto path = std::filesystem::temp_directory_path() / "PhotoEngineThumbnailTornTest.pack";
+    std::filesystem::remove(path);
+
+    const auto thumbnail = MakeNoiseImage(32, 24, 5);
+    {
+        ThumbnailStore store(path, SmallOptions(8));
+        for (int i = 0; i < 3; i++)
+        {
+            store.Add(PhotoPath(i), 1, 1, thumbnail.View());
+        }
+    }
+
+    // Damage the header of the second slot, as if the process died while writing it.
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(4096 + 8192 + 20);
+        file.put('x');
+    }
+
+    ThumbnailStore store(path, SmallOptions(8));
+    EXPECT_EQ(store.Count(), size_t{ 2 });
+    EXPECT_TRUE(static_cast<bool>(store.Find(PhotoPath(0), 1, 1)));
+    EXPECT_FALSE(static_cast<bool>(store.Find(PhotoPath(1), 1, 1)));
+    EXPECT_TRUE(static_cast<bool>(store.Find(PhotoPath(2), 1, 1)));
+
+    // The freed slot is reused.
+    store.Add(PhotoPath(1), 1, 1, thumbnail.View());
+    EXPECT_EQ(store.Count(), size_t{ 3 });
+    EXPECT_EQ(MaxDifference(store.Find(PhotoPath(1), 1, 1).View(), thumbnail.View()), 0);
+
+    std::filesystem::remove(path);
+}
+
+TEST(ThumbnailStoreTests, LeastRecentlyUsedIsEvictedAndCompactShrinks)
+{
+    const auto path = std::filesystem::temp_directory_path() / "PhotoEngineThumbnailEvictTest.pack";
+    std::filesystem::remove(path);
+
+    std::vector<Image> thumbnails;
+    {
+        ThumbnailStore store(path, SmallOptions(4));
+        for (int i = 0; i < 4; i++)
+        {
+            thumbnails.push_back(MakeNoiseImage(32, 32, i));
+            store.Add(PhotoPath(i), 1, 1, thumbnails.back().View());
+        }
+        EXPECT_EQ(store.FileBytes(), uint64_t{ 4096 + 4 * 8192 });
+
+        // Touch the first thumbnail so the second is the least recently used.
+        EXPECT_TRUE(static_cast<bool>(store.Find(PhotoPath(0), 1, 1)));
+        thumbnails.push_back(MakeNoiseImage(32, 32, 4));
+        store.Add(PhotoPath(4), 1, 1, thumbnails.back().View());
+
+        EXPECT_EQ(store.Count(), size_t{ 4 });
+        EXPECT_EQ(store.Statistics().Evictions, size_t{ 1 });
+        EXPECT_EQ(store.FileBytes(), uint64_t{ 4096 + 4 * 8192 });
+        EXPECT_FALSE(static_cast<bool>(store.Find(PhotoPath(1), 1, 1)));
+
+        EXPECT_TRUE(store.Remove(PhotoPath(0)));
+        EXPECT_TRUE(store.Remove(PhotoPath(3)));
+        store.Compact();
+        EXPECT_EQ(store.FileBytes(), uint64_t{ 4096 + 2 * 8192 });
+        EXPECT_EQ(store.Count(), size_t{ 2 });
+        EXPECT_EQ(MaxDifference(store.Find(PhotoPath(2), 1, 1).View(), thumbnails[2].View()), 0);
+        EXPECT_EQ(MaxDifference(store.Find(PhotoPath(4), 1, 1).View(), thumbnails[4].View()), 0);
+
+        // The compacted pack grows again when thumbnails are added.
+        store.Add(PhotoPath(5), 1, 1, thumbnails[0].View());
+        EXPECT_EQ(store.Count(), size_t{ 3 });
+    }
+
+    // A smaller cap keeps the most recently used thumbnails.
+    ThumbnailStore store(path, SmallOptions(2));
+    EXPECT_EQ(store.Count(), size_t{ 2 });
+    EXPECT_EQ(store.FileBytes(), uint64_t{ 4096 + 2 * 8192 });
+    EXPECT_TRUE(static_cast<bool>(store.Find(PhotoPath(5), 1, 1)));
+    EXPECT_FALSE(static_cast<bool>(store.Find(PhotoPath(2), 1, 1)));
+
+    std::filesystem::remove(path);
+}
+
+TEST(ThumbnailStoreTests, SlotsKeepTheirPaths)
+{
+    const auto path = std::filesystem::temp_directory_path() / "PhotoEngineThumbnailPathTest.pack";
+    std::filesystem::remove(path);
+
+    const auto thumbnail = MakeNoiseImage(32, 24, 6);
+    const std::string longest = "/photos/" + std::string(1024 - 12, 'x') + ".jpg";
+    {
+        ThumbnailStore store(path, SmallOptions(8));
+        store.Add(PhotoPath(0), 1, 1, thumbnail.View());
+        store.Add(longest, 1, 1, thumbnail.View());
+        EXPECT_THROW(store.Add(longest + "x", 1, 1, thumbnail.View()), std::invalid_argument);
+        EXPECT_THROW(store.Add("", 1, 1, thumbnail.View()), std::invalid_argument);
+    }
+
+    // A damaged path no longer matches the hash in the slot header, so the slot is free.
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(4096 + 64 + 3);
+        file.put('X');
+    }
+
+    ThumbnailStore store(path, SmallOptions(8));
+    EXPECT_EQ(store.Count(), size_t{ 1 });
+    EXPECT_FALSE(static_cast<bool>(store.Find(PhotoPath(0), 1, 1)));
+    EXPECT_EQ(MaxDifference(store.Find(longest, 1, 1).View(), thumbnail.View()), 0);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,155 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "Renderer.h"
+#include "Test.h"
+#include "TestImages.h"
+#include "TiledImage.h"
+#include "TiledRenderer.h"
+#include <filesystem>
+
+using namespace PhotoEngine;
+using namespace PhotoEngine::Testing;
+
+namespace
+{
+    // Copies an image into a tiled image through the row writer, a few rows at a time.
+    void WriteInRows(ConstImageView source, TiledImage& image, uint32_t rowsPerWrite)
+    {
+        TiledImageRowWriter writer(image);
+        for (uint32_t top = 0; top < source.Height; top += rowsPerWrite)
+        {
+            writer.WriteRows(source.Rows(top, std::min(rowsPerWrite, source.Height - top)));
+        }
+    }
+
+    Image ReadWhole(TiledImage const& image)
+    {
+        Image result(image.Width(), image.Height());
+        TiledImageRowReader reader(image);
+        reader.ReadRows(result.View());
+        return result;
+    }
+}
+
+TEST(TiledImageTests, StoresPixelsInMemoryAndInAScratchFile)
+{
+    auto source = MakeNoiseImage(150, 97);
+    const auto directory = std::filesystem::temp_directory_path();
+
+    for (bool fileBacked : { false, true })
+    {
+        TiledImageOptions options;
+        options.TileSize = 32;
+        options.ScratchDirectory = fileBacked ? directory : std::filesystem::path();
+        TiledImage image(150, 97, options);
+        EXPECT_EQ(image.IsFileBacked(), fileBacked);
+        EXPECT_EQ(image.TileColumns(), 5u);
+        EXPECT_EQ(image.TileRows(), 4u);
+        EXPECT_EQ(image.Tile(4, 3).Width, 22u);
+        EXPECT_EQ(image.Tile(4, 3).Height, 1u);
+
+        // Released tiles come back from the scratch file when they are read again.
+        WriteInRows(source.View(), image, 7);
+        EXPECT_EQ(MaxDifference(source.View(), ReadWhole(image).View()), 0);
+
+        Image region(70, 40);
+        image.ReadRegion(20, 50, region.View());
+        EXPECT_EQ(MaxDifference(source.View().Region(20, 50, 70, 40), region.View()), 0);
+
+        EXPECT_THROW(image.ReadRegion(100, 50, region.View()), std::out_of_range);
+        EXPECT_THROW(image.Tile(5, 0), std::out_of_range);
+    }
+
+    TiledImageOptions options;
+    options.TileSize = 48;
+    EXPECT_THROW(TiledImage(10, 10, options), std::invalid_argument);
+    options.TileSize = 32;
+    options.ScratchDirectory = directory / "PhotoEngineTests-missing";
+    EXPECT_THROW(TiledImage(10, 10, options), std::runtime_error);
+}
+
+TEST(TiledImageTests, TiledRenderMatchesFullFrameRender)
+{
+    ThreadPool pool(3);
+    auto chain = EffectChain::FromSelection({ "light", "blur", "sepia" });
+    auto source = MakeNoiseImage(181, 133);
+
+    TiledImageOptions options;
+    options.TileSize = 64;
+    TiledImage tiledSource(181, 133, options);
+    WriteInRows(source.View(), tiledSource, 133);
+
+    for (float blurAmount : { 0.0f, 1.5f, 6.0f })
+    {
+        EffectParameters params;
+        params.Exposure = 0.3f;
+        params.Contrast = 0.2f;
+        params.BlurAmount = blurAmount;
+        params.Intensity = 0.7f;
+
+        Image expected(181, 133);
+        Renderer(pool).Render(chain, params, source.View(), expected.View());
+
+        // The destination may use other tiles than the source.
+        options.TileSize = blurAmount > 2.0f ? 32 : 64;
+        options.ScratchDirectory = std::filesystem::temp_directory_path();
+        TiledImage rendered(181, 133, options);
+        TiledRenderer renderer(pool);
+        renderer.Render(chain, params, tiledSource, rendered);
+
+        // The direct kernel sees identical neighbors; the recursive filter's response past
+        // the halo is cut off, across tile columns as well as rows.
+        EXPECT_LE(MaxDifference(expected.View(), ReadWhole(rendered).View()), blurAmount > 2.0f ? 2 : 0);
+        EXPECT_EQ(renderer.Statistics().Tiles, rendered.TileColumns() * rendered.TileRows());
+    }
+
+    EXPECT_THROW(TiledRenderer(pool).Render(chain, {}, tiledSource, tiledSource), std::invalid_argument);
+}
+
+TEST(TiledImageTests, PeakMemoryDoesNotGrowWithImageSize)
+{
+    ThreadPool pool(2);
+    auto chain = EffectChain::FromSelection({ "blur", "invert" });
+    EffectParameters params;
+    params.BlurAmount = 2.0f;
+
+    TiledImageOptions options;
+    options.TileSize = 32;
+    options.ScratchDirectory = std::filesystem::temp_directory_path();
+
+    // At most one tile per thread is in hand, with its halo, as input and output.
+    for (uint32_t size : { 200u, 600u })
+    {
+        TiledImage source(size, size, options);
+        TiledImage rendered(size, size, options);
+        TiledRenderer renderer(pool);
+        renderer.Render(chain, params, source, rendered);
+
+        const size_t side = 32 + 2 * renderer.Statistics().Halo;
+        EXPECT_GT(renderer.Statistics().Halo, 0u);
+        EXPECT_GT(renderer.Statistics().PeakBufferBytes, 0u);
+        EXPECT_LE(renderer.Statistics().PeakBufferBytes, pool.ThreadCount() * 2 * side * side * BytesPerPixel);
+    }
+}
@@ -0,0 +1,116 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "WorkStealingScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+using namespace PhotoEngine;
+
+TEST(WorkStealingSchedulerTests, RunsEveryTaskIncludingNestedOnes)
+{
+    WorkStealingScheduler scheduler(4);
+    std::atomic<int> count{ 0 };
+    std::atomic<bool> workerIndicesValid{ true };
+
+    for (int i = 0; i < 100; i++)
+    {
+        scheduler.Submit([&]
+        {
+            const int worker = scheduler.CurrentWorker();
+            if (worker < 0 || worker >= static_cast<int>(scheduler.ThreadCount()))
+            {
+                workerIndicesValid = false;
+            }
+            count++;
+
+            for (int j = 0; j < 2; j++)
+            {
+                scheduler.Submit([&] { count++; });
+            }
+        });
+    }
+    scheduler.Wait();
+
+    EXPECT_EQ(count.load(), 300);
+    EXPECT_TRUE(workerIndicesValid.load());
+    EXPECT_EQ(scheduler.CurrentWorker(), -1);
+
+    // The scheduler can be reused after Wait.
+    scheduler.Submit([&] { count++; });
+    scheduler.Wait();
+    EXPECT_EQ(count.load(), 301);
+}
+
+TEST(WorkStealingSchedulerTests, IdleWorkersStealQueuedTasks)
+{
+    WorkStealingScheduler scheduler(4);
+    std::mutex mutex;
+    std::set<int> workers;
+
+    // Every task lands on the queue of the worker that runs the first one.
+    scheduler.Submit([&]
+    {
+        for (int i = 0; i < 40; i++)
+        {
+            scheduler.Submit([&]
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                std::lock_guard<std::mutex> lock(mutex);
+                workers.insert(scheduler.CurrentWorker());
+            });
+        }
+    });
+    scheduler.Wait();
+
+    EXPECT_GT(workers.size(), 1u);
+    EXPECT_GT(scheduler.Steals(), 0u);
+}
+
+TEST(WorkStealingSchedulerTests, WaitRethrowsTheFirstException)
+{
+    WorkStealingScheduler scheduler(2);
+    std::atomic<int> count{ 0 };
+    for (int i = 0; i < 10; i++)
+    {
+        scheduler.Submit([&, i]
+        {
+            count++;
+            if (i == 3)
+            {
+                throw std::runtime_error("task failed");
+            }
+        });
+    }
+
+    EXPECT_THROW(scheduler.Wait(), std::runtime_error);
+    EXPECT_EQ(count.load(), 10);
+
+    // The error is reported once.
+    scheduler.Wait();
+}
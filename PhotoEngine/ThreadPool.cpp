@@ -0,0 +1,188 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Shared between the caller of ParallelFor and the helper tasks it queues. Helpers
+        // can start after ParallelFor has returned, so the state is reference counted.
+        struct ParallelForState
+        {
+            std::function<void(size_t, size_t)> const* Body{ nullptr };
+            size_t Begin{ 0 };
+            size_t End{ 0 };
+            size_t BandSize{ 0 };
+            size_t BandCount{ 0 };
+            std::atomic<size_t> NextBand{ 0 };
+
+            std::mutex Mutex;
+            std::condition_variable Finished;
+            size_t CompletedBands{ 0 };
+            std::exception_ptr Error;
+
+            // Runs bands until none are left.
+            void RunBands()
+            {
+                for (size_t band = NextBand++; band < BandCount; band = NextBand++)
+                {
+                    const size_t bandBegin = Begin + band * BandSize;
+                    const size_t bandEnd = std::min(End, bandBegin + BandSize);
+
+                    std::exception_ptr error;
+                    try
+                    {
+                        (*Body)(bandBegin, bandEnd);
+                    }
+                    catch (...)
+                    {
+                        error = std::current_exception();
+                    }
+
+                    std::lock_guard<std::mutex> lock(Mutex);
+                    if (error && !Error)
+                    {
+                        Error = error;
+                    }
+                    if (++CompletedBands == BandCount)
+                    {
+                        Finished.notify_all();
+                    }
+                }
+            }
+        };
+    }
+
+    ThreadPool::ThreadPool(unsigned threadCount)
+    {
+        const unsigned workerCount = std::max(threadCount, 1u) - 1;
+        m_workers.reserve(workerCount);
+        for (unsigned i = 0; i < workerCount; i++)
+        {
+            m_workers.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_taskAvailable.notify_all();
+
+        for (auto&& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::Submit(std::function<void()> task)
+    {
+        if (m_workers.empty())
+        {
+            task();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        m_taskAvailable.notify_one();
+    }
+
+    void ThreadPool::ParallelFor(size_t begin, size_t end, size_t minBandSize, std::function<void(size_t, size_t)> const& body)
+    {
+        if (end <= begin)
+        {
+            return;
+        }
+
+        const size_t count = end - begin;
+        minBandSize = std::max<size_t>(minBandSize, 1);
+
+        // A few bands per thread keeps threads busy when some bands finish early.
+        const size_t targetBands = static_cast<size_t>(ThreadCount()) * 4;
+        const size_t bandSize = std::max(minBandSize, (count + targetBands - 1) / targetBands);
+        const size_t bandCount = (count + bandSize - 1) / bandSize;
+
+        if (bandCount == 1 || m_workers.empty())
+        {
+            body(begin, end);
+            return;
+        }
+
+        auto state = std::make_shared<ParallelForState>();
+        state->Body = &body;
+        state->Begin = begin;
+        state->End = end;
+        state->BandSize = bandSize;
+        state->BandCount = bandCount;
+
+        const size_t helpers = std::min(bandCount - 1, m_workers.size());
+        for (size_t i = 0; i < helpers; i++)
+        {
+            Submit([state] { state->RunBands(); });
+        }
+
+        state->RunBands();
+
+        std::unique_lock<std::mutex> lock(state->Mutex);
+        state->Finished.wait(lock, [&] { return state->CompletedBands == state->BandCount; });
+
+        if (state->Error)
+        {
+            std::rethrow_exception(state->Error);
+        }
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_taskAvailable.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+
+                if (m_tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+
+            task();
+        }
+    }
+}
@@ -0,0 +1,72 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PhotoEngine
+{
+    // Fixed set of worker threads that run submitted tasks in FIFO order.
+    class ThreadPool
+    {
+    public:
+        // Creates a pool that runs work on threadCount threads in total. The thread
+        // calling ParallelFor counts as one of them, so threadCount - 1 workers are started.
+        explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        ThreadPool(ThreadPool const&) = delete;
+        ThreadPool& operator=(ThreadPool const&) = delete;
+
+        // Number of threads that take part in ParallelFor, including the caller.
+        unsigned ThreadCount() const
+        {
+            return static_cast<unsigned>(m_workers.size()) + 1;
+        }
+
+        // Queues a task to run on a worker thread.
+        void Submit(std::function<void()> task);
+
+        // Splits [begin, end) into contiguous bands of at least minBandSize items and runs
+        // body(bandBegin, bandEnd) for each band, blocking until all bands have finished.
+        // The calling thread runs bands too. The first exception thrown by body is rethrown.
+        void ParallelFor(size_t begin, size_t end, size_t minBandSize, std::function<void(size_t, size_t)> const& body);
+
+    private:
+        void WorkerLoop();
+
+        std::vector<std::thread> m_workers;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_taskAvailable;
+        bool m_stopping{ false };
+    };
+}
@@ -0,0 +1,203 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ThumbnailCache.h"
+
+namespace PhotoEngine
+{
+    std::shared_ptr<const Image> ThumbnailCache::Get(std::string const& key, Loader const& load)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (auto found = m_index.find(key); found != m_index.end())
+        {
+            auto& entry = m_slots[found->second];
+            entry.Referenced = true;
+            m_statistics.Hits++;
+            return entry.Thumbnail;
+        }
+
+        if (auto loading = m_loading.find(key); loading != m_loading.end())
+        {
+            auto result = loading->second;
+            m_statistics.Coalesced++;
+            lock.unlock();
+            return result.get();
+        }
+
+        std::promise<std::shared_ptr<const Image>> promise;
+        m_loading.emplace(key, promise.get_future().share());
+        m_statistics.Misses++;
+        lock.unlock();
+
+        std::shared_ptr<const Image> thumbnail;
+        try
+        {
+            thumbnail = std::make_shared<const Image>(load());
+        }
+        catch (...)
+        {
+            lock.lock();
+            m_loading.erase(key);
+            lock.unlock();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        lock.lock();
+        m_loading.erase(key);
+        Store(key, thumbnail);
+        lock.unlock();
+        promise.set_value(thumbnail);
+        return thumbnail;
+    }
+
+    std::shared_ptr<const Image> ThumbnailCache::Find(std::string const& key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_index.find(key);
+        if (found == m_index.end())
+        {
+            return nullptr;
+        }
+
+        auto& entry = m_slots[found->second];
+        entry.Referenced = true;
+        m_statistics.Hits++;
+        return entry.Thumbnail;
+    }
+
+    bool ThumbnailCache::Remove(std::string const& key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_index.find(key);
+        if (found == m_index.end())
+        {
+            return false;
+        }
+
+        Erase(found->second);
+        return true;
+    }
+
+    void ThumbnailCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_slots.clear();
+        m_freeSlots.clear();
+        m_index.clear();
+        m_hand = 0;
+        m_statistics.Count = 0;
+        m_statistics.Bytes = 0;
+    }
+
+    size_t ThumbnailCache::Budget() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_budget;
+    }
+
+    void ThumbnailCache::Budget(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_budget = bytes;
+        EvictTo(m_budget);
+    }
+
+    ThumbnailCacheStatistics ThumbnailCache::Statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    void ThumbnailCache::Store(std::string const& key, std::shared_ptr<const Image> thumbnail)
+    {
+        const size_t bytes = thumbnail->Stride() * thumbnail->Height();
+        if (bytes > m_budget)
+        {
+            return;
+        }
+
+        EvictTo(m_budget - bytes);
+
+        size_t slot = m_slots.size();
+        if (!m_freeSlots.empty())
+        {
+            slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        else
+        {
+            m_slots.emplace_back();
+        }
+
+        // New entries start unreferenced, so a thumbnail that is never read again is
+        // the first to go.
+        m_slots[slot] = { key, std::move(thumbnail), bytes, false };
+        m_index.emplace(key, slot);
+        m_statistics.Count++;
+        m_statistics.Bytes += bytes;
+    }
+
+    void ThumbnailCache::Erase(size_t slot)
+    {
+        auto& entry = m_slots[slot];
+        m_index.erase(entry.Key);
+        m_statistics.Count--;
+        m_statistics.Bytes -= entry.Bytes;
+        entry = {};
+        m_freeSlots.push_back(slot);
+    }
+
+    void ThumbnailCache::EvictTo(size_t bytes)
+    {
+        while (m_statistics.Bytes > bytes)
+        {
+            if (m_hand >= m_slots.size())
+            {
+                m_hand = 0;
+            }
+
+            const size_t slot = m_hand++;
+            auto& entry = m_slots[slot];
+            if (!entry.Thumbnail)
+            {
+                continue;
+            }
+            if (entry.Referenced)
+            {
+                entry.Referenced = false;
+                continue;
+            }
+
+            Erase(slot);
+            m_statistics.Evictions++;
+        }
+    }
+
+    ThumbnailCache& GetThumbnailCache()
+    {
+        static ThumbnailCache cache;
+        return cache;
+    }
+}
@@ -0,0 +1,122 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Image.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace PhotoEngine
+{
+    struct ThumbnailCacheStatistics
+    {
+        // Get calls answered from the cache.
+        size_t Hits{ 0 };
+
+        // Get calls that ran their loader.
+        size_t Misses{ 0 };
+
+        // Get calls that waited for another caller's load of the same key.
+        size_t Coalesced{ 0 };
+
+        // Thumbnails dropped to stay within the budget.
+        size_t Evictions{ 0 };
+
+        size_t Count{ 0 };
+        size_t Bytes{ 0 };
+    };
+
+    // Decoded thumbnails shared by everything that shows a photo, bounded by a byte
+    // budget. Eviction is CLOCK: a thumbnail read since the hand last passed it gets a
+    // second chance, which approximates LRU without reordering on every hit.
+    //
+    // Concurrent Get calls for a key that is not cached run the loader once; the other
+    // callers wait for its result. Keys should identify the version of the file, for
+    // example its path together with its last write time.
+    //
+    // All methods may be called from any thread.
+    class ThumbnailCache
+    {
+    public:
+        using Loader = std::function<Image()>;
+
+        explicit ThumbnailCache(size_t budgetBytes = 64 << 20) :
+            m_budget(budgetBytes)
+        {
+        }
+
+        // Returns the cached thumbnail for key, or loads, caches, and returns it. If the
+        // loader throws, the exception reaches every caller waiting on it and nothing is
+        // cached. A thumbnail larger than the whole budget is returned but not cached.
+        std::shared_ptr<const Image> Get(std::string const& key, Loader const& load);
+
+        // Returns the cached thumbnail for key, or nullptr without waiting for a load.
+        std::shared_ptr<const Image> Find(std::string const& key);
+
+        bool Remove(std::string const& key);
+
+        void Clear();
+
+        size_t Budget() const;
+
+        // Changes the budget, evicting thumbnails if the cache is now over it.
+        void Budget(size_t bytes);
+
+        ThumbnailCacheStatistics Statistics() const;
+
+    private:
+        struct Entry
+        {
+            std::string Key;
+            std::shared_ptr<const Image> Thumbnail;
+            size_t Bytes{ 0 };
+            bool Referenced{ false };
+        };
+
+        void Store(std::string const& key, std::shared_ptr<const Image> thumbnail);
+        void Erase(size_t slot);
+        void EvictTo(size_t bytes);
+
+        mutable std::mutex m_mutex;
+        size_t m_budget;
+
+        // The clock: entries in slots, with free slots reused before the vector grows.
+        std::vector<Entry> m_slots;
+        std::vector<size_t> m_freeSlots;
+        std::unordered_map<std::string, size_t> m_index;
+        size_t m_hand{ 0 };
+
+        std::unordered_map<std::string, std::shared_future<std::shared_ptr<const Image>>> m_loading;
+        ThumbnailCacheStatistics m_statistics;
+    };
+
+    // The process-wide thumbnail cache.
+    ThumbnailCache& GetThumbnailCache();
+}
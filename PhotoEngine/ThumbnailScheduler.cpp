@@ -0,0 +1,277 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ThumbnailScheduler.h"
+#include <algorithm>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Orders the heap so the lowest priority value, then the oldest ticket, is on top.
+        struct FartherFirst
+        {
+            template <typename Entry>
+            bool operator()(Entry const& a, Entry const& b) const
+            {
+                return a.Priority != b.Priority ? a.Priority > b.Priority : a.Ticket > b.Ticket;
+            }
+        };
+    }
+
+    ThumbnailScheduler::ThumbnailScheduler(ThumbnailSchedulerOptions const& options, PrefetchFactory prefetch) :
+        m_options(options),
+        m_prefetch(std::move(prefetch))
+    {
+        for (unsigned i = 0; i < std::max(m_options.MaxConcurrentLoads, 1u); i++)
+        {
+            m_workers.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    ThumbnailScheduler::~ThumbnailScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            for (auto&& [ticket, request] : m_requests)
+            {
+                request->Cancelled->store(true);
+            }
+        }
+        m_workAvailable.notify_all();
+
+        for (auto&& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    uint64_t ThumbnailScheduler::Request(size_t index, Load load)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // The container's request replaces a prefetch of the same item that has not started.
+        if (auto prefetch = m_prefetchTickets.find(index); prefetch != m_prefetchTickets.end())
+        {
+            auto& request = *m_requests.at(prefetch->second);
+            if (!request.Running)
+            {
+                CancelLocked(request);
+            }
+        }
+
+        const auto ticket = Enqueue(index, std::move(load), false);
+        m_workAvailable.notify_one();
+        return ticket;
+    }
+
+    bool ThumbnailScheduler::Cancel(uint64_t ticket)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_requests.find(ticket);
+        if (found == m_requests.end())
+        {
+            return false;
+        }
+
+        CancelLocked(*found->second);
+        return true;
+    }
+
+    void ThumbnailScheduler::Viewport(size_t first, size_t count, size_t itemCount)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (first != m_first)
+            {
+                m_scrollingBack = first < m_first;
+            }
+            m_first = first;
+            m_count = count;
+            m_itemCount = itemCount;
+
+            UpdatePrefetch();
+            Reprioritize();
+        }
+        m_workAvailable.notify_all();
+    }
+
+    void ThumbnailScheduler::WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_requests.empty(); });
+    }
+
+    ThumbnailSchedulerStatistics ThumbnailScheduler::Statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    uint64_t ThumbnailScheduler::Priority(size_t index) const
+    {
+        const size_t end = m_first + m_count;
+        if (index >= m_first && index < end)
+        {
+            return 0;
+        }
+
+        const bool ahead = m_scrollingBack ? index < m_first : index >= end;
+        const uint64_t distance = index < m_first ? m_first - index : index - end + 1;
+        return ahead ? distance : 2 * distance;
+    }
+
+    uint64_t ThumbnailScheduler::Enqueue(size_t index, Load load, bool prefetch)
+    {
+        auto request = std::make_shared<Pending>();
+        request->Ticket = m_nextTicket++;
+        request->Index = index;
+        request->Prefetch = prefetch;
+        request->Work = std::move(load);
+        request->Cancelled = std::make_shared<std::atomic<bool>>(false);
+
+        m_requests.emplace(request->Ticket, request);
+        m_queue.push_back({ Priority(index), request->Ticket, request });
+        std::push_heap(m_queue.begin(), m_queue.end(), FartherFirst());
+        return request->Ticket;
+    }
+
+    void ThumbnailScheduler::CancelLocked(Pending& request)
+    {
+        request.Cancelled->store(true);
+        if (auto prefetch = m_prefetchTickets.find(request.Index); prefetch != m_prefetchTickets.end() && prefetch->second == request.Ticket)
+        {
+            m_prefetchTickets.erase(prefetch);
+        }
+
+        if (request.Running)
+        {
+            m_statistics.CancelledRunning++;
+            return;
+        }
+
+        // The queue entry is dropped when it reaches the top.
+        m_statistics.CancelledQueued++;
+        m_requests.erase(request.Ticket);
+        if (m_requests.empty())
+        {
+            m_idle.notify_all();
+        }
+    }
+
+    void ThumbnailScheduler::UpdatePrefetch()
+    {
+        if (!m_prefetch)
+        {
+            return;
+        }
+
+        const size_t end = std::min(m_first + m_count, m_itemCount);
+        const size_t windowBegin = m_scrollingBack ? m_first - std::min(m_first, m_options.PrefetchItems) : end;
+        const size_t windowEnd = m_scrollingBack ? m_first : std::min(end + m_options.PrefetchItems, m_itemCount);
+        auto inWindow = [&](size_t index) { return index >= windowBegin && index < windowEnd; };
+
+        for (auto it = m_prefetchTickets.begin(); it != m_prefetchTickets.end();)
+        {
+            auto& request = *m_requests.at(it->second);
+            ++it;
+            if (!inWindow(request.Index) && !request.Running)
+            {
+                CancelLocked(request);
+            }
+        }
+        for (auto it = m_prefetched.begin(); it != m_prefetched.end();)
+        {
+            it = inWindow(*it) ? std::next(it) : m_prefetched.erase(it);
+        }
+
+        for (size_t index = windowBegin; index < windowEnd; index++)
+        {
+            if (m_prefetched.insert(index).second)
+            {
+                m_prefetchTickets[index] = Enqueue(index, m_prefetch(index), true);
+                m_statistics.Prefetched++;
+            }
+        }
+    }
+
+    void ThumbnailScheduler::Reprioritize()
+    {
+        m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [](QueueEntry const& entry) { return entry.Request->Cancelled->load(); }), m_queue.end());
+        for (auto&& entry : m_queue)
+        {
+            entry.Priority = Priority(entry.Request->Index);
+        }
+        std::make_heap(m_queue.begin(), m_queue.end(), FartherFirst());
+    }
+
+    void ThumbnailScheduler::WorkerLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            m_workAvailable.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty())
+            {
+                return;
+            }
+
+            std::pop_heap(m_queue.begin(), m_queue.end(), FartherFirst());
+            auto request = std::move(m_queue.back().Request);
+            m_queue.pop_back();
+            if (request->Cancelled->load())
+            {
+                continue;
+            }
+
+            request->Running = true;
+            m_statistics.Started++;
+            lock.unlock();
+
+            bool failed = false;
+            try
+            {
+                request->Work(*request->Cancelled);
+            }
+            catch (...)
+            {
+                failed = true;
+            }
+
+            lock.lock();
+            m_statistics.Failed += failed ? 1 : 0;
+            m_statistics.Completed += failed ? 0 : 1;
+            if (auto prefetch = m_prefetchTickets.find(request->Index); prefetch != m_prefetchTickets.end() && prefetch->second == request->Ticket)
+            {
+                m_prefetchTickets.erase(prefetch);
+            }
+            m_requests.erase(request->Ticket);
+            if (m_requests.empty())
+            {
+                m_idle.notify_all();
+            }
+        }
+    }
+}
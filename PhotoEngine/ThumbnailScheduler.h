@@ -0,0 +1,162 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace PhotoEngine
+{
+    struct ThumbnailSchedulerOptions
+    {
+        // Loads running at once.
+        unsigned MaxConcurrentLoads{ 4 };
+
+        // Items past the visible range, in the direction of the last scroll, that are
+        // loaded before any container asks for them.
+        size_t PrefetchItems{ 32 };
+    };
+
+    struct ThumbnailSchedulerStatistics
+    {
+        size_t Started{ 0 };
+        size_t Completed{ 0 };
+
+        // Requests cancelled before they started, and while they ran.
+        size_t CancelledQueued{ 0 };
+        size_t CancelledRunning{ 0 };
+
+        // Prefetch requests created.
+        size_t Prefetched{ 0 };
+
+        // Loads that threw.
+        size_t Failed{ 0 };
+    };
+
+    // Runs thumbnail loads for the items of a scrolling grid, nearest to the screen
+    // first, on a bounded number of threads.
+    //
+    // Queued requests are ordered by their item's distance from the visible range, with
+    // items behind the scroll direction counting twice as far, and are reordered when
+    // the viewport moves. Items just past the visible range in the scroll direction are
+    // prefetched, and queued prefetches that fall out of that window are dropped. A
+    // container that is recycled cancels its request: a queued request never starts,
+    // and a running one sees its cancelled flag turn true.
+    //
+    // All methods may be called from any thread.
+    class ThumbnailScheduler
+    {
+    public:
+        // Loads the thumbnail of one item. Long loads should check the flag and return
+        // early once it is true. Exceptions are caught and counted.
+        using Load = std::function<void(std::atomic<bool> const& cancelled)>;
+
+        // Makes the load for an item that is prefetched. It is called with the
+        // scheduler's lock held, so it should only capture what the load needs. Without
+        // it, nothing is prefetched.
+        using PrefetchFactory = std::function<Load(size_t index)>;
+
+        explicit ThumbnailScheduler(ThumbnailSchedulerOptions const& options = {}, PrefetchFactory prefetch = {});
+
+        // Cancels the queued requests and waits for the running loads.
+        ~ThumbnailScheduler();
+
+        ThumbnailScheduler(ThumbnailScheduler const&) = delete;
+        ThumbnailScheduler& operator=(ThumbnailScheduler const&) = delete;
+
+        // Queues the load of an item that a container shows. Returns a ticket for Cancel.
+        uint64_t Request(size_t index, Load load);
+
+        // Cancels a request. Returns false if it has already finished.
+        bool Cancel(uint64_t ticket);
+
+        // Moves the visible range to [first, first + count) of itemCount items.
+        void Viewport(size_t first, size_t count, size_t itemCount);
+
+        // Blocks until no request is queued or running.
+        void WaitIdle();
+
+        ThumbnailSchedulerStatistics Statistics() const;
+
+    private:
+        struct Pending
+        {
+            uint64_t Ticket{ 0 };
+            size_t Index{ 0 };
+            bool Prefetch{ false };
+            Load Work;
+            std::shared_ptr<std::atomic<bool>> Cancelled;
+            bool Running{ false };
+        };
+
+        struct QueueEntry
+        {
+            uint64_t Priority;
+            uint64_t Ticket;
+            std::shared_ptr<Pending> Request;
+        };
+
+        uint64_t Priority(size_t index) const;
+        uint64_t Enqueue(size_t index, Load load, bool prefetch);
+        void CancelLocked(Pending& request);
+        void UpdatePrefetch();
+        void Reprioritize();
+        void WorkerLoop();
+
+        ThumbnailSchedulerOptions m_options;
+        PrefetchFactory m_prefetch;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        std::condition_variable m_idle;
+        bool m_stopping{ false };
+
+        // A heap with the nearest item on top; cancelled entries are skipped when popped.
+        std::vector<QueueEntry> m_queue;
+        std::unordered_map<uint64_t, std::shared_ptr<Pending>> m_requests;
+        uint64_t m_nextTicket{ 1 };
+
+        size_t m_first{ 0 };
+        size_t m_count{ 0 };
+        size_t m_itemCount{ 0 };
+        bool m_scrollingBack{ false };
+
+        // Queued or running prefetches by item, and the items prefetched in the window.
+        std::unordered_map<size_t, uint64_t> m_prefetchTickets;
+        std::unordered_set<size_t> m_prefetched;
+
+        ThumbnailSchedulerStatistics m_statistics;
+        std::vector<std::thread> m_workers;
+    };
+}
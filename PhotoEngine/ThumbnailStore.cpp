@@ -0,0 +1,456 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "ThumbnailStore.h"
+#include "MetadataIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        constexpr char PackMagic[4] = { 'P', 'E', 'T', 'S' };
+        constexpr uint32_t PackVersion = 2;
+        constexpr uint32_t SlotMagic = 0x4C534550;
+
+        // The pack header fills the first page so slots start page aligned.
+        constexpr size_t HeaderBytes = 4096;
+
+        // Room for the UTF-8 path of the file, between the slot header and the pixels.
+        constexpr size_t MaxPathBytes = 1024;
+
+        // Slots the file grows by at a time, so it is not remapped on every add.
+        constexpr size_t GrowSlots = 64;
+
+        struct PackHeader
+        {
+            char Magic[4];
+            uint32_t Version;
+            uint32_t MaxWidth;
+            uint32_t MaxHeight;
+            uint64_t SlotBytes;
+        };
+
+        uint32_t Checksum(const void* data, size_t size)
+        {
+            uint32_t hash = 2166136261u;
+            for (size_t i = 0; i < size; i++)
+            {
+                hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 16777619u;
+            }
+            return hash;
+        }
+    }
+
+    struct ThumbnailStore::SlotHeader
+    {
+        uint32_t Magic;
+        uint32_t Checksum;
+        uint64_t PathHash;
+        uint64_t Size;
+        int64_t LastWriteTime;
+        uint64_t Sequence;
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t PathLength;
+        uint8_t Reserved[12];
+
+        uint32_t ComputeChecksum() const
+        {
+            auto copy = *this;
+            copy.Checksum = 0;
+            return PhotoEngine::Checksum(&copy, sizeof(copy));
+        }
+    };
+
+    ThumbnailStore::ThumbnailStore(std::filesystem::path const& path, ThumbnailStoreOptions const& options) :
+        m_path(path),
+        m_options(options)
+    {
+        static_assert(sizeof(SlotHeader) == 64, "The slot header layout is part of the file format");
+
+        const size_t pixelBytes = static_cast<size_t>(options.MaxWidth) * options.MaxHeight * BytesPerPixel;
+        m_slotBytes = (PixelOffset() + pixelBytes + HeaderBytes - 1) / HeaderBytes * HeaderBytes;
+        m_capacity = options.MaxBytes > HeaderBytes ? static_cast<size_t>((options.MaxBytes - HeaderBytes) / m_slotBytes) : 0;
+        if (options.MaxWidth == 0 || options.MaxHeight == 0 || m_capacity == 0)
+        {
+            throw std::invalid_argument("ThumbnailStore: the size cap must hold at least one slot");
+        }
+
+        Open();
+    }
+
+    void ThumbnailStore::Create()
+    {
+        std::vector<char> header(HeaderBytes);
+        PackHeader pack{};
+        std::memcpy(pack.Magic, PackMagic, sizeof(PackMagic));
+        pack.Version = PackVersion;
+        pack.MaxWidth = m_options.MaxWidth;
+        pack.MaxHeight = m_options.MaxHeight;
+        pack.SlotBytes = m_slotBytes;
+        std::memcpy(header.data(), &pack, sizeof(pack));
+
+        std::ofstream file(m_path, std::ios::binary | std::ios::trunc);
+        file.write(header.data(), static_cast<std::streamsize>(header.size()));
+        if (!file.flush())
+        {
+            throw std::runtime_error("ThumbnailStore: cannot create " + m_path.string());
+        }
+    }
+
+    void ThumbnailStore::Open()
+    {
+        std::error_code error;
+        const auto fileSize = std::filesystem::file_size(m_path, error);
+        bool valid = !error && fileSize >= HeaderBytes;
+        if (valid)
+        {
+            PackHeader pack{};
+            std::ifstream(m_path, std::ios::binary).read(reinterpret_cast<char*>(&pack), sizeof(pack));
+            valid = std::memcmp(pack.Magic, PackMagic, sizeof(PackMagic)) == 0 && pack.Version == PackVersion &&
+                pack.MaxWidth == m_options.MaxWidth && pack.MaxHeight == m_options.MaxHeight && pack.SlotBytes == m_slotBytes;
+        }
+        if (!valid)
+        {
+            Create();
+        }
+
+        m_file = std::fstream(m_path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!m_file)
+        {
+            throw std::runtime_error("ThumbnailStore: cannot open " + m_path.string());
+        }
+        Remap();
+
+        // Rebuild the key table from the slot headers; torn or cleared slots are free. The
+        // path hash in the header checks the path, which is written with the pixels.
+        const size_t slotCount = (m_mapping->Size() - HeaderBytes) / m_slotBytes;
+        m_slots.assign(slotCount, {});
+        m_freeSlots.clear();
+        m_slotsByPath.clear();
+        m_sequence = 0;
+
+        for (size_t slot = 0; slot < slotCount; slot++)
+        {
+            const uint8_t* data = m_mapping->Data() + SlotOffset(slot);
+            SlotHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            const bool valid = header.Magic == SlotMagic && header.Checksum == header.ComputeChecksum() &&
+                header.Width > 0 && header.Width <= m_options.MaxWidth && header.Height > 0 && header.Height <= m_options.MaxHeight &&
+                header.PathLength > 0 && header.PathLength <= MaxPathBytes;
+            std::string path;
+            if (valid)
+            {
+                path.assign(reinterpret_cast<const char*>(data + sizeof(SlotHeader)), header.PathLength);
+            }
+            if (!valid || HashPath(path) != header.PathHash)
+            {
+                m_freeSlots.push_back(slot);
+                continue;
+            }
+
+            // A crash between writing a new slot and clearing an old one leaves two; the
+            // later write wins.
+            auto [existing, inserted] = m_slotsByPath.emplace(path, slot);
+            if (!inserted)
+            {
+                if (m_slots[existing->second].LastUse > header.Sequence)
+                {
+                    m_freeSlots.push_back(slot);
+                    continue;
+                }
+                m_slots[existing->second].Occupied = false;
+                m_freeSlots.push_back(existing->second);
+                existing->second = slot;
+            }
+
+            m_slots[slot] = { true, std::move(path), header.Sequence };
+            m_sequence = std::max(m_sequence, header.Sequence);
+        }
+        m_clock = m_sequence;
+
+        if (slotCount > m_capacity)
+        {
+            CompactLocked();
+        }
+    }
+
+    void ThumbnailStore::Remap()
+    {
+        m_mapping = std::make_shared<const MappedFile>(m_path);
+    }
+
+    uint64_t ThumbnailStore::SlotOffset(size_t slot) const
+    {
+        return HeaderBytes + static_cast<uint64_t>(slot) * m_slotBytes;
+    }
+
+    void ThumbnailStore::WriteAt(uint64_t offset, const void* data, size_t size)
+    {
+        m_file.seekp(static_cast<std::streamoff>(offset));
+        m_file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        if (!m_file)
+        {
+            throw std::runtime_error("ThumbnailStore: cannot write " + m_path.string());
+        }
+    }
+
+    size_t ThumbnailStore::PixelOffset()
+    {
+        return sizeof(SlotHeader) + MaxPathBytes;
+    }
+
+    size_t ThumbnailStore::AcquireSlot(std::string const& path)
+    {
+        if (auto existing = m_slotsByPath.find(path); existing != m_slotsByPath.end())
+        {
+            return existing->second;
+        }
+
+        if (m_freeSlots.empty() && m_slots.size() < m_capacity)
+        {
+            // Grow the file by writing its new last byte; the new slots read as cleared.
+            const size_t oldCount = m_slots.size();
+            const size_t newCount = std::min(m_capacity, oldCount + GrowSlots);
+            const char zero = 0;
+            WriteAt(SlotOffset(newCount) - 1, &zero, 1);
+            m_file.flush();
+            Remap();
+
+            m_slots.resize(newCount);
+            for (size_t slot = newCount; slot > oldCount; slot--)
+            {
+                m_freeSlots.push_back(slot - 1);
+            }
+        }
+
+        if (!m_freeSlots.empty())
+        {
+            const size_t slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+            return slot;
+        }
+
+        // Evict the least recently used thumbnail.
+        size_t victim = 0;
+        for (size_t slot = 1; slot < m_slots.size(); slot++)
+        {
+            if (m_slots[slot].LastUse < m_slots[victim].LastUse)
+            {
+                victim = slot;
+            }
+        }
+        m_slotsByPath.erase(m_slots[victim].Path);
+        m_statistics.Evictions++;
+        return victim;
+    }
+
+    void ThumbnailStore::FreeSlot(size_t slot)
+    {
+        const SlotHeader cleared{};
+        WriteAt(SlotOffset(slot), &cleared, sizeof(cleared));
+        m_file.flush();
+
+        m_slotsByPath.erase(m_slots[slot].Path);
+        m_slots[slot] = {};
+        m_freeSlots.push_back(slot);
+    }
+
+    Thumbnail ThumbnailStore::Find(std::string_view path, uint64_t size, int64_t lastWriteTime)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_slotsByPath.find(std::string(path));
+        if (found == m_slotsByPath.end())
+        {
+            m_statistics.Misses++;
+            return {};
+        }
+
+        const uint8_t* slot = m_mapping->Data() + SlotOffset(found->second);
+        SlotHeader header;
+        std::memcpy(&header, slot, sizeof(header));
+        if (header.Size != size || header.LastWriteTime != lastWriteTime)
+        {
+            m_statistics.Misses++;
+            return {};
+        }
+
+        m_slots[found->second].LastUse = ++m_clock;
+        m_statistics.Hits++;
+        const size_t stride = static_cast<size_t>(header.Width) * BytesPerPixel;
+        return Thumbnail(m_mapping, { slot + PixelOffset(), header.Width, header.Height, stride });
+    }
+
+    void ThumbnailStore::Add(std::string_view path, uint64_t size, int64_t lastWriteTime, ConstImageView thumbnail)
+    {
+        if (thumbnail.Width == 0 || thumbnail.Height == 0 ||
+            thumbnail.Width > m_options.MaxWidth || thumbnail.Height > m_options.MaxHeight)
+        {
+            throw std::invalid_argument("ThumbnailStore: the thumbnail does not fit a slot");
+        }
+        if (path.empty() || path.size() > MaxPathBytes)
+        {
+            throw std::invalid_argument("ThumbnailStore: the path does not fit a slot");
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string key(path);
+        const size_t slot = AcquireSlot(key);
+        const uint64_t offset = SlotOffset(slot);
+
+        // Clear the old header before touching the pixels it describes.
+        if (m_slots[slot].Occupied)
+        {
+            const SlotHeader cleared{};
+            WriteAt(offset, &cleared, sizeof(cleared));
+            m_file.flush();
+        }
+
+        WriteAt(offset + sizeof(SlotHeader), key.data(), key.size());
+        const size_t rowBytes = static_cast<size_t>(thumbnail.Width) * BytesPerPixel;
+        for (uint32_t y = 0; y < thumbnail.Height; y++)
+        {
+            WriteAt(offset + PixelOffset() + y * rowBytes, thumbnail.Row(y), rowBytes);
+        }
+        m_file.flush();
+
+        SlotHeader header{};
+        header.Magic = SlotMagic;
+        header.PathHash = HashPath(key);
+        header.PathLength = static_cast<uint32_t>(key.size());
+        header.Size = size;
+        header.LastWriteTime = lastWriteTime;
+        header.Sequence = ++m_sequence;
+        header.Width = thumbnail.Width;
+        header.Height = thumbnail.Height;
+        header.Checksum = header.ComputeChecksum();
+        WriteAt(offset, &header, sizeof(header));
+        m_file.flush();
+
+        m_clock = std::max(m_clock, m_sequence);
+        m_slotsByPath[key] = slot;
+        m_slots[slot] = { true, std::move(key), ++m_clock };
+        m_statistics.Adds++;
+    }
+
+    bool ThumbnailStore::Remove(std::string_view path)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_slotsByPath.find(std::string(path));
+        if (found == m_slotsByPath.end())
+        {
+            return false;
+        }
+
+        FreeSlot(found->second);
+        return true;
+    }
+
+    void ThumbnailStore::Compact()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CompactLocked();
+    }
+
+    void ThumbnailStore::CompactLocked()
+    {
+        // Keep the most recently used thumbnails that fit the cap.
+        std::vector<size_t> kept;
+        for (size_t slot = 0; slot < m_slots.size(); slot++)
+        {
+            if (m_slots[slot].Occupied)
+            {
+                kept.push_back(slot);
+            }
+        }
+        std::sort(kept.begin(), kept.end(), [&](size_t a, size_t b) { return m_slots[a].LastUse > m_slots[b].LastUse; });
+        if (kept.size() > m_capacity)
+        {
+            m_statistics.Evictions += kept.size() - m_capacity;
+            kept.resize(m_capacity);
+        }
+
+        // Write the new pack next to the old one and swap them, so a crash keeps the old one.
+        auto temporary = m_path;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(m_mapping->Data()), HeaderBytes);
+            for (auto slot : kept)
+            {
+                file.write(reinterpret_cast<const char*>(m_mapping->Data() + SlotOffset(slot)), static_cast<std::streamsize>(m_slotBytes));
+            }
+            if (!file.flush())
+            {
+                throw std::runtime_error("ThumbnailStore: cannot write " + temporary.string());
+            }
+        }
+
+        std::vector<Slot> slots;
+        for (auto slot : kept)
+        {
+            slots.push_back(m_slots[slot]);
+        }
+
+        m_file.close();
+        m_mapping.reset();
+        std::filesystem::rename(temporary, m_path);
+
+        m_file = std::fstream(m_path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!m_file)
+        {
+            throw std::runtime_error("ThumbnailStore: cannot open " + m_path.string());
+        }
+        Remap();
+
+        m_slots = std::move(slots);
+        m_freeSlots.clear();
+        m_slotsByPath.clear();
+        for (size_t slot = 0; slot < m_slots.size(); slot++)
+        {
+            m_slotsByPath[m_slots[slot].Path] = slot;
+        }
+    }
+
+    size_t ThumbnailStore::Count() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_slotsByPath.size();
+    }
+
+    uint64_t ThumbnailStore::FileBytes() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_mapping->Size();
+    }
+
+    ThumbnailStoreStatistics ThumbnailStore::Statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+}
@@ -0,0 +1,179 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Image.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace PhotoEngine
+{
+    struct ThumbnailStoreOptions
+    {
+        // Largest thumbnail a slot holds. Every slot is sized for it.
+        uint32_t MaxWidth{ 256 };
+        uint32_t MaxHeight{ 256 };
+
+        // Size cap of the pack file. The least recently used thumbnails are evicted
+        // when it is full.
+        uint64_t MaxBytes{ 256ull << 20 };
+    };
+
+    struct ThumbnailStoreStatistics
+    {
+        size_t Hits{ 0 };
+        size_t Misses{ 0 };
+        size_t Adds{ 0 };
+        size_t Evictions{ 0 };
+    };
+
+    // A thumbnail read from a ThumbnailStore. The view points into the store's mapping,
+    // which the handle keeps alive. Adding another thumbnail for the same file, or one
+    // that evicts it, changes the pixels under the view, so copy them out before then.
+    class Thumbnail
+    {
+    public:
+        Thumbnail() = default;
+
+        Thumbnail(std::shared_ptr<const MappedFile> mapping, ConstImageView view) :
+            m_mapping(std::move(mapping)),
+            m_view(view)
+        {
+        }
+
+        explicit operator bool() const
+        {
+            return m_mapping != nullptr;
+        }
+
+        ConstImageView View() const
+        {
+            return m_view;
+        }
+
+    private:
+        std::shared_ptr<const MappedFile> m_mapping;
+        ConstImageView m_view;
+    };
+
+    // A persistent store of BGRA8 thumbnails in one memory-mapped pack file, so the
+    // grid can show a photo it has shown before without decoding it again.
+    //
+    // The pack is a header page followed by fixed-size slots, each holding a slot header,
+    // the file's path, and up to MaxWidth x MaxHeight pixels. Thumbnails are keyed like
+    // MetadataIndex: by the full path, and valid while the file's size and last write
+    // time match. Find returns a view straight into the mapping.
+    //
+    // Appends are crash safe: a slot's header is cleared before its pixels are written
+    // and written again, with a checksum, only after them, so a slot interrupted by a
+    // crash reads back as free. Open rebuilds the key table from the slot headers.
+    //
+    // All methods may be called from any thread.
+    class ThumbnailStore
+    {
+    public:
+        // Opens or creates the pack file. A file that is not a pack, or was written for
+        // other slot dimensions, is replaced by an empty pack. Throws std::runtime_error
+        // if the file cannot be created.
+        explicit ThumbnailStore(std::filesystem::path const& path, ThumbnailStoreOptions const& options = {});
+
+        // Returns the thumbnail of the file, or an empty handle if there is none for this
+        // size and last write time.
+        Thumbnail Find(std::string_view path, uint64_t size, int64_t lastWriteTime);
+
+        // Stores the thumbnail of a file, replacing the file's previous one. Throws
+        // std::invalid_argument if it is larger than the slots, or if the path is empty or
+        // longer than 1024 bytes.
+        void Add(std::string_view path, uint64_t size, int64_t lastWriteTime, ConstImageView thumbnail);
+
+        // Frees the slot of a file. Returns false if the store has no thumbnail for it.
+        bool Remove(std::string_view path);
+
+        // Rewrites the pack with the occupied slots packed at the front and the free
+        // slots dropped. On Windows, Thumbnail handles must be released first.
+        void Compact();
+
+        // Thumbnails stored.
+        size_t Count() const;
+
+        // Most thumbnails the size cap allows.
+        size_t Capacity() const
+        {
+            return m_capacity;
+        }
+
+        size_t SlotBytes() const
+        {
+            return m_slotBytes;
+        }
+
+        uint64_t FileBytes() const;
+
+        ThumbnailStoreStatistics Statistics() const;
+
+    private:
+        struct SlotHeader;
+
+        struct Slot
+        {
+            bool Occupied{ false };
+            std::string Path;
+            uint64_t LastUse{ 0 };
+        };
+
+        void Create();
+        void Open();
+        void CompactLocked();
+        void Remap();
+        uint64_t SlotOffset(size_t slot) const;
+        void WriteAt(uint64_t offset, const void* data, size_t size);
+        static size_t PixelOffset();
+        size_t AcquireSlot(std::string const& path);
+        void FreeSlot(size_t slot);
+
+        std::filesystem::path m_path;
+        ThumbnailStoreOptions m_options;
+        size_t m_slotBytes{ 0 };
+        size_t m_capacity{ 0 };
+
+        mutable std::mutex m_mutex;
+        std::fstream m_file;
+        std::shared_ptr<const MappedFile> m_mapping;
+        std::vector<Slot> m_slots;
+        std::vector<size_t> m_freeSlots;
+        std::unordered_map<std::string, size_t> m_slotsByPath;
+        uint64_t m_clock{ 0 };
+        uint64_t m_sequence{ 0 };
+        ThumbnailStoreStatistics m_statistics;
+    };
+}
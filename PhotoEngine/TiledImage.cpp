@@ -0,0 +1,325 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "TiledImage.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // Calls part(column, row, x, y, width, height) with the image coordinates of the
+        // part of each tile that the region covers.
+        template <typename Part>
+        void ForEachTilePart(TiledImage const& image, uint32_t left, uint32_t top, uint32_t width, uint32_t height, Part&& part)
+        {
+            if (left > image.Width() || width > image.Width() - left || top > image.Height() || height > image.Height() - top)
+            {
+                throw std::out_of_range("TiledImage: region outside the image");
+            }
+
+            const uint32_t size = image.TileSize();
+            for (uint32_t row = top / size; row < image.TileRows() && row * size < top + height; row++)
+            {
+                const uint32_t y0 = std::max(top, row * size);
+                const uint32_t y1 = std::min(top + height, (row + 1) * size);
+                for (uint32_t column = left / size; column < image.TileColumns() && column * size < left + width; column++)
+                {
+                    const uint32_t x0 = std::max(left, column * size);
+                    const uint32_t x1 = std::min(left + width, (column + 1) * size);
+                    part(column, row, x0, y0, x1 - x0, y1 - y0);
+                }
+            }
+        }
+    }
+
+    TiledImage::TiledImage(uint32_t width, uint32_t height, TiledImageOptions const& options) :
+        m_width(width),
+        m_height(height),
+        m_tileSize(options.TileSize)
+    {
+        if (m_tileSize == 0 || m_tileSize % 32 != 0)
+        {
+            throw std::invalid_argument("TiledImage: the tile size must be a multiple of 32");
+        }
+
+        m_columns = (width + m_tileSize - 1) / m_tileSize;
+        m_rows = (height + m_tileSize - 1) / m_tileSize;
+        const size_t size = static_cast<size_t>(m_columns) * m_rows * TileBytes();
+        if (size == 0)
+        {
+            return;
+        }
+
+        const std::string error = "TiledImage: cannot allocate " + std::to_string(width) + "x" + std::to_string(height) + " pixels";
+        void* view = nullptr;
+
+#if defined(_WIN32)
+        if (options.ScratchDirectory.empty())
+        {
+            view = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        }
+        else
+        {
+            wchar_t name[MAX_PATH];
+            if (!GetTempFileNameW(options.ScratchDirectory.c_str(), L"pe", 0, name))
+            {
+                throw std::runtime_error(error + " in " + options.ScratchDirectory.string());
+            }
+
+            HANDLE file = CreateFileW(name, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+            {
+                DeleteFileW(name);
+                throw std::runtime_error(error + " in " + options.ScratchDirectory.string());
+            }
+
+            // Mapping past the end of the file grows it to the size of the image.
+            LARGE_INTEGER fileSize{};
+            fileSize.QuadPart = static_cast<LONGLONG>(size);
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, fileSize.HighPart, fileSize.LowPart, nullptr);
+            view = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : nullptr;
+            if (mapping)
+            {
+                CloseHandle(mapping);
+            }
+            if (!view)
+            {
+                CloseHandle(file);
+                throw std::runtime_error(error + " in " + options.ScratchDirectory.string());
+            }
+            m_file = reinterpret_cast<intptr_t>(file);
+        }
+#else
+        if (options.ScratchDirectory.empty())
+        {
+            view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            view = view == MAP_FAILED ? nullptr : view;
+        }
+        else
+        {
+            // The file has no name from the start, so nothing is left behind if the
+            // process dies. It is created sparse and reads as zeros.
+            std::string name = (options.ScratchDirectory / "PhotoEngine-XXXXXX").string();
+            const int file = mkstemp(name.data());
+            if (file < 0)
+            {
+                throw std::runtime_error(error + " in " + options.ScratchDirectory.string());
+            }
+            unlink(name.c_str());
+            fcntl(file, F_SETFD, FD_CLOEXEC);
+
+            if (ftruncate(file, static_cast<off_t>(size)) == 0)
+            {
+                view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+                view = view == MAP_FAILED ? nullptr : view;
+            }
+            if (!view)
+            {
+                close(file);
+                throw std::runtime_error(error + " in " + options.ScratchDirectory.string());
+            }
+            m_file = file;
+        }
+#endif
+
+        if (!view)
+        {
+            throw std::runtime_error(error);
+        }
+        m_data = static_cast<uint8_t*>(view);
+        m_size = size;
+    }
+
+    TiledImage::~TiledImage()
+    {
+        Close();
+    }
+
+    TiledImage::TiledImage(TiledImage&& other) noexcept :
+        m_width(std::exchange(other.m_width, 0)),
+        m_height(std::exchange(other.m_height, 0)),
+        m_tileSize(std::exchange(other.m_tileSize, 0)),
+        m_columns(std::exchange(other.m_columns, 0)),
+        m_rows(std::exchange(other.m_rows, 0)),
+        m_data(std::exchange(other.m_data, nullptr)),
+        m_size(std::exchange(other.m_size, 0)),
+        m_file(std::exchange(other.m_file, -1))
+    {
+    }
+
+    TiledImage& TiledImage::operator=(TiledImage&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            m_width = std::exchange(other.m_width, 0);
+            m_height = std::exchange(other.m_height, 0);
+            m_tileSize = std::exchange(other.m_tileSize, 0);
+            m_columns = std::exchange(other.m_columns, 0);
+            m_rows = std::exchange(other.m_rows, 0);
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_file = std::exchange(other.m_file, -1);
+        }
+        return *this;
+    }
+
+    ImageView TiledImage::Tile(uint32_t column, uint32_t row)
+    {
+        if (column >= m_columns || row >= m_rows)
+        {
+            throw std::out_of_range("TiledImage: tile outside the image");
+        }
+
+        const uint32_t left = column * m_tileSize;
+        const uint32_t top = row * m_tileSize;
+        return { TileData(column, row), std::min(m_tileSize, m_width - left), std::min(m_tileSize, m_height - top),
+            static_cast<size_t>(m_tileSize) * BytesPerPixel };
+    }
+
+    ConstImageView TiledImage::Tile(uint32_t column, uint32_t row) const
+    {
+        return const_cast<TiledImage*>(this)->Tile(column, row);
+    }
+
+    void TiledImage::ReadRegion(uint32_t left, uint32_t top, ImageView dst) const
+    {
+        ForEachTilePart(*this, left, top, dst.Width, dst.Height, [&](uint32_t column, uint32_t row, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+        {
+            CopyPixels(Tile(column, row).Region(x - column * m_tileSize, y - row * m_tileSize, width, height),
+                dst.Region(x - left, y - top, width, height));
+        });
+    }
+
+    void TiledImage::WriteRegion(uint32_t left, uint32_t top, ConstImageView src)
+    {
+        ForEachTilePart(*this, left, top, src.Width, src.Height, [&](uint32_t column, uint32_t row, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+        {
+            CopyPixels(src.Region(x - left, y - top, width, height),
+                Tile(column, row).Region(x - column * m_tileSize, y - row * m_tileSize, width, height));
+        });
+    }
+
+    void TiledImage::Release(uint32_t firstRow, uint32_t rowCount) const
+    {
+        if (!IsFileBacked() || firstRow >= m_rows || rowCount == 0)
+        {
+            return;
+        }
+
+        uint8_t* start = TileData(0, firstRow);
+        const size_t length = static_cast<size_t>(std::min(rowCount, m_rows - firstRow)) * m_columns * TileBytes();
+
+#if defined(_WIN32)
+        // Unlocking pages that are not locked takes them out of the working set.
+        VirtualUnlock(start, length);
+#elif defined(__linux__)
+        // Dirty pages of a shared mapping move to the page cache, which writes them to the
+        // file and frees them as memory is needed.
+        madvise(start, length, MADV_DONTNEED);
+#else
+        posix_madvise(start, length, POSIX_MADV_DONTNEED);
+#endif
+    }
+
+    void TiledImage::Close()
+    {
+        if (m_data)
+        {
+#if defined(_WIN32)
+            if (IsFileBacked())
+            {
+                UnmapViewOfFile(m_data);
+            }
+            else
+            {
+                VirtualFree(m_data, 0, MEM_RELEASE);
+            }
+#else
+            munmap(m_data, m_size);
+#endif
+        }
+
+        if (IsFileBacked())
+        {
+#if defined(_WIN32)
+            CloseHandle(reinterpret_cast<HANDLE>(m_file));
+#else
+            close(static_cast<int>(m_file));
+#endif
+        }
+
+        m_data = nullptr;
+        m_size = 0;
+        m_file = -1;
+    }
+
+    void TiledImageRowReader::ReadRows(ImageView rows)
+    {
+        if (rows.Height > m_image.Height() - m_nextRow)
+        {
+            throw std::out_of_range("TiledImageRowReader: read past the last row");
+        }
+
+        m_image.ReadRegion(0, m_nextRow, rows);
+
+        // Tile rows the next read starts below are done with.
+        const uint32_t tileSize = m_image.TileSize();
+        const uint32_t firstRow = m_nextRow / tileSize;
+        m_nextRow += rows.Height;
+        const uint32_t endRow = m_nextRow == m_image.Height() ? m_image.TileRows() : m_nextRow / tileSize;
+        m_image.Release(firstRow, endRow > firstRow ? endRow - firstRow : 0);
+    }
+
+    void TiledImageRowWriter::WriteRows(ConstImageView rows)
+    {
+        if (rows.Height > m_image.Height() - m_nextRow)
+        {
+            throw std::out_of_range("TiledImageRowWriter: write past the last row");
+        }
+
+        m_image.WriteRegion(0, m_nextRow, rows);
+
+        const uint32_t tileSize = m_image.TileSize();
+        const uint32_t firstRow = m_nextRow / tileSize;
+        m_nextRow += rows.Height;
+        const uint32_t endRow = m_nextRow == m_image.Height() ? m_image.TileRows() : m_nextRow / tileSize;
+        m_image.Release(firstRow, endRow > firstRow ? endRow - firstRow : 0);
+    }
+}
@@ -0,0 +1,185 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Image.h"
+#include "RowStream.h"
+#include <filesystem>
+
+namespace PhotoEngine
+{
+    // Where the pixels of a TiledImage live.
+    struct TiledImageOptions
+    {
+        // Width and height of a tile in pixels. Must be a multiple of 32, so that every
+        // tile starts on a page boundary.
+        uint32_t TileSize{ 256 };
+
+        // Directory for a scratch file that backs the pixels. The file is deleted when the
+        // image is destroyed, or when the process exits. Empty keeps the pixels in memory.
+        std::filesystem::path ScratchDirectory;
+    };
+
+    // A BGRA8 image stored as square tiles, for images too large to hold in memory at
+    // once, such as panoramas and scans of several gigapixels.
+    //
+    // Each tile is contiguous, so rendering a tile touches only its own pages. With a
+    // scratch file, the pixels are a shared mapping of that file: the system pages tiles
+    // in when they are touched and writes them back under memory pressure, and Release
+    // drops tiles that will not be needed soon, so the memory a pass over the image uses
+    // depends on the tiles it has in hand and not on the size of the image.
+    class TiledImage
+    {
+    public:
+        TiledImage() = default;
+
+        // Creates an image of transparent black pixels. Throws std::invalid_argument if
+        // the tile size is not a multiple of 32, or std::runtime_error if the pixels
+        // cannot be allocated or the scratch file cannot be created.
+        TiledImage(uint32_t width, uint32_t height, TiledImageOptions const& options = {});
+
+        ~TiledImage();
+
+        TiledImage(TiledImage&& other) noexcept;
+        TiledImage& operator=(TiledImage&& other) noexcept;
+        TiledImage(TiledImage const&) = delete;
+        TiledImage& operator=(TiledImage const&) = delete;
+
+        uint32_t Width() const
+        {
+            return m_width;
+        }
+
+        uint32_t Height() const
+        {
+            return m_height;
+        }
+
+        uint32_t TileSize() const
+        {
+            return m_tileSize;
+        }
+
+        // Number of tiles across and down. The tiles of the last column and row may be
+        // narrower or shorter than TileSize().
+        uint32_t TileColumns() const
+        {
+            return m_columns;
+        }
+
+        uint32_t TileRows() const
+        {
+            return m_rows;
+        }
+
+        bool IsFileBacked() const
+        {
+            return m_file != -1;
+        }
+
+        // Returns a view of the pixels of one tile.
+        ImageView Tile(uint32_t column, uint32_t row);
+        ConstImageView Tile(uint32_t column, uint32_t row) const;
+
+        // Copies the pixels whose top left pixel is (left, top) into dst, or from src.
+        // The region must lie inside the image and may span any number of tiles.
+        void ReadRegion(uint32_t left, uint32_t top, ImageView dst) const;
+        void WriteRegion(uint32_t left, uint32_t top, ConstImageView src);
+
+        // Tells the system the tiles of rows [firstRow, firstRow + rowCount) will not be
+        // needed soon. A file-backed image lets their pages go after writing them to the
+        // scratch file, and reads them back if they are touched again; an image in memory
+        // keeps them.
+        void Release(uint32_t firstRow, uint32_t rowCount) const;
+
+    private:
+        size_t TileBytes() const
+        {
+            return static_cast<size_t>(m_tileSize) * m_tileSize * BytesPerPixel;
+        }
+
+        uint8_t* TileData(uint32_t column, uint32_t row) const
+        {
+            return m_data + (static_cast<size_t>(row) * m_columns + column) * TileBytes();
+        }
+
+        void Close();
+
+        uint32_t m_width{ 0 };
+        uint32_t m_height{ 0 };
+        uint32_t m_tileSize{ 0 };
+        uint32_t m_columns{ 0 };
+        uint32_t m_rows{ 0 };
+        uint8_t* m_data{ nullptr };
+        size_t m_size{ 0 };
+
+        // Handle or descriptor of the scratch file, or -1.
+        intptr_t m_file{ -1 };
+    };
+
+    // Reads the rows of a tiled image from top to bottom, releasing each row of tiles
+    // once it has been read, e.g. to feed an encoder.
+    class TiledImageRowReader : public RowReader
+    {
+    public:
+        explicit TiledImageRowReader(TiledImage const& image) :
+            m_image(image)
+        {
+        }
+
+        uint32_t Width() const override
+        {
+            return m_image.Width();
+        }
+
+        uint32_t Height() const override
+        {
+            return m_image.Height();
+        }
+
+        void ReadRows(ImageView rows) override;
+
+    private:
+        TiledImage const& m_image;
+        uint32_t m_nextRow{ 0 };
+    };
+
+    // Writes rows into a tiled image from top to bottom, releasing each row of tiles once
+    // it is complete, e.g. from a decoder.
+    class TiledImageRowWriter : public RowWriter
+    {
+    public:
+        explicit TiledImageRowWriter(TiledImage& image) :
+            m_image(image)
+        {
+        }
+
+        void WriteRows(ConstImageView rows) override;
+
+    private:
+        TiledImage& m_image;
+        uint32_t m_nextRow{ 0 };
+    };
+}
@@ -0,0 +1,116 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "TiledRenderer.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace PhotoEngine
+{
+    void TiledRenderer::Render(EffectChain const& chain, EffectParameters const& params, TiledImage const& src, TiledImage& dst)
+    {
+        if (src.Width() != dst.Width() || src.Height() != dst.Height())
+        {
+            throw std::invalid_argument("TiledRenderer: source and destination sizes differ");
+        }
+        if (&src == &dst)
+        {
+            throw std::invalid_argument("TiledRenderer: source and destination are the same image");
+        }
+
+        const uint32_t width = dst.Width();
+        const uint32_t height = dst.Height();
+        const uint32_t tileSize = dst.TileSize();
+        Pipeline pipeline(chain, m_options);
+        const uint32_t halo = pipeline.Halo(params);
+        const bool direct = halo == 0 && src.TileSize() == tileSize;
+        m_statistics = { 0, halo, 0 };
+
+        // Bake the color LUTs for the whole image up front; the tiles' pipeline copies share them.
+        for (size_t i = 0; i < pipeline.Stages().size(); i++)
+        {
+            pipeline.StageLut(i, params, static_cast<size_t>(width) * height);
+        }
+
+        std::atomic<size_t> liveBytes{ 0 };
+        std::atomic<size_t> peakBytes{ 0 };
+        uint32_t releasedSourceRows = 0;
+
+        for (uint32_t row = 0; row < dst.TileRows(); row++)
+        {
+            m_pool.ParallelFor(0, dst.TileColumns(), 1, [&](size_t begin, size_t end)
+            {
+                // Each band renders its tiles on this thread with its own copy of the pipeline.
+                ThreadPool serial(1);
+                Renderer renderer(serial, m_kernels);
+                Pipeline bandPipeline = pipeline;
+
+                for (auto column = static_cast<uint32_t>(begin); column < end; column++)
+                {
+                    const ImageView target = dst.Tile(column, row);
+                    if (direct)
+                    {
+                        renderer.Render(bandPipeline, params, src.Tile(column, row), target);
+                        continue;
+                    }
+
+                    const uint32_t left = column * tileSize;
+                    const uint32_t top = row * tileSize;
+                    const uint32_t inputLeft = left - std::min(left, halo);
+                    const uint32_t inputTop = top - std::min(top, halo);
+                    const uint32_t inputRight = left + target.Width + std::min(halo, width - left - target.Width);
+                    const uint32_t inputBottom = top + target.Height + std::min(halo, height - top - target.Height);
+
+                    Image input = Image::Uninitialized(inputRight - inputLeft, inputBottom - inputTop);
+                    Image output = Image::Uninitialized(input.Width(), input.Height());
+                    const size_t bytes = 2 * input.Stride() * input.Height();
+                    const size_t live = liveBytes += bytes;
+                    for (size_t peak = peakBytes; live > peak && !peakBytes.compare_exchange_weak(peak, live);)
+                    {
+                    }
+
+                    src.ReadRegion(inputLeft, inputTop, input.View());
+                    renderer.Render(bandPipeline, params, input.View(), output.View());
+                    CopyPixels(output.View().Region(left - inputLeft, top - inputTop, target.Width, target.Height), target);
+                    liveBytes -= bytes;
+                }
+            });
+            m_statistics.Tiles += dst.TileColumns();
+
+            // Later rows read the source from halo pixels above their first row on.
+            const uint32_t nextTop = (row + 1) * tileSize;
+            const uint32_t neededSourceRow = row + 1 < dst.TileRows() ? (nextTop - std::min(nextTop, halo)) / src.TileSize() : src.TileRows();
+            if (neededSourceRow > releasedSourceRows)
+            {
+                src.Release(releasedSourceRows, neededSourceRow - releasedSourceRows);
+                releasedSourceRows = neededSourceRow;
+            }
+            dst.Release(row, 1);
+        }
+
+        m_statistics.PeakBufferBytes = peakBytes;
+    }
+}
@@ -0,0 +1,96 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include "EffectChain.h"
+#include "EffectParameters.h"
+#include "Pipeline.h"
+#include "PixelKernels.h"
+#include "ThreadPool.h"
+#include "TiledImage.h"
+
+namespace PhotoEngine
+{
+    // Counters from the last TiledRenderer::Render call.
+    struct TiledRenderStatistics
+    {
+        uint32_t Tiles{ 0 };
+
+        // Pixels around each tile that were read and rendered so blurs near the tile
+        // edges see the same neighbors as in a full-frame render.
+        uint32_t Halo{ 0 };
+
+        // Largest total size of the tile buffers that were alive at the same time.
+        size_t PeakBufferBytes{ 0 };
+    };
+
+    // Renders an effect chain from one tiled image to another, one tile at a time, so
+    // the memory used depends on the tile size and the number of threads but not on the
+    // size of the image.
+    //
+    // Each tile is read together with the halo its blurs need, rendered on one thread,
+    // and its inner part written to the destination. Tiles of a row are spread across
+    // the thread pool; after each row, the source tiles no later row reads and the
+    // finished destination tiles are released. Chains without a blur need no halo and
+    // render straight from source tile to destination tile.
+    class TiledRenderer
+    {
+    public:
+        explicit TiledRenderer(ThreadPool& pool, PixelKernels const& kernels = GetPixelKernels()) :
+            m_pool(pool),
+            m_kernels(kernels)
+        {
+        }
+
+        // Gets or sets how the effect chain is compiled.
+        PipelineOptions const& Options() const
+        {
+            return m_options;
+        }
+
+        void Options(PipelineOptions const& value)
+        {
+            m_options = value;
+        }
+
+        // Renders src through chain into dst. The images must have the same size and be
+        // different images; they may have different tile sizes and storage. The result
+        // matches Renderer::Render on the whole image exactly for point effects and the
+        // direct blur. The recursive blur, which Automatic picks for larger sigma, is
+        // within 2 levels of it, since the halo cuts off the filter's infinite response.
+        void Render(EffectChain const& chain, EffectParameters const& params, TiledImage const& src, TiledImage& dst);
+
+        TiledRenderStatistics const& Statistics() const
+        {
+            return m_statistics;
+        }
+
+    private:
+        ThreadPool& m_pool;
+        PixelKernels const& m_kernels;
+        PipelineOptions m_options;
+        TiledRenderStatistics m_statistics;
+    };
+}
@@ -0,0 +1,180 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#include "WorkStealingScheduler.h"
+#include <algorithm>
+
+namespace PhotoEngine
+{
+    namespace
+    {
+        // The scheduler and worker index of the calling thread.
+        thread_local WorkStealingScheduler const* CurrentScheduler = nullptr;
+        thread_local int CurrentIndex = -1;
+    }
+
+    WorkStealingScheduler::WorkStealingScheduler(unsigned threadCount)
+    {
+        const unsigned workerCount = std::max(threadCount, 1u);
+        for (unsigned i = 0; i < workerCount; i++)
+        {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+
+        // Every queue exists before any worker looks for work to steal.
+        for (size_t i = 0; i < m_workers.size(); i++)
+        {
+            m_workers[i]->Thread = std::thread([this, i] { WorkerLoop(i); });
+        }
+    }
+
+    WorkStealingScheduler::~WorkStealingScheduler()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_allDone.wait(lock, [this] { return m_pending == 0; });
+            m_stopping = true;
+        }
+        m_taskAvailable.notify_all();
+
+        for (auto&& worker : m_workers)
+        {
+            worker->Thread.join();
+        }
+    }
+
+    void WorkStealingScheduler::Submit(std::function<void()> task)
+    {
+        const int current = CurrentWorker();
+        const size_t index = current >= 0 ? static_cast<size_t>(current) : m_nextWorker++ % m_workers.size();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending++;
+        }
+        {
+            auto& worker = *m_workers[index];
+            std::lock_guard<std::mutex> lock(worker.Mutex);
+            worker.Tasks.push_back(std::move(task));
+            m_queued++;
+        }
+
+        // A worker checks m_queued under m_mutex before it sleeps, so taking the lock here
+        // orders the notification after that check.
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_taskAvailable.notify_one();
+    }
+
+    void WorkStealingScheduler::Wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_allDone.wait(lock, [this] { return m_pending == 0; });
+
+        if (m_error)
+        {
+            auto error = m_error;
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    int WorkStealingScheduler::CurrentWorker() const
+    {
+        return CurrentScheduler == this ? CurrentIndex : -1;
+    }
+
+    bool WorkStealingScheduler::TryTake(size_t index, std::function<void()>& task)
+    {
+        {
+            auto& own = *m_workers[index];
+            std::lock_guard<std::mutex> lock(own.Mutex);
+            if (!own.Tasks.empty())
+            {
+                task = std::move(own.Tasks.back());
+                own.Tasks.pop_back();
+                m_queued--;
+                return true;
+            }
+        }
+
+        for (size_t offset = 1; offset < m_workers.size(); offset++)
+        {
+            auto& victim = *m_workers[(index + offset) % m_workers.size()];
+            std::lock_guard<std::mutex> lock(victim.Mutex);
+            if (!victim.Tasks.empty())
+            {
+                task = std::move(victim.Tasks.front());
+                victim.Tasks.pop_front();
+                m_queued--;
+                m_steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkStealingScheduler::WorkerLoop(size_t index)
+    {
+        CurrentScheduler = this;
+        CurrentIndex = static_cast<int>(index);
+
+        for (;;)
+        {
+            std::function<void()> task;
+            if (!TryTake(index, task))
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_taskAvailable.wait(lock, [this] { return m_stopping || m_queued > 0; });
+                if (m_queued == 0)
+                {
+                    return;
+                }
+                continue;
+            }
+
+            std::exception_ptr error;
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            task = nullptr;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (error && !m_error)
+            {
+                m_error = error;
+            }
+            if (--m_pending == 0)
+            {
+                m_allDone.notify_all();
+            }
+        }
+    }
+}
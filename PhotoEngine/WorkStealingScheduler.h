@@ -0,0 +1,107 @@
+﻿//  ---------------------------------------------------------------------------------
+//  Copyright (c) Microsoft Corporation.  All rights reserved.
+// 
+//  The MIT License (MIT)
+// 
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+// 
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE
+//  ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PhotoEngine
+{
+    // Worker threads that each own a queue of tasks and steal from the others when their
+    // own runs dry, for batches of independent tasks whose costs vary widely, such as one
+    // task per photo.
+    //
+    // A worker runs its own newest task first, so a task it submits while running runs
+    // next on the same thread with its data still in cache. An idle worker takes the
+    // oldest task of another worker, which is the one furthest from being run there.
+    // Tasks submitted from other threads are dealt round robin.
+    class WorkStealingScheduler
+    {
+    public:
+        explicit WorkStealingScheduler(unsigned threadCount = std::thread::hardware_concurrency());
+
+        // Waits for the queued tasks to finish.
+        ~WorkStealingScheduler();
+
+        WorkStealingScheduler(WorkStealingScheduler const&) = delete;
+        WorkStealingScheduler& operator=(WorkStealingScheduler const&) = delete;
+
+        unsigned ThreadCount() const
+        {
+            return static_cast<unsigned>(m_workers.size());
+        }
+
+        // Queues a task. May be called from any thread, including from a task.
+        void Submit(std::function<void()> task);
+
+        // Blocks until every submitted task, and every task those submitted, has finished.
+        // Rethrows the first exception a task threw since the last Wait; the other tasks
+        // still run.
+        void Wait();
+
+        // Returns the index of the worker running the calling thread, in [0, ThreadCount()),
+        // or -1 if the thread is not one of this scheduler's workers.
+        int CurrentWorker() const;
+
+        // Tasks a worker took from another worker's queue.
+        size_t Steals() const
+        {
+            return m_steals;
+        }
+
+    private:
+        struct Worker
+        {
+            std::thread Thread;
+            std::mutex Mutex;
+            std::deque<std::function<void()>> Tasks;
+        };
+
+        void WorkerLoop(size_t index);
+        bool TryTake(size_t index, std::function<void()>& task);
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::atomic<size_t> m_nextWorker{ 0 };
+        std::atomic<size_t> m_steals{ 0 };
+
+        // Tasks in the queues, and tasks queued or running.
+        std::atomic<size_t> m_queued{ 0 };
+        size_t m_pending{ 0 };
+
+        std::mutex m_mutex;
+        std::condition_variable m_taskAvailable;
+        std::condition_variable m_allDone;
+        std::exception_ptr m_error;
+        bool m_stopping{ false };
+    };
+}